@@ -38,6 +38,7 @@
 #include <pthread.h>
 #include <stdbool.h>
 #include "query.h"
+#include "geo_index.h"
 
 #define CLUSTERDOWN_ERR "ERRCLUSTER Uninitialized cluster state, could not perform command"
 
@@ -363,6 +364,10 @@ void setKNNSpecialCase(searchRequestCtx *req, specialCaseCtx *knn_ctx) {
 }
 
 
+static int isNotGeoKnn(QueryNode *node, QueryNode *q, void *ctx) {
+  return !QueryNode_IsGeoKnn(node);
+}
+
 // Prepare a TOPK special case, return a context with the required KNN fields if query is
 // valid and contains KNN section, NULL otherwise (and set proper error in *status* if error
 // was found).
@@ -411,6 +416,13 @@ specialCaseCtx *prepareOptionalTopKCase(const char *query_string, RedisModuleStr
         goto cleanup;
       }
       Param_DictFree(params);
+      params = NULL;
+  }
+
+  // The nearest documents of every shard are not merged into the nearest documents of the cluster
+  if (!QueryNode_ForEach(queryNode, isNotGeoKnn, NULL, 0)) {
+    QueryError_SetError(status, QUERY_EBADOPTION, "GEO KNN is not supported in cluster mode");
+    goto cleanup;
   }
 
   if (queryNode->type == QN_VECTOR) {
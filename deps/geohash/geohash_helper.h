@@ -38,6 +38,8 @@
 #define GISZERO(s) (!s.bits && !s.step)
 #define GISNOTZERO(s) (s.bits || s.step)
 
+extern const double EARTH_RADIUS_IN_METERS;
+
 typedef uint64_t GeoHashFix52Bits;
 typedef uint64_t GeoHashVarBits;
 
@@ -1036,6 +1036,15 @@ int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
     QOptimizer_QueryNodes(req->ast.root, req->optimizer);
   }
 
+  // A range query at the root may return its results by distance, unless the optimizer intersects
+  // it with the numeric range of the sort key.
+  QueryNode *root = ast->root;
+  if (root && root->type == QN_VECTOR && root->vn.vq->type == VECSIM_QT_RANGE &&
+      (!IsOptimized(req) || req->optimizer->type == Q_OPT_NONE ||
+       req->optimizer->type == Q_OPT_NO_SORTER)) {
+    root->vn.vq->range.order = BY_SCORE;
+  }
+
   if (QueryError_HasError(status)) {
     return REDISMODULE_ERR;
   }
@@ -1301,11 +1310,17 @@ static void buildImplicitPipeline(AREQ *req, QueryError *Status) {
 
   RLookup_Init(first, cache);
 
-  ResultProcessor *rp = RPIndexIterator_New(req->rootiter);
+  ResultProcessor *rp = RPIndexIterator_New(req->rootiter, req->sctx->spec->docIdsEpoch);
   ResultProcessor *rpUpstream = NULL;
   req->qiter.rootProc = req->qiter.endProc = rp;
   PUSH_RP();
 
+  // Re-rank the candidates of a quantized KNN query before their distances are yielded
+  if (req->ast.rerankIter) {
+    rp = RPReranker_New(req->ast.rerankIter, req->reqflags & QEXEC_F_RUN_IN_BACKGROUND);
+    PUSH_RP();
+  }
+
   // Load results metrics according to their RLookup key.
   // We need this RP only if metricRequests is not empty.
   if (req->ast.metricRequests) {
@@ -269,6 +269,16 @@ CONFIG_SETTER(setForkGcCleanThreshold) {
   RETURN_STATUS(acrc);
 }
 
+CONFIG_SETTER(set_ForkGcCompactDocIdsRatio) {
+  int acrc = AC_GetSize(ac, &config->gcConfigParams.forkGc.forkGcCompactDocIdsRatio, 0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(get_ForkGcCompactDocIdsRatio) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->gcConfigParams.forkGc.forkGcCompactDocIdsRatio);
+}
+
 CONFIG_SETTER(setForkGcRetryInterval) {
   int acrc = AC_GetSize(ac, &config->gcConfigParams.forkGc.forkGcRetryInterval, AC_F_GE1);
   RETURN_STATUS(acrc);
@@ -279,6 +289,16 @@ CONFIG_SETTER(setMinUnionIteratorHeap) {
   RETURN_STATUS(acrc);
 }
 
+CONFIG_SETTER(set_UnionBatchWindow) {
+  int acrc = AC_GetLongLong(ac, &config->iteratorsConfigParams.unionBatchWindow, AC_F_GE0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_SETTER(set_NumericMergeMinRanges) {
+  int acrc = AC_GetLongLong(ac, &config->iteratorsConfigParams.numericMergeMinRanges, AC_F_GE0);
+  RETURN_STATUS(acrc);
+}
+
 CONFIG_SETTER(setCursorMaxIdle) {
   int acrc = AC_GetLongLong(ac, &config->cursorMaxIdle, AC_F_GE1);
   RETURN_STATUS(acrc);
@@ -316,6 +336,16 @@ CONFIG_GETTER(getMinUnionIteratorHeap) {
   return sdscatprintf(ss, "%lld", config->iteratorsConfigParams.minUnionIterHeap);
 }
 
+CONFIG_GETTER(get_UnionBatchWindow) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lld", config->iteratorsConfigParams.unionBatchWindow);
+}
+
+CONFIG_GETTER(get_NumericMergeMinRanges) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lld", config->iteratorsConfigParams.numericMergeMinRanges);
+}
+
 CONFIG_GETTER(getCursorMaxIdle) {
   sds ss = sdsempty();
   return sdscatprintf(ss, "%lld", config->cursorMaxIdle);
@@ -513,10 +543,68 @@ CONFIG_GETTER(getBGIndexSleepGap) {
   return sdscatprintf(ss, "%u", config->numBGIndexingIterationsBeforeSleep);
 }
 
+// _BG_INDEX_BATCH_SIZE
+CONFIG_SETTER(set_BGIndexBatchSize) {
+  int acrc = AC_GetSize(ac, &config->bgIndexingBatchSize, 0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(get_BGIndexBatchSize) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->bgIndexingBatchSize);
+}
+
+// _BG_INDEX_PARALLEL
+CONFIG_BOOLEAN_SETTER(set_BGIndexParallel, bgIndexingParallel)
+CONFIG_BOOLEAN_GETTER(get_BGIndexParallel, bgIndexingParallel, 0)
+
 // _PRIORITIZE_INTERSECT_UNION_CHILDREN
 CONFIG_BOOLEAN_SETTER(set_PrioritizeIntersectUnionChildren, prioritizeIntersectUnionChildren)
 CONFIG_BOOLEAN_GETTER(get_PrioritizeIntersectUnionChildren, prioritizeIntersectUnionChildren, 0)
 
+// _BLOCK_DECODING
+CONFIG_BOOLEAN_SETTER(set_BlockDecoding, invertedIndexBlockDecoding)
+CONFIG_BOOLEAN_GETTER(get_BlockDecoding, invertedIndexBlockDecoding, 0)
+
+// _BLOCK_SKIPS
+CONFIG_BOOLEAN_SETTER(set_BlockSkips, invertedIndexBlockSkips)
+CONFIG_BOOLEAN_GETTER(get_BlockSkips, invertedIndexBlockSkips, 0)
+
+// _ADAPTIVE_INTERSECT_ORDER
+CONFIG_BOOLEAN_SETTER(set_AdaptiveIntersectOrder, adaptiveIntersectOrder)
+CONFIG_BOOLEAN_GETTER(get_AdaptiveIntersectOrder, adaptiveIntersectOrder, 0)
+
+// _TAG_BITMAP_BLOCKS
+CONFIG_BOOLEAN_SETTER(set_TagBitmapBlocks, tagBitmapBlocks)
+CONFIG_BOOLEAN_GETTER(get_TagBitmapBlocks, tagBitmapBlocks, 0)
+
+// _FILTER_CACHE_SIZE
+CONFIG_SETTER(set_FilterCacheSize) {
+  int acrc = AC_GetLongLong(ac, &config->filterCacheSize, AC_F_GE0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(get_FilterCacheSize) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lld", config->filterCacheSize);
+}
+
+// _NUMERIC_COLUMNAR_BLOCKS
+CONFIG_BOOLEAN_SETTER(set_NumericColumnarBlocks, numericColumnarBlocks)
+CONFIG_BOOLEAN_GETTER(get_NumericColumnarBlocks, numericColumnarBlocks, 0)
+
+// _HYBRID_ADAPTIVE_POLICY
+CONFIG_BOOLEAN_SETTER(set_HybridAdaptivePolicy, hybridAdaptivePolicy)
+CONFIG_BOOLEAN_GETTER(get_HybridAdaptivePolicy, hybridAdaptivePolicy, 0)
+
+// _HYBRID_PREFILTER_BITMAP
+CONFIG_BOOLEAN_SETTER(set_HybridPrefilterBitmap, hybridPrefilterBitmap)
+CONFIG_BOOLEAN_GETTER(get_HybridPrefilterBitmap, hybridPrefilterBitmap, 0)
+
+// _NUMERIC_ORDERED_SCAN
+CONFIG_BOOLEAN_SETTER(set_NumericOrderedScan, iteratorsConfigParams.numericOrderedScan)
+CONFIG_BOOLEAN_GETTER(get_NumericOrderedScan, iteratorsConfigParams.numericOrderedScan, 0)
+
 RSConfig RSGlobalConfig = RS_DEFAULT_CONFIG;
 
 static RSConfigVar *findConfigVar(const RSConfigOptions *config, const char *name) {
@@ -687,6 +775,13 @@ RSConfigOptions RSGlobalConfigOptions = {
          .helpText = "clean empty nodes from numeric tree",
          .setValue = set_ForkGCCleanNumericEmptyNodes,
          .getValue = get_ForkGCCleanNumericEmptyNodes},
+        {.name = "_FORK_GC_COMPACT_DOCIDS_RATIO",
+         .helpText = "If not 0, after cleaning an index the fork gc renumbers its documents densely"
+                     " when its highest document id is more than this many times its number of"
+                     " documents. Indexes with vector fields are never renumbered. Queries paused"
+                     " while the documents are renumbered (e.g. cursors) end when resumed.",
+         .setValue = set_ForkGcCompactDocIdsRatio,
+         .getValue = get_ForkGcCompactDocIdsRatio},
         {.name = "UNION_ITERATOR_HEAP",
          .helpText = "minimum number of iterators in a union from which the interator will"
                      "switch to heap based implementation.",
@@ -756,6 +851,19 @@ RSConfigOptions RSGlobalConfigOptions = {
          .setValue = setBGIndexSleepGap,
          .getValue = getBGIndexSleepGap,
          .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "_BG_INDEX_BATCH_SIZE",
+         .helpText = "The number of documents loaded by the background indexing before they are"
+                     " tokenized together on the workers thread pool, and then merged into the index"
+                     " in order. 0 indexes the documents one by one.",
+         .setValue = set_BGIndexBatchSize,
+         .getValue = get_BGIndexBatchSize},
+        {.name = "_BG_INDEX_PARALLEL",
+         .helpText = "Release the GIL while the batches of the background indexing (see"
+                     " _BG_INDEX_BATCH_SIZE) are tokenized on the workers thread pool, so the server"
+                     " keeps serving commands. Keys written meanwhile are indexed by their own"
+                     " notifications, and their scanned version is dropped.",
+         .setValue = set_BGIndexParallel,
+         .getValue = get_BGIndexParallel},
         {.name = "_PRIORITIZE_INTERSECT_UNION_CHILDREN",
          .helpText = "Intersection iterator orders the children iterators by their relative estimated"
                      " number of results in ascending order, so that if we see first iterators with"
@@ -766,6 +874,74 @@ RSConfigOptions RSGlobalConfigOptions = {
                      "overall estimated number of results instead.",
          .setValue = set_PrioritizeIntersectUnionChildren,
          .getValue = get_PrioritizeIntersectUnionChildren},
+        {.name = "_BLOCK_DECODING",
+         .helpText = "Decode whole inverted index blocks at once into flat arrays (using SIMD"
+                     " kernels when the CPU supports them) and iterate over the decoded arrays,"
+                     " instead of decoding the records one by one.",
+         .setValue = set_BlockDecoding,
+         .getValue = get_BlockDecoding},
+        {.name = "_BLOCK_SKIPS",
+         .helpText = "Keep a skip point every few records of the inverted index blocks, so that"
+                     " skipping to a document id inside a block can jump close to it instead of"
+                     " decoding the block from its start.",
+         .setValue = set_BlockSkips,
+         .getValue = get_BlockSkips},
+        {.name = "_ADAPTIVE_INTERSECT_ORDER",
+         .helpText = "Reorder the children of intersection iterators while iterating, so that the"
+                     " ones which reject most candidate documents are advanced first.",
+         .setValue = set_AdaptiveIntersectOrder,
+         .getValue = get_AdaptiveIntersectOrder},
+        {.name = "_UNION_BATCH_WINDOW",
+         .helpText = "If not 0, unions of more than UNION_ITERATOR_HEAP index readers buffer the"
+                     " records of their children in windows of this many document ids, instead of"
+                     " merging them one record at a time. Windows are capped at 65536 document"
+                     " ids.",
+         .setValue = set_UnionBatchWindow,
+         .getValue = get_UnionBatchWindow},
+        {.name = "_TAG_BITMAP_BLOCKS",
+         .helpText = "Create new tag indexes with sealed blocks: full blocks are bit-packed, or"
+                     " stored as bitmaps of document ids when they are dense enough. Takes effect"
+                     " for tag values indexed after it is set.",
+         .setValue = set_TagBitmapBlocks,
+         .getValue = get_TagBitmapBlocks},
+        {.name = "_FILTER_CACHE_SIZE",
+         .helpText = "If not 0, the document ids matched by tag and numeric filters are cached per"
+                     " index, for up to this many filters, until documents are added to or deleted"
+                     " from the index. Cached filters do not contribute to the score of results.",
+         .setValue = set_FilterCacheSize,
+         .getValue = get_FilterCacheSize},
+        {.name = "_NUMERIC_COLUMNAR_BLOCKS",
+         .helpText = "Create new numeric ranges with sealed blocks: full blocks store their document"
+                     " ids and values in separate bit-packed columns if that makes them smaller, with"
+                     " the minimal and maximal values of the block, so range filters can skip or"
+                     " accept whole blocks. Takes effect for numeric ranges created after it is set.",
+         .setValue = set_NumericColumnarBlocks,
+         .getValue = get_NumericColumnarBlocks},
+        {.name = "_NUMERIC_MERGE_MIN_RANGES",
+         .helpText = "If not 0, numeric filters which select at least this many numeric ranges merge"
+                     " the documents of the ranges through a bitmap of document ids, instead of a"
+                     " union iterator's heap.",
+         .setValue = set_NumericMergeMinRanges,
+         .getValue = get_NumericMergeMinRanges},
+        {.name = "_NUMERIC_ORDERED_SCAN",
+         .helpText = "Answer queries sorted by a numeric field by reading the ranges of the field in"
+                     " the order of the sort, one at a time, until enough results are found.",
+         .setValue = set_NumericOrderedScan,
+         .getValue = get_NumericOrderedScan},
+        {.name = "_HYBRID_ADAPTIVE_POLICY",
+         .helpText = "Learn the rate in which vectors pass the filters of hybrid vector queries, per"
+                     " vector field and filter shape, and use it to choose the search mode and the"
+                     " batch size of the following queries, instead of the estimated number of"
+                     " results of the filter.",
+         .setValue = set_HybridAdaptivePolicy,
+         .getValue = get_HybridAdaptivePolicy},
+        {.name = "_HYBRID_PREFILTER_BITMAP",
+         .helpText = "Read the filter of hybrid vector queries in batches mode once into a bitmap of"
+                     " document ids, and filter the batches of vectors by it, instead of"
+                     " intersecting every batch with the filter. The batch size then follows the"
+                     " exact number of documents which pass the filter.",
+         .setValue = set_HybridPrefilterBitmap,
+         .getValue = get_HybridPrefilterBitmap},
         {.name = NULL}}};
 
 void RSConfigOptions_AddConfigs(RSConfigOptions *src, RSConfigOptions *dst) {
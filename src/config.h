@@ -41,6 +41,9 @@ typedef struct {
   size_t forkGcRetryInterval;
   size_t forkGcSleepBeforeExit;
   int forkGCCleanNumericEmptyNodes;
+  // If not 0, the GC compacts the doc ids of indexes whose highest id is over this many times
+  // their number of documents
+  size_t forkGcCompactDocIdsRatio;
 } forkGcConfig;
 
 typedef struct {
@@ -71,6 +74,15 @@ typedef struct {
   // The minimal number of characters we allow expansion for in a prefix search. Default: 2
   long long minTermPrefix;
   long long minUnionIterHeap;
+  // If not 0, unions with more than minUnionIterHeap children of index readers buffer their
+  // children's records in windows of this many docIds, instead of merging them with a heap
+  long long unionBatchWindow;
+  // If not 0, numeric filters which select at least this many numeric ranges merge the ranges'
+  // readers through a bitmap of docIds, instead of a heap
+  long long numericMergeMinRanges;
+  // If set, queries sorted by a numeric field walk the field's ranges in the order of the sort,
+  // instead of widening a numeric filter until enough results are found
+  int numericOrderedScan;
 } IteratorsConfig;
 
 
@@ -150,9 +162,37 @@ typedef struct {
   // before we call usleep(1) (sleep for 1 micro-second) and make sure that
   // we allow redis process other commands.
   unsigned int numBGIndexingIterationsBeforeSleep;
+  // The number of documents the background indexing loads before preprocessing them together on
+  // the workers thread pool. 0 indexes the documents one by one.
+  size_t bgIndexingBatchSize;
+  // If set, the background indexing preprocesses its batches with the GIL released.
+  int bgIndexingParallel;
   // If set, we use an optimization that sorts the children of an intersection iterator in a way
   // where union iterators are being factorize by the number of their own children.
   int prioritizeIntersectUnionChildren;
+  // If set, term index readers decode a whole index block at once into a structure-of-arrays
+  // buffer and iterate over it, instead of decoding one record at a time.
+  int invertedIndexBlockDecoding;
+  // If set, inverted index writers record a skip point (docId and offset) every
+  // INDEX_BLOCK_SKIP_INTERVAL records of a block, which IR_SkipTo uses to seek inside the block.
+  int invertedIndexBlockSkips;
+  // If set, intersection iterators reorder their children while iterating, by the rate in which
+  // each child rejects the candidate documents it is skipped to.
+  int adaptiveIntersectOrder;
+  // If set, new tag indexes seal their full blocks in a compact format, storing the dense ones as
+  // bitmaps of document ids.
+  int tagBitmapBlocks;
+  // The maximal number of filter results cached per index (see filter_cache.h). 0 disables the cache
+  long long filterCacheSize;
+  // If set, new numeric ranges seal their full blocks in a columnar format, with a zone map of the
+  // block's minimal and maximal values, if it makes them smaller.
+  int numericColumnarBlocks;
+  // If set, hybrid vector queries learn the rate in which vectors pass their filter per vector field
+  // and filter shape (see hybrid_stats.h), and choose their search mode and batch size by it.
+  int hybridAdaptivePolicy;
+  // If set, hybrid vector queries in batches mode read their filter once into a bitmap of document
+  // ids, and filter the batches by it instead of intersecting every batch with the filter.
+  int hybridPrefilterBitmap;
 } RSConfig;
 
 typedef enum {
@@ -257,11 +297,15 @@ void DialectsGlobalStats_AddToInfo(RedisModuleInfoCtx *ctx);
     .gcConfigParams.forkGc.forkGcSleepBeforeExit = 0,                                                                 \
     .gcConfigParams.forkGc.forkGcRetryInterval = 5,                                                                   \
     .gcConfigParams.forkGc.forkGcCleanThreshold = 100,                                                                \
+    .gcConfigParams.forkGc.forkGcCompactDocIdsRatio = 0,                                                              \
     .noMemPool = 0,                                                                                                   \
     .filterCommands = 0,                                                                                              \
     .maxSearchResults = SEARCH_REQUEST_RESULTS_MAX,                                                                   \
     .maxAggregateResults = -1,                                                                                        \
     .iteratorsConfigParams.minUnionIterHeap = 20,                                                                     \
+    .iteratorsConfigParams.unionBatchWindow = 0,                                                                      \
+    .iteratorsConfigParams.numericMergeMinRanges = 0,                                                                 \
+    .iteratorsConfigParams.numericOrderedScan = false,                                                                \
     .numericCompress = false,                                                                                         \
     .numericTreeMaxDepthRange = 0,                                                                                    \
     .requestConfigParams.printProfileClock = 1,                                                                       \
@@ -273,7 +317,17 @@ void DialectsGlobalStats_AddToInfo(RedisModuleInfoCtx *ctx);
     .multiTextOffsetDelta = 100,                                                                                      \
     .used_dialects = 0,                                                                                               \
     .numBGIndexingIterationsBeforeSleep = 100,                                                                        \
-    .prioritizeIntersectUnionChildren = false                                                                         \
+    .bgIndexingBatchSize = 0,                                                                                         \
+    .bgIndexingParallel = false,                                                                                      \
+    .prioritizeIntersectUnionChildren = false,                                                                        \
+    .invertedIndexBlockDecoding = false,                                                                              \
+    .invertedIndexBlockSkips = false,                                                                                 \
+    .adaptiveIntersectOrder = false,                                                                                  \
+    .tagBitmapBlocks = false,                                                                                         \
+    .filterCacheSize = 0,                                                                                             \
+    .numericColumnarBlocks = false,                                                                                   \
+    .hybridAdaptivePolicy = false,                                                                                    \
+    .hybridPrefilterBitmap = false                                                                                    \
   }
 
 #define REDIS_ARRAY_LIMIT 7
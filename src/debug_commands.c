@@ -737,6 +737,70 @@ end:
   return REDISMODULE_OK;
 }
 
+// FT.DEBUG NUMIDX_REBUILD INDEX_NAME NUMERIC_FIELD_NAME
+DEBUG_COMMAND(NumericIndexRebuild) {
+  if (argc != 2) {
+    return RedisModule_WrongArity(ctx);
+  }
+  GET_SEARCH_CTX(argv[0])
+  RedisModuleKey *keyp = NULL;
+  RedisModuleString *keyName = getFieldKeyName(sctx->spec, argv[1], INDEXFLD_T_NUMERIC);
+  if (!keyName) {
+    RedisModule_ReplyWithError(sctx->redisCtx, "Could not find given field in index spec");
+    goto end;
+  }
+  NumericRangeTree *rt = OpenNumericIndex(sctx, keyName, &keyp);
+  if (!rt) {
+    RedisModule_ReplyWithError(sctx->redisCtx, "can not open numeric field");
+    goto end;
+  }
+
+  RedisSearchCtx_LockSpecWrite(sctx);
+  NRN_AddRv rv = NumericRangeTree_Rebuild(rt);
+  sctx->spec->stats.invertedSize += rv.sz;
+  sctx->spec->stats.numRecords += rv.numRecords;
+  RedisSearchCtx_UnlockSpec(sctx);
+  RedisModule_ReplyWithSimpleString(ctx, "OK");
+
+end:
+  if (keyp) {
+    RedisModule_CloseKey(keyp);
+  }
+  SearchCtx_Free(sctx);
+  return REDISMODULE_OK;
+}
+
+static int CompactDocIdsReply(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  long long *reclaimed = RedisModule_GetBlockedClientPrivateData(ctx);
+  if (*reclaimed < 0) {
+    return RedisModule_ReplyWithError(ctx, "Can not compact the doc ids of an index with vector fields");
+  }
+  return RedisModule_ReplyWithLongLong(ctx, *reclaimed);
+}
+
+static void CompactDocIdsFree(RedisModuleCtx *ctx, void *privdata) {
+  rm_free(privdata);
+}
+
+// FT.DEBUG COMPACT_DOCIDS INDEX_NAME
+DEBUG_COMMAND(CompactDocIds) {
+  if (argc != 1) {
+    return RedisModule_WrongArity(ctx);
+  }
+  StrongRef ref = IndexSpec_LoadUnsafe(ctx, RedisModule_StringPtrLen(argv[0], NULL));
+  IndexSpec *sp = StrongRef_Get(ref);
+  if (!sp) {
+    return RedisModule_ReplyWithError(ctx, "Unknown index name");
+  }
+
+  // The ids are compacted by the GC thread, as a fork GC which is already running collected its
+  // changes on the old ids
+  RedisModuleBlockedClient *bc =
+      RedisModule_BlockClient(ctx, CompactDocIdsReply, NULL, CompactDocIdsFree, 0);
+  GCContext_ForceCompactDocIds(sp->gc, bc);
+  return REDISMODULE_OK;
+}
+
 DEBUG_COMMAND(ttl) {
   if (argc < 1) {
     return RedisModule_WrongArity(ctx);
@@ -1064,6 +1128,28 @@ static void VecSim_Reply_Info_Iterator(RedisModuleCtx *ctx, VecSimInfoIterator *
   }
 }
 
+static void QuantizedIndex_ReplyInfo(RedisModuleCtx *ctx, const FieldSpec *fs,
+                                     const QuantizedIndex *qi) {
+  const BFParams *params = &fs->vectorOpts.vecSimParams.algoParams.bfParams;
+  RedisModule_ReplyWithArray(ctx, 8 * 2);
+  RedisModule_ReplyWithSimpleString(ctx, "ALGORITHM");
+  RedisModule_ReplyWithSimpleString(ctx, VecSimAlgorithm_ToString(VecSimAlgo_BF));
+  RedisModule_ReplyWithSimpleString(ctx, "TYPE");
+  RedisModule_ReplyWithSimpleString(ctx, VecSimType_ToString(params->type));
+  RedisModule_ReplyWithSimpleString(ctx, "DIMENSION");
+  RedisModule_ReplyWithLongLong(ctx, params->dim);
+  RedisModule_ReplyWithSimpleString(ctx, "METRIC");
+  RedisModule_ReplyWithSimpleString(ctx, VecSimMetric_ToString(params->metric));
+  RedisModule_ReplyWithSimpleString(ctx, VECSIM_QUANTIZATION);
+  RedisModule_ReplyWithSimpleString(ctx, VECSIM_QUANT_SQ8);
+  RedisModule_ReplyWithSimpleString(ctx, VECSIM_RERANK);
+  RedisModule_ReplyWithLongLong(ctx, fs->vectorOpts.quantParams.rerank);
+  RedisModule_ReplyWithSimpleString(ctx, "INDEX_SIZE");
+  RedisModule_ReplyWithLongLong(ctx, QuantizedIndex_Size(qi));
+  RedisModule_ReplyWithSimpleString(ctx, "MEMORY");
+  RedisModule_ReplyWithLongLong(ctx, QuantizedIndex_MemoryUsage(qi));
+}
+
 /**
  * FT.DEBUG VECSIM_INFO <index> <field>
  */
@@ -1078,6 +1164,13 @@ DEBUG_COMMAND(VecsimInfo) {
     SearchCtx_Free(sctx);
     return RedisModule_ReplyWithError(ctx, "Vector index not found");
   }
+  const char *fieldName = RedisModule_StringPtrLen(argv[1], NULL);
+  const FieldSpec *fs = IndexSpec_GetField(sctx->spec, fieldName, strlen(fieldName));
+  if (FieldSpec_IsQuantized(fs)) {
+    QuantizedIndex_ReplyInfo(ctx, fs, OpenQuantizedVectorIndex(sctx->spec, keyName));
+    SearchCtx_Free(sctx);
+    return REDISMODULE_OK;
+  }
   // This call can't fail, since we already checked that the key exists
   // (or should exist, and this call will create it).
   VecSimIndex *vecsimIndex = OpenVectorIndex(sctx->spec, keyName);
@@ -1173,6 +1266,8 @@ DebugCommandType commands[] = {{"DUMP_INVIDX", DumpInvertedIndex}, // Print all
                                {"GC_FORCEINVOKE", GCForceInvoke},
                                {"GC_FORCEBGINVOKE", GCForceBGInvoke},
                                {"GC_CLEAN_NUMERIC", GCCleanNumeric},
+                               {"NUMIDX_REBUILD", NumericIndexRebuild}, // Rebuild a numeric tree in bulk, balanced and without empty leaves
+                               {"COMPACT_DOCIDS", CompactDocIds}, // Renumber the documents of an index densely
                                {"GC_STOP_SCHEDULE", GCStopFutureRuns},
                                {"GC_CONTINUE_SCHEDULE", GCContinueFutureRuns},
                                {"GC_WAIT_FOR_JOBS", GCWaitForAllJobs},
@@ -27,6 +27,26 @@
     RS_LOG_ASSERT(count < (1 << 16) - 1, "overflow of dmd ref_count");        \
   })
 
+/* Grow the columns from oldcap to the capacity of the table, clearing the new entries */
+static void DocTable_GrowColumns(DocTable *t, size_t oldcap) {
+  DocTableColumns *cols = &t->cols;
+  size_t n = t->cap - oldcap;
+  cols->keys = rm_realloc(cols->keys, t->cap * sizeof(*cols->keys));
+  cols->scores = rm_realloc(cols->scores, t->cap * sizeof(*cols->scores));
+  cols->lens = rm_realloc(cols->lens, t->cap * sizeof(*cols->lens));
+  memset(cols->keys + oldcap, 0, n * sizeof(*cols->keys));
+  memset(cols->scores + oldcap, 0, n * sizeof(*cols->scores));
+  memset(cols->lens + oldcap, 0, n * sizeof(*cols->lens));
+}
+
+static void DocTable_FreeColumns(DocTable *t) {
+  DocTableColumns *cols = &t->cols;
+  rm_free(cols->keys);
+  rm_free(cols->scores);
+  rm_free(cols->lens);
+  *cols = (DocTableColumns){0};
+}
+
 /* Creates a new DocTable with a given capacity */
 DocTable NewDocTable(size_t cap, size_t max_size) {
   DocTable ret = {
@@ -35,10 +55,12 @@ DocTable NewDocTable(size_t cap, size_t max_size) {
       .maxDocId = 0,
       .memsize = 0,
       .sortablesSize = 0,
+      .maxDocScore = 0,
       .maxSize = max_size,
       .dim = NewDocIdMap(),
   };
   ret.buckets = rm_calloc(cap, sizeof(*ret.buckets));
+  DocTable_GrowColumns(&ret, 0);
   return ret;
 }
 
@@ -87,6 +109,10 @@ int DocTable_Exists(const DocTable *t, t_docId docId) {
   if (!docId || docId > t->maxDocId) {
     return 0;
   }
+  // a document which owns its bucket is in the columns
+  if (docId < t->maxSize) {
+    return DocTable_InColumns(t, docId);
+  }
   uint32_t ix = DocTable_GetBucket(t, docId);
   if (ix >= t->cap) {
     return 0;
@@ -112,6 +138,28 @@ const RSDocumentMetadata *DocTable_BorrowByKeyR(const DocTable *t, RedisModuleSt
   return DocTable_Borrow(t, id);
 }
 
+void DocTable_UpdateColumns(DocTable *t, const RSDocumentMetadata *dmd) {
+  t->maxDocScore = MAX(t->maxDocScore, dmd->score);
+  t_docId docId = dmd->id;
+  if (docId >= t->maxSize || docId >= t->cap) {
+    return;
+  }
+  DocTableColumns *cols = &t->cols;
+  cols->keys[docId] = dmd->keyPtr;
+  cols->scores[docId] = dmd->score;
+  cols->lens[docId] = dmd->len;
+}
+
+static void DocTable_ClearColumns(DocTable *t, t_docId docId) {
+  if (docId >= t->maxSize || docId >= t->cap) {
+    return;
+  }
+  DocTableColumns *cols = &t->cols;
+  cols->keys[docId] = NULL;
+  cols->scores[docId] = 0;
+  cols->lens[docId] = 0;
+}
+
 static inline void DocTable_Set(DocTable *t, t_docId docId, RSDocumentMetadata *dmd) {
   uint32_t bucket = DocTable_GetBucket(t, docId);
   if (bucket >= t->cap && t->cap < t->maxSize) {
@@ -129,6 +177,7 @@ static inline void DocTable_Set(DocTable *t, t_docId docId, RSDocumentMetadata *
     // We clear new extra allocation to Null all list pointers
     size_t memsetSize = (t->cap - oldcap) * sizeof(DMDChain);
     memset(&t->buckets[oldcap], 0, memsetSize);
+    DocTable_GrowColumns(t, oldcap);
   }
 
   DMDChain *chain = &t->buckets[bucket];
@@ -136,6 +185,63 @@ static inline void DocTable_Set(DocTable *t, t_docId docId, RSDocumentMetadata *
 
   // Adding the dmd to the chain
   dllist2_append(&chain->lroot, &dmd->llnode);
+  DocTable_UpdateColumns(t, dmd);
+}
+
+t_docId DocIdRemap_Get(const DocIdRemap *m, t_docId oldId, size_t *hint) {
+  size_t lo = *hint, hi = m->n;
+  if (lo >= hi || m->oldIds[lo] > oldId) {
+    lo = 0;
+  }
+  // find the first position whose old id is not smaller than oldId
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (m->oldIds[mid] < oldId) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  *hint = lo;
+  return lo < m->n && m->oldIds[lo] == oldId ? lo + 1 : 0;
+}
+
+void DocIdRemap_Free(DocIdRemap *m) {
+  rm_free(m->oldIds);
+  *m = (DocIdRemap){0};
+}
+
+static int cmpDmdIds(const void *a, const void *b) {
+  t_docId ida = (*(const RSDocumentMetadata **)a)->id;
+  t_docId idb = (*(const RSDocumentMetadata **)b)->id;
+  return ida < idb ? -1 : ida > idb;
+}
+
+DocIdRemap DocTable_Compact(DocTable *t) {
+  RSDocumentMetadata **dmds = rm_malloc(t->size * sizeof(*dmds));
+  size_t n = 0;
+  DOCTABLE_FOREACH(t, dmds[n++] = dmd);
+  qsort(dmds, n, sizeof(*dmds), cmpDmdIds);
+
+  // the buckets and columns are rebuilt for the new ids, which need no more than n + 1 of them
+  rm_free(t->buckets);
+  DocTable_FreeColumns(t);
+  t->cap = MIN(n + 1, t->maxSize);
+  t->buckets = rm_calloc(t->cap, sizeof(*t->buckets));
+  DocTable_GrowColumns(t, 0);
+
+  DocIdRemap remap = {.oldIds = rm_malloc((n + 1) * sizeof(*remap.oldIds)), .n = n};
+  for (size_t i = 0; i < n; ++i) {
+    RSDocumentMetadata *dmd = dmds[i];
+    remap.oldIds[i] = dmd->id;
+    dmd->id = i + 1;
+    dllist2_append(&t->buckets[DocTable_GetBucket(t, dmd->id)].lroot, &dmd->llnode);
+    DocTable_UpdateColumns(t, dmd);
+    DocIdMap_Put(&t->dim, dmd->keyPtr, sdslen(dmd->keyPtr), dmd->id);
+  }
+  t->maxDocId = n;
+  rm_free(dmds);
+  return remap;
 }
 
 /** Get the docId of a key if it exists in the table, or 0 if it doesnt */
@@ -168,6 +274,7 @@ int DocTable_SetPayload(DocTable *t, RSDocumentMetadata *dmd, const char *data,
 
   dmd->flags |= Document_HasPayload;
   t->memsize += len;
+  DocTable_UpdateColumns(t, dmd);
   return 1;
 }
 
@@ -196,6 +303,7 @@ int DocTable_SetSortingVector(DocTable *t, RSDocumentMetadata *dmd, RSSortingVec
   dmd->sortVector = v;
   dmd->flags |= Document_HasSortVector;
   t->sortablesSize += RSSortingVector_GetMemorySize(v);
+  DocTable_UpdateColumns(t, dmd);
 
   return 1;
 }
@@ -207,6 +315,7 @@ int DocTable_SetByteOffsets(DocTable *t, RSDocumentMetadata *dmd, RSByteOffsets
 
   dmd->byteOffsets = v;
   dmd->flags |= Document_HasOffsetVector;
+  DocTable_UpdateColumns(t, dmd);
   return 1;
 }
 
@@ -273,13 +382,18 @@ sds DocTable_GetKey(const DocTable *t, t_docId docId, size_t *lenp) {
     lenp = &len_s;
   }
 
-  const RSDocumentMetadata *dmd = DocTable_Borrow(t, docId);
-  if (!dmd) {
-    *lenp = 0;
-    return NULL;
+  sds key;
+  if (DocTable_InColumns(t, docId)) {
+    key = sdsdup((sds)t->cols.keys[docId]);
+  } else {
+    const RSDocumentMetadata *dmd = DocTable_Borrow(t, docId);
+    if (!dmd) {
+      *lenp = 0;
+      return NULL;
+    }
+    key = sdsdup(dmd->keyPtr);
+    DMD_Return(dmd);
   }
-  sds key = sdsdup(dmd->keyPtr);
-  DMD_Return(dmd);
   *lenp = sdslen(key);
   return key;
 }
@@ -320,6 +434,7 @@ void DocTable_Free(DocTable *t) {
     }
   }
   rm_free(t->buckets);
+  DocTable_FreeColumns(t);
   DocIdMap_Free(&t->dim);
 }
 
@@ -327,6 +442,7 @@ static void DocTable_DmdUnchain(DocTable *t, RSDocumentMetadata *md) {
   uint32_t bucketIndex = DocTable_GetBucket(t, md->id);
   DMDChain *dmdChain = &t->buckets[bucketIndex];
   dllist2_delete(&dmdChain->lroot, &md->llnode);
+  DocTable_ClearColumns(t, md->id);
 }
 
 int DocTable_Delete(DocTable *t, const char *s, size_t n) {
@@ -384,6 +500,7 @@ int DocTable_Replace(DocTable *t, const char *from_str, size_t from_len, const c
   RSDocumentMetadata *dmd = DocTable_GetOwn(t, id);
   sdsfree(dmd->keyPtr);
   dmd->keyPtr = sdsnewlen(to_str, to_len);
+  DocTable_UpdateColumns(t, dmd);
   return REDISMODULE_OK;
 }
 
@@ -451,6 +568,8 @@ void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
     t->cap = t->maxSize;
     rm_free(t->buckets);
     t->buckets = rm_calloc(t->cap, sizeof(*t->buckets));
+    DocTable_FreeColumns(t);
+    DocTable_GrowColumns(t, 0);
   }
 
   for (size_t i = 1; i < t->size; i++) {
@@ -63,6 +63,16 @@ typedef struct {
   DLLIST2 lroot;
 } DMDChain;
 
+/* Dense columns of the metadata read by the GC, key lookups and block-max pruning, indexed by
+ * docId, with the same capacity as the buckets. Only documents whose ids are below the table's
+ * maxSize (and so own their bucket) are in the columns, and a NULL key marks a missing or deleted
+ * document. The keys are borrowed from the metadata, which stays the owner of the document */
+typedef struct {
+  const char **keys;
+  float *scores;
+  uint32_t *lens;
+} DocTableColumns;
+
 typedef struct {
   size_t size;
   // the maximum size this table is allowed to grow to
@@ -71,8 +81,11 @@ typedef struct {
   size_t cap;
   size_t memsize;
   size_t sortablesSize;
+  // an upper bound of the scores of the documents, which is never decreased
+  float maxDocScore;
 
   DMDChain *buckets;
+  DocTableColumns cols;
   DocIdMap dim;
 } DocTable;
 
@@ -99,6 +112,35 @@ const RSDocumentMetadata *DocTable_Borrow(const DocTable *t, t_docId docId);
 
 const RSDocumentMetadata *DocTable_BorrowByKeyR(const DocTable *r, RedisModuleString *s);
 
+/* Returns 1 if the metadata of docId can be read from the columns of the table, without
+ * borrowing it */
+static inline int DocTable_InColumns(const DocTable *t, t_docId docId) {
+  return docId < t->maxSize && docId < t->cap && t->cols.keys[docId] != NULL;
+}
+
+/* Update the columns of the table after the scoring fields of `dmd` were changed directly */
+void DocTable_UpdateColumns(DocTable *t, const RSDocumentMetadata *dmd);
+
+/* The old ids of the documents of a compacted table, in ascending order. The new id of the
+ * document whose old id is oldIds[i] is i + 1 */
+typedef struct {
+  t_docId *oldIds;
+  size_t n;
+} DocIdRemap;
+
+/* Get the new id of a document from its old id, or 0 if the document is not in the table anymore.
+ * `hint` is a position in oldIds from which to start looking, which is advanced to the position of
+ * the document, so ascending ids are looked up without going over the same positions again. */
+t_docId DocIdRemap_Get(const DocIdRemap *m, t_docId oldId, size_t *hint);
+
+void DocIdRemap_Free(DocIdRemap *m);
+
+/* Renumber the documents of the table from 1 to the number of documents, in the order of their
+ * ids, so the ids left unused by deleted documents are reclaimed. Every index holding the old ids
+ * must be renumbered with the returned remap (see InvertedIndex_Remap) before the lock of the spec
+ * is released */
+DocIdRemap DocTable_Compact(DocTable *t);
+
 /* Put a new document into the table, assign it an incremental id and store the metadata in the
  * table.
  *
@@ -0,0 +1,154 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "docid_compact.h"
+#include "inverted_index.h"
+#include "redis_index.h"
+#include "numeric_index.h"
+#include "tag_index.h"
+#include "geometry_index.h"
+#include "geometry/geometry_api.h"
+#include "util/arr.h"
+#include "rmalloc.h"
+
+int DocIdCompact_IsNeeded(const IndexSpec *sp, size_t ratio) {
+  if (!ratio || (sp->flags & Index_HasVecSim)) {
+    return 0;
+  }
+  return sp->docs.maxDocId > ratio * sp->stats.numDocuments;
+}
+
+// Apply the changes of a renumbered inverted index to the stats of the spec
+static void updateStats(RedisSearchCtx *sctx, IndexRepairParams *params) {
+  sctx->spec->stats.numRecords -= params->entriesCollected;
+  sctx->spec->stats.invertedSize += params->bytesAfterFix - params->bytesBeforFix;
+}
+
+static void compactTerms(RedisSearchCtx *sctx, const DocIdRemap *remap) {
+  TrieIterator *iter = Trie_Iterate(sctx->spec->terms, "", 0, 0, 1);
+  rune *rstr = NULL;
+  t_len slen = 0;
+  float score = 0;
+  int dist = 0;
+  while (TrieIterator_Next(iter, &rstr, &slen, NULL, &score, &dist)) {
+    size_t termLen;
+    char *term = runesToStr(rstr, slen, &termLen);
+    RedisModuleKey *idxKey = NULL;
+    InvertedIndex *idx = Redis_OpenInvertedIndexEx(sctx, term, termLen, 0, NULL, &idxKey);
+    if (idx) {
+      IndexRepairParams params = {0};
+      InvertedIndex_Remap(idx, remap, &params);
+      updateStats(sctx, &params);
+    }
+    if (idxKey) {
+      RedisModule_CloseKey(idxKey);
+    }
+    rm_free(term);
+  }
+  TrieIterator_Free(iter);
+}
+
+static void compactNumeric(RedisSearchCtx *sctx, const DocIdRemap *remap) {
+  arrayof(FieldSpec *) fields = getFieldsByType(sctx->spec, INDEXFLD_T_NUMERIC | INDEXFLD_T_GEO);
+  for (int i = 0; i < array_len(fields); ++i) {
+    RedisModuleKey *idxKey = NULL;
+    RedisModuleString *keyName =
+        IndexSpec_GetFormattedKey(sctx->spec, fields[i], INDEXFLD_T_NUMERIC);
+    NumericRangeTree *rt = OpenNumericIndex(sctx, keyName, &idxKey);
+    if (!rt) {
+      continue;
+    }
+    NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(rt);
+    NumericRangeNode *node;
+    while ((node = NumericRangeTreeIterator_Next(iter))) {
+      if (!node->range) {
+        continue;
+      }
+      IndexRepairParams params = {0};
+      InvertedIndex_Remap(node->range->entries, remap, &params);
+      node->range->invertedIndexSize += params.bytesAfterFix - params.bytesBeforFix;
+      rt->numEntries -= params.entriesCollected;
+      updateStats(sctx, &params);
+    }
+    NumericRangeTreeIterator_Free(iter);
+
+    size_t hint = 0;
+    rt->lastDocId = DocIdRemap_Get(remap, rt->lastDocId, &hint);
+    // paused numeric iterators abort when the revision of their tree changes
+    rt->revisionId++;
+    if (idxKey) {
+      RedisModule_CloseKey(idxKey);
+    }
+  }
+  array_free(fields);
+}
+
+static void compactTags(RedisSearchCtx *sctx, const DocIdRemap *remap) {
+  arrayof(FieldSpec *) fields = getFieldsByType(sctx->spec, INDEXFLD_T_TAG);
+  for (int i = 0; i < array_len(fields); ++i) {
+    RedisModuleKey *idxKey = NULL;
+    RedisModuleString *keyName = IndexSpec_GetFormattedKey(sctx->spec, fields[i], INDEXFLD_T_TAG);
+    TagIndex *tagIdx = TagIndex_Open(sctx, keyName, false, &idxKey);
+    if (tagIdx) {
+      TrieMapIterator *iter = TrieMap_Iterate(tagIdx->values, "", 0);
+      char *ptr;
+      tm_len_t len;
+      InvertedIndex *idx;
+      while (TrieMapIterator_Next(iter, &ptr, &len, (void **)&idx)) {
+        IndexRepairParams params = {0};
+        InvertedIndex_Remap(idx, remap, &params);
+        updateStats(sctx, &params);
+      }
+      TrieMapIterator_Free(iter);
+    }
+    if (idxKey) {
+      RedisModule_CloseKey(idxKey);
+    }
+  }
+  array_free(fields);
+}
+
+static t_docId remapGeometryId(void *ctx, t_docId docId) {
+  size_t hint = 0;
+  return DocIdRemap_Get(ctx, docId, &hint);
+}
+
+static void compactGeometry(RedisSearchCtx *sctx, DocIdRemap *remap) {
+  arrayof(FieldSpec *) fields = getFieldsByType(sctx->spec, INDEXFLD_T_GEOMETRY);
+  for (int i = 0; i < array_len(fields); ++i) {
+    RedisModuleKey *idxKey = NULL;
+    GeometryIndex *idx = OpenGeometryIndex(sctx->redisCtx, sctx->spec, &idxKey, fields[i]);
+    if (idx) {
+      GeometryApi_Get(idx)->remap(idx, remapGeometryId, remap);
+    }
+    if (idxKey) {
+      RedisModule_CloseKey(idxKey);
+    }
+  }
+  array_free(fields);
+}
+
+long long DocIdCompact_Run(RedisSearchCtx *sctx) {
+  IndexSpec *sp = sctx->spec;
+  if (sp->flags & Index_HasVecSim) {
+    return -1;
+  }
+  t_docId maxDocId = sp->docs.maxDocId;
+  DocIdRemap remap = DocTable_Compact(&sp->docs);
+
+  compactTerms(sctx, &remap);
+  compactNumeric(sctx, &remap);
+  compactTags(sctx, &remap);
+  if (sp->flags & Index_HasGeometry) {
+    compactGeometry(sctx, &remap);
+  }
+
+  // cached filter results hold the old ids
+  sp->revision++;
+  sp->docIdsEpoch++;
+  DocIdRemap_Free(&remap);
+  return maxDocId - sp->docs.maxDocId;
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "search_ctx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Doc ids are never reused, so after many updates and deletions most of the id space of an index
+ * is made of holes. The compaction renumbers the documents of the index from 1 to the number of
+ * documents, and rewrites every index holding their ids - the term, numeric, geo, tag and geometry
+ * indexes - in place, under the write lock of the spec, so queries see either the old ids or the
+ * new ones. Queries which were paused while the ids were renumbered (e.g. cursors) end when they
+ * are resumed, see IndexSpec.docIdsEpoch.
+ *
+ * Vector indexes can not relabel their vectors, so indexes with vector fields are never compacted.
+ */
+
+/* Whether the ids of the index are sparse enough to be compacted - the highest id is more than
+ * `ratio` times the number of documents. A ratio of 0 disables the compaction */
+int DocIdCompact_IsNeeded(const IndexSpec *sp, size_t ratio);
+
+/* Compact the ids of the index. Must be called with the spec locked for write. Returns the number
+ * of ids reclaimed, or -1 if the index can not be compacted */
+long long DocIdCompact_Run(RedisSearchCtx *sctx);
+
+#ifdef __cplusplus
+}
+#endif
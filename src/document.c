@@ -23,6 +23,9 @@
 #include "geometry/geometry_api.h"
 #include "aggregate/expr/expression.h"
 #include "rmutil/rm_assert.h"
+#include "config.h"
+#include "util/workers_pool.h"
+#include "deps/thpool/thpool.h"
 
 // Memory pool for RSAddDocumentContext contexts
 static mempool_t *actxPool_g = NULL;
@@ -645,6 +648,18 @@ FIELD_PREPROCESSOR(vectorPreprocessor) {
 
 FIELD_BULK_INDEXER(vectorIndexer) {
   IndexSpec *sp = ctx->spec;
+  if (FieldSpec_IsQuantized(fs)) {
+    RedisModuleString *keyName = IndexSpec_GetFormattedKey(sp, fs, INDEXFLD_T_VECTOR);
+    QuantizedIndex *qi = OpenQuantizedVectorIndex(sp, keyName);
+    if (!qi) {
+      QueryError_SetError(status, QUERY_EGENERIC, "Could not open vector for indexing");
+      return -1;
+    }
+    // Quantized fields are single-value
+    QuantizedIndex_Add(qi, fdata->vector, aCtx->doc->docId);
+    sp->stats.numRecords += fdata->numVec;
+    return 0;
+  }
   VecSimIndex *rt = bulk->indexDatas[IXFLDPOS_VECTOR];
   if (!rt) {
     RedisModuleString *keyName = IndexSpec_GetFormattedKey(sp, fs, INDEXFLD_T_VECTOR);
@@ -781,8 +796,11 @@ FIELD_BULK_INDEXER(tagIndexer) {
     }
   }
 
+  ssize_t resized = 0;
   ctx->spec->stats.invertedSize +=
-      TagIndex_Index(tidx, (const char **)fdata->tags, array_len(fdata->tags), aCtx->doc->docId);
+      TagIndex_Index(tidx, (const char **)fdata->tags, array_len(fdata->tags), aCtx->doc->docId,
+                     &resized);
+  ctx->spec->stats.invertedSize += resized;
   ctx->spec->stats.numRecords++;
   return 0;
 }
@@ -838,10 +856,12 @@ void IndexerBulkCleanup(IndexBulkData *cur, RedisSearchCtx *sctx) {
   }
 }
 
-int Document_AddToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+/* Run the preprocessors of the fields of the document - tokenization and stemming of the text
+ * fields into the forward index, parsing of the other fields. The indexes are not touched, so this
+ * can run outside of the write lock of the spec. Returns the spec of the field which failed, with
+ * the error in the status of the context, or NULL on success */
+static const FieldSpec *Document_Preprocess(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
   Document *doc = aCtx->doc;
-  int ourRv = REDISMODULE_OK;
-
   for (size_t i = 0; i < doc->numFields; i++) {
     const FieldSpec *fs = aCtx->fspecs + i;
     DocumentField *ff = doc->fields + i;
@@ -854,10 +874,7 @@ int Document_AddToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
 
       PreprocessorFunc pp = preprocessorMap[ii];
       if (pp(aCtx, sctx, ff, fs, fdata, &aCtx->status) != 0) {
-        IndexError_AddError(&aCtx->spec->stats.indexError, QueryError_GetError(&aCtx->status), doc->docKey);
-        IndexError_AddError(&aCtx->spec->fields[fs->index].indexError, QueryError_GetError(&aCtx->status), doc->docKey);
-        ourRv = REDISMODULE_ERR;
-        goto cleanup;
+        return fs;
       }
       if (!(fs->options & FieldSpec_Dynamic)) {
         // Non-dynamic fields are only indexed as a single type.
@@ -866,6 +883,21 @@ int Document_AddToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
       }
     }
   }
+  return NULL;
+}
+
+/* Add a preprocessed document to the indexes, or drop it if `failed` (the result of
+ * Document_Preprocess) is set. Must be called with the spec locked for write */
+static int Document_AddPreprocessed(RSAddDocumentCtx *aCtx, const FieldSpec *failed) {
+  Document *doc = aCtx->doc;
+  int ourRv = REDISMODULE_OK;
+
+  if (failed) {
+    IndexError_AddError(&aCtx->spec->stats.indexError, QueryError_GetError(&aCtx->status), doc->docKey);
+    IndexError_AddError(&aCtx->spec->fields[failed->index].indexError, QueryError_GetError(&aCtx->status), doc->docKey);
+    ourRv = REDISMODULE_ERR;
+    goto cleanup;
+  }
 
   if (Indexer_Add(aCtx->indexer, aCtx) != 0) {
     ourRv = REDISMODULE_ERR;
@@ -886,6 +918,146 @@ cleanup:
   return ourRv;
 }
 
+int Document_AddToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+  return Document_AddPreprocessed(aCtx, Document_Preprocess(aCtx, sctx));
+}
+
+typedef struct {
+  RSAddDocumentCtx **aCtxs;
+  const FieldSpec **failed;
+  RedisSearchCtx *sctx;
+} PreprocessBatch;
+
+static void preprocessBatchTask(void *ctx, size_t i) {
+  PreprocessBatch *batch = ctx;
+  batch->failed[i] = Document_Preprocess(batch->aCtxs[i], batch->sctx);
+}
+
+#ifdef MT_BUILD
+/* The documents of a batch are preprocessed by the calling thread and by the workers. The calling
+ * thread takes documents as well, and only waits for the documents already taken by the workers,
+ * so a batch never waits on a busy pool. The job is freed by the last thread releasing it, as
+ * late workers may start after the batch is done */
+typedef struct {
+  size_t next;
+  size_t done;
+  size_t refcount;
+  size_t n;
+  PreprocessBatch *batch;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+} PreprocessJob;
+
+static void PreprocessJob_Work(PreprocessJob *job) {
+  size_t i;
+  while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->n) {
+    preprocessBatchTask(job->batch, i);
+    if (__atomic_add_fetch(&job->done, 1, __ATOMIC_ACQ_REL) == job->n) {
+      pthread_mutex_lock(&job->lock);
+      pthread_cond_broadcast(&job->cond);
+      pthread_mutex_unlock(&job->lock);
+    }
+  }
+}
+
+static void PreprocessJob_Release(PreprocessJob *job, size_t n) {
+  if (__atomic_sub_fetch(&job->refcount, n, __ATOMIC_ACQ_REL) == 0) {
+    pthread_mutex_destroy(&job->lock);
+    pthread_cond_destroy(&job->cond);
+    rm_free(job);
+  }
+}
+
+static void PreprocessJob_Worker(void *arg) {
+  PreprocessJob *job = arg;
+  PreprocessJob_Work(job);
+  PreprocessJob_Release(job, 1);
+}
+
+static void preprocessParallel(PreprocessBatch *batch, size_t n) {
+  size_t numJobs = MIN(RSGlobalConfig.numWorkerThreads, n - 1);
+  PreprocessJob *job = rm_malloc(sizeof(*job));
+  *job = (PreprocessJob){.refcount = numJobs + 1, .n = n, .batch = batch};
+  pthread_mutex_init(&job->lock, NULL);
+  pthread_cond_init(&job->cond, NULL);
+
+  redisearch_thpool_work_t *works = rm_malloc(numJobs * sizeof(*works));
+  for (size_t i = 0; i < numJobs; ++i) {
+    works[i] = (redisearch_thpool_work_t){.function_p = PreprocessJob_Worker, .arg_p = job};
+  }
+  if (redisearch_thpool_add_n_work(_workers_thpool, works, numJobs, THPOOL_PRIORITY_HIGH)) {
+    // nothing was submitted, preprocess every document here
+    PreprocessJob_Release(job, numJobs);
+  }
+  rm_free(works);
+
+  PreprocessJob_Work(job);
+  pthread_mutex_lock(&job->lock);
+  while (__atomic_load_n(&job->done, __ATOMIC_ACQUIRE) < n) {
+    pthread_cond_wait(&job->cond, &job->lock);
+  }
+  pthread_mutex_unlock(&job->lock);
+  PreprocessJob_Release(job, 1);
+}
+#endif
+
+void AddDocumentCtx_PreprocessBatch(RSAddDocumentCtx **aCtxs, size_t n, RedisSearchCtx *sctx,
+                                    uint32_t options, const FieldSpec **failed) {
+  RS_LOG_ASSERT(!(options & DOCUMENT_ADD_PARTIAL), "Partial updates can not be batched");
+  for (size_t i = 0; i < n; ++i) {
+    aCtxs[i]->options = options;
+    Document_MakeStringsOwner(aCtxs[i]->doc);
+    aCtxs[i]->sctx = sctx;
+  }
+
+  PreprocessBatch batch = {.aCtxs = aCtxs, .failed = failed, .sctx = sctx};
+#ifdef MT_BUILD
+  if (n > 1 && RSGlobalConfig.mt_mode == MT_MODE_FULL && _workers_thpool) {
+    preprocessParallel(&batch, n);
+  } else
+#endif
+  {
+    for (size_t i = 0; i < n; ++i) {
+      preprocessBatchTask(&batch, i);
+    }
+  }
+}
+
+void AddDocumentCtx_IndexBatch(RSAddDocumentCtx **aCtxs, size_t n, const FieldSpec **failed) {
+  // The documents which were preprocessed are indexed together, so the entries of their terms are
+  // merged
+  RSAddDocumentCtx *head = NULL, *tail = NULL;
+  for (size_t i = 0; i < n; ++i) {
+    if (failed[i]) {
+      Document_AddPreprocessed(aCtxs[i], failed[i]);
+      continue;
+    }
+    if (tail) {
+      tail->next = aCtxs[i];
+    } else {
+      head = aCtxs[i];
+    }
+    tail = aCtxs[i];
+  }
+  if (head) {
+    Indexer_AddBatch(head->indexer, head);
+  }
+}
+
+void AddDocumentCtx_SubmitBatch(RSAddDocumentCtx **aCtxs, size_t n, RedisSearchCtx *sctx,
+                                uint32_t options) {
+  RS_LOG_ASSERT(sctx->flags == RS_CTX_READONLY, "Spec must be locked for read");
+  const FieldSpec **failed = rm_malloc(n * sizeof(*failed));
+  AddDocumentCtx_PreprocessBatch(aCtxs, n, sctx, options, failed);
+
+  // Only the ids assignment and the merge into the indexes need the write lock, and are done in
+  // the order of the batch
+  RedisSearchCtx_UnlockSpec(sctx);
+  RedisSearchCtx_LockSpecWrite(sctx);
+  AddDocumentCtx_IndexBatch(aCtxs, n, failed);
+  rm_free(failed);
+}
+
 /* Evaluate an IF expression (e.g. IF "@foo == 'bar'") against a document, by getting the properties
  * from the sorting table or from the hash representation of the document.
  *
@@ -966,6 +1138,7 @@ static void AddDocumentCtx_UpdateNoIndex(RSAddDocumentCtx *aCtx, RedisSearchCtx
 
   // Update the score
   md->score = doc->score;
+  DocTable_UpdateColumns(&sctx->spec->docs, md);
   // Set the payload if needed
   if (doc->payload) {
     DocTable_SetPayload(&sctx->spec->docs, md, doc->payload, doc->payloadSize);
@@ -324,6 +324,33 @@ RSAddDocumentCtx *NewAddDocumentCtx(IndexSpec *sp, Document *base, QueryError *s
  */
 void AddDocumentCtx_Submit(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx, uint32_t options);
 
+/**
+ * Submit a batch of contexts created for the same spec. The documents are preprocessed -
+ * tokenized, stemmed and their forward indexes built - in parallel on the workers thread pool
+ * (when running in full MT mode), with the spec locked for read. Their ids are then assigned and
+ * they are merged into the indexes in the order of the batch, with the spec locked for write.
+ *
+ * Must be called with the spec of `sctx` locked for read, and returns with it locked for write.
+ * Partial updates can not be batched.
+ */
+void AddDocumentCtx_SubmitBatch(RSAddDocumentCtx **aCtxs, size_t n, RedisSearchCtx *sctx,
+                                uint32_t options);
+
+/**
+ * The two phases of AddDocumentCtx_SubmitBatch, for callers which release the GIL in between.
+ *
+ * AddDocumentCtx_PreprocessBatch preprocesses the documents, and sets in `failed[i]` the field
+ * which failed to be preprocessed for the i'th document, or NULL. It does not touch the indexes,
+ * so the spec does not have to be locked, nor the GIL held if the documents already own their
+ * strings (see Document_MakeStringsOwner). `sctx` must outlive the batch.
+ *
+ * AddDocumentCtx_IndexBatch then indexes the documents, and must be called with the spec locked
+ * for write and the GIL held.
+ */
+void AddDocumentCtx_PreprocessBatch(RSAddDocumentCtx **aCtxs, size_t n, RedisSearchCtx *sctx,
+                                    uint32_t options, const FieldSpec **failed);
+void AddDocumentCtx_IndexBatch(RSAddDocumentCtx **aCtxs, size_t n, const FieldSpec **failed);
+
 /**
  * Indicate that processing is finished on the current document
  */
@@ -597,6 +597,59 @@ void DefaultExpanderFree(void *p) {
   StemmerExpanderFree(p);
 }
 
+/******************************************************************************************
+ *
+ * Term score bounds, used for skipping documents which cannot make it into the top results.
+ * All the bounds assume a document score of at most 1, and ignore the slop (which is at least 1)
+ *
+ ******************************************************************************************/
+
+/* TFIDF: the frequency of a term is normalized by the maximal frequency in the document, so it is
+ * at most 1 */
+static double TFIDFTermBound(const RSIndexStats *stats, const RSIndexResult *r, uint32_t maxFreq,
+                             uint32_t minDocLen) {
+  double idf = r->term.term ? r->term.term->idf : 0;
+  return r->weight * idf;
+}
+
+/* BM25: the score grows with the frequency and tends to the IDF */
+static double BM25TermBound(const RSIndexStats *stats, const RSIndexResult *r, uint32_t maxFreq,
+                            uint32_t minDocLen) {
+  static const float b = 0.5;
+  static const float k1 = 1.2;
+  double idf = r->term.term ? r->term.term->idf : 0;
+  if (!maxFreq) {
+    return idf;
+  }
+  double f = (double)maxFreq;
+  return idf * f / (f + k1 * (1.0f - b + b * stats->avgDocLen));
+}
+
+/* BM25STD: the score grows with the frequency, shrinks with the document length, and tends to
+ * IDF * (k1 + 1) */
+static double BM25StdTermBound(const RSIndexStats *stats, const RSIndexResult *r,
+                               uint32_t maxFreq, uint32_t minDocLen) {
+  static const float b = 0.5f;
+  static const float k1 = 1.2f;
+  double idf = r->term.term ? r->term.term->bm25_idf : 0;
+  if (!maxFreq || stats->avgDocLen == 0) {
+    return idf * (k1 + 1);
+  }
+  double f = (double)maxFreq;
+  return idf * f * (k1 + 1) / (f + k1 * (1.0f - b + b * (float)minDocLen / stats->avgDocLen));
+}
+
+RSTermScoreBound DefaultScorer_GetTermBound(const char *scorerName) {
+  if (!scorerName || !strcmp(scorerName, DEFAULT_SCORER_NAME)) {
+    return TFIDFTermBound;
+  } else if (!strcmp(scorerName, BM25_SCORER_NAME)) {
+    return BM25TermBound;
+  } else if (!strcmp(scorerName, BM25_STD_SCORER_NAME)) {
+    return BM25StdTermBound;
+  }
+  return NULL;
+}
+
 /* Register the default extension */
 int DefaultExtensionInit(RSExtensionCtx *ctx) {
 
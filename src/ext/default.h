@@ -20,6 +20,18 @@
 #define DOCSCORE_SCORER "DOCSCORE"
 #define HAMMINGDISTANCE_SCORER "HAMMING"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 int DefaultExtensionInit(RSExtensionCtx *ctx);
 
+/* Get the term score bound of a default scorer (see RSTermScoreBound), where NULL stands for the
+ * default scorer. Returns NULL if the scorer has no such bound */
+RSTermScoreBound DefaultScorer_GetTermBound(const char *scorerName);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
\ No newline at end of file
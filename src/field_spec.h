@@ -10,6 +10,7 @@
 #include "redisearch.h"
 #include "value.h"
 #include "VecSim/vec_sim.h"
+#include "vector_quant.h"
 #include "geometry/geometry_types.h"
 #include "info/index_error.h"
 #include "info/field_spec_info.h"
@@ -108,6 +109,8 @@ typedef struct FieldSpec {
       VecSimParams vecSimParams;
       // expected size of vector blob.
       size_t expBlobSize;
+      // Quantization of a FLAT index, which is then stored by a QuantizedIndex instead of VecSim.
+      VecSimQuantParams quantParams;
     } vectorOpts;
     struct {
       // Geometry index parameters
@@ -138,6 +141,8 @@ typedef struct FieldSpec {
 #define FieldSpec_IsPhonetics(fs) ((fs)->options & FieldSpec_Phonetics)
 #define FieldSpec_IsIndexable(fs) (0 == ((fs)->options & FieldSpec_NotIndexable))
 #define FieldSpec_HasSuffixTrie(fs) ((fs)->options & FieldSpec_WithSuffixTrie)
+#define FieldSpec_IsQuantized(fs) \
+  (FIELD_IS((fs), INDEXFLD_T_VECTOR) && (fs)->vectorOpts.quantParams.type != VecSimQuant_NONE)
 #define FieldSpec_IsUndefinedOrder(fs) ((fs)->options & FieldSpec_UndefinedOrder)
 #define FieldSpec_IsUnf(fs) ((fs)->options & FieldSpec_UNF)
 
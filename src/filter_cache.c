@@ -0,0 +1,152 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "filter_cache.h"
+#include "index.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+
+#include <pthread.h>
+#include <string.h>
+
+typedef struct {
+  char *key;
+  size_t keyLen;
+  uint64_t revision;
+  uint64_t lastUsed;  // The cache tick in which the entry was last opened
+  t_docId *ids;
+  size_t len;
+  // One reference is held by the cache while the entry is in it, and one by every open iterator
+  uint32_t refcount;
+} FilterCacheEntry;
+
+struct FilterCache {
+  FilterCacheEntry **entries;
+  uint64_t tick;
+  pthread_mutex_t lock;
+};
+
+FilterCache *NewFilterCache(void) {
+  FilterCache *cache = rm_calloc(1, sizeof(*cache));
+  cache->entries = array_new(FilterCacheEntry *, 8);
+  pthread_mutex_init(&cache->lock, NULL);
+  return cache;
+}
+
+static void entry_Decref(void *p) {
+  FilterCacheEntry *e = p;
+  if (__atomic_sub_fetch(&e->refcount, 1, __ATOMIC_ACQ_REL)) {
+    return;
+  }
+  rm_free(e->key);
+  rm_free(e->ids);
+  rm_free(e);
+}
+
+static IndexIterator *entry_Open(FilterCacheEntry *e, double weight) {
+  __atomic_add_fetch(&e->refcount, 1, __ATOMIC_RELAXED);
+  return NewSharedIdListIterator(e->ids, e->len, weight, entry_Decref, e);
+}
+
+/* Remove the entry at position i. Must be called with the lock held */
+static void cache_Remove(FilterCache *cache, uint32_t i) {
+  FilterCacheEntry *e = cache->entries[i];
+  array_del_fast(cache->entries, i);
+  entry_Decref(e);
+}
+
+void FilterCache_Free(FilterCache *cache) {
+  if (!cache) {
+    return;
+  }
+  for (uint32_t i = 0; i < array_len(cache->entries); ++i) {
+    entry_Decref(cache->entries[i]);
+  }
+  array_free(cache->entries);
+  pthread_mutex_destroy(&cache->lock);
+  rm_free(cache);
+}
+
+/* Return the position of the entry of a key, or -1. Must be called with the lock held */
+static int cache_Find(FilterCache *cache, const char *key, size_t len) {
+  for (uint32_t i = 0; i < array_len(cache->entries); ++i) {
+    FilterCacheEntry *e = cache->entries[i];
+    if (e->keyLen == len && !memcmp(e->key, key, len)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+IndexIterator *FilterCache_Open(FilterCache *cache, const char *key, size_t len, uint64_t revision,
+                                double weight) {
+  IndexIterator *ret = NULL;
+  pthread_mutex_lock(&cache->lock);
+  int i = cache_Find(cache, key, len);
+  if (i >= 0) {
+    FilterCacheEntry *e = cache->entries[i];
+    if (e->revision == revision) {
+      e->lastUsed = ++cache->tick;
+      ret = entry_Open(e, weight);
+    } else {
+      cache_Remove(cache, i);
+    }
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return ret;
+}
+
+IndexIterator *FilterCache_Put(FilterCache *cache, const char *key, size_t len, uint64_t revision,
+                               t_docId *ids, size_t n, size_t maxEntries, double weight) {
+  FilterCacheEntry *e = rm_malloc(sizeof(*e));
+  e->key = rm_malloc(len);
+  memcpy(e->key, key, len);
+  e->keyLen = len;
+  e->revision = revision;
+  e->ids = ids;
+  e->len = n;
+  e->refcount = 1;
+  IndexIterator *ret = entry_Open(e, weight);
+
+  pthread_mutex_lock(&cache->lock);
+  // another query may have cached the same key in the meantime
+  int i = cache_Find(cache, key, len);
+  if (i >= 0) {
+    cache_Remove(cache, i);
+  }
+  // drop the stale entries first, and then the least recently used ones
+  for (i = 0; i < array_len(cache->entries);) {
+    if (cache->entries[i]->revision != revision) {
+      cache_Remove(cache, i);
+    } else {
+      ++i;
+    }
+  }
+  while (array_len(cache->entries) && array_len(cache->entries) >= maxEntries) {
+    uint32_t lru = 0;
+    for (uint32_t j = 1; j < array_len(cache->entries); ++j) {
+      if (cache->entries[j]->lastUsed < cache->entries[lru]->lastUsed) {
+        lru = j;
+      }
+    }
+    cache_Remove(cache, lru);
+  }
+  if (maxEntries) {
+    e->lastUsed = ++cache->tick;
+    cache->entries = array_append(cache->entries, e);
+  } else {
+    entry_Decref(e);
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return ret;
+}
+
+size_t FilterCache_Size(FilterCache *cache) {
+  pthread_mutex_lock(&cache->lock);
+  size_t n = array_len(cache->entries);
+  pthread_mutex_unlock(&cache->lock);
+  return n;
+}
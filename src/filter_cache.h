@@ -0,0 +1,49 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "redisearch.h"
+#include "index_iterator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A per-index cache of the document ids matched by filter subtrees of queries (e.g. tag and
+ * numeric filters), keyed by a normalised form of the subtree.
+ *
+ * Every entry is stamped with the revision of the index it was computed at (see
+ * IndexSpec.revision). Adding or deleting documents bumps the revision, so stale entries are never
+ * served - they are dropped when they are next looked up, or when room is needed for new entries.
+ *
+ * Entries are reference counted, so iterators opened over an entry stay valid after it is evicted
+ * or after the cache is freed. The cache may be used by several query threads concurrently.
+ */
+typedef struct FilterCache FilterCache;
+
+FilterCache *NewFilterCache(void);
+
+/* Free the cache. Entries which are still referenced by open iterators are freed with them */
+void FilterCache_Free(FilterCache *cache);
+
+/* Return an iterator over the ids cached for `key` at `revision`, or NULL if there are none */
+IndexIterator *FilterCache_Open(FilterCache *cache, const char *key, size_t len, uint64_t revision,
+                                double weight);
+
+/* Cache the sorted and unique ids matched by `key` at `revision`, evicting the least recently used
+ * entries to keep at most `maxEntries` entries. The cache takes ownership of `ids` (allocated with
+ * rm_malloc). Returns an iterator over the ids */
+IndexIterator *FilterCache_Put(FilterCache *cache, const char *key, size_t len, uint64_t revision,
+                               t_docId *ids, size_t n, size_t maxEntries, double weight);
+
+/* The number of entries in the cache */
+size_t FilterCache_Size(FilterCache *cache);
+
+#ifdef __cplusplus
+}
+#endif
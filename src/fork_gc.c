@@ -25,6 +25,7 @@
 #include "rmutil/rm_assert.h"
 #include "suffix.h"
 #include "resp3.h"
+#include "docid_compact.h"
 
 #define GC_WRITERFD 1
 #define GC_READERFD 0
@@ -537,6 +538,8 @@ FGC_recvRepairedBlock(ForkGC *gc, MSG_RepairedBlock *binfo) {
   if (FGC_recvFixed(gc, binfo, sizeof(*binfo)) != REDISMODULE_OK) {
     return REDISMODULE_ERR;
   }
+  // The skip points are dropped by the repair; never keep a pointer from the child's address space
+  binfo->blk.skips = NULL;
   Buffer *b = &binfo->blk.buf;
   if (FGC_recvBuffer(gc, (void **)&b->data, &b->offset) != REDISMODULE_OK) {
     return REDISMODULE_ERR;
@@ -654,6 +657,7 @@ static void FGC_applyInvertedIndex(ForkGC *gc, InvIdxBuffers *idxData, MSG_Index
     // Blocks that were deleted entirely:
     MSG_DeletedBlock *delinfo = idxData->delBlocks + i;
     rm_free(delinfo->ptr);
+    array_free(idx->blocks[delinfo->oldix].skips);
   }
   TotalIIBlocks -= idxData->numDelBlocks;
   rm_free(idxData->delBlocks);
@@ -716,6 +720,7 @@ static void FGC_applyInvertedIndex(ForkGC *gc, InvIdxBuffers *idxData, MSG_Index
   for (size_t i = 0; i < info->nblocksRepaired; ++i) {
     MSG_RepairedBlock *blockModified = idxData->changedBlocks + i;
     idx->blocks[blockModified->newix] = blockModified->blk;
+    IndexBlock_BuildSkips(&idx->blocks[blockModified->newix], idx->flags);
   }
 
   idx->numDocs -= info->ndocsCollected;
@@ -1098,6 +1103,32 @@ FGCError FGC_parentHandleFromChild(ForkGC *gc) {
   return status;
 }
 
+/* Compact the doc ids of the index after it was cleaned, if they became too sparse or if `force` is
+ * set. Returns the number of ids reclaimed, or -1 if the index can not be compacted */
+static long long FGC_compactDocIds(ForkGC *gc, bool force) {
+  StrongRef spec_ref = WeakRef_Promote(gc->index);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (!sp) {
+    return 0;
+  }
+  long long reclaimed = 0;
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
+  RedisSearchCtx_LockSpecWrite(&sctx);
+  if (force ||
+      DocIdCompact_IsNeeded(sp, RSGlobalConfig.gcConfigParams.forkGc.forkGcCompactDocIdsRatio)) {
+    reclaimed = DocIdCompact_Run(&sctx);
+    RedisModule_Log(gc->ctx, "verbose", "ForkGC in index %s - reclaimed %lld doc ids", sp->name,
+                    reclaimed);
+  }
+  RedisSearchCtx_UnlockSpec(&sctx);
+  StrongRef_Release(spec_ref);
+  return reclaimed;
+}
+
+long long FGC_ForceCompactDocIds(ForkGC *gc) {
+  return FGC_compactDocIds(gc, true);
+}
+
 static int periodicCb(void *privdata) {
   ForkGC *gc = privdata;
   RedisModuleCtx *ctx = gc->ctx;
@@ -1203,6 +1234,10 @@ static int periodicCb(void *privdata) {
     RedisModule_KillForkChild(cpid);
     RedisModule_ThreadSafeContextUnlock(ctx);
 
+    if (gcrv && RSGlobalConfig.gcConfigParams.forkGc.forkGcCompactDocIdsRatio) {
+      FGC_compactDocIds(gc, false);
+    }
+
 #ifdef MT_BUILD
     if (gcrv) {
       gcrv = VecSim_CallTieredIndexesGC(gc->index);
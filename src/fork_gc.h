@@ -110,6 +110,13 @@ void FGC_ForkAndWaitBeforeApply(ForkGC *gc);
  */
 void FGC_Apply(ForkGC *gc);
 
+/**
+ * Compact the doc ids of the index regardless of their sparsity. Must be called from the GC thread,
+ * so it never renumbers the ids while a collection applies the changes its child collected on the
+ * old ids. Returns the number of ids reclaimed, or -1 if the index can not be compacted.
+ */
+long long FGC_ForceCompactDocIds(ForkGC *gc);
+
 #ifdef __cplusplus
 }
 #endif
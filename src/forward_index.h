@@ -21,6 +21,9 @@ typedef struct ForwardIndexEntry {
 
   uint32_t freq;
   t_fieldMask fieldMask;
+  // The length of the document, set by the indexer before the entry is written. Used for the
+  // block statistics of the inverted index
+  uint32_t docLen;
 
   const char *term;
   uint32_t len;
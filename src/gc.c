@@ -161,6 +161,21 @@ void GCContext_ForceBGInvoke(GCContext* gc) {
   GCContext_CommonForceInvoke(gc, NULL);
 }
 
+static void compactDocIdsTaskCallback(void* data) {
+  GCDebugTask *task = data;
+  long long *reclaimed = rm_new(long long);
+  *reclaimed = FGC_ForceCompactDocIds(task->gc->gcCtx);
+  RedisModule_UnblockClient(task->bClient, reclaimed);
+  rm_free(task);
+}
+
+void GCContext_ForceCompactDocIds(GCContext* gc, RedisModuleBlockedClient* bc) {
+  // The GC thread runs one job at a time, so the ids are never renumbered while a collection
+  // applies the changes of its child
+  GCDebugTask *task = GCDebugTaskCreate(gc, bc);
+  redisearch_thpool_add_work(gcThreadpool_g, compactDocIdsTaskCallback, task, THPOOL_PRIORITY_HIGH);
+}
+
 static void GCContext_UnblockClient(void* data) {
   RedisModuleBlockedClient *bc = data;
   RedisModule_BlockedClientMeasureTimeEnd(bc);
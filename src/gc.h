@@ -49,6 +49,9 @@ void GCContext_RenderStatsForInfo(GCContext* gc, RedisModuleInfoCtx* ctx);
 void GCContext_OnDelete(GCContext* gc);
 void GCContext_ForceInvoke(GCContext* gc, RedisModuleBlockedClient* bc);
 void GCContext_ForceBGInvoke(GCContext* gc);
+// Compact the doc ids of the index on the GC thread, after the collections already queued. The
+// number of ids reclaimed is passed to the blocked client as a `long long *`
+void GCContext_ForceCompactDocIds(GCContext* gc, RedisModuleBlockedClient* bc);
 void GCContext_WaitForAllOperations(RedisModuleBlockedClient* bc);
 
 void GC_ThreadPoolStart();
@@ -11,8 +11,10 @@
 #include "rmutil/rm_assert.h"
 #include "query_node.h"
 #include "query_param.h"
+#include "geohash/geohash_helper.h"
+#include <math.h>
+#include <sys/param.h>
 
-static double extractUnitFactor(GeoDistance unit);
 
 /* Parse a geo filter from redis arguments. We assume the filter args start at argv[0], and FILTER
  * is not passed to us.
@@ -72,43 +74,31 @@ void GeoFilter_Free(GeoFilter *gf) {
   rm_free(gf);
 }
 
-static t_docId *geoRangeLoad(const GeoIndex *gi, const GeoFilter *gf, size_t *num) {
-  *num = 0;
-  t_docId *docIds = NULL;
-  RedisModuleString *s = IndexSpec_GetFormattedKey(gi->ctx->spec, gi->sp, INDEXFLD_T_GEO);
-  RS_LOG_ASSERT(s, "failed to retrive key");
-  /*GEORADIUS key longitude latitude radius m|km|ft|mi */
-  RedisModuleCtx *ctx = gi->ctx->redisCtx;
-  RedisModuleString *slon = RedisModule_CreateStringPrintf(ctx, "%f", gf->lon);
-  RedisModuleString *slat = RedisModule_CreateStringPrintf(ctx, "%f", gf->lat);
-  RedisModuleString *srad = RedisModule_CreateStringPrintf(ctx, "%f", gf->radius);
-  const char *unitstr = GeoDistance_ToString(gf->unitType);
-  RedisModuleCallReply *rep =
-      RedisModule_Call(ctx, "GEORADIUS", "ssssc", s, slon, slat, srad, unitstr);
-  if (rep == NULL || RedisModule_CallReplyType(rep) != REDISMODULE_REPLY_ARRAY) {
-    goto done;
-  }
-
-  size_t sz = RedisModule_CallReplyLength(rep);
-  docIds = rm_calloc(sz, sizeof(t_docId));
-  for (size_t i = 0; i < sz; i++) {
-    const char *s = RedisModule_CallReplyStringPtr(RedisModule_CallReplyArrayElement(rep, i), NULL);
-    if (!s) continue;
+static int cmpGeoHashRange(const void *p1, const void *p2) {
+  const GeoHashRange *r1 = p1, *r2 = p2;
+  return r1->min < r2->min ? -1 : r1->min > r2->min;
+}
 
-    docIds[i] = (t_docId)atol(s);
+/* Neighbouring cells of the search area are often adjacent on the geohash curve. Merge the
+ * overlapping and adjacent ranges calculated by calcRanges, moving them to the start of the array,
+ * so that no numeric range is read more than once. Returns the number of merged ranges */
+static size_t mergeGeoHashRanges(GeoHashRange *ranges) {
+  size_t n = 0;
+  for (size_t ii = 0; ii < GEO_RANGE_COUNT; ++ii) {
+    if (ranges[ii].min != ranges[ii].max) {
+      ranges[n++] = ranges[ii];
+    }
   }
-
-  *num = sz;
-
-done:
-  RedisModule_FreeString(ctx, slon);
-  RedisModule_FreeString(ctx, slat);
-  RedisModule_FreeString(ctx, srad);
-  if (rep) {
-    RedisModule_FreeCallReply(rep);
+  qsort(ranges, n, sizeof(*ranges), cmpGeoHashRange);
+  size_t merged = 0;
+  for (size_t ii = 0; ii < n; ++ii) {
+    if (merged && ranges[ii].min <= ranges[merged - 1].max) {
+      ranges[merged - 1].max = MAX(ranges[merged - 1].max, ranges[ii].max);
+    } else {
+      ranges[merged++] = ranges[ii];
+    }
   }
-
-  return docIds;
+  return merged;
 }
 
 IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf, ConcurrentSearchCtx *csx, IteratorsConfig *config) {
@@ -119,23 +109,22 @@ IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf, Con
     return NULL;
   }
 
+  GeoFilter_PrepareArea((GeoFilter *)gf);
   GeoHashRange ranges[GEO_RANGE_COUNT] = {{0}};
-  double radius_meter = gf->radius * extractUnitFactor(gf->unitType);
-  calcRanges(gf->lon, gf->lat, radius_meter, ranges);
+  calcRanges(gf->lon, gf->lat, gf->radiusMeters, ranges);
+  size_t numRanges = mergeGeoHashRanges(ranges);
 
   IndexIterator **iters = rm_calloc(GEO_RANGE_COUNT, sizeof(*iters));
   ((GeoFilter *)gf)->numericFilters = rm_calloc(GEO_RANGE_COUNT, sizeof(*gf->numericFilters));
   size_t itersCount = 0;
-  for (size_t ii = 0; ii < GEO_RANGE_COUNT; ++ii) {
-    if (ranges[ii].min != ranges[ii].max) {
-      NumericFilter *filt = gf->numericFilters[ii] =
-              NewNumericFilter(ranges[ii].min, ranges[ii].max, 1, 1, true);
-      filt->fieldName = rm_strdup(gf->property);
-      filt->geoFilter = gf;
-      struct indexIterator *numIter = NewNumericFilterIterator(ctx, filt, csx, INDEXFLD_T_GEO, config);
-      if (numIter != NULL) {
-        iters[itersCount++] = numIter;
-      }
+  for (size_t ii = 0; ii < numRanges; ++ii) {
+    NumericFilter *filt = gf->numericFilters[ii] =
+            NewNumericFilter(ranges[ii].min, ranges[ii].max, 1, 1, true);
+    filt->fieldName = rm_strdup(gf->property);
+    filt->geoFilter = gf;
+    struct indexIterator *numIter = NewNumericFilterIterator(ctx, filt, csx, INDEXFLD_T_GEO, config);
+    if (numIter != NULL) {
+      iters[itersCount++] = numIter;
     }
   }
 
@@ -238,7 +227,7 @@ double calcGeoHash(double lon, double lat) {
 /**
  * Convert different units to meters
  */
-static double extractUnitFactor(GeoDistance unit) {
+double extractUnitFactor(GeoDistance unit) {
   double rv;
   switch (unit) {
     case GEO_DISTANCE_M:
@@ -276,15 +265,89 @@ static int populateRange(const GeoFilter *gf, GeoHashRange *ranges) {
   return 0;
 }
 
+// The bounding box is widened by this many degrees on every side, so that points on the edge of the
+// search area are never rejected by rounding errors. It only has to be tight enough to be useful
+#define GEO_AREA_MARGIN 1e-6
+
+void GeoFilter_PrepareArea(GeoFilter *gf) {
+  gf->radiusMeters = gf->radius * extractUnitFactor(gf->unitType);
+
+  // The latitudes of the area are within its angular radius from the center. Unless the area
+  // contains a pole, its longitudes are within asin(sin(r) / cos(lat)) from the center - which is
+  // wider than the r / cos(lat) of geohashBoundingBox, as meridians converge away from the center
+  double r = gf->radiusMeters / EARTH_RADIUS_IN_METERS;
+  double lat = gf->lat * M_PI / 180;
+  double minLat = lat - r, maxLat = lat + r;
+  double minLon = -M_PI, maxLon = M_PI;
+  if (minLat > -M_PI_2 && maxLat < M_PI_2) {
+    double dlon = asin(sin(r) / cos(lat));
+    double lon = gf->lon * M_PI / 180;
+    // an area crossing the antimeridian is not bounded in longitude
+    if (lon - dlon > -M_PI && lon + dlon < M_PI) {
+      minLon = lon - dlon;
+      maxLon = lon + dlon;
+    }
+  }
+  gf->bbox[0] = minLon * 180 / M_PI - GEO_AREA_MARGIN;
+  gf->bbox[1] = MAX(minLat, -M_PI_2) * 180 / M_PI - GEO_AREA_MARGIN;
+  gf->bbox[2] = maxLon * 180 / M_PI + GEO_AREA_MARGIN;
+  gf->bbox[3] = MIN(maxLat, M_PI_2) * 180 / M_PI + GEO_AREA_MARGIN;
+}
+
+static inline int GeoFilter_BoxContains(const GeoFilter *gf, double lon, double lat) {
+  return lon >= gf->bbox[0] && lat >= gf->bbox[1] && lon <= gf->bbox[2] && lat <= gf->bbox[3];
+}
+
+int GeoFilter_MayMatchRange(const GeoFilter *gf, double minHash, double maxHash) {
+  // empty ranges have no meaningful bounds
+  if (!(minHash >= 0 && minHash <= maxHash && maxHash < (double)(1ULL << GEO_STEP_MAX * 2))) {
+    return 1;
+  }
+  // The geohash cell enclosing the range is the longest prefix of whole steps (pairs of bits)
+  // shared by both ends of the range
+  uint64_t lo = minHash, hi = maxHash;
+  int step = GEO_STEP_MAX;
+  if (lo != hi) {
+    int highBit = 63 - __builtin_clzll(lo ^ hi);
+    step = (GEO_STEP_MAX * 2 - 1 - highBit) / 2;
+  }
+  if (step <= 0) {
+    return 1;
+  }
+  GeoHashBits cell = {.bits = lo >> (GEO_STEP_MAX - step) * 2, .step = step};
+  GeoHashArea area;
+  if (!geohashDecodeType(cell, &area)) {
+    return 1;
+  }
+  return area.longitude.max >= gf->bbox[0] && area.latitude.max >= gf->bbox[1] &&
+         area.longitude.min <= gf->bbox[2] && area.latitude.min <= gf->bbox[3];
+}
+
 /**
  * Checks if the given coordinate d is within the radius gf
  */
 int isWithinRadius(const GeoFilter *gf, double d, double *distance) {
   double xy[2];
   decodeGeo(d, xy);
-  double radius_meters = gf->radius * extractUnitFactor(gf->unitType);
-  int rv = isWithinRadiusLonLat(gf->lon, gf->lat, xy[0], xy[1], radius_meters, distance);
-  return rv;
+  // most of the points outside the radius are rejected by the bounding box, without computing
+  // their distance
+  if (!GeoFilter_BoxContains(gf, xy[0], xy[1])) {
+    return 0;
+  }
+  return isWithinRadiusLonLat(gf->lon, gf->lat, xy[0], xy[1], gf->radiusMeters, distance);
+}
+
+size_t GeoFilter_FilterPoints(const GeoFilter *gf, t_docId *ids, double *values, size_t n) {
+  size_t kept = 0;
+  for (size_t i = 0; i < n; ++i) {
+    double distance;
+    if (isWithinRadius(gf, values[i], &distance)) {
+      ids[kept] = ids[i];
+      values[kept] = distance;
+      ++kept;
+    }
+  }
+  return kept;
 }
 
 static int checkResult(const GeoFilter *gf, const RSIndexResult *cur) {
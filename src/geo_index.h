@@ -44,8 +44,17 @@ typedef struct GeoFilter {
   double radius;
   GeoDistance unitType;
   NumericFilter **numericFilters;
+  // The search area, set by GeoFilter_PrepareArea when the filter's iterator is opened: the radius
+  // in meters, and a bounding box (min lon, min lat, max lon, max lat) of the points within it
+  double radiusMeters;
+  double bbox[4];
+  // If set, only the `knn` documents nearest to the center are matched, in increasing distance
+  size_t knn;
 } GeoFilter;
 
+/* A geo node which matches the k documents nearest to its center. It must be the root of the query */
+#define QueryNode_IsGeoKnn(qn) ((qn)->type == QN_GEO && (qn)->gn.gf->knn)
+
 /* Create a geo filter from parsed strings and numbers */
 GeoFilter *NewGeoFilter(double lon, double lat, double radius, const char *unit, size_t unit_len);
 
@@ -70,3 +79,17 @@ IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf, Con
 #define INVALID_GEOHASH -1.0
 double calcGeoHash(double lon, double lat);
 int isWithinRadius(const GeoFilter *gf, double d, double *distance);
+/* The number of meters in a distance unit */
+double extractUnitFactor(GeoDistance unit);
+
+/* Compute the search area of the filter. Called by NewGeoRangeIterator */
+void GeoFilter_PrepareArea(GeoFilter *gf);
+
+/* Return 0 if none of the geohashes between `minHash` and `maxHash` can be within the radius of
+ * the filter, i.e. if the geohash cell enclosing them does not meet the search area */
+int GeoFilter_MayMatchRange(const GeoFilter *gf, double minHash, double maxHash);
+
+/* Keep only the points within the radius of the filter, compacting the ids and geohashes arrays in
+ * place, and replace the geohashes of the kept points with their distances from the center.
+ * Returns the number of points kept */
+size_t GeoFilter_FilterPoints(const GeoFilter *gf, t_docId *ids, double *values, size_t n);
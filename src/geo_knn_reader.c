@@ -0,0 +1,231 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "geo_knn_reader.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+#include <math.h>
+#include <sys/param.h>
+
+// The radius of the first ring is the radius of the filter divided by this factor
+#define GEO_KNN_FIRST_RING_DIVISOR 1024
+
+#define GEO_KNN_DISTANCE(r) \
+  ((r)->type == RSResultType_Metric ? (r)->num.value : (r)->agg.children[0]->num.value)
+
+static int cmpByDistance(const void *p1, const void *p2) {
+  const RSIndexResult *r1 = *(const RSIndexResult **)p1, *r2 = *(const RSIndexResult **)p2;
+  double d1 = GEO_KNN_DISTANCE(r1), d2 = GEO_KNN_DISTANCE(r2);
+  if (d1 != d2) {
+    return d1 < d2 ? -1 : 1;
+  }
+  return r1->docId < r2->docId ? -1 : r1->docId > r2->docId;
+}
+
+static int cmpDocIds(const void *p1, const void *p2) {
+  t_docId d1 = *(const t_docId *)p1, d2 = *(const t_docId *)p2;
+  return d1 < d2 ? -1 : d1 > d2;
+}
+
+/* The distance of a result of the geo range iterator. The union of the ranges exits on the first
+ * range which has the document, and the readers skip the other points of a document, so for
+ * documents with several points this is the first point read within the ring, which is not
+ * necessarily the nearest one */
+static double geoResultDistance(const RSIndexResult *r) {
+  if (r->type != RSResultType_Union) {
+    return r->num.value;
+  }
+  double distance = INFINITY;
+  for (int i = 0; i < r->agg.numChildren; ++i) {
+    distance = MIN(distance, geoResultDistance(r->agg.children[i]));
+  }
+  return distance;
+}
+
+static void GKR_AddResult(GeoKnnIterator *it, t_docId docId, double distance,
+                          RSIndexResult *childRes) {
+  RSIndexResult *metric = NewMetricResult();
+  metric->docId = docId;
+  metric->num.value = distance / it->unitFactor;
+
+  RSIndexResult *hit = metric;
+  if (childRes && !it->ignoreScores) {
+    // The first child is the distance, and the second is the result of the rest of the query
+    RSIndexResult *res = it->base.current;
+    AggregateResult_AddChild(res, metric);
+    AggregateResult_AddChild(res, childRes);
+    hit = IndexResult_DeepCopy(res);
+    AggregateResult_Reset(res);
+    IndexResult_Free(metric);
+  }
+  ResultMetrics_Add(hit, it->base.ownKey, RS_NumVal(distance / it->unitFactor));
+  it->results = array_append(it->results, hit);
+}
+
+/* Search the next ring around the center, adding the documents which are further than the previous
+ * ring and match the child to the results, sorted by their distance. Returns 0 if the radius of
+ * the filter was already searched */
+static int GKR_SearchRing(GeoKnnIterator *it) {
+  double maxRadius = it->gf->radius * it->unitFactor;
+  if (it->radius >= maxRadius) {
+    return 0;
+  }
+  double inner = it->radius;
+  it->radius = inner ? MIN(inner * 2, maxRadius) : maxRadius / GEO_KNN_FIRST_RING_DIVISOR;
+  ++it->numRings;
+
+  // the documents yielded by the previous rings, for skipping documents with several points
+  size_t numReturned = array_len(it->results);
+  t_docId *returned = NULL;
+  if (numReturned) {
+    returned = rm_malloc(numReturned * sizeof(*returned));
+    for (size_t i = 0; i < numReturned; ++i) {
+      returned[i] = it->results[i]->docId;
+    }
+    qsort(returned, numReturned, sizeof(*returned), cmpDocIds);
+  }
+
+  GeoFilter *ring = NewGeoFilter(it->gf->lon, it->gf->lat, it->radius, "m", 1);
+  ring->property = rm_strdup(it->gf->property);
+  IndexIterator *geo = NewGeoRangeIterator(it->sctx, ring, NULL, it->config);
+
+  if (geo) {
+    RSIndexResult *geoRes = NULL, *childRes = NULL;
+    if (it->child) {
+      it->child->Rewind(it->child->ctx);
+    }
+    int rc = geo->Read(geo->ctx, &geoRes);
+    while (rc == INDEXREAD_OK || rc == INDEXREAD_NOTFOUND) {
+      if (it->child) {
+        if (!childRes || childRes->docId < geoRes->docId) {
+          if (it->child->SkipTo(it->child->ctx, geoRes->docId, &childRes) == INDEXREAD_EOF) {
+            break;
+          }
+        }
+        if (childRes->docId != geoRes->docId) {
+          rc = geo->SkipTo(geo->ctx, childRes->docId, &geoRes);
+          continue;
+        }
+      }
+      double distance = geoResultDistance(geoRes);
+      if (distance > inner && !(returned && bsearch(&geoRes->docId, returned, numReturned,
+                                                    sizeof(*returned), cmpDocIds))) {
+        GKR_AddResult(it, geoRes->docId, distance, childRes);
+      }
+      rc = geo->Read(geo->ctx, &geoRes);
+    }
+    geo->Free(geo);
+  }
+  GeoFilter_Free(ring);
+  rm_free(returned);
+
+  // keep only the nearest documents of the ring which are needed to complete the k results
+  size_t n = array_len(it->results);
+  qsort(it->results + numReturned, n - numReturned, sizeof(*it->results), cmpByDistance);
+  while (array_len(it->results) > it->gf->knn) {
+    IndexResult_Free(array_pop(it->results));
+  }
+  return 1;
+}
+
+static int GKR_HasNext(void *ctx) {
+  GeoKnnIterator *it = ctx;
+  return it->base.isValid;
+}
+
+static int GKR_Read(void *ctx, RSIndexResult **hit) {
+  GeoKnnIterator *it = ctx;
+  while (it->pos == array_len(it->results)) {
+    if (!it->base.isValid || it->pos >= it->gf->knn || !GKR_SearchRing(it)) {
+      it->base.isValid = 0;
+      return INDEXREAD_EOF;
+    }
+  }
+  *hit = it->results[it->pos++];
+  it->lastDocId = (*hit)->docId;
+  return INDEXREAD_OK;
+}
+
+static size_t GKR_NumEstimated(void *ctx) {
+  GeoKnnIterator *it = ctx;
+  if (it->child == NULL) return it->gf->knn;
+  return MIN(it->gf->knn, it->child->NumEstimated(it->child->ctx));
+}
+
+static size_t GKR_Len(void *ctx) {
+  return GKR_NumEstimated(ctx);
+}
+
+static void GKR_Abort(void *ctx) {
+  GeoKnnIterator *it = ctx;
+  it->base.isValid = 0;
+}
+
+static t_docId GKR_LastDocId(void *ctx) {
+  GeoKnnIterator *it = ctx;
+  return it->lastDocId;
+}
+
+static void GKR_Rewind(void *ctx) {
+  GeoKnnIterator *it = ctx;
+  for (size_t i = 0; i < array_len(it->results); ++i) {
+    IndexResult_Free(it->results[i]);
+  }
+  array_clear(it->results);
+  it->radius = 0;
+  it->numRings = 0;
+  it->pos = 0;
+  it->lastDocId = 0;
+  it->base.isValid = 1;
+}
+
+static void GeoKnnIterator_Free(struct indexIterator *self) {
+  GeoKnnIterator *it = self->ctx;
+  if (it == NULL) {
+    return;
+  }
+  array_free_ex(it->results, IndexResult_Free(*(RSIndexResult **)ptr));
+  IndexResult_Free(it->base.current);
+  if (it->child) {
+    it->child->Free(it->child);
+  }
+  rm_free(it);
+}
+
+IndexIterator *NewGeoKnnIterator(RedisSearchCtx *sctx, const GeoFilter *gf, IndexIterator *child,
+                                 bool ignoreScores, IteratorsConfig *config) {
+  GeoKnnIterator *it = rm_new(GeoKnnIterator);
+  it->sctx = sctx;
+  it->gf = gf;
+  it->config = config;
+  it->child = child;
+  it->ignoreScores = ignoreScores;
+  it->unitFactor = extractUnitFactor(gf->unitType);
+  it->radius = 0;
+  it->numRings = 0;
+  it->results = array_new(RSIndexResult *, MIN(gf->knn, 1024));
+  it->pos = 0;
+  it->lastDocId = 0;
+
+  IndexIterator *ri = &it->base;
+  ri->ctx = it;
+  // This will be changed later to a valid RLookupKey if the distance is yielded,
+  // by the creation of the metrics loader results processor.
+  ri->ownKey = NULL;
+  ri->isValid = 1;
+  ri->type = GEO_KNN_ITERATOR;
+  ri->NumEstimated = GKR_NumEstimated;
+  ri->LastDocId = GKR_LastDocId;
+  ri->Free = GeoKnnIterator_Free;
+  ri->Len = GKR_Len;
+  ri->Abort = GKR_Abort;
+  ri->Rewind = GKR_Rewind;
+  ri->HasNext = GKR_HasNext;
+  ri->Read = GKR_Read;
+  ri->SkipTo = NULL;  // The results are returned by distance, unsorted by id
+  ri->current = child && !ignoreScores ? NewHybridResult() : NewMetricResult();
+  return ri;
+}
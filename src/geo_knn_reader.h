@@ -0,0 +1,50 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "index_iterator.h"
+#include "redisearch.h"
+#include "search_ctx.h"
+#include "geo_index.h"
+
+/* Returns the k documents of a geo field which are nearest to a point, in increasing distance.
+ *
+ * The documents are searched in rings around the point: the first ring is a small fraction of the
+ * radius of the filter, and every following ring doubles the previous one, until k documents
+ * matching the child iterator (the rest of the query) are found or the radius of the filter is
+ * reached. Every ring is sorted by distance before it is yielded, so only the rings needed for the
+ * k nearest documents are ever read. Documents with several points are ordered by the distance of
+ * the first of their points read within the ring where they are found */
+typedef struct {
+  IndexIterator base;
+  RedisSearchCtx *sctx;
+  const GeoFilter *gf;
+  IteratorsConfig *config;
+  IndexIterator *child;       // The rest of the query, or NULL
+  bool ignoreScores;          // Ignore the document scores, only the distance matters.
+
+  double unitFactor;          // Meters in a unit of the filter, for yielding the distances
+  double radius;              // The outer radius of the last searched ring, in meters
+  size_t numRings;            // The number of rings searched
+  RSIndexResult **results;    // The results of the searched rings, in increasing distance
+  size_t pos;                 // The position of the next result to return
+  t_docId lastDocId;
+} GeoKnnIterator;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Create an iterator over the `gf->knn` documents nearest to the center of `gf`, which are
+ * within its radius and match `child` (which may be NULL). The iterator takes ownership of the
+ * child */
+IndexIterator *NewGeoKnnIterator(RedisSearchCtx *sctx, const GeoFilter *gf, IndexIterator *child,
+                                 bool ignoreScores, IteratorsConfig *config);
+
+#ifdef __cplusplus
+}
+#endif
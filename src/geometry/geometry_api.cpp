@@ -69,6 +69,10 @@ namespace {
   std::size_t Index_##variant##_Report(const GeometryIndex *idx) {                          \
     return std::get<rtree_ptr<variant>>(idx->index)->report();                              \
   }                                                                                         \
+  void Index_##variant##_Remap(GeometryIndex *idx, t_docId (*remap)(void *, t_docId),       \
+                               void *ctx) {                                                 \
+    std::get<rtree_ptr<variant>>(idx->index)->remap(remap, ctx);                            \
+  }                                                                                         \
   constexpr GeometryApi GeometryApi_##variant = {                                           \
       .freeIndex = Index_##variant##_Free,                                                  \
       .addGeomStr = Index_##variant##_Insert,                                               \
@@ -76,14 +80,15 @@ namespace {
       .query = Index_##variant##_Query,                                                     \
       .dump = Index_##variant##_Dump,                                                       \
       .report = Index_##variant##_Report,                                                   \
+      .remap = Index_##variant##_Remap,                                                     \
   };                                                                                        \
-  auto Index_##variant##_New() -> GeometryIndex * {                                         \
+  auto Index_##variant##_New(const GeometryJobQueue *jobQueue) -> GeometryIndex * {         \
     using alloc_type = Allocator<GeometryIndex>;                                            \
     alloc_type alloc;                                                                       \
     const auto idx = std::allocator_traits<alloc_type>::allocate(alloc, 1);                 \
     std::allocator_traits<alloc_type>::construct(                                           \
         alloc, idx, &GeometryApi_##variant,                                                 \
-        boost::allocate_unique<RTree<variant>>(Allocator<RTree<variant>>{}));               \
+        boost::allocate_unique<RTree<variant>>(Allocator<RTree<variant>>{}, jobQueue));     \
     return idx;                                                                             \
   }
 GEO_VARIANTS(X)
@@ -91,9 +96,10 @@ GEO_VARIANTS(X)
 }  // anonymous namespace
 
 #define X(variant) Index_##variant##_New,
-auto GeometryIndexFactory(GEOMETRY_COORDS tag) -> GeometryIndex * {
+auto GeometryIndexFactory(GEOMETRY_COORDS tag, const GeometryJobQueue *jobQueue)
+    -> GeometryIndex * {
   static constexpr auto geometry_ctors = std::array{GEO_VARIANTS(X)};
-  return geometry_ctors[tag]();
+  return geometry_ctors[tag](jobQueue);
 }
 #undef X
 
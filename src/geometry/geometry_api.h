@@ -15,7 +15,8 @@
 extern "C" {
 #endif
 
-GeometryIndex *GeometryIndexFactory(GEOMETRY_COORDS tag);
+// `jobQueue` may be NULL, in which case the queries of the index run on the calling thread only
+GeometryIndex *GeometryIndexFactory(GEOMETRY_COORDS tag, const GeometryJobQueue *jobQueue);
 const GeometryApi *GeometryApi_Get(const GeometryIndex *index);
 const char *GeometryCoordsToName(GEOMETRY_COORDS tag);
 
@@ -28,6 +29,9 @@ struct GeometryApi {
                           const char *str, size_t len, RedisModuleString **err_msg);
   void (*dump)(const GeometryIndex *index, RedisModuleCtx *ctx);
   size_t (*report)(const GeometryIndex *index);
+  // Renumber the documents of the index with `remap`, which returns the new id of a document, or 0
+  // to drop it
+  void (*remap)(GeometryIndex *index, t_docId (*remap)(void *ctx, t_docId docId), void *ctx);
 };
 
 #ifdef __cplusplus
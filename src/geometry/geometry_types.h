@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #define GEO_VARIANTS(X) X(Cartesian) X(Geographic)
 
 typedef struct GeometryIndex GeometryIndex;
@@ -39,3 +41,14 @@ typedef enum QueryType {
   DISJOINT,
   INTERSECTS,
 } QueryType;
+
+// Submits `n` jobs running `cb(arg)` to `jobQueue`. Returns 0 if all the jobs were submitted, and
+// non-zero if none were.
+typedef int (*GeometrySubmitCB)(void *jobQueue, void (*cb)(void *), void *arg, size_t n);
+
+// A job queue for running the exact predicate of large geometry queries in parallel.
+typedef struct {
+  void *jobQueue;             // NULL if the queries run on the calling thread only
+  size_t numThreads;          // The number of threads consuming the queue
+  GeometrySubmitCB submitCb;
+} GeometryJobQueue;
@@ -12,6 +12,7 @@
 #include <vector>     // std::vector
 #include <ranges>     // ranges::input_range, ranges::begin, ranges::end
 #include <algorithm>  // ranges::sort
+#include <utility>    // std::move
 
 namespace RediSearch {
 namespace GeoShape {
@@ -36,6 +37,11 @@ struct QueryIterator {
     std::ranges::sort(iter_, std::ranges::less{}, proj);
   }
 
+  explicit QueryIterator(container_type &&docs)
+      : base_{init_base(this)}, iter_{std::move(docs)}, index_{0} {
+    std::ranges::sort(iter_);
+  }
+
   /* rule of 5 */
   explicit QueryIterator(QueryIterator const &) = delete;
   explicit QueryIterator(QueryIterator &&) = delete;
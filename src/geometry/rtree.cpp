@@ -6,12 +6,15 @@
 
 #include "rtree.hpp"
 
-#include <string>     // std::string, std::char_traits
-#include <sstream>    // std::stringstream
-#include <algorithm>  // ranges::for_each, views::transform
-#include <exception>  // std::exception
-#include <execution>  // std::unseq
-#include <numeric>    // std::transform_reduce
+#include <string>              // std::string, std::char_traits
+#include <sstream>             // std::stringstream
+#include <algorithm>           // ranges::for_each, views::transform
+#include <exception>           // std::exception, std::exception_ptr
+#include <execution>           // std::unseq
+#include <numeric>             // std::transform_reduce
+#include <atomic>              // std::atomic_size_t
+#include <iterator>            // std::back_inserter
+#include <condition_variable>  // std::condition_variable
 
 namespace RediSearch {
 namespace GeoShape {
@@ -155,13 +158,92 @@ constexpr auto within_filter = overload{
 template <typename cs>
 constexpr auto intersects_filter =
     [](auto const& geom1, auto const& geom2) -> bool { return bg::intersects(geom1, geom2); };
+
+// Runs `num_tasks` tasks on the calling thread and on the threads of a job queue.
+// The calling thread takes tasks as well, and only waits for the tasks already taken by the queue,
+// so a query which is itself running on a thread of the queue can not wait on a busy queue.
+// The job is freed by the last thread releasing it, as late jobs may start after the query ended.
+struct ParallelJob {
+  std::atomic_size_t next_task;
+  std::atomic_size_t done_tasks;
+  std::atomic_size_t refcount;
+  const std::size_t num_tasks;
+  void (*const run)(void* ctx, std::size_t task);
+  void* const ctx;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::exception_ptr error;  // The first error thrown by a task, guarded by `mutex`
+
+  ParallelJob(std::size_t refs, std::size_t tasks, void (*fn)(void*, std::size_t), void* fn_ctx)
+      : next_task{0}, done_tasks{0}, refcount{refs}, num_tasks{tasks}, run{fn}, ctx{fn_ctx} {
+  }
+
+  void work() {
+    for (auto task = next_task++; task < num_tasks; task = next_task++) {
+      try {
+        run(ctx, task);
+      } catch (...) {
+        std::lock_guard lock{mutex};
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      if (++done_tasks == num_tasks) {
+        std::lock_guard lock{mutex};
+        cv.notify_all();
+      }
+    }
+  }
+
+  void release(std::size_t n = 1) {
+    if (refcount.fetch_sub(n) == n) {
+      using alloc_type = Allocator::Allocator<ParallelJob>;
+      alloc_type alloc;
+      std::allocator_traits<alloc_type>::destroy(alloc, this);
+      std::allocator_traits<alloc_type>::deallocate(alloc, this, 1);
+    }
+  }
+
+  static void worker(void* arg) {
+    const auto job = static_cast<ParallelJob*>(arg);
+    job->work();
+    job->release();
+  }
+};
+
+template <typename F>
+void run_parallel(GeometryJobQueue const& queue, std::size_t num_tasks, F& f) {
+  using alloc_type = Allocator::Allocator<ParallelJob>;
+  alloc_type alloc;
+  const auto num_jobs = std::min(queue.numThreads, num_tasks - 1);
+  const auto job = std::allocator_traits<alloc_type>::allocate(alloc, 1);
+  std::allocator_traits<alloc_type>::construct(
+      alloc, job, num_jobs + 1, num_tasks,
+      [](void* ctx, std::size_t task) { (*static_cast<F*>(ctx))(task); }, &f);
+  if (queue.submitCb(queue.jobQueue, ParallelJob::worker, job, num_jobs)) {
+    job->release(num_jobs);  // nothing was submitted, run every task here
+  }
+  job->work();
+  auto error = [job]() {
+    auto lock = std::unique_lock{job->mutex};
+    job->cv.wait(lock, [job] { return job->done_tasks == job->num_tasks; });
+    return job->error;
+  }();
+  job->release();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
 }  // anonymous namespace
 
 template <typename cs>
-RTree<cs>::RTree()
+RTree<cs>::RTree(GeometryJobQueue const* jobQueue)
     : allocated_{sizeof *this},
       rtree_{{}, {}, {}, doc_alloc{allocated_}},
-      docLookup_{0, lookup_alloc{allocated_}} {
+      pending_{doc_alloc{allocated_}},
+      flush_mutex_{},
+      docLookup_{0, lookup_alloc{allocated_}},
+      jobQueue_{jobQueue ? *jobQueue : GeometryJobQueue{}} {
 }
 
 template <typename cs>
@@ -179,10 +261,33 @@ auto RTree<cs>::lookup(doc_type const& doc) const -> boost::optional<geom_type c
 template <typename cs>
 void RTree<cs>::insert(geom_type const& geom, t_docId id) {
   docLookup_.insert(lookup_type{id, geom});
-  rtree_.insert(make_doc<cs>(geom, id));
+  pending_.push_back(make_doc<cs>(geom, id));
   allocated_ += std::visit(geometry_reporter<cs>, geom);
 }
 
+template <typename cs>
+void RTree<cs>::flush() const {
+  std::lock_guard lock{flush_mutex_};
+  if (pending_.empty()) {
+    return;
+  }
+  // documents removed before they were flushed are only missing from the lookup table.
+  // document ids are only reused by remap, which flushes first, so a pending document is never
+  // shadowed by a newer one.
+  std::erase_if(pending_, [this](doc_type const& doc) -> bool { return !lookup(doc); });
+  if (pending_.size() < rtree_.size()) {
+    rtree_.insert(std::begin(pending_), std::end(pending_));
+  } else {
+    // the packing constructor sorts the documents into tiles (STR), producing a tree with full
+    // and barely overlapping nodes in O(n log n), much faster than inserting them one by one.
+    pending_.insert(std::end(pending_), std::begin(rtree_), std::end(rtree_));
+    auto packed = rtree_type{pending_, {}, {}, {}, rtree_.get_allocator()};
+    rtree_.swap(packed);
+  }
+  pending_.clear();
+  pending_.shrink_to_fit();
+}
+
 template <typename cs>
 int RTree<cs>::insertWKT(std::string_view wkt, t_docId id, RedisModuleString** err_msg) {
   try {
@@ -201,15 +306,39 @@ bool RTree<cs>::remove(t_docId id) {
   return lookup(id)
       .map([&](geom_type const& geom) {
         allocated_ -= std::visit(geometry_reporter<cs>, geom);
-        rtree_.remove(make_doc<cs>(geom, id));
+        rtree_.remove(make_doc<cs>(geom, id));  // a pending document is dropped by the next flush
         docLookup_.erase(id);
         return true;
       })
       .value_or(false);
 }
 
+template <typename cs>
+void RTree<cs>::remap(t_docId (*fn)(void* ctx, t_docId id), void* ctx) {
+  flush();
+  auto docs = std::vector<doc_type, doc_alloc>{doc_alloc{allocated_}};
+  docs.reserve(docLookup_.size());
+  auto lookup = LUT_type{0, lookup_alloc{allocated_}};
+  lookup.reserve(docLookup_.size());
+  // no structured bindings, boost::geometry::get would be found for them by ADL
+  for (auto& doc : docLookup_) {
+    auto& geom = doc.second;
+    if (const auto new_id = fn(ctx, doc.first)) {
+      docs.push_back(make_doc<cs>(geom, new_id));
+      lookup.insert(lookup_type{new_id, std::move(geom)});
+    } else {
+      allocated_ -= std::visit(geometry_reporter<cs>, geom);
+    }
+  }
+  docLookup_.swap(lookup);
+  // pack the tree from scratch, as flush does when most documents are pending
+  auto packed = rtree_type{docs, {}, {}, {}, rtree_.get_allocator()};
+  rtree_.swap(packed);
+}
+
 template <typename cs>
 void RTree<cs>::dump(RedisModuleCtx* ctx) const {
+  flush();
   RedisModule_ReplyWithArray(ctx, 8);
 
   RedisModule_ReplyWithStringBuffer(ctx, "type", std::strlen("type"));
@@ -251,18 +380,51 @@ std::size_t RTree<cs>::report() const noexcept {
   return allocated_;
 }
 
+template <typename cs>
+template <typename Filter>
+void RTree<cs>::refine(ids_type& ids, Filter const& filter) const {
+  using flags_type = std::vector<char, Allocator::TrackingAllocator<char>>;
+  auto matches = flags_type(ids.size(), false, Allocator::TrackingAllocator<char>{allocated_});
+  auto refine_chunk = [&](std::size_t chunk) -> void {
+    const auto first = chunk * REFINE_CHUNK_SIZE;
+    const auto last = std::min(first + REFINE_CHUNK_SIZE, ids.size());
+    for (auto i = first; i < last; ++i) {
+      matches[i] = lookup(ids[i]).map(filter).value_or(false);
+    }
+  };
+
+  const auto num_chunks = (ids.size() + REFINE_CHUNK_SIZE - 1) / REFINE_CHUNK_SIZE;
+  if (num_chunks > 1 && jobQueue_.jobQueue && jobQueue_.numThreads) {
+    run_parallel(jobQueue_, num_chunks, refine_chunk);
+  } else {
+    for (auto chunk = std::size_t{0}; chunk < num_chunks; ++chunk) {
+      refine_chunk(chunk);
+    }
+  }
+
+  auto out = std::begin(ids);
+  for (auto i = std::size_t{0}; i < ids.size(); ++i) {
+    if (matches[i]) {
+      *out++ = ids[i];
+    }
+  }
+  ids.erase(out, std::end(ids));
+}
+
 template <typename cs>
 template <typename Predicate, typename Filter>
-auto RTree<cs>::apply_predicate(Predicate&& predicate, Filter&& filter) const -> query_results {
-  return rtree_.qbegin(std::forward<Predicate>(predicate) &&
-                       bgi::satisfies([this, f = std::move(filter)](doc_type const& doc) -> bool {
-                         return lookup(doc).map(f).value_or(false);
-                       }));
+auto RTree<cs>::apply_predicate(Predicate&& predicate, Filter&& filter) const -> ids_type {
+  // the tree only compares the bounding boxes, the candidates are refined by the exact predicate
+  auto ids = ids_type{Allocator::TrackingAllocator<t_docId>{allocated_}};
+  std::ranges::transform(rtree_.qbegin(std::forward<Predicate>(predicate)), rtree_.qend(),
+                         std::back_inserter(ids), get_id<cs>);
+  refine(ids, filter);
+  return ids;
 }
 
 template <typename cs>
-auto RTree<cs>::query_begin(QueryType query_type, geom_type const& query_geom) const
-    -> query_results {
+auto RTree<cs>::query_ids(QueryType query_type, geom_type const& query_geom) const
+    -> ids_type {
   const auto query_mbr = get_rect<cs>(make_doc<cs>(query_geom));
   switch (query_type) {
     case QueryType::CONTAINS:  // contains(g1, g2) == within(g2, g1)
@@ -293,11 +455,10 @@ auto RTree<cs>::query(std::string_view wkt, QueryType query_type, RedisModuleStr
     using alloc_type = Allocator::TrackingAllocator<QueryIterator>;
     auto alloc = alloc_type{allocated_};
     const auto query_geom = from_wkt<cs>(wkt);
-    const auto qbegin = query_begin(query_type, query_geom);
-    const auto results =
-        std::ranges::subrange{qbegin, rtree_.qend()} | std::views::transform(get_id<cs>);
+    flush();
+    auto results = query_ids(query_type, query_geom);
     const auto qi = std::allocator_traits<alloc_type>::allocate(alloc, 1);
-    std::allocator_traits<alloc_type>::construct(alloc, qi, results, allocated_);
+    std::allocator_traits<alloc_type>::construct(alloc, qi, std::move(results));
     return qi->base();
   } catch (const std::exception& e) {
     if (err_msg) {
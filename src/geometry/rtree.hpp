@@ -12,6 +12,7 @@
 #include "query_iterator.hpp"
 #include "geometry_types.h"
 
+#include <mutex>                                   // std::mutex
 #include <vector>                                  // std::vector
 #include <variant>                                 // std::variant
 #include <utility>                                 // std::pair
@@ -52,18 +53,28 @@ class RTree {
   using LUT_type = boost::unordered_flat_map<t_docId, geom_type, std::hash<t_docId>,
                                              std::equal_to<t_docId>, lookup_alloc>;
 
-  using query_results = rtree_type::const_query_iterator;
+  using ids_type = QueryIterator::container_type;
+
+  // The number of candidates refined by a single task when the refinement runs in parallel
+  static constexpr std::size_t REFINE_CHUNK_SIZE = 1024;
 
  private:
   mutable std::size_t allocated_;
-  rtree_type rtree_;
+  // Inserted documents are buffered and only added to the tree by the next query. If at least as
+  // many documents are pending as are already indexed (e.g. on RDB load or reindex), the tree is
+  // packed from scratch instead of growing one insertion at a time.
+  mutable rtree_type rtree_;
+  mutable std::vector<doc_type, doc_alloc> pending_;
+  mutable std::mutex flush_mutex_;
   LUT_type docLookup_;
+  GeometryJobQueue jobQueue_;
 
  public:
-  explicit RTree();
+  explicit RTree(GeometryJobQueue const* jobQueue = nullptr);
 
   int insertWKT(std::string_view wkt, t_docId id, RedisModuleString** err_msg);
   bool remove(t_docId id);
+  void remap(t_docId (*fn)(void* ctx, t_docId id), void* ctx);
   [[nodiscard]] auto query(std::string_view wkt, QueryType query_type,
                            RedisModuleString** err_msg) const -> IndexIterator*;
 
@@ -74,12 +85,14 @@ class RTree {
   [[nodiscard]] auto lookup(t_docId id) const -> boost::optional<geom_type const&>;
   [[nodiscard]] auto lookup(doc_type const& doc) const -> boost::optional<geom_type const&>;
   void insert(geom_type const& geom, t_docId id);
+  void flush() const;
 
+  template <typename Filter>
+  void refine(ids_type& ids, Filter const& filter) const;
   template <typename Predicate, typename Filter>
-  [[nodiscard]] auto apply_predicate(Predicate&& predicate, Filter&& filter) const
-      -> query_results;
-  [[nodiscard]] auto query_begin(QueryType query_type, geom_type const& query_geom) const
-      -> query_results;
+  [[nodiscard]] auto apply_predicate(Predicate&& predicate, Filter&& filter) const -> ids_type;
+  [[nodiscard]] auto query_ids(QueryType query_type, geom_type const& query_geom) const
+      -> ids_type;
 };
 
 }  // namespace GeoShape
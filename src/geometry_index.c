@@ -8,6 +8,9 @@
 #include "geometry/geometry_api.h"
 #include "rmalloc.h"
 #include "field_spec.h"
+#include "config.h"
+#include "util/workers_pool.h"
+#include "deps/thpool/thpool.h"
 
 void GeometryQuery_Free(GeometryQuery *geomq) {
   if (geomq->str) {
@@ -24,6 +27,34 @@ RedisModuleString *fmtRedisGeometryIndexKey(RedisSearchCtx *ctx, const char *fie
   return RedisModule_CreateStringPrintf(ctx->redisCtx, GEOMETRYINDEX_KEY_FMT, ctx->spec->name, field);
 }
 
+#ifdef MT_BUILD
+static int submitGeometryJobs(void *pool, void (*cb)(void *), void *arg, size_t n) {
+  redisearch_thpool_work_t *jobs = rm_malloc(n * sizeof(*jobs));
+  for (size_t i = 0; i < n; ++i) {
+    jobs[i] = (redisearch_thpool_work_t){.function_p = cb, .arg_p = arg};
+  }
+  int rc = redisearch_thpool_add_n_work(pool, jobs, n, THPOOL_PRIORITY_HIGH);
+  rm_free(jobs);
+  return rc;
+}
+#endif
+
+static GeometryIndex *newGeometryIndex(const FieldSpec *fs) {
+  GeometryJobQueue jobQueue = {0};
+#ifdef MT_BUILD
+  // The exact predicate of large queries is checked in parallel by the workers, which are only
+  // guaranteed to be running in full mode. The pool is constant throughout the module lifetime.
+  if (RSGlobalConfig.mt_mode == MT_MODE_FULL && _workers_thpool) {
+    jobQueue = (GeometryJobQueue){
+      .jobQueue = _workers_thpool,
+      .numThreads = RSGlobalConfig.numWorkerThreads,
+      .submitCb = submitGeometryJobs,
+    };
+  }
+#endif
+  return GeometryIndexFactory(fs->geometryOpts.geometryCoords, &jobQueue);
+}
+
 static GeometryIndex *openGeometryKeysDict(const IndexSpec *spec, RedisModuleString *keyName,
                                            int write, const FieldSpec *fs) {
   KeysDictValue *kdv = dictFetchValue(spec->keysDict, keyName);
@@ -34,7 +65,7 @@ static GeometryIndex *openGeometryKeysDict(const IndexSpec *spec, RedisModuleStr
     return NULL;
   }
   
-  GeometryIndex *idx = GeometryIndexFactory(fs->geometryOpts.geometryCoords);
+  GeometryIndex *idx = newGeometryIndex(fs);
   const GeometryApi *api = GeometryApi_Get(idx);
 
   kdv = rm_malloc(sizeof(*kdv));
@@ -64,7 +95,7 @@ GeometryIndex *OpenGeometryIndex(RedisModuleCtx *redisCtx, IndexSpec *spec, Redi
 
   /* Create an empty value object if the key is currently empty. */
   if (RedisModule_KeyType(*idxKey) == REDISMODULE_KEYTYPE_EMPTY) {
-    GeometryIndex *idx = GeometryIndexFactory(fs->geometryOpts.geometryCoords);
+    GeometryIndex *idx = newGeometryIndex(fs);
     RedisModule_ModuleTypeSetValue(*idxKey, GeometryIndexType, idx);
     return idx;
   } 
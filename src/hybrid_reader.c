@@ -127,6 +127,7 @@ static void alternatingIterate(HybridIterator *hr, VecSimQueryReply_Iterator *ve
   HR_ReadInBatch(hr, &cur_vec_res);
   while (IITER_HAS_NEXT(hr->child)) {
     if (cur_vec_res->docId == cur_child_res->docId) {
+      hr->numPassed++;
       // Found a match - check if it should be added to the results heap.
       if (hr->topResults->count < hr->query.k || cur_vec_res->num.value < *upper_bound) {
         // Otherwise, set the vector and child results as the children the res
@@ -184,6 +185,7 @@ static VecSimQueryReply_Code computeDistances(HybridIterator *hr) {
     if (isnan(metric)) {
       continue;
     }
+    hr->numPassed++;
     if (hr->topResults->count < hr->query.k || metric < upper_bound) {
       // Populate the vector result.
       cur_vec_res->docId = cur_child_res->docId;
@@ -191,6 +193,7 @@ static VecSimQueryReply_Code computeDistances(HybridIterator *hr) {
       insertResultToHeap(hr, cur_res, cur_child_res, &cur_vec_res, &upper_bound);
     }
   }
+  hr->numRead = VecSimIndex_IndexSize(hr->index);
   VecSimTieredIndex_ReleaseSharedLocks(hr->index);
   if (qvector != hr->query.vector) {
     rm_free(qvector);
@@ -199,6 +202,136 @@ static VecSimQueryReply_Code computeDistances(HybridIterator *hr) {
   return rc;
 }
 
+// A bitmap of the ids of the documents matched by the child, starting at the first one.
+typedef struct {
+  uint64_t *words;
+  size_t numWords;
+  t_docId base;
+} FilterBitmap;
+
+static inline bool FilterBitmap_Contains(const FilterBitmap *bm, t_docId docId) {
+  if (docId < bm->base) {
+    return false;
+  }
+  t_docId offset = docId - bm->base;
+  return (offset >> 6) < bm->numWords && ((bm->words[offset >> 6] >> (offset & 63)) & 1);
+}
+
+// Read the child once into a bitmap of the ids it matches. Returns false on timeout.
+static bool buildFilterBitmap(HybridIterator *hr, FilterBitmap *bm) {
+  RSIndexResult *cur_child_res;
+  size_t cap = 0;
+  *bm = (FilterBitmap){0};
+  hr->numFiltered = 0;
+  while (hr->child->Read(hr->child->ctx, &cur_child_res) != INDEXREAD_EOF) {
+    if (TimedOut_WithCtx(&hr->timeoutCtx)) {
+      return false;
+    }
+    if (hr->numFiltered++ == 0) {
+      bm->base = cur_child_res->docId;
+    }
+    size_t word = (cur_child_res->docId - bm->base) >> 6;
+    if (word >= cap) {
+      size_t new_cap = MAX(cap * 2, word + 1);
+      bm->words = rm_realloc(bm->words, new_cap * sizeof(*bm->words));
+      memset(bm->words + cap, 0, (new_cap - cap) * sizeof(*bm->words));
+      cap = new_cap;
+    }
+    bm->words[word] |= 1ULL << ((cur_child_res->docId - bm->base) & 63);
+    bm->numWords = word + 1;
+  }
+  return true;
+}
+
+static int cmpResultsById(const void *p1, const void *p2) {
+  const RSIndexResult *r1 = *(const RSIndexResult **)p1, *r2 = *(const RSIndexResult **)p2;
+  return r1->docId < r2->docId ? -1 : r1->docId > r2->docId;
+}
+
+// Batches mode over a bitmap of the child results: the child is read once, and every batch is
+// filtered by looking its ids up in the bitmap, rather than by rewinding the child and
+// intersecting it with the batch. Since the number of child results is then exact, so is the batch
+// size, and restrictive filters need far fewer rounds.
+// Only the results of the child for the k nearest documents are read again in the end.
+static VecSimQueryReply_Code prefilteredBatches(HybridIterator *hr) {
+  FilterBitmap bm;
+  if (!buildFilterBitmap(hr, &bm)) {
+    rm_free(bm.words);
+    return VecSim_QueryReply_TimedOut;
+  }
+  size_t vec_index_size = VecSimIndex_IndexSize(hr->index);
+  size_t child_num = MIN(hr->numFiltered, vec_index_size);
+  if (child_num == 0) {
+    rm_free(bm.words);
+    return VecSim_QueryReply_OK;
+  }
+  // Review the policy once, with the exact number of the child results.
+  if ((VecSimSearchMode)hr->runtimeParams.searchMode != VECSIM_HYBRID_BATCHES &&
+      VecSimIndex_PreferAdHocSearch(hr->index, child_num, hr->query.k, false)) {
+    rm_free(bm.words);
+    hr->searchMode = VECSIM_HYBRID_BATCHES_TO_ADHOC_BF;
+    hr->child->Rewind(hr->child->ctx);
+    return computeDistances(hr);
+  }
+
+  VecSimBatchIterator *batch_it = VecSimBatchIterator_New(hr->index, hr->query.vector, &hr->runtimeParams);
+  VecSimQueryReply_Code code = VecSim_QueryReply_OK;
+  RSIndexResult *cur_vec_res = NewMetricResult();
+  while (hr->topResults->count < hr->query.k && VecSimBatchIterator_HasNext(batch_it)) {
+    hr->numIterations++;
+    size_t n_res_left = hr->query.k - hr->topResults->count;
+    size_t batch_size = hr->runtimeParams.batchSize;
+    if (batch_size == 0) {
+      batch_size = n_res_left * ((float)vec_index_size / child_num) + 1;
+    }
+    // The results are sorted by score, so the first k which pass the filter are the nearest.
+    VecSimQueryReply *reply = VecSimBatchIterator_Next(batch_it, batch_size, BY_SCORE);
+    code = VecSimQueryReply_GetCode(reply);
+    if (VecSim_QueryReply_TimedOut == code) {
+      VecSimQueryReply_Free(reply);
+      break;
+    }
+    VecSimQueryReply_Iterator *iter = VecSimQueryReply_GetIterator(reply);
+    while (hr->topResults->count < hr->query.k && VecSimQueryReply_IteratorHasNext(iter)) {
+      VecSimQueryResult *res = VecSimQueryReply_IteratorNext(iter);
+      hr->numRead++;
+      t_docId id = VecSimQueryResult_GetId(res);
+      if (!FilterBitmap_Contains(&bm, id)) {
+        continue;
+      }
+      hr->numPassed++;
+      cur_vec_res->docId = id;
+      cur_vec_res->num.value = VecSimQueryResult_GetScore(res);
+      mmh_insert(hr->topResults, cur_vec_res);
+      cur_vec_res = NewMetricResult();
+    }
+    VecSimQueryReply_IteratorFree(iter);
+    VecSimQueryReply_Free(reply);
+  }
+  IndexResult_Free(cur_vec_res);
+  VecSimBatchIterator_Free(batch_it);
+  rm_free(bm.words);
+
+  // Attach the results of the child to the nearest documents, skipping to them in increasing ids.
+  size_t n = hr->topResults->count;
+  RSIndexResult **nearest = rm_malloc(n * sizeof(*nearest));
+  for (size_t i = 0; i < n; i++) {
+    nearest[i] = mmh_pop_min(hr->topResults);
+  }
+  qsort(nearest, n, sizeof(*nearest), cmpResultsById);
+  hr->child->Rewind(hr->child->ctx);
+  double upper_bound = INFINITY;
+  for (size_t i = 0; i < n; i++) {
+    RSIndexResult *cur_child_res;  // This will use the memory of hr->child->current.
+    if (hr->child->SkipTo(hr->child->ctx, nearest[i]->docId, &cur_child_res) == INDEXREAD_OK) {
+      insertResultToHeap(hr, hr->base.current, cur_child_res, &nearest[i], &upper_bound);
+    }
+    IndexResult_Free(nearest[i]);
+  }
+  rm_free(nearest);
+  return code;
+}
+
 // Review the estimated child results num, and returns true if hybrid policy should change.
 static bool reviewHybridSearchPolicy(HybridIterator *hr, size_t n_res_left, size_t child_upper_bound,
                                      size_t *child_num_estimated) {
@@ -226,7 +359,15 @@ static bool reviewHybridSearchPolicy(HybridIterator *hr, size_t n_res_left, size
   return VecSimIndex_PreferAdHocSearch(hr->index, *child_num_estimated, hr->query.k, false);
 }
 
-static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
+// Record the rate in which the vectors read by a hybrid query passed the filter.
+static void recordHybridStats(HybridIterator *hr) {
+  if (hr->stats && hr->searchMode != VECSIM_STANDARD_KNN) {
+    HybridStats_Record(hr->stats, hr->fieldName, hr->filterShape, hr->numPassed, hr->numRead,
+                       hr->numIterations);
+  }
+}
+
+static VecSimQueryReply_Code prepareHybridResults(HybridIterator *hr) {
   if (hr->searchMode == VECSIM_STANDARD_KNN) {
     hr->reply = VecSimIndex_TopKQuery(hr->index, hr->query.vector, hr->query.k, &(hr->runtimeParams), hr->query.order);
     hr->iter = VecSimQueryReply_GetIterator(hr->reply);
@@ -241,6 +382,9 @@ static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
   if (hr->child->NumEstimated(hr->child->ctx) == 0) {
     return VecSim_QueryReply_OK;
   }
+  if (hr->prefilter) {
+    return prefilteredBatches(hr);
+  }
   VecSimBatchIterator *batch_it = VecSimBatchIterator_New(hr->index, hr->query.vector, &hr->runtimeParams);
   double upper_bound = INFINITY;
   VecSimQueryReply_Code code = VecSim_QueryReply_OK;
@@ -250,6 +394,10 @@ static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
     child_num_estimated = VecSimIndex_IndexSize(hr->index);
   }
   size_t child_upper_bound = child_num_estimated;
+  // Start from the number of results learned from previous queries of the same filter, if any.
+  if (hr->childNumEstimated && hr->childNumEstimated < child_num_estimated) {
+    child_num_estimated = hr->childNumEstimated;
+  }
   while (VecSimBatchIterator_HasNext(batch_it)) {
     hr->numIterations++;
     size_t vec_index_size = VecSimIndex_IndexSize(hr->index);
@@ -270,6 +418,7 @@ static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
       break;
     }
     hr->iter = VecSimQueryReply_GetIterator(hr->reply);
+    hr->numRead += VecSimQueryReply_Len(hr->reply);
     hr->child->Rewind(hr->child->ctx);
 
     // Go over both iterators and save mutual results in the heap.
@@ -284,6 +433,7 @@ static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
       // Clean the saved results, and restart the hybrid search in ad-hoc BF mode.
       mmh_clear(hr->topResults);
       hr->child->Rewind(hr->child->ctx);
+      hr->numPassed = 0;
       code = computeDistances(hr);
       break;
     }
@@ -292,6 +442,14 @@ static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
   return code;
 }
 
+static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
+  VecSimQueryReply_Code code = prepareHybridResults(hr);
+  if (code != VecSim_QueryReply_TimedOut) {
+    recordHybridStats(hr);
+  }
+  return code;
+}
+
 static int HR_HasNext(void *ctx) {
   HybridIterator *hr = ctx;
   return hr->base.isValid;
@@ -367,6 +525,9 @@ static void HR_Rewind(void *ctx) {
   HybridIterator *hr = ctx;
   hr->resultsPrepared = false;
   hr->numIterations = 0;
+  hr->numPassed = 0;
+  hr->numRead = 0;
+  hr->numFiltered = 0;
   VecSimQueryReply_Free(hr->reply);
   VecSimQueryReply_IteratorFree(hr->iter);
   hr->reply = NULL;
@@ -402,6 +563,7 @@ void HybridIterator_Free(struct indexIterator *self) {
   if (it->child) {
     it->child->Free(it->child);
   }
+  rm_free(it->filterShape);
   rm_free(it);
 }
 
@@ -431,6 +593,14 @@ IndexIterator *NewHybridVectorIterator(HybridIteratorParams hParams, QueryError
   hi->ignoreScores = hParams.ignoreDocScore;
   hi->timeoutCtx = (TimeoutCtx){ .timeout = hParams.timeout, .counter = 0 };
   hi->runtimeParams.timeoutCtx = &hi->timeoutCtx;
+  hi->stats = hParams.stats && hParams.fieldName && hParams.filterShape ? hParams.stats : NULL;
+  hi->fieldName = hParams.fieldName;
+  hi->filterShape = hi->stats ? rm_strdup(hParams.filterShape) : NULL;
+  hi->childNumEstimated = 0;
+  hi->numPassed = 0;
+  hi->numRead = 0;
+  hi->prefilter = hParams.prefilter;
+  hi->numFiltered = 0;
 
   if (hParams.childIt == NULL || hParams.query.k == 0) {
     // If there is no child iterator, or the query is going to return 0 results, we can use simple KNN.
@@ -442,12 +612,23 @@ IndexIterator *NewHybridVectorIterator(HybridIteratorParams hParams, QueryError
     size_t subset_size = hParams.childIt->NumEstimated(hParams.childIt->ctx);
     // IITER_INVALID_NUM_ESTIMATED_RESULTS is the default (invalid) value for indicating invalid intersection iterator.
     if (subset_size == IITER_INVALID_NUM_ESTIMATED_RESULTS) {
+      rm_free(hi->filterShape);
       rm_free(hi);
       return NULL;
     }
     if (subset_size > VecSimIndex_IndexSize(hParams.index)) {
       subset_size = VecSimIndex_IndexSize(hParams.index);
     }
+    // Previous queries of the same filter shape tell how many of the vectors pass the filter,
+    // which is usually much more accurate than the upper bound estimated by the child.
+    double passRate = hi->stats ? HybridStats_PassRate(hi->stats, hi->fieldName, hi->filterShape) : -1;
+    if (passRate >= 0) {
+      size_t learned = passRate * VecSimIndex_IndexSize(hParams.index) + 1;
+      if (learned < subset_size) {
+        subset_size = learned;
+      }
+      hi->childNumEstimated = subset_size;
+    }
     // If user asks explicitly for a policy - use it.
     if (hParams.qParams.searchMode) {
       hi->searchMode = (VecSimSearchMode)hParams.qParams.searchMode;
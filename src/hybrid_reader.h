@@ -12,6 +12,7 @@
 #include "spec.h"
 #include "util/minmax_heap.h"
 #include "util/timeout.h"
+#include "hybrid_stats.h"
 
 typedef struct {
   VecSimIndex *index;
@@ -24,6 +25,10 @@ typedef struct {
   bool ignoreDocScore;
   IndexIterator *childIt;
   struct timespec timeout;
+  HybridStats *stats;              // If not NULL, learn and use the pass rate of the filter
+  const char *fieldName;           // The vector field, for the statistics
+  const char *filterShape;         // The shape of the filter (the child), for the statistics
+  bool prefilter;                  // Filter the batches by a bitmap of the child results
 } HybridIteratorParams;
 
 typedef struct {
@@ -47,6 +52,14 @@ typedef struct {
   size_t numIterations;
   bool ignoreScores;               // Ignore the document scores, only vector score matters.
   TimeoutCtx timeoutCtx;           // Timeout parameters
+  HybridStats *stats;              // The learned pass rates of the filters of the index, or NULL
+  const char *fieldName;
+  char *filterShape;
+  size_t childNumEstimated;        // The learned number of child results, or 0 if unknown
+  size_t numPassed;                // The number of vectors read which passed the filter
+  size_t numRead;                  // The number of vectors read
+  bool prefilter;                  // Filter the batches by a bitmap of the child results
+  size_t numFiltered;              // The number of child results in the bitmap
 } HybridIterator;
 
 #ifdef __cplusplus
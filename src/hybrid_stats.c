@@ -0,0 +1,137 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "hybrid_stats.h"
+#include "reply_macros.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+
+#include <pthread.h>
+#include <string.h>
+
+// The maximal number of keys kept per index
+#define HYBRID_STATS_MAX_ENTRIES 128
+// The weight of the last query in the moving average of the pass rate
+#define HYBRID_STATS_DECAY 0.25
+
+typedef struct {
+  char *field;
+  char *shape;
+  double passRate;
+  size_t numQueries;
+  size_t numBatches;  // The total number of batches read by the queries in batches mode
+  uint64_t lastUsed;  // The tick in which the entry was last used
+} HybridStatsEntry;
+
+struct HybridStats {
+  HybridStatsEntry *entries;
+  uint64_t tick;
+  pthread_mutex_t lock;
+};
+
+HybridStats *NewHybridStats(void) {
+  HybridStats *stats = rm_calloc(1, sizeof(*stats));
+  stats->entries = array_new(HybridStatsEntry, 8);
+  pthread_mutex_init(&stats->lock, NULL);
+  return stats;
+}
+
+static void entry_Free(HybridStatsEntry *e) {
+  rm_free(e->field);
+  rm_free(e->shape);
+}
+
+void HybridStats_Free(HybridStats *stats) {
+  if (!stats) {
+    return;
+  }
+  array_free_ex(stats->entries, entry_Free(ptr));
+  pthread_mutex_destroy(&stats->lock);
+  rm_free(stats);
+}
+
+/* Return the entry of a key, or NULL. Must be called with the lock held */
+static HybridStatsEntry *stats_Find(HybridStats *stats, const char *field, const char *shape) {
+  for (uint32_t i = 0; i < array_len(stats->entries); ++i) {
+    HybridStatsEntry *e = stats->entries + i;
+    if (!strcmp(e->field, field) && !strcmp(e->shape, shape)) {
+      e->lastUsed = ++stats->tick;
+      return e;
+    }
+  }
+  return NULL;
+}
+
+double HybridStats_PassRate(HybridStats *stats, const char *field, const char *shape) {
+  pthread_mutex_lock(&stats->lock);
+  HybridStatsEntry *e = stats_Find(stats, field, shape);
+  double passRate = e ? e->passRate : -1;
+  pthread_mutex_unlock(&stats->lock);
+  return passRate;
+}
+
+void HybridStats_Record(HybridStats *stats, const char *field, const char *shape, size_t passed,
+                        size_t read, size_t numBatches) {
+  if (!read) {
+    return;
+  }
+  double passRate = (double)passed / read;
+  pthread_mutex_lock(&stats->lock);
+  HybridStatsEntry *e = stats_Find(stats, field, shape);
+  if (e) {
+    e->passRate += HYBRID_STATS_DECAY * (passRate - e->passRate);
+    e->numQueries++;
+    e->numBatches += numBatches;
+    pthread_mutex_unlock(&stats->lock);
+    return;
+  }
+
+  if (array_len(stats->entries) >= HYBRID_STATS_MAX_ENTRIES) {
+    // evict the least recently used entry
+    uint32_t lru = 0;
+    for (uint32_t i = 1; i < array_len(stats->entries); ++i) {
+      if (stats->entries[i].lastUsed < stats->entries[lru].lastUsed) {
+        lru = i;
+      }
+    }
+    entry_Free(stats->entries + lru);
+    array_del_fast(stats->entries, lru);
+  }
+  HybridStatsEntry entry = {
+      .field = rm_strdup(field),
+      .shape = rm_strdup(shape),
+      .passRate = passRate,
+      .numQueries = 1,
+      .numBatches = numBatches,
+      .lastUsed = ++stats->tick,
+  };
+  stats->entries = array_append(stats->entries, entry);
+  pthread_mutex_unlock(&stats->lock);
+}
+
+size_t HybridStats_Size(HybridStats *stats) {
+  pthread_mutex_lock(&stats->lock);
+  size_t n = array_len(stats->entries);
+  pthread_mutex_unlock(&stats->lock);
+  return n;
+}
+
+void HybridStats_Reply(HybridStats *stats, RedisModule_Reply *reply) {
+  pthread_mutex_lock(&stats->lock);
+  RedisModule_Reply_Array(reply);
+  for (uint32_t i = 0; i < array_len(stats->entries); ++i) {
+    const HybridStatsEntry *e = stats->entries + i;
+    RedisModule_Reply_Map(reply);
+    REPLY_KVSTR("attribute", e->field);
+    REPLY_KVSTR("filter", e->shape);
+    REPLY_KVNUM("pass_rate", e->passRate);
+    REPLY_KVINT("queries", e->numQueries);
+    REPLY_KVINT("batches", e->numBatches);
+    REPLY_MAP_END;
+  }
+  REPLY_ARRAY_END;
+  pthread_mutex_unlock(&stats->lock);
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "reply.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Per-index statistics of hybrid vector queries, keyed by the vector field and the shape of the
+ * filter of the query (the types of its nodes and the fields they filter, without their values).
+ *
+ * For every key, the rate in which the vectors read by the hybrid queries pass their filter is
+ * learned as a moving average, so later queries of the same shape can choose their search mode
+ * and batch size by the rate observed so far, rather than by the estimated number of results of
+ * the filter, which is only an upper bound.
+ *
+ * The number of keys is bounded, the least recently used ones are evicted. The statistics may be
+ * used by several query threads concurrently.
+ */
+typedef struct HybridStats HybridStats;
+
+HybridStats *NewHybridStats(void);
+void HybridStats_Free(HybridStats *stats);
+
+/* The learned pass rate of the filter shape on the vector field, or a negative value if no query
+ * of this shape was recorded */
+double HybridStats_PassRate(HybridStats *stats, const char *field, const char *shape);
+
+/* Record a query of the filter shape on the vector field, in which `passed` of `read` vectors
+ * passed the filter, in `numBatches` batches */
+void HybridStats_Record(HybridStats *stats, const char *field, const char *shape, size_t passed,
+                        size_t read, size_t numBatches);
+
+/* The number of keys in the statistics */
+size_t HybridStats_Size(HybridStats *stats);
+
+/* Reply with an array of the statistics of every key */
+void HybridStats_Reply(HybridStats *stats, RedisModule_Reply *reply);
+
+#ifdef __cplusplus
+}
+#endif
@@ -14,6 +14,9 @@ typedef struct {
   t_docId lastDocId;
   t_offset size;
   t_offset offset;
+  // If set, the ids are shared with `owner`, and released with this callback instead of being freed
+  void (*release)(void *);
+  void *owner;
 } IdListIterator;
 
 static inline void setEof(IdListIterator *it, int value) {
@@ -105,7 +108,9 @@ t_docId IL_LastDocId(void *ctx) {
 void IL_Free(struct indexIterator *self) {
   IdListIterator *it = self->ctx;
   IndexResult_Free(it->base.current);
-  if (it->docIds) {
+  if (it->release) {
+    it->release(it->owner);
+  } else if (it->docIds) {
     rm_free(it->docIds);
   }
   rm_free(self);
@@ -131,16 +136,13 @@ void IL_Rewind(void *p) {
   il->offset = 0;
 }
 
-IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight) {
-
-  // first sort the ids, so the caller will not have to deal with it
-  qsort(ids, (size_t)num, sizeof(t_docId), cmp_docids);
-
+static IndexIterator *newIdListIterator(t_docId *ids, t_offset num, double weight) {
   IdListIterator *it = rm_new(IdListIterator);
 
   it->size = num;
-  it->docIds = rm_calloc(num, sizeof(t_docId));
-  if (num > 0) memcpy(it->docIds, ids, num * sizeof(t_docId));
+  it->docIds = ids;
+  it->release = NULL;
+  it->owner = NULL;
   setEof(it, 0);
   it->lastDocId = 0;
   it->base.current = NewVirtualResult(weight);
@@ -163,3 +165,22 @@ IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight) {
   ret->HasNext = NULL;
   return ret;
 }
+
+IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight) {
+
+  // first sort the ids, so the caller will not have to deal with it
+  qsort(ids, (size_t)num, sizeof(t_docId), cmp_docids);
+
+  t_docId *copy = rm_calloc(num, sizeof(t_docId));
+  if (num > 0) memcpy(copy, ids, num * sizeof(t_docId));
+  return newIdListIterator(copy, num, weight);
+}
+
+IndexIterator *NewSharedIdListIterator(const t_docId *ids, t_offset num, double weight,
+                                       void (*release)(void *), void *owner) {
+  IndexIterator *ret = newIdListIterator((t_docId *)ids, num, weight);
+  IdListIterator *it = ret->ctx;
+  it->release = release;
+  it->owner = owner;
+  return ret;
+}
@@ -16,16 +16,23 @@
 #include "rmalloc.h"
 #include "rmutil/rm_assert.h"
 #include "util/heap.h"
+#include "util/arr.h"
 #include "profile.h"
 #include "hybrid_reader.h"
 #include "metric_iterator.h"
 #include "optimizer_reader.h"
+#include "geo_knn_reader.h"
+#include "quantized_reader.h"
+#include "vector_range_reader.h"
 
 static int UI_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit);
 static int UI_SkipToHigh(void *ctx, t_docId docId, RSIndexResult **hit);
 static inline int UI_ReadUnsorted(void *ctx, RSIndexResult **hit);
 static int UI_ReadSorted(void *ctx, RSIndexResult **hit);
 static int UI_ReadSortedHigh(void *ctx, RSIndexResult **hit);
+static int UI_ReadPruned(void *ctx, RSIndexResult **hit);
+static int UI_ReadBatched(void *ctx, RSIndexResult **hit);
+static int UI_SkipToBatched(void *ctx, t_docId docId, RSIndexResult **hit);
 static size_t UI_NumEstimated(void *ctx);
 static size_t UI_Len(void *ctx);
 
@@ -74,8 +81,20 @@ typedef struct {
   QueryNodeType origType;
   // original string for fuzzy or prefix unions
   const char *qstr;
+
+  // Score pruning state, if enabled (see UI_EnableScorePruning)
+  struct UnionPruning *pruning;
+  // Window of buffered records, if reading in batched mode (see UI_ReadBatched)
+  struct UnionBatch *batch;
 } UnionIterator;
 
+static void UI_RewindPruning(UnionIterator *ui);
+static void UI_FreePruning(UnionIterator *ui);
+static void UI_EnableBatch(UnionIterator *ui, long long window);
+static void UI_DisableBatch(UnionIterator *ui);
+static void UI_RewindBatch(UnionIterator *ui);
+static void UI_FreeBatch(UnionIterator *ui);
+
 static void resetMinIdHeap(UnionIterator *ui) {
   heap_t *hp = ui->heapMinId;
   heap_clear(hp);
@@ -140,6 +159,8 @@ static void UI_Rewind(void *ctx) {
   CURRENT_RECORD(ui)->docId = 0;
 
   UI_SyncIterList(ui);
+  UI_RewindPruning(ui);
+  UI_RewindBatch(ui);
 
   // rewind all child iterators
   for (size_t i = 0; i < ui->num; i++) {
@@ -192,6 +213,11 @@ IndexIterator *NewUnionIterator(IndexIterator **its, int num, DocTable *dt, int
     ctx->heapMinId = rm_malloc(heap_sizeof(num));
     heap_init(ctx->heapMinId, cmpMinId, NULL, num);
     resetMinIdHeap(ctx);
+
+    // With this many children, buffering windows of records beats updating the heap per record
+    if (config->unionBatchWindow) {
+      UI_EnableBatch(ctx, config->unionBatchWindow);
+    }
   }
 
   return it;
@@ -517,6 +543,683 @@ static int UI_SkipToHigh(void *ctx, t_docId docId, RSIndexResult **hit) {
   return rc;
 }
 
+/**********************************************************
+ * Batched union.
+ *
+ * A union of many children spends most of its time updating its min-heap, once for every record of
+ * every child. In batched mode the union instead reads the records of all its children inside a
+ * window of docIds into a buffer, marks their docIds in a bitmap and links the records of each
+ * docId into a list. Documents are then returned by scanning the bitmap, and skips inside the
+ * window do not touch the children at all. Only the documents which are actually returned get an
+ * aggregate result.
+ *
+ * The buffered records are flat copies which own their offsets, so they remain valid when the
+ * readers are reopened. Therefore only children with flat records (index readers) are batched.
+ *
+ * Numeric range filters have a variant of their own, numeric merge mode (see
+ * UI_EnableNumericMerge). The ranges of a numeric filter are disjoint, so a document rarely has
+ * more than one record, and all that is kept of it is its value. The window is then just a bitmap
+ * and an array of values, and every document is returned with a single numeric child.
+ **********************************************************/
+
+// The end of a record list
+#define UI_BATCH_NONE UINT32_MAX
+// The largest window. The per docId arrays of a window (`first`, `values`) are sized by it, so it
+// keeps them at a few hundred KB however large the configured window is
+#define UI_BATCH_MAX_WINDOW (1 << 16)
+
+typedef struct {
+  uint32_t next;
+  uint32_t offsetsPos;
+} UnionBatchLink;
+
+typedef struct UnionBatch {
+  // The window is [base, end). An empty window has end == 0
+  t_docId base;
+  t_docId end;
+  uint32_t size;
+  // The number of bitmap words which may have bits set
+  uint32_t nwords;
+  // The docIds of the window which have records, relative to base
+  uint64_t *bits;
+  // The first record of each docId which has records
+  uint32_t *first;
+  // The buffered records. They are not kept in an `arr.h` array, whose header would misalign them
+  RSIndexResult *recs;
+  uint32_t nrecs;
+  uint32_t recsCap;
+  // For each record, the next record of the same docId and the position of its offsets in `offsets`
+  UnionBatchLink *links;
+  char *offsets;
+  // In numeric merge mode, the value of each docId of the window which has records, and the record
+  // which returns them. The record buffers above are not used then
+  double *values;
+  RSIndexResult *numeric;
+} UnionBatch;
+
+/* Switch the union to batched mode with windows of (about) `window` docIds, if all its children
+ * are index readers */
+static void UI_EnableBatch(UnionIterator *ui, long long window) {
+  for (uint32_t i = 0; i < ui->norig; ++i) {
+    const IndexIterator *it = ui->origits[i];
+    if (it->type != READ_ITERATOR || !it->current ||
+        !(it->current->type & (RSResultType_Term | RSResultType_Numeric | RSResultType_Virtual))) {
+      return;
+    }
+  }
+  ui->batch = rm_calloc(1, sizeof(*ui->batch));
+  // round the window up to whole bitmap words
+  ui->batch->size = (MIN(window, UI_BATCH_MAX_WINDOW) + 63) & ~63;
+  ui->base.Read = UI_ReadBatched;
+  ui->base.SkipTo = UI_SkipToBatched;
+}
+
+static void UI_FreeBatch(UnionIterator *ui) {
+  UnionBatch *b = ui->batch;
+  if (!b) {
+    return;
+  }
+  rm_free(b->bits);
+  rm_free(b->first);
+  rm_free(b->recs);
+  rm_free(b->links);
+  array_free(b->offsets);
+  rm_free(b->values);
+  if (b->numeric) {
+    IndexResult_Free(b->numeric);
+  }
+  rm_free(b);
+  ui->batch = NULL;
+}
+
+/* Go back to reading record by record. Must be called before reading from the union */
+static void UI_DisableBatch(UnionIterator *ui) {
+  if (!ui->batch) {
+    return;
+  }
+  UI_FreeBatch(ui);
+  ui->base.Read = ui->heapMinId ? UI_ReadSortedHigh : UI_ReadSorted;
+  ui->base.SkipTo = ui->heapMinId ? UI_SkipToHigh : UI_SkipTo;
+}
+
+static void UI_RewindBatch(UnionIterator *ui) {
+  if (ui->batch) {
+    ui->batch->end = 0;
+  }
+}
+
+static void UI_BatchAdd(UnionBatch *b, const RSIndexResult *res) {
+  uint32_t off = res->docId - b->base;
+  if (b->nrecs == b->recsCap) {
+    b->recsCap = b->recsCap ? b->recsCap * 2 : 64;
+    b->recs = rm_realloc(b->recs, b->recsCap * sizeof(*b->recs));
+    b->links = rm_realloc(b->links, b->recsCap * sizeof(*b->links));
+  }
+  uint32_t ix = b->nrecs++;
+  b->recs[ix] = *res;
+  b->links[ix].offsetsPos = array_len(b->offsets);
+  if (res->type == RSResultType_Term && res->term.offsets.len) {
+    b->offsets = array_ensure_append_n(b->offsets, res->term.offsets.data, res->term.offsets.len);
+  }
+
+  uint64_t bit = 1ULL << (off & 63);
+  uint64_t *word = b->bits + (off >> 6);
+  b->links[ix].next = (*word & bit) ? b->first[off] : UI_BATCH_NONE;
+  *word |= bit;
+  b->first[off] = ix;
+  b->nwords = MAX(b->nwords, (off >> 6) + 1);
+}
+
+/* Numeric merge mode: keep only the docId and the value of a record. Children are read in reverse
+ * order, so the value of the first child which has the docId wins, as it does in the heap */
+static void UI_BatchAddValue(UnionBatch *b, const RSIndexResult *res) {
+  uint32_t off = res->docId - b->base;
+  b->bits[off >> 6] |= 1ULL << (off & 63);
+  b->values[off] = res->num.value;
+  b->nwords = MAX(b->nwords, (off >> 6) + 1);
+}
+
+/* Buffer the records of all the children from docId `from` to the end of the window starting at
+ * it. Exhausted children are removed from the active list */
+static void UI_FillBatch(UnionIterator *ui, t_docId from) {
+  UnionBatch *b = ui->batch;
+  if (!b->bits) {
+    b->bits = rm_calloc(b->size / 64, sizeof(*b->bits));
+    if (b->numeric) {
+      b->values = rm_malloc(b->size * sizeof(*b->values));
+    } else {
+      b->first = rm_malloc(b->size * sizeof(*b->first));
+    }
+    b->offsets = array_new(char, 256);
+  } else {
+    memset(b->bits, 0, b->nwords * sizeof(*b->bits));
+    array_clear(b->offsets);
+  }
+  b->nwords = 0;
+  b->nrecs = 0;
+  b->base = from;
+  b->end = from > UINT64_MAX - b->size ? UINT64_MAX : from + b->size;
+
+  // The children are read in reverse order, since records are prepended to the lists of their
+  // docIds. A child which is ahead of `from` has its current record pending from the last window
+  for (int i = (int)ui->num - 1; i >= 0; --i) {
+    IndexIterator *it = ui->its[i];
+    RSIndexResult *res = IITER_CURRENT_RECORD(it);
+    int rc = INDEXREAD_OK;
+    if (it->minId < from) {
+      rc = it->SkipTo(it->ctx, from, &res);
+      if (rc != INDEXREAD_EOF) {
+        it->minId = res->docId;
+      }
+    }
+    while (rc != INDEXREAD_EOF && it->minId < b->end) {
+      if (b->numeric) {
+        UI_BatchAddValue(b, res);
+      } else {
+        UI_BatchAdd(b, res);
+      }
+      do {
+        rc = it->Read(it->ctx, &res);
+      } while (rc == INDEXREAD_NOTFOUND);
+      if (rc == INDEXREAD_OK) {
+        it->minId = res->docId;
+      }
+    }
+    if (rc == INDEXREAD_EOF) {
+      UI_RemoveExhausted(ui, i);
+    }
+  }
+
+  // the offsets buffer is final now
+  for (uint32_t ix = 0; ix < b->nrecs; ++ix) {
+    RSIndexResult *rec = b->recs + ix;
+    if (rec->type == RSResultType_Term && rec->term.offsets.len) {
+      rec->term.offsets.data = b->offsets + b->links[ix].offsetsPos;
+    }
+  }
+}
+
+/* Find the first docId of the window which has records, from offset `off`. Returns the window
+ * size if there is none */
+static uint32_t UI_BatchNextOffset(const UnionBatch *b, uint32_t off) {
+  uint32_t w = off >> 6;
+  if (w >= b->nwords) {
+    return b->size;
+  }
+  uint64_t word = b->bits[w] & (~0ULL << (off & 63));
+  while (!word) {
+    if (++w == b->nwords) {
+      return b->size;
+    }
+    word = b->bits[w];
+  }
+  return (w << 6) + __builtin_ctzll(word);
+}
+
+/* Move to the first document not smaller than docId, refilling the window as needed, and put its
+ * aggregate result in the union's current record */
+static int UI_BatchSeek(UnionIterator *ui, t_docId docId) {
+  UnionBatch *b = ui->batch;
+  for (;;) {
+    if (docId >= b->base && docId < b->end) {
+      uint32_t off = UI_BatchNextOffset(b, docId - b->base);
+      if (off < b->size) {
+        RSIndexResult *cur = CURRENT_RECORD(ui);
+        AggregateResult_Reset(cur);
+        if (b->numeric) {
+          b->numeric->docId = b->base + off;
+          b->numeric->num.value = b->values[off];
+          AggregateResult_AddChild(cur, b->numeric);
+        }
+        for (uint32_t ix = b->numeric ? UI_BATCH_NONE : b->first[off]; ix != UI_BATCH_NONE;
+             ix = b->links[ix].next) {
+          AggregateResult_AddChild(cur, b->recs + ix);
+          if (ui->quickExit) {
+            break;
+          }
+        }
+        ui->minDocId = cur->docId;
+        return INDEXREAD_OK;
+      }
+      docId = b->end;
+    }
+    if (!ui->num || docId == UINT64_MAX) {
+      IITER_SET_EOF(&ui->base);
+      return INDEXREAD_EOF;
+    }
+    // start the window at the first record any child may have, to skip over gaps in the ids
+    t_docId from = UINT64_MAX;
+    for (uint32_t i = 0; i < ui->num; ++i) {
+      from = MIN(from, MAX(ui->its[i]->minId, docId));
+    }
+    UI_FillBatch(ui, from);
+    docId = from;
+  }
+}
+
+int UI_EnableNumericMerge(IndexIterator *it, long long window) {
+  if (it->type != UNION_ITERATOR) {
+    return 0;
+  }
+  UnionIterator *ui = it->ctx;
+  for (uint32_t i = 0; i < ui->norig; ++i) {
+    const IndexIterator *child = ui->origits[i];
+    if (child->type != READ_ITERATOR || !child->current ||
+        child->current->type != RSResultType_Numeric) {
+      return 0;
+    }
+  }
+  UI_DisableBatch(ui);
+  UI_EnableBatch(ui, window);
+  ui->batch->numeric = NewNumericResult();
+  return 1;
+}
+
+static int UI_ReadBatched(void *ctx, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  if (!IITER_HAS_NEXT(&ui->base)) {
+    return INDEXREAD_EOF;
+  }
+  if (UI_BatchSeek(ui, ui->minDocId + 1) == INDEXREAD_EOF) {
+    return INDEXREAD_EOF;
+  }
+  ui->len++;
+  *hit = CURRENT_RECORD(ui);
+  return INDEXREAD_OK;
+}
+
+static int UI_SkipToBatched(void *ctx, t_docId docId, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  if (docId == 0) {
+    return UI_ReadBatched(ctx, hit);
+  }
+  if (!IITER_HAS_NEXT(&ui->base)) {
+    return INDEXREAD_EOF;
+  }
+  if (UI_BatchSeek(ui, docId) == INDEXREAD_EOF) {
+    return INDEXREAD_EOF;
+  }
+  *hit = CURRENT_RECORD(ui);
+  return ui->minDocId == docId ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
+}
+
+/**********************************************************
+ * Score pruning of a union iterator.
+ *
+ * The children ("clauses") of the union are sorted by the upper bound of their contribution to
+ * the score. The clauses whose bounds add up to less than the threshold cannot bring a document to
+ * the top results on their own, so the candidates are taken from the other ("essential") clauses
+ * only. A candidate is then checked against the bounds of the index blocks that contain it, and if
+ * these add up to less than the threshold, the essential clauses skip past the blocks.
+ *
+ * The block bounds hold for any document score up to the maximal score of the doc table. When the
+ * candidate is in the columns of the doc table, it is also checked with its own score and length,
+ * and skipped alone if these keep it out of reach.
+ **********************************************************/
+
+// Relative slack of the bounds, covering rounding differences between the bounds and the scorers
+#define UI_PRUNE_EPSILON 1e-9
+// Clauses with more term readers are bounded by their global bound, to keep the checks cheap
+#define UI_PRUNE_MAX_BLOCK_READERS 8
+
+typedef struct {
+  IndexReader *ir;
+  // The product of the weights of the unions above the reader
+  double factor;
+  // The block found by the last lookup, where the next lookup starts
+  uint32_t blockIx;
+} PruneReader;
+
+typedef struct {
+  PruneReader *readers;
+  double maxBound;
+  int eof;
+  int isUnion;
+  // Set when a union clause was skipped past the requested docId. Its current record then holds
+  // only some of the children matching its current docId
+  int partial;
+} PruneClause;
+
+typedef struct UnionPruning {
+  const double *threshold;
+  RSTermScoreBound bound;
+  RSIndexStats stats;
+  // The doc table of the documents, or NULL if their scores are at most 1
+  const DocTable *docs;
+  // One clause for each of the union's children, in the same order
+  PruneClause *clauses;
+  // The clause indexes sorted by ascending bound, and the running sums of their bounds
+  uint32_t *order;
+  double *prefixBound;
+} UnionPruning;
+
+static double PruneReader_BlockBound(const UnionPruning *p, const PruneReader *r,
+                                     const IndexBlock *blk) {
+  // a saturated frequency is unknown
+  uint32_t maxFreq = blk->maxFreq == UINT16_MAX ? 0 : blk->maxFreq;
+  return r->factor * p->bound(&p->stats, r->ir->record, maxFreq, blk->minDocLen);
+}
+
+static double PruneReader_MaxBound(const UnionPruning *p, const PruneReader *r) {
+  const InvertedIndex *idx = r->ir->idx;
+  double ret = 0;
+  for (uint32_t i = 0; i < idx->size; ++i) {
+    if (idx->blocks[i].numEntries) {
+      ret = MAX(ret, PruneReader_BlockBound(p, r, idx->blocks + i));
+    }
+  }
+  return ret;
+}
+
+/* Bound the contribution of a reader to the score of docId. `*upto` is set to the last docId for
+ * which the bound holds. `*docBound` is set to the bound of docId alone, given its length `docLen`
+ * (0 if unknown) */
+static double PruneReader_Bound(const UnionPruning *p, PruneReader *r, t_docId docId,
+                                uint32_t docLen, t_docId *upto, double *docBound) {
+  *docBound = 0;
+  // an exhausted (or aborted) reader has nothing more to contribute
+  if (r->ir->atEnd_) {
+    *upto = UINT64_MAX;
+    return 0;
+  }
+  const InvertedIndex *idx = r->ir->idx;
+  r->blockIx = InvertedIndex_FindBlock(idx, r->blockIx, docId);
+  if (r->blockIx == idx->size) {
+    *upto = UINT64_MAX;
+    return 0;
+  }
+  const IndexBlock *blk = idx->blocks + r->blockIx;
+  if (blk->firstId > docId) {
+    *upto = blk->firstId - 1;
+    return 0;
+  }
+  *upto = blk->lastId;
+  double ret = PruneReader_BlockBound(p, r, blk);
+  if (docLen > blk->minDocLen) {
+    uint32_t maxFreq = blk->maxFreq == UINT16_MAX ? 0 : blk->maxFreq;
+    *docBound = r->factor * p->bound(&p->stats, r->ir->record, maxFreq, docLen);
+  } else {
+    *docBound = ret;
+  }
+  return ret;
+}
+
+/* Bound the contribution of a clause to the score of docId. `*upto` is set to the last docId for
+ * which the bound holds, and `*docBound` to the bound of docId alone (see PruneReader_Bound) */
+static double PruneClause_Bound(const UnionPruning *p, PruneClause *c, const IndexIterator *it,
+                                t_docId docId, uint32_t docLen, t_docId *upto, double *docBound) {
+  *upto = UINT64_MAX;
+  *docBound = 0;
+  if (c->eof) {
+    return 0;
+  }
+  // the clause has already moved past the docId, and has nothing before its current position
+  if (it->minId > docId) {
+    *upto = it->minId - 1;
+    return 0;
+  }
+  if (array_len(c->readers) > UI_PRUNE_MAX_BLOCK_READERS) {
+    *docBound = c->maxBound;
+    return c->maxBound;
+  }
+  double ret = 0;
+  for (uint32_t i = 0; i < array_len(c->readers); ++i) {
+    t_docId readerUpto;
+    double readerDocBound;
+    ret += PruneReader_Bound(p, c->readers + i, docId, docLen, &readerUpto, &readerDocBound);
+    *docBound += readerDocBound;
+    *upto = MIN(*upto, readerUpto);
+  }
+  return ret;
+}
+
+/* The factor of the document scores in the bounds. Scores are bounded by the maximal score of the
+ * doc table, which is read on every call since documents may be added while a query is paused */
+static inline double UI_PruneScoreBound(const UnionPruning *p) {
+  return p->docs ? MAX(p->docs->maxDocScore, 0) : 1;
+}
+
+/* Collect the term readers under an iterator. Returns 0 if there are other kinds of iterators */
+static int UI_CollectPruneReaders(IndexIterator *it, double factor, PruneReader **readers) {
+  switch (it->type) {
+    case READ_ITERATOR: {
+      IndexReader *ir = it->ctx;
+      if (ir->record->type != RSResultType_Term) {
+        return 0;
+      }
+      PruneReader r = {.ir = ir, .factor = factor, .blockIx = 0};
+      *readers = array_append(*readers, r);
+      return 1;
+    }
+    case UNION_ITERATOR: {
+      UnionIterator *ui = it->ctx;
+      if (ui->weight < 0) {
+        return 0;
+      }
+      // the bounds are taken from the readers' positions, which run ahead of a batched union
+      UI_DisableBatch(ui);
+      for (uint32_t i = 0; i < ui->norig; ++i) {
+        if (!UI_CollectPruneReaders(ui->origits[i], factor * ui->weight, readers)) {
+          return 0;
+        }
+      }
+      return 1;
+    }
+    case EMPTY_ITERATOR:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+int UI_EnableScorePruning(IndexIterator *it, const double *threshold, RSTermScoreBound bound,
+                          const RSIndexStats *stats, const DocTable *docs) {
+  if (it->type != UNION_ITERATOR) {
+    return 0;
+  }
+  UnionIterator *ui = it->ctx;
+  if (ui->quickExit || ui->weight < 0 || ui->pruning) {
+    return 0;
+  }
+  UI_DisableBatch(ui);
+
+  UnionPruning *p = rm_calloc(1, sizeof(*p));
+  p->threshold = threshold;
+  p->bound = bound;
+  p->stats = *stats;
+  p->docs = docs;
+  p->clauses = rm_calloc(ui->norig, sizeof(*p->clauses));
+  p->order = rm_malloc(ui->norig * sizeof(*p->order));
+  p->prefixBound = rm_malloc(ui->norig * sizeof(*p->prefixBound));
+  ui->pruning = p;
+
+  for (uint32_t i = 0; i < ui->norig; ++i) {
+    PruneClause *c = p->clauses + i;
+    c->isUnion = ui->origits[i]->type == UNION_ITERATOR;
+    c->readers = array_new(PruneReader, 1);
+    if (!UI_CollectPruneReaders(ui->origits[i], ui->weight, &c->readers)) {
+      UI_FreePruning(ui);
+      return 0;
+    }
+    for (uint32_t j = 0; j < array_len(c->readers); ++j) {
+      c->maxBound += PruneReader_MaxBound(p, c->readers + j);
+    }
+
+    // insertion sort by bound, there are usually only a few clauses
+    uint32_t j = i;
+    for (; j > 0 && p->clauses[p->order[j - 1]].maxBound > c->maxBound; --j) {
+      p->order[j] = p->order[j - 1];
+    }
+    p->order[j] = i;
+  }
+
+  double sum = 0;
+  for (uint32_t i = 0; i < ui->norig; ++i) {
+    sum += p->clauses[p->order[i]].maxBound;
+    p->prefixBound[i] = sum;
+  }
+
+  it->Read = UI_ReadPruned;
+  return 1;
+}
+
+static void UI_RewindPruning(UnionIterator *ui) {
+  UnionPruning *p = ui->pruning;
+  if (!p) {
+    return;
+  }
+  for (uint32_t i = 0; i < ui->norig; ++i) {
+    PruneClause *c = p->clauses + i;
+    c->eof = 0;
+    c->partial = 0;
+    for (uint32_t j = 0; j < array_len(c->readers); ++j) {
+      c->readers[j].blockIx = 0;
+    }
+  }
+}
+
+static void UI_FreePruning(UnionIterator *ui) {
+  UnionPruning *p = ui->pruning;
+  if (!p) {
+    return;
+  }
+  for (uint32_t i = 0; i < ui->norig; ++i) {
+    array_free(p->clauses[i].readers);
+  }
+  rm_free(p->clauses);
+  rm_free(p->order);
+  rm_free(p->prefixBound);
+  rm_free(p);
+  ui->pruning = NULL;
+}
+
+/* Skip a clause iterator to docId, or one place after it. Returns 0 if it reached EOF */
+static int PruneClause_SkipTo(PruneClause *c, IndexIterator *it, t_docId docId) {
+  RSIndexResult *res = NULL;
+  int rc = it->SkipTo(it->ctx, docId, &res);
+  if (rc == INDEXREAD_EOF) {
+    c->eof = 1;
+    return 0;
+  }
+  c->partial = c->isUnion && rc == INDEXREAD_NOTFOUND;
+  if (res) {
+    it->minId = res->docId;
+  }
+  return 1;
+}
+
+// UI_Read with score pruning
+static int UI_ReadPruned(void *ctx, RSIndexResult **hit) {
+  UnionIterator *ui = ctx;
+  UnionPruning *p = ui->pruning;
+  uint32_t num = ui->norig;
+
+  if (!IITER_HAS_NEXT(&ui->base)) {
+    IITER_SET_EOF(&ui->base);
+    return INDEXREAD_EOF;
+  }
+  AggregateResult_Reset(CURRENT_RECORD(ui));
+  CURRENT_RECORD(ui)->weight = ui->weight;
+
+  while (1) {
+    double threshold = *p->threshold;
+    double scoreBound = UI_PruneScoreBound(p);
+
+    // skip the clauses which cannot reach the threshold on their own
+    uint32_t first = 0;
+    if (threshold > 0) {
+      while (first < num && p->prefixBound[first] * scoreBound * (1 + UI_PRUNE_EPSILON) < threshold) {
+        ++first;
+      }
+    }
+
+    // the candidate is the next document of the essential clauses
+    t_docId docId = UINT64_MAX;
+    for (uint32_t j = first; j < num; ++j) {
+      PruneClause *c = p->clauses + p->order[j];
+      IndexIterator *it = ui->origits[p->order[j]];
+      while (!c->eof && it->minId <= ui->minDocId) {
+        RSIndexResult *res = NULL;
+        if (it->Read(it->ctx, &res) == INDEXREAD_EOF) {
+          c->eof = 1;
+        } else if (res) {
+          it->minId = res->docId;
+          c->partial = 0;
+        }
+      }
+      if (!c->eof) {
+        docId = MIN(docId, it->minId);
+      }
+    }
+    if (docId == UINT64_MAX) {
+      break;
+    }
+
+    if (threshold > 0) {
+      // the score and length of the candidate, if they can be read without borrowing its metadata
+      int inColumns = p->docs && DocTable_InColumns(p->docs, docId);
+      uint32_t docLen = inColumns ? p->docs->cols.lens[docId] : 0;
+
+      // check the candidate against the bounds of all the clauses at its position
+      double total = 0, docTotal = 0;
+      t_docId upto = UINT64_MAX;
+      for (uint32_t i = 0; i < num; ++i) {
+        t_docId clauseUpto;
+        double clauseDocBound;
+        total += PruneClause_Bound(p, p->clauses + i, ui->origits[i], docId, docLen, &clauseUpto,
+                                   &clauseDocBound);
+        docTotal += clauseDocBound;
+        upto = MIN(upto, clauseUpto);
+      }
+      if (total * scoreBound * (1 + UI_PRUNE_EPSILON) < threshold) {
+        // no document can reach the threshold before `upto`
+        if (upto == UINT64_MAX) {
+          break;
+        }
+        for (uint32_t j = first; j < num; ++j) {
+          PruneClause *c = p->clauses + p->order[j];
+          IndexIterator *it = ui->origits[p->order[j]];
+          if (!c->eof && it->minId <= upto) {
+            PruneClause_SkipTo(c, it, upto + 1);
+          }
+        }
+        continue;
+      }
+      // the candidate alone may still be out of reach by its own score and length
+      if (inColumns && docTotal * MAX(p->docs->cols.scores[docId], 0) * (1 + UI_PRUNE_EPSILON) <
+                           threshold) {
+        for (uint32_t j = first; j < num; ++j) {
+          PruneClause *c = p->clauses + p->order[j];
+          IndexIterator *it = ui->origits[p->order[j]];
+          if (!c->eof && it->minId <= docId) {
+            PruneClause_SkipTo(c, it, docId + 1);
+          }
+        }
+        continue;
+      }
+    }
+
+    // collect all the clauses matching the candidate
+    for (uint32_t i = 0; i < num; ++i) {
+      PruneClause *c = p->clauses + i;
+      IndexIterator *it = ui->origits[i];
+      if (c->eof || (it->minId < docId && !PruneClause_SkipTo(c, it, docId))) {
+        continue;
+      }
+      if (it->minId == docId && (!c->partial || PruneClause_SkipTo(c, it, docId))) {
+        AggregateResult_AddChild(CURRENT_RECORD(ui), IITER_CURRENT_RECORD(it));
+      }
+    }
+    ui->minDocId = docId;
+    ui->len++;
+    *hit = CURRENT_RECORD(ui);
+    return INDEXREAD_OK;
+  }
+
+  IITER_SET_EOF(&ui->base);
+  return INDEXREAD_EOF;
+}
+
 void UnionIterator_Free(IndexIterator *itbase) {
   if (itbase == NULL) return;
 
@@ -530,6 +1233,8 @@ void UnionIterator_Free(IndexIterator *itbase) {
 
   IndexResult_Free(CURRENT_RECORD(ui));
   if (ui->heapMinId) heap_free(ui->heapMinId);
+  UI_FreePruning(ui);
+  UI_FreeBatch(ui);
   rm_free(ui->its);
   rm_free(ui->origits);
   rm_free(ui);
@@ -545,6 +1250,7 @@ void trimUnionIterator(IndexIterator *iter, size_t offset, size_t limit, bool as
   if (ui->norig <= 2) { // nothing to trim
     return;
   }
+  UI_DisableBatch(ui);
 
   size_t curTotal = 0;
   int i;
@@ -578,6 +1284,17 @@ void trimUnionIterator(IndexIterator *iter, size_t offset, size_t limit, bool as
   iter->Read = UI_ReadUnsorted;
 }
 
+// The number of candidate documents an intersect iterator examines between two reorders of its
+// children
+#define II_REORDER_INTERVAL 1024
+
+/* Statistics of an intersection child, used to order the children at runtime. `attempts` counts
+ * the candidates the child was skipped to, and `rejects` how many of them it did not contain */
+typedef struct {
+  uint32_t attempts;
+  uint32_t rejects;
+} IIChildStats;
+
 /* The context used by the intersection methods during iterating an intersect
  * iterator */
 typedef struct {
@@ -599,6 +1316,11 @@ typedef struct {
   t_fieldMask fieldMask;
   double weight;
   size_t nexpected;
+
+  // Adaptive child ordering (see II_Reorder). NULL if disabled
+  IIChildStats *stats;
+  // The number of candidates examined since the last reorder
+  uint32_t rounds;
 } IntersectIterator;
 
 void IntersectIterator_Free(IndexIterator *it) {
@@ -612,6 +1334,7 @@ void IntersectIterator_Free(IndexIterator *it) {
 
   rm_free(ui->docIds);
   rm_free(ui->its);
+  rm_free(ui->stats);
   IndexResult_Free(it->current);
   rm_free(it);
 }
@@ -748,9 +1471,52 @@ IndexIterator *NewIntersecIterator(IndexIterator **its_, size_t num, DocTable *d
   it->Rewind = II_Rewind;
   it->HasNext = NULL;
   II_SortChildren(ctx);
+  // The order by estimates is only a guess, since it ignores the correlation between children.
+  // If enabled, keep reordering them by the rate in which they reject candidates
+  if (RSGlobalConfig.adaptiveIntersectOrder && !ctx->inOrder && ctx->num > 1 &&
+      ctx->nexpected != IITER_INVALID_NUM_ESTIMATED_RESULTS) {
+    ctx->stats = rm_calloc(ctx->num, sizeof(*ctx->stats));
+  }
   return it;
 }
 
+/* Returns true if child stats `a` reject candidates in a higher rate than `b`. A child that was
+ * never skipped to a candidate is the leader, which generated all of them, so it keeps its place */
+static inline int II_RejectsMore(const IIChildStats *a, const IIChildStats *b) {
+  if (!a->attempts || !b->attempts) {
+    return !a->attempts && b->attempts;
+  }
+  return (uint64_t)a->rejects * b->attempts > (uint64_t)b->rejects * a->attempts;
+}
+
+/* Reorder the children of the intersection so that the ones which reject most of the candidates
+ * they are skipped to come first. The first child drives the iteration, and a candidate rejected by
+ * an early child is not skipped to by the later ones, so this minimizes the number of skips. The
+ * statistics are halved afterwards, so that the order follows changes along the index */
+static void II_Reorder(IntersectIterator *ic) {
+  IIChildStats *stats = ic->stats;
+  // stable insertion sort, the number of children is small
+  for (unsigned i = 1; i < ic->num; i++) {
+    IIChildStats st = stats[i];
+    IndexIterator *it = ic->its[i];
+    t_docId docId = ic->docIds[i];
+    unsigned j = i;
+    for (; j > 0 && II_RejectsMore(&st, &stats[j - 1]); j--) {
+      stats[j] = stats[j - 1];
+      ic->its[j] = ic->its[j - 1];
+      ic->docIds[j] = ic->docIds[j - 1];
+    }
+    stats[j] = st;
+    ic->its[j] = it;
+    ic->docIds[j] = docId;
+  }
+  for (unsigned i = 0; i < ic->num; i++) {
+    stats[i].attempts >>= 1;
+    stats[i].rejects >>= 1;
+  }
+  ic->rounds = 0;
+}
+
 static int II_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
   /* A seek with docId 0 is equivalent to a read */
   if (docId == 0) {
@@ -837,6 +1603,9 @@ static int II_ReadSorted(void *ctx, RSIndexResult **hit) {
   do {
     nh = 0;
     AggregateResult_Reset(ic->base.current);
+    if (ic->stats && ++ic->rounds == II_REORDER_INTERVAL) {
+      II_Reorder(ic);
+    }
 
     for (i = 0; i < ic->num; i++) {
       IndexIterator *it = ic->its[i];
@@ -852,6 +1621,10 @@ static int II_ReadSorted(void *ctx, RSIndexResult **hit) {
           rc = it->Read(it->ctx, &h);
         } else {
           rc = it->SkipTo(it->ctx, ic->lastDocId, &h);
+          if (ic->stats && rc != INDEXREAD_EOF) {
+            ic->stats[i].attempts++;
+            ic->stats[i].rejects += (h->docId > ic->lastDocId);
+          }
         }
         // printf("II %p last docId %d, it %d read docId %d(%d), rc %d\n", ic, ic->lastDocId, i,
         //        h->docId, it->LastDocId(it->ctx), rc);
@@ -1698,6 +2471,9 @@ void PrintIteratorChildProfile(RedisModule_Reply *reply, IndexIterator *root, si
       if (hi->searchMode == VECSIM_HYBRID_BATCHES ||
           hi->searchMode == VECSIM_HYBRID_BATCHES_TO_ADHOC_BF) {
         printProfileNumBatches(hi);
+        if (hi->prefilter) {
+          printProfileFilterBitmapSize(hi);
+        }
       }
     }
 
@@ -1706,6 +2482,18 @@ void PrintIteratorChildProfile(RedisModule_Reply *reply, IndexIterator *root, si
       printProfileOptimizationType(oi);
     }
 
+    if (root->type == GEO_KNN_ITERATOR) {
+      printProfileNumRings((GeoKnnIterator *)root->ctx);
+    }
+
+    if (root->type == QUANTIZED_KNN_ITERATOR) {
+      printProfileNumReranked((QuantizedKnnIterator *)root->ctx);
+    }
+
+    if (root->type == VECTOR_RANGE_ITERATOR) {
+      printProfileNumRangeBatches((VectorRangeIterator *)root->ctx);
+    }
+
     if (child) {
       RedisModule_Reply_SimpleString(reply, "Child iterator");
       printIteratorProfile(reply, child, 0, 0, depth + 1, limited, config);
@@ -1728,10 +2516,13 @@ void PrintIteratorChildProfile(RedisModule_Reply *reply, IndexIterator *root, si
 PRINT_PROFILE_SINGLE_NO_CHILD(printWildcardIt,          "WILDCARD");
 PRINT_PROFILE_SINGLE_NO_CHILD(printIdListIt,            "ID-LIST");
 PRINT_PROFILE_SINGLE_NO_CHILD(printEmptyIt,             "EMPTY");
+PRINT_PROFILE_SINGLE_NO_CHILD(printVectorRangeIt,       "VECTOR RANGE");
 PRINT_PROFILE_SINGLE(printNotIt, NotIterator,           "NOT");
 PRINT_PROFILE_SINGLE(printOptionalIt, OptionalIterator, "OPTIONAL");
 PRINT_PROFILE_SINGLE(printHybridIt, HybridIterator,     "VECTOR");
 PRINT_PROFILE_SINGLE(printOptimusIt, OptimizerIterator, "OPTIMIZER");
+PRINT_PROFILE_SINGLE(printGeoKnnIt, GeoKnnIterator,     "GEO KNN");
+PRINT_PROFILE_SINGLE(printQuantizedKnnIt, QuantizedKnnIterator, "VECTOR QUANTIZED");
 
 PRINT_PROFILE_FUNC(printProfileIt) {
   ProfileIterator *pi = (ProfileIterator *)root;
@@ -1765,6 +2556,9 @@ void printIteratorProfile(RedisModule_Reply *reply, IndexIterator *root, size_t
     case HYBRID_ITERATOR:     { printHybridIt(reply, root, counter, cpuTime, depth, limited, config);     break; }
     case METRIC_ITERATOR:     { printMetricIt(reply, root, counter, cpuTime, depth, limited, config);     break; }
     case OPTIMUS_ITERATOR:    { printOptimusIt(reply, root, counter, cpuTime, depth, limited, config);    break; }
+    case GEO_KNN_ITERATOR:    { printGeoKnnIt(reply, root, counter, cpuTime, depth, limited, config);     break; }
+    case QUANTIZED_KNN_ITERATOR: { printQuantizedKnnIt(reply, root, counter, cpuTime, depth, limited, config); break; }
+    case VECTOR_RANGE_ITERATOR: { printVectorRangeIt(reply, root, counter, cpuTime, depth, limited, config); break; }
     case MAX_ITERATOR:        { RS_LOG_ASSERT(0, "nope");   break; }
   }
 }
@@ -1790,6 +2584,12 @@ void Profile_AddIters(IndexIterator **root) {
     case OPTIMUS_ITERATOR:
       Profile_AddIters(&((OptimizerIterator *)((*root)->ctx))->child);
       break;
+    case GEO_KNN_ITERATOR:
+      Profile_AddIters(&((GeoKnnIterator *)((*root)->ctx))->child);
+      break;
+    case QUANTIZED_KNN_ITERATOR:
+      Profile_AddIters(&((QuantizedKnnIterator *)((*root)->ctx))->child);
+      break;
     case UNION_ITERATOR:
       ui = (*root)->ctx;
       for (int i = 0; i < ui->norig; i++) {
@@ -1808,6 +2608,7 @@ void Profile_AddIters(IndexIterator **root) {
     case EMPTY_ITERATOR:
     case ID_LIST_ITERATOR:
     case METRIC_ITERATOR:
+    case VECTOR_RANGE_ITERATOR:
       break;
     case PROFILE_ITERATOR:
     case MAX_ITERATOR:
@@ -52,6 +52,20 @@ IndexIterator *NewUnionIterator(IndexIterator **its, int num, DocTable *t, int q
 
 void UI_Foreach(IndexIterator *it, void (*callback)(IndexReader *it));
 
+/* Let a union iterator skip documents whose score cannot reach `*threshold`, the minimal score of
+ * the top results so far. The union's children must be term readers, or unions of term readers,
+ * and `bound` bounds the score contribution of a single term. The document scores are bounded and
+ * read from `docs`, or taken to be at most 1 if it is NULL. Only the union's Read is affected, so
+ * this applies to the root iterator of a query. Returns 0 if the union is not eligible */
+int UI_EnableScorePruning(IndexIterator *it, const double *threshold, RSTermScoreBound bound,
+                          const RSIndexStats *stats, const DocTable *docs);
+
+/* Switch a union of numeric range readers to numeric merge mode: the union reads its children in
+ * windows of (about) `window` docIds, keeping only a bitmap of the docIds and their values, instead
+ * of merging them through its heap. Every document is returned with a single numeric child.
+ * Returns 0 if the union is not eligible */
+int UI_EnableNumericMerge(IndexIterator *it, long long window);
+
 /* Create a new intersect iterator over the given list of child iterators. If maxSlop is not a
  * negative number, we will allow at most maxSlop intervening positions between the terms. If
  * maxSlop is set and inOrder is 1, we assert that the terms are in
@@ -84,6 +98,12 @@ IndexIterator *NewWildcardIterator(t_docId maxId, size_t numDocs);
  * the end and assumed to be allocated using rm_malloc */
 IndexIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight);
 
+/* Create a new IdListIterator over an array of sorted and unique document ids which is shared with
+ * the caller. The ids are neither copied nor freed - instead `release` is called with `owner` when
+ * the iterator is freed */
+IndexIterator *NewSharedIdListIterator(const t_docId *ids, t_offset num, double weight,
+                                       void (*release)(void *), void *owner);
+
 /** Create a new iterator which returns no results */
 IndexIterator *NewEmptyIterator(void);
 
@@ -31,6 +31,9 @@ enum iteratorType {
   METRIC_ITERATOR,
   PROFILE_ITERATOR,
   OPTIMUS_ITERATOR,
+  GEO_KNN_ITERATOR,
+  QUANTIZED_KNN_ITERATOR,
+  VECTOR_RANGE_ITERATOR,
   MAX_ITERATOR,
 };
 
@@ -108,8 +108,43 @@ RSIndexResult *NewMetricResult() {
   return res;
 }
 
-RSIndexResult *IndexResult_DeepCopy(const RSIndexResult *src) {
-  RSIndexResult *ret = rm_new(RSIndexResult);
+/* A deep copy of a result tree is laid out in a single allocation: first the results, then the
+ * children arrays of the aggregate results, and then the offset vectors of the term results */
+typedef struct {
+  size_t numResults;
+  size_t numChildren;
+  size_t offsetsLen;
+} ResultCopySize;
+
+typedef struct {
+  RSIndexResult *results;
+  RSIndexResult **children;
+  char *offsets;
+} ResultCopyArena;
+
+static void IndexResult_CopySize(const RSIndexResult *r, ResultCopySize *sz) {
+  ++sz->numResults;
+  switch (r->type) {
+    case RSResultType_Intersection:
+    case RSResultType_Union:
+    case RSResultType_HybridMetric:
+      sz->numChildren += r->agg.numChildren;
+      for (int i = 0; i < r->agg.numChildren; i++) {
+        IndexResult_CopySize(r->agg.children[i], sz);
+      }
+      break;
+    case RSResultType_Term:
+      if (r->term.offsets.data) {
+        sz->offsetsLen += r->term.offsets.len;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static RSIndexResult *IndexResult_CopyInto(const RSIndexResult *src, ResultCopyArena *arena) {
+  RSIndexResult *ret = arena->results++;
   *ret = *src;
   ret->isCopy = 1;
 
@@ -126,12 +161,13 @@ RSIndexResult *IndexResult_DeepCopy(const RSIndexResult *src) {
     case RSResultType_Intersection:
     case RSResultType_Union:
     case RSResultType_HybridMetric:
-      // allocate a new child pointer array
-      ret->agg.children = rm_malloc(src->agg.numChildren * sizeof(RSIndexResult *));
+      // take the child pointer array from the arena
+      ret->agg.children = arena->children;
       ret->agg.childrenCap = src->agg.numChildren;
+      arena->children += src->agg.numChildren;
       // deep copy recursively all children
       for (int i = 0; i < src->agg.numChildren; i++) {
-        ret->agg.children[i] = IndexResult_DeepCopy(src->agg.children[i]);
+        ret->agg.children[i] = IndexResult_CopyInto(src->agg.children[i], arena);
       }
       break;
 
@@ -139,8 +175,9 @@ RSIndexResult *IndexResult_DeepCopy(const RSIndexResult *src) {
     case RSResultType_Term:
       // copy the offset vectors
       if (src->term.offsets.data) {
-        ret->term.offsets.data = rm_malloc(ret->term.offsets.len);
+        ret->term.offsets.data = arena->offsets;
         memcpy(ret->term.offsets.data, src->term.offsets.data, ret->term.offsets.len);
+        arena->offsets += ret->term.offsets.len;
       }
       break;
 
@@ -151,6 +188,28 @@ RSIndexResult *IndexResult_DeepCopy(const RSIndexResult *src) {
   return ret;
 }
 
+RSIndexResult *IndexResult_DeepCopy(const RSIndexResult *src) {
+  ResultCopySize sz = {0};
+  IndexResult_CopySize(src, &sz);
+  size_t resultsLen = sz.numResults * sizeof(RSIndexResult);
+  size_t childrenLen = sz.numChildren * sizeof(RSIndexResult *);
+  char *buf = rm_malloc(resultsLen + childrenLen + sz.offsetsLen);
+  ResultCopyArena arena = {.results = (RSIndexResult *)buf,
+                           .children = (RSIndexResult **)(buf + resultsLen),
+                           .offsets = buf + resultsLen + childrenLen};
+  return IndexResult_CopyInto(src, &arena);
+}
+
+/* Free the metrics of all the results of a deep copy */
+static void IndexResult_FreeCopyMetrics(RSIndexResult *r) {
+  ResultMetrics_Free(r);
+  if (RSIndexResult_IsAggregate(r)) {
+    for (int i = 0; i < r->agg.numChildren; i++) {
+      IndexResult_FreeCopyMetrics(r->agg.children[i]);
+    }
+  }
+}
+
 void IndexResult_Print(RSIndexResult *r, int depth) {
   for (int i = 0; i < depth; i++) printf("  ");
 
@@ -237,26 +296,20 @@ int RSIndexResult_HasOffsets(const RSIndexResult *res) {
 
 void IndexResult_Free(RSIndexResult *r) {
   if (!r) return;
+  if (r->isCopy) {
+    // a deep copy is a single allocation, which also holds its children and offset vectors
+    IndexResult_FreeCopyMetrics(r);
+    rm_free(r);
+    return;
+  }
   ResultMetrics_Free(r);
   if (r->type == RSResultType_Intersection || r->type == RSResultType_Union || r->type == RSResultType_HybridMetric) {
-    // for deep-copy results we also free the children
-    if (r->isCopy && r->agg.children) {
-      for (int i = 0; i < r->agg.numChildren; i++) {
-        IndexResult_Free(r->agg.children[i]);
-      }
-    }
     rm_free(r->agg.children);
     r->agg.children = NULL;
   } else if (r->type == RSResultType_Term) {
-    if (r->isCopy) {
-      rm_free(r->term.offsets.data);
-
-    } else {  // non copy result...
-
-      // we only free up terms for non copy results
-      if (r->term.term != NULL) {
-        Term_Free(r->term.term);
-      }
+    // we only free up terms for non copy results
+    if (r->term.term != NULL) {
+      Term_Free(r->term.term);
     }
   }
 
@@ -98,8 +98,9 @@ static inline void AggregateResult_AddChild(RSIndexResult *parent, RSIndexResult
   parent->fieldMask |= child->fieldMask;
   ResultMetrics_Concat(parent, child);
 }
-/* Create a deep copy of the results that is totally thread safe. This is very slow so use it with
- * caution */
+/* Create a deep copy of the results that is totally thread safe. The copy, its children and their
+ * offset vectors are laid out in a single allocation, so only the root of a copy may be freed with
+ * IndexResult_Free, and children may not be added to its aggregates */
 RSIndexResult *IndexResult_DeepCopy(const RSIndexResult *res);
 
 /* Debug print a result */
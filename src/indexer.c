@@ -22,12 +22,14 @@ extern RedisModuleCtx *RSDummyContext;
 
 static void writeIndexEntry(IndexSpec *spec, InvertedIndex *idx, IndexEncoder encoder,
                             ForwardIndexEntry *entry) {
-  size_t sz = InvertedIndex_WriteForwardIndexEntry(idx, encoder, entry);
+  ssize_t resized = 0;
+  size_t sz = InvertedIndex_WriteForwardIndexEntry(idx, encoder, entry, &resized);
 
   // Update index statistics:
 
-  // Number of additional bytes
+  // Number of additional bytes, including the blocks sealed or unsealed by the write
   spec->stats.invertedSize += sz;
+  spec->stats.invertedSize += resized;
   // Number of records
   spec->stats.numRecords++;
 
@@ -78,6 +80,50 @@ static size_t countMerged(mergedEntry *ent) {
   return n;
 }
 
+// Sets the document id and length of the entry, before it is written
+static void prepareEntry(ForwardIndexEntry *entry, RSAddDocumentCtx *aCtx) {
+  entry->docId = aCtx->doc->docId;
+  RS_LOG_ASSERT(entry->docId, "docId should not be 0");
+  // the document length is kept in 24 bits in the metadata, report unknown (0) on overflow
+  entry->docLen = aCtx->fwIdx->totalFreq <= 0xFFFFFF ? aCtx->fwIdx->totalFreq : 0;
+}
+
+/**
+ * Writes a list of entries of the same term, linked by their `next` member and in ascending order
+ * of their document ids. The term is looked up, and its inverted index opened, once for the whole
+ * list.
+ */
+static void writeTermEntries(RedisSearchCtx *ctx, IndexEncoder encoder, ForwardIndexEntry *head) {
+  IndexSpec *spec = ctx->spec;
+  RedisModuleKey *idxKey = NULL;
+  bool isNew;
+  InvertedIndex *invidx = Redis_OpenInvertedIndexEx(ctx, head->term, head->len, 1, &isNew, &idxKey);
+  if (isNew) {
+    IndexSpec_AddTerm(spec, head->term, head->len);
+  }
+
+  t_fieldMask fieldMask = 0;
+  for (ForwardIndexEntry *entry = head; entry; entry = entry->next) {
+    if (invidx) {
+      writeIndexEntry(spec, invidx, encoder, entry);
+    }
+    fieldMask |= entry->fieldMask;
+  }
+  if (invidx && Index_StoreFieldMask(spec)) {
+    invidx->fieldMask |= fieldMask;
+  }
+
+  if (spec->suffixMask & fieldMask && head->term[0] != STEM_PREFIX
+                                   && head->term[0] != PHONETIC_PREFIX
+                                   && head->term[0] != SYNONYM_PREFIX_CHAR) {
+    addSuffixTrie(spec->suffix, head->term, head->len);
+  }
+
+  if (idxKey) {
+    RedisModule_CloseKey(idxKey);
+  }
+}
+
 /**
  * Simple implementation, writes all the entries for a single document. This
  * function is used when there is only one item in the queue. In this case
@@ -87,39 +133,60 @@ static size_t countMerged(mergedEntry *ent) {
 static void writeCurEntries(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx, RedisSearchCtx *ctx) {
   RS_LOG_ASSERT(ctx, "ctx should not be NULL");
 
-  IndexSpec *spec = ctx->spec;
   ForwardIndexIterator it = ForwardIndex_Iterate(aCtx->fwIdx);
   ForwardIndexEntry *entry = ForwardIndexIterator_Next(&it);
   IndexEncoder encoder = InvertedIndex_GetEncoder(aCtx->specFlags);
 
   while (entry != NULL) {
-    RedisModuleKey *idxKey = NULL;
-    bool isNew;
-    InvertedIndex *invidx = Redis_OpenInvertedIndexEx(ctx, entry->term, entry->len, 1, &isNew, &idxKey);
-    if (isNew) {
-      IndexSpec_AddTerm(spec, entry->term, entry->len);
-    }
-    if (invidx) {
-      entry->docId = aCtx->doc->docId;
-      RS_LOG_ASSERT(entry->docId, "docId should not be 0");
-      writeIndexEntry(spec, invidx, encoder, entry);
-      if (Index_StoreFieldMask(spec)) {
-        invidx->fieldMask |= entry->fieldMask;
-      }
-    }
+    prepareEntry(entry, aCtx);
+    entry->next = NULL;
+    writeTermEntries(ctx, encoder, entry);
+    entry = ForwardIndexIterator_Next(&it);
+  }
+}
 
-    if (spec->suffixMask & entry->fieldMask && entry->term[0] != STEM_PREFIX
-                                            && entry->term[0] != PHONETIC_PREFIX
-                                            && entry->term[0] != SYNONYM_PREFIX_CHAR) {
-      addSuffixTrie(spec->suffix, entry->term, entry->len);
-    }
+/**
+ * Writes the entries of a chain of documents, whose ids were assigned in ascending order. The
+ * entries of all the documents are first merged by term, so each term is looked up and its
+ * inverted index appended to once for the whole chain, instead of once per document.
+ */
+static void writeMergedEntries(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx,
+                               RedisSearchCtx *ctx) {
+  RS_LOG_ASSERT(ctx, "ctx should not be NULL");
+
+  KHTable *ht = &indexer->mergeHt;
+  IndexEncoder encoder = InvertedIndex_GetEncoder(aCtx->specFlags);
 
-    if (idxKey) {
-      RedisModule_CloseKey(idxKey);
+  for (RSAddDocumentCtx *cur = aCtx; cur; cur = cur->next) {
+    if (!cur->fwIdx || (cur->stateFlags & ACTX_F_ERRORED) || !cur->doc->docId) {
+      continue;
+    }
+    ForwardIndexIterator it = ForwardIndex_Iterate(cur->fwIdx);
+    ForwardIndexEntry *entry;
+    while ((entry = ForwardIndexIterator_Next(&it))) {
+      prepareEntry(entry, cur);
+      entry->next = NULL;
+      int isNew = 0;
+      mergedEntry *merged =
+          (mergedEntry *)KHTable_GetEntry(ht, entry->term, entry->len, entry->hash, &isNew);
+      if (isNew) {
+        merged->head = merged->tail = entry;
+      } else {
+        merged->tail->next = entry;
+        merged->tail = entry;
+      }
     }
+  }
 
-    entry = ForwardIndexIterator_Next(&it);
+  KHTableIterator iter;
+  KHTableIter_Init(ht, &iter);
+  KHTableEntry *ent;
+  while ((ent = KHtableIter_Next(&iter))) {
+    writeTermEntries(ctx, encoder, ((mergedEntry *)ent)->head);
   }
+
+  KHTable_Clear(ht);
+  BlkAlloc_Clear(&indexer->alloc, NULL, NULL, 0);
 }
 
 /** Assigns a document ID to a single document. */
@@ -141,8 +208,12 @@ static RSDocumentMetadata *makeDocumentId(RedisModuleCtx *ctx, RSAddDocumentCtx
         for (int i = 0; i < spec->numFields; ++i) {
           if (spec->fields[i].types == INDEXFLD_T_VECTOR) {
             RedisModuleString * rmstr = RedisModule_CreateString(RSDummyContext, spec->fields[i].name, strlen(spec->fields[i].name));
-            VecSimIndex *vecsim = OpenVectorIndex(spec, rmstr);
-            VecSimIndex_DeleteVector(vecsim, dmd->id);
+            if (FieldSpec_IsQuantized(&spec->fields[i])) {
+              QuantizedIndex_Delete(OpenQuantizedVectorIndex(spec, rmstr), dmd->id);
+            } else {
+              VecSimIndex *vecsim = OpenVectorIndex(spec, rmstr);
+              VecSimIndex_DeleteVector(vecsim, dmd->id);
+            }
             RedisModule_FreeString(RSDummyContext, rmstr);
             // TODO: use VecSimReplace instead and if successful, do not insert and remove from doc
           }
@@ -190,6 +261,7 @@ static void doAssignIds(RSAddDocumentCtx *cur, RedisSearchCtx *ctx) {
 
     md->maxFreq = cur->fwIdx->maxFreq;
     md->len = cur->fwIdx->totalFreq;
+    DocTable_UpdateColumns(&spec->docs, md);
     spec->stats.totalDocsLen += md->len;
 
     if (cur->sv) {
@@ -212,8 +284,8 @@ static void indexBulkFields(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
   IndexBulkData *activeBulks[SPEC_MAX_FIELDS];
   size_t numActiveBulks = 0;
 
-  for (RSAddDocumentCtx *cur = aCtx; cur && cur->doc->docId; cur = cur->next) {
-    if (cur->stateFlags & ACTX_F_ERRORED) {
+  for (RSAddDocumentCtx *cur = aCtx; cur; cur = cur->next) {
+    if (!cur->doc->docId || (cur->stateFlags & ACTX_F_ERRORED)) {
       continue;
     }
 
@@ -298,13 +370,18 @@ static void Indexer_Process(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx) {
   }
 
   // Handle FULLTEXT indexes
-  if ((aCtx->fwIdx && (aCtx->stateFlags & ACTX_F_ERRORED) == 0)) {
+  if (aCtx->next) {
+    writeMergedEntries(indexer, aCtx, &ctx);
+  } else if ((aCtx->fwIdx && (aCtx->stateFlags & ACTX_F_ERRORED) == 0)) {
     writeCurEntries(indexer, aCtx, &ctx);
   }
 
-  if (!(aCtx->stateFlags & ACTX_F_OTHERINDEXED)) {
+  if (aCtx->next || !(aCtx->stateFlags & ACTX_F_OTHERINDEXED)) {
     indexBulkFields(aCtx, &ctx);
   }
+
+  // the results of queries may have changed, only after the documents were fully indexed
+  ctx.spec->revision++;
 }
 
 int Indexer_Add(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx) {
@@ -313,6 +390,27 @@ int Indexer_Add(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx) {
   return 0;
 }
 
+void Indexer_AddBatch(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx) {
+  while (aCtx) {
+    // split the chain, the number of documents merged at once is bounded
+    RSAddDocumentCtx *last = aCtx;
+    for (size_t n = 1; n < MAX_BULK_DOCS && last->next; ++n) {
+      last = last->next;
+    }
+    RSAddDocumentCtx *rest = last->next;
+    last->next = NULL;
+
+    Indexer_Process(indexer, aCtx);
+    while (aCtx) {
+      RSAddDocumentCtx *next = aCtx->next;
+      aCtx->next = NULL;
+      AddDocumentCtx_Finish(aCtx);
+      aCtx = next;
+    }
+    aCtx = rest;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 /// Multiple Indexers                                                        ///
@@ -342,10 +440,20 @@ DocumentIndexer *NewIndexer(IndexSpec *spec) {
       RedisModule_CreateStringPrintf(indexer->redisCtx, INDEX_SPEC_KEY_FMT, spec->name);
 
   ConcurrentSearchCtx_InitSingle(&indexer->concCtx, indexer->redisCtx, reopenCb);
+
+  static const KHTableProcs procs = {
+      .Alloc = mergedAlloc,
+      .Compare = mergedCompare,
+      .Hash = mergedHash,
+  };
+  BlkAlloc_Init(&indexer->alloc);
+  KHTable_Init(&indexer->mergeHt, &procs, &indexer->alloc, 4096);
   return indexer;
 }
 
 void Indexer_Free(DocumentIndexer *indexer) {
+  KHTable_Free(&indexer->mergeHt);
+  BlkAlloc_FreeAll(&indexer->alloc, NULL, NULL, 0);
   rm_free(indexer->concCtx.openKeys);
   RedisModule_FreeString(indexer->redisCtx, indexer->specKeyName);
   RedisModule_FreeThreadSafeContext(indexer->redisCtx);
@@ -10,6 +10,8 @@
 #include "document.h"
 #include "concurrent_ctx.h"
 #include "util/arr.h"
+#include "util/khtable.h"
+#include "util/block_alloc.h"
 #include "geometry_index.h"
 // Preprocessors can store field data to this location
 typedef struct FieldIndexerData {
@@ -48,6 +50,8 @@ typedef struct DocumentIndexer {
   RedisModuleCtx *redisCtx;        // Context for keeping the spec key
   RedisModuleString *specKeyName;  // Cached, used for opening/closing the spec key.
   uint64_t specId;                 // Unique spec ID. Used to verify we haven't been replaced
+  KHTable mergeHt;                 // Hashtable and block allocator for merging the terms of a batch
+  BlkAlloc alloc;
 } DocumentIndexer;
 
 void Indexer_Free(DocumentIndexer *indexer);
@@ -59,6 +63,14 @@ DocumentIndexer *NewIndexer(IndexSpec *spec);
  */
 int Indexer_Add(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx);
 
+/**
+ * Add a chain of documents (linked by their `next` member) to the index. The documents are
+ * assigned ids in the order of the chain, and the entries of their forward indexes are merged by
+ * term, so each term is looked up and written once for many documents. Every context of the chain
+ * is finished.
+ */
+void Indexer_AddBatch(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx);
+
 /**
  * Function to preprocess field data. This should do as much stateless processing
  * as possible on the field - this means things like input validation and normalization.
@@ -7,6 +7,7 @@
 #include "spec.h"
 #include "inverted_index.h"
 #include "vector_index.h"
+#include "hybrid_stats.h"
 #include "cursor.h"
 #include "resp3.h"
 #include "geometry/geometry_api.h"
@@ -33,6 +34,9 @@ static void renderIndexOptions(RedisModule_Reply *reply, IndexSpec *sp) {
   if (sp->flags & Index_WideSchema) {
     RedisModule_Reply_SimpleString(reply, SPEC_SCHEMA_EXPANDABLE_STR);
   }
+  if (sp->flags & Index_BlockPacked) {
+    RedisModule_Reply_SimpleString(reply, SPEC_PACKED_STR);
+  }
   RedisModule_Reply_ArrayEnd(reply);
 }
 
@@ -171,6 +175,10 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
         REPLY_KVSTR("data_type", VecSimType_ToString(algo_params.bfParams.type));
         REPLY_KVINT("dim", algo_params.bfParams.dim);
         REPLY_KVSTR("distance_metric", VecSimMetric_ToString(algo_params.bfParams.metric));
+        if (FieldSpec_IsQuantized(fs)) {
+          REPLY_KVSTR("quantization", VECSIM_QUANT_SQ8);
+          REPLY_KVINT("rerank", fs->vectorOpts.quantParams.rerank);
+        }
       }
     }
 
@@ -255,6 +263,11 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     RedisModule_Reply_MapEnd(reply);
   }
 
+  if (sp->hybridStats && HybridStats_Size(sp->hybridStats)) {
+    RedisModule_Reply_SimpleString(reply, "hybrid_filter_stats");
+    HybridStats_Reply(sp->hybridStats, reply);
+  }
+
   Cursors_RenderStats(&g_CursorsList, &g_CursorsListCoord, sp, reply);
 
   if (sp->flags & Index_HasCustomStopwords) {
@@ -10,6 +10,8 @@
 #include "varint.h"
 #include <stdio.h>
 #include <float.h>
+#include <pthread.h>
+#include <sys/param.h>
 #include "rmalloc.h"
 #include "qint.h"
 #include "qint.c"
@@ -19,6 +21,8 @@
 #include "rmutil/rm_assert.h"
 #include "geo_index.h"
 #include "module.h"
+#include "pfor.h"
+#include "util/arr.h"
 
 uint64_t TotalIIBlocks = 0;
 
@@ -35,9 +39,33 @@ uint64_t TotalIIBlocks = 0;
 // pointer to the current block while reading the index
 #define IR_CURRENT_BLOCK(ir) (ir->idx->blocks[ir->currentBlock])
 
+// In Index_BlockPacked indexes, every block starts with one of these format bytes. The last block is
+// always "staged" - records are written one by one by the regular encoders. Once a block is full it
+// is sealed and re-encoded as bit-packed frames, or - for dense doc-ids-only blocks - as a bitmap
+// with a bit for every document id between the first and last ids of the block. Numeric blocks are
+// sealed as columns: a zone map (the minimal and maximal values of the block), the bit-packed doc
+// id deltas, and then the values - bit-packed offsets from the minimal value if they are all
+// integers, or an array of doubles otherwise
+#define INDEX_BLOCK_STAGED 0
+#define INDEX_BLOCK_PACKED 1
+#define INDEX_BLOCK_BITMAP 2
+#define INDEX_BLOCK_COLUMNAR 3
+
+// A doc-ids-only block is sealed as a bitmap if its id range is at most this many times larger than
+// its number of records, i.e. if the bitmap takes at most a byte per record
+#define INDEX_BLOCK_BITMAP_MAX_SPARSITY 8
+
+#define IndexBlock_Format(blk) ((blk)->buf.offset ? (uint8_t)(blk)->buf.data[0] : INDEX_BLOCK_STAGED)
+#define IndexBlock_IsSealed(blk) (IndexBlock_Format(blk) != INDEX_BLOCK_STAGED)
+
 static IndexReader *NewIndexReaderGeneric(const IndexSpec *sp, InvertedIndex *idx,
                                           IndexDecoderProcs decoder, IndexDecoderCtx decoderCtx, int skipMulti,
                                           RSIndexResult *record);
+static void IndexReader_DecodeBlock(IndexReader *ir);
+static uint32_t IndexBlock_DecodeNumeric(const IndexBlock *blk, IndexFlags flags,
+                                         const NumericFilter *f, IndexBlockDecoded *out);
+static ssize_t IndexBlock_Pack(IndexBlock *blk, IndexFlags flags);
+static ssize_t IndexBlock_Unpack(IndexBlock *blk, IndexFlags flags, IndexEncoder encoder);
 
 /* Add a new block to the index with a given document id as the initial id */
 IndexBlock *InvertedIndex_AddBlock(InvertedIndex *idx, t_docId firstId) {
@@ -79,6 +107,7 @@ InvertedIndex *NewInvertedIndex(IndexFlags flags, int initBlock) {
 
 void indexBlock_Free(IndexBlock *blk) {
   Buffer_Free(&blk->buf);
+  array_free(blk->skips);
 }
 
 void InvertedIndex_Free(void *ctx) {
@@ -133,6 +162,12 @@ void IndexReader_OnReopen(IndexReader *ir) {
     size_t offset = ir->br.pos;
     ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
     ir->br.pos = offset;
+    if (ir->blockDecoding) {
+      // records might have been appended to the block while we were asleep
+      uint32_t pos = ir->decodedPos;
+      IndexReader_DecodeBlock(ir);
+      ir->decodedPos = pos;
+    }
   } else {
     // if there has been a GC cycle on this key while we were asleep, the offset might not be valid
     // anymore. This means that we need to seek to last docId we were at
@@ -506,7 +541,7 @@ IndexEncoder InvertedIndex_GetEncoder(IndexFlags flags) {
 
 /* Write a forward-index entry to an index writer */
 size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder, t_docId docId,
-                                       RSIndexResult *entry) {
+                                       RSIndexResult *entry, ssize_t *resized) {
 
   int same_doc = 0;
   if (idx->lastId && idx->lastId == docId) {
@@ -521,6 +556,8 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
   }
 
   t_docId delta = 0;
+  // sealing and unsealing blocks changes their size, which is reported apart from the record
+  ssize_t resize = 0;
   IndexBlock *blk = &INDEX_LAST_BLOCK(idx);
 
   // use proper block size. Index_DocIdsOnly == 0x00
@@ -530,6 +567,9 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
 
   // see if we need to grow the current block
   if (blk->numEntries >= blockSize && !same_doc) {
+    if (idx->flags & Index_BlockPacked) {
+      resize += IndexBlock_Pack(blk, idx->flags);
+    }
     // If same doc can span more than a single block - need to adjust IndexReader_SkipToBlock
     blk = InvertedIndex_AddBlock(idx, docId);
   } else if (blk->numEntries == 0) {
@@ -546,10 +586,33 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
   //
   // For numeric encoder the maximal delta is practically not a limit (see structs `EncodingHeader` and `NumEncodingCommon`)
   if (delta > UINT32_MAX && encoder != encodeNumeric) {
+    if (idx->flags & Index_BlockPacked) {
+      resize += IndexBlock_Pack(blk, idx->flags);
+    }
     blk = InvertedIndex_AddBlock(idx, docId);
     delta = 0;
   }
 
+  if (idx->flags & Index_BlockPacked) {
+    if (!blk->buf.offset) {
+      BufferWriter hw = NewBufferWriter(&blk->buf);
+      resize += Buffer_WriteU8(&hw, INDEX_BLOCK_STAGED);
+    } else if (IndexBlock_IsSealed(blk)) {
+      resize += IndexBlock_Unpack(blk, idx->flags, encoder);
+    }
+  }
+
+  // Every INDEX_BLOCK_SKIP_INTERVAL records, remember where the next record starts. Packed blocks
+  // are always read by the block decoder, which does not need skip points
+  if (RSGlobalConfig.invertedIndexBlockSkips && blk->numEntries &&
+      !(blk->numEntries % INDEX_BLOCK_SKIP_INTERVAL) && !(idx->flags & Index_BlockPacked)) {
+    IndexBlockSkip skip = {.lastId = blk->lastId, .offset = blk->buf.offset};
+    if (!blk->skips) {
+      blk->skips = array_new(IndexBlockSkip, 4);
+    }
+    blk->skips = array_append(blk->skips, skip);
+  }
+
   BufferWriter bw = NewBufferWriter(&blk->buf);
 
   size_t ret = encoder(&bw, delta, entry);
@@ -563,13 +626,31 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
   if (encoder == encodeNumeric) {
     ++idx->numEntries;
   }
+  if (resized) {
+    *resized += resize;
+  }
 
   return ret;
 }
 
+/* Update the statistics of a block with the record that was just written to it */
+static void IndexBlock_UpdateStats(IndexBlock *blk, uint32_t freq, uint32_t docLen) {
+  uint16_t f = MIN(freq, UINT16_MAX);
+  if (blk->numEntries == 1) {
+    blk->maxFreq = f;
+    blk->minDocLen = docLen;
+    return;
+  }
+  // an unknown maximal frequency remains unknown
+  if (blk->maxFreq && f > blk->maxFreq) {
+    blk->maxFreq = f;
+  }
+  blk->minDocLen = MIN(blk->minDocLen, docLen);
+}
+
 /** Write a forward-index entry to the index */
 size_t InvertedIndex_WriteForwardIndexEntry(InvertedIndex *idx, IndexEncoder encoder,
-                                            ForwardIndexEntry *ent) {
+                                            ForwardIndexEntry *ent, ssize_t *resized) {
   RSIndexResult rec = {.type = RSResultType_Term,
                        .docId = ent->docId,
                        .offsetsSz = VVW_GetByteLength(ent->vw),
@@ -581,24 +662,44 @@ size_t InvertedIndex_WriteForwardIndexEntry(InvertedIndex *idx, IndexEncoder enc
     rec.term.offsets.data = VVW_GetByteData(ent->vw);
     rec.term.offsets.len = VVW_GetByteLength(ent->vw);
   }
-  return InvertedIndex_WriteEntryGeneric(idx, encoder, ent->docId, &rec);
+  size_t ret = InvertedIndex_WriteEntryGeneric(idx, encoder, ent->docId, &rec, resized);
+  if (ret) {
+    IndexBlock_UpdateStats(&INDEX_LAST_BLOCK(idx), ent->freq, ent->docLen);
+  }
+  return ret;
 }
 
 /* Write a numeric entry to the index */
-size_t InvertedIndex_WriteNumericEntry(InvertedIndex *idx, t_docId docId, double value) {
+size_t InvertedIndex_WriteNumericEntry(InvertedIndex *idx, t_docId docId, double value,
+                                       ssize_t *resized) {
 
   RSIndexResult rec = (RSIndexResult){
       .docId = docId,
       .type = RSResultType_Numeric,
       .num = (RSNumericRecord){.value = value},
   };
-  return InvertedIndex_WriteEntryGeneric(idx, encodeNumeric, docId, &rec);
+  return InvertedIndex_WriteEntryGeneric(idx, encodeNumeric, docId, &rec, resized);
+}
+
+// In block decoding mode, decode the reader's current block and point at its first record
+static void IndexReader_DecodeBlock(IndexReader *ir) {
+  if (!ir->blockDecoding) {
+    return;
+  }
+  if (ir->idx->flags & Index_StoreNumeric) {
+    IndexBlock_DecodeNumeric(&IR_CURRENT_BLOCK(ir), ir->idx->flags, ir->decoderCtx.ptr,
+                             &ir->decoded);
+  } else {
+    IndexBlock_Decode(&IR_CURRENT_BLOCK(ir), ir->idx->flags, &ir->decoded);
+  }
+  ir->decodedPos = 0;
 }
 
 static void IndexReader_AdvanceBlock(IndexReader *ir) {
   ir->currentBlock++;
   ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
   ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
+  IndexReader_DecodeBlock(ir);
 }
 
 /******************************************************************************
@@ -952,6 +1053,715 @@ IndexDecoderProcs InvertedIndex_GetDecoder(uint32_t flags) {
   }
 }
 
+/******************************************************************************
+ * Block Decoding.
+ *
+ * In block decoding mode a reader decodes all the records of its current block at once into
+ * flat arrays (see IndexBlockDecoded), and then iterates or binary searches over them. The records
+ * themselves are variable-length, so they are still decoded one by one, but in a tight loop
+ * specialized for the index flags. Turning the deltas into absolute document ids is a prefix sum,
+ * which we vectorize when the CPU supports it.
+ *
+ ******************************************************************************/
+
+typedef void (*DocIdsKernel)(t_docId *out, const uint32_t *deltas, uint32_t n, t_docId base);
+
+// Numeric filtering kernels keep only the records whose values match the filter, compacting the ids
+// and values arrays in place. Returns the number of records kept
+typedef uint32_t (*ValuesFilterKernel)(t_docId *ids, double *values, uint32_t n,
+                                       const NumericFilter *f);
+
+// Scalar fallbacks. `prefixSum` is used for delta encoded blocks, where every record is relative
+// to the previous one, and `addBase` for raw encoded blocks, where it is relative to the first id
+static void prefixSum_scalar(t_docId *out, const uint32_t *deltas, uint32_t n, t_docId base) {
+  for (uint32_t i = 0; i < n; ++i) {
+    base += deltas[i];
+    out[i] = base;
+  }
+}
+
+static void addBase_scalar(t_docId *out, const uint32_t *deltas, uint32_t n, t_docId base) {
+  for (uint32_t i = 0; i < n; ++i) {
+    out[i] = base + deltas[i];
+  }
+}
+
+static uint32_t filterValues_scalar(t_docId *ids, double *values, uint32_t n,
+                                    const NumericFilter *f) {
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    if (NumericFilter_Match(f, values[i])) {
+      ids[kept] = ids[i];
+      values[kept] = values[i];
+      ++kept;
+    }
+  }
+  return kept;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+
+__attribute__((target("avx2")))
+static void prefixSum_avx2(t_docId *out, const uint32_t *deltas, uint32_t n, t_docId base) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i carry = _mm256_set1_epi64x(base);
+  uint32_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i x = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(deltas + i)));
+    // [a, b, c, d] -> [a, a+b, b+c, c+d]
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(
+                                _mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03));
+    // -> [a, a+b, a+b+c, a+b+c+d]
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(
+                                _mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F));
+    x = _mm256_add_epi64(x, carry);
+    _mm256_storeu_si256((__m256i *)(out + i), x);
+    carry = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  if (i < n) {
+    prefixSum_scalar(out + i, deltas + i, n - i, i ? out[i - 1] : base);
+  }
+}
+
+__attribute__((target("avx2")))
+static void addBase_avx2(t_docId *out, const uint32_t *deltas, uint32_t n, t_docId base) {
+  const __m256i vbase = _mm256_set1_epi64x(base);
+  uint32_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i x = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(deltas + i)));
+    _mm256_storeu_si256((__m256i *)(out + i), _mm256_add_epi64(x, vbase));
+  }
+  addBase_scalar(out + i, deltas + i, n - i, base);
+}
+
+__attribute__((target("sse4.1")))
+static void prefixSum_sse41(t_docId *out, const uint32_t *deltas, uint32_t n, t_docId base) {
+  __m128i carry = _mm_set1_epi64x(base);
+  uint32_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128i x = _mm_cvtepu32_epi64(_mm_loadl_epi64((const __m128i *)(deltas + i)));
+    // [a, b] -> [a, a+b]
+    x = _mm_add_epi64(x, _mm_slli_si128(x, 8));
+    x = _mm_add_epi64(x, carry);
+    _mm_storeu_si128((__m128i *)(out + i), x);
+    carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 2, 3, 2));
+  }
+  if (i < n) {
+    prefixSum_scalar(out + i, deltas + i, n - i, i ? out[i - 1] : base);
+  }
+}
+
+__attribute__((target("sse4.1")))
+static void addBase_sse41(t_docId *out, const uint32_t *deltas, uint32_t n, t_docId base) {
+  const __m128i vbase = _mm_set1_epi64x(base);
+  uint32_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128i x = _mm_cvtepu32_epi64(_mm_loadl_epi64((const __m128i *)(deltas + i)));
+    _mm_storeu_si128((__m128i *)(out + i), _mm_add_epi64(x, vbase));
+  }
+  addBase_scalar(out + i, deltas + i, n - i, base);
+}
+
+// Compare four values at a time against both ends of the range. Runs of matching values are left
+// in place, and only the records following a rejected one are moved
+__attribute__((target("avx2")))
+static uint32_t filterValues_avx2(t_docId *ids, double *values, uint32_t n,
+                                  const NumericFilter *f) {
+  const __m256d vmin = _mm256_set1_pd(f->min);
+  const __m256d vmax = _mm256_set1_pd(f->max);
+  uint32_t kept = 0, i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d v = _mm256_loadu_pd(values + i);
+    __m256d lo = f->inclusiveMin ? _mm256_cmp_pd(v, vmin, _CMP_GE_OQ)
+                                 : _mm256_cmp_pd(v, vmin, _CMP_GT_OQ);
+    __m256d hi = f->inclusiveMax ? _mm256_cmp_pd(v, vmax, _CMP_LE_OQ)
+                                 : _mm256_cmp_pd(v, vmax, _CMP_LT_OQ);
+    uint32_t mask = _mm256_movemask_pd(_mm256_and_pd(lo, hi));
+    if (mask == 0xF && kept == i) {
+      kept += 4;
+      continue;
+    }
+    while (mask) {
+      uint32_t j = i + __builtin_ctz(mask);
+      ids[kept] = ids[j];
+      values[kept] = values[j];
+      ++kept;
+      mask &= mask - 1;
+    }
+  }
+  for (; i < n; ++i) {
+    if (NumericFilter_Match(f, values[i])) {
+      ids[kept] = ids[i];
+      values[kept] = values[i];
+      ++kept;
+    }
+  }
+  return kept;
+}
+#endif  // __x86_64__ && __GNUC__
+
+static DocIdsKernel prefixSum_g = NULL;
+static DocIdsKernel addBase_g = NULL;
+static ValuesFilterKernel filterValues_g = NULL;
+static pthread_once_t selectDocIdsKernelsOnce_g = PTHREAD_ONCE_INIT;
+
+// Select the best kernels for the running CPU. Runs once, before the first block is decoded by any
+// thread
+static void selectDocIdsKernels() {
+  DocIdsKernel prefixSum = prefixSum_scalar, addBase = addBase_scalar;
+  ValuesFilterKernel filterValues = filterValues_scalar;
+#if defined(__x86_64__) && defined(__GNUC__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    prefixSum = prefixSum_avx2;
+    addBase = addBase_avx2;
+    filterValues = filterValues_avx2;
+  } else if (__builtin_cpu_supports("sse4.1")) {
+    prefixSum = prefixSum_sse41;
+    addBase = addBase_sse41;
+  }
+#endif
+  filterValues_g = filterValues;
+  addBase_g = addBase;
+  prefixSum_g = prefixSum;
+}
+
+static void IndexBlockDecoded_Grow(IndexBlockDecoded *out, IndexFlags flags, uint32_t cap) {
+  out->cap = cap;
+  out->docIds = rm_realloc(out->docIds, cap * sizeof(*out->docIds));
+  out->deltas = rm_realloc(out->deltas, cap * sizeof(*out->deltas));
+  if (flags & Index_StoreFreqs) {
+    out->freqs = rm_realloc(out->freqs, cap * sizeof(*out->freqs));
+  }
+  if (flags & Index_StoreFieldFlags) {
+    out->fieldMasks = rm_realloc(out->fieldMasks, cap * sizeof(*out->fieldMasks));
+  }
+  if (flags & Index_StoreTermOffsets) {
+    out->offsetsSz = rm_realloc(out->offsetsSz, cap * sizeof(*out->offsetsSz));
+    out->offsetsPos = rm_realloc(out->offsetsPos, cap * sizeof(*out->offsetsPos));
+  }
+  if (flags & Index_StoreNumeric) {
+    out->values = rm_realloc(out->values, cap * sizeof(*out->values));
+  }
+}
+
+void IndexBlockDecoded_Free(IndexBlockDecoded *decoded) {
+  rm_free(decoded->docIds);
+  rm_free(decoded->deltas);
+  rm_free(decoded->freqs);
+  rm_free(decoded->fieldMasks);
+  rm_free(decoded->offsetsSz);
+  rm_free(decoded->offsetsPos);
+  rm_free(decoded->values);
+  *decoded = (IndexBlockDecoded){0};
+}
+
+// Decode the records of the block one after the other with `body`, which reads the record at
+// position n from `br`. Must be used inside the storage flags switch of IndexBlock_Decode
+#define DECODE_RECORDS(...)                                  \
+  while (!BufferReader_AtEnd(&br)) {                         \
+    if (n == out->cap) {                                     \
+      IndexBlockDecoded_Grow(out, flags, out->cap * 2 + 16); \
+    }                                                        \
+    __VA_ARGS__;                                             \
+    ++n;                                                     \
+  }                                                          \
+  break;
+
+#define DECODE_OFFSETS()             \
+  out->offsetsPos[n] = br.pos;       \
+  Buffer_Skip(&br, out->offsetsSz[n]);
+
+static uint32_t IndexBlock_DecodePacked(const IndexBlock *blk, IndexFlags flags, BufferReader *br,
+                                        IndexBlockDecoded *out) {
+  uint32_t n = ReadVarint(br);
+  if (out->cap < n) {
+    IndexBlockDecoded_Grow(out, flags, n);
+  }
+
+  PFor_Decode(br, out->deltas, n);
+  if (flags & Index_StoreFreqs) {
+    PFor_Decode(br, out->freqs, n);
+  }
+  if (flags & Index_StoreFieldFlags) {
+    if (flags & Index_WideSchema) {
+      for (uint32_t i = 0; i < n; ++i) {
+        out->fieldMasks[i] = ReadVarintFieldMask(br);
+      }
+    } else {
+      // the doc ids are computed last, so we can use them as scratch space
+      uint32_t *masks = (uint32_t *)out->docIds;
+      PFor_Decode(br, masks, n);
+      for (uint32_t i = 0; i < n; ++i) {
+        out->fieldMasks[i] = masks[i];
+      }
+    }
+  }
+  if (flags & Index_StoreTermOffsets) {
+    // the offset vectors are stored one after the other at the end of the block
+    PFor_Decode(br, out->offsetsSz, n);
+    uint32_t pos = br->pos;
+    for (uint32_t i = 0; i < n; ++i) {
+      out->offsetsPos[i] = pos;
+      pos += out->offsetsSz[i];
+    }
+  }
+
+  prefixSum_g(out->docIds, out->deltas, n, blk->firstId);
+  out->len = n;
+  return n;
+}
+
+/* Decode a bitmap block. Bit i of the bitmap is set if document `firstId + i` is in the block */
+static uint32_t IndexBlock_DecodeBitmap(const IndexBlock *blk, BufferReader *br,
+                                        IndexBlockDecoded *out) {
+  const uint8_t *bits = (const uint8_t *)(br->buf->data + br->pos);
+  size_t nbytes = br->buf->offset - br->pos;
+  uint32_t n = 0;
+  for (size_t i = 0; i < nbytes; i += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    memcpy(&word, bits + i, MIN(sizeof(word), nbytes - i));
+    while (word) {
+      out->docIds[n++] = blk->firstId + i * 8 + __builtin_ctzll(word);
+      word &= word - 1;
+    }
+  }
+  out->len = n;
+  return n;
+}
+
+// The zone map of a columnar block follows its format byte
+#define COLUMNAR_ZONE_MAP_SIZE (2 * sizeof(double))
+
+// The values column of a columnar block starts with one of these encoding bytes
+#define COLUMNAR_VALUES_DOUBLES 0
+#define COLUMNAR_VALUES_INTEGERS 1
+
+// Integers up to this magnitude are represented exactly by doubles
+#define COLUMNAR_MAX_EXACT_INTEGER 9007199254740992.0  // 2^53
+
+/* Read the zone map of a columnar block - the minimal and maximal values of its records */
+static void IndexBlock_ZoneMap(const IndexBlock *blk, double *min, double *max) {
+  memcpy(min, blk->buf.data + 1, sizeof(double));
+  memcpy(max, blk->buf.data + 1 + sizeof(double), sizeof(double));
+}
+
+/* Decode a columnar numeric block, positioned after its format byte */
+static uint32_t IndexBlock_DecodeColumnar(const IndexBlock *blk, BufferReader *br,
+                                          IndexBlockDecoded *out) {
+  Buffer_Skip(br, COLUMNAR_ZONE_MAP_SIZE);
+  uint32_t n = ReadVarint(br);
+  if (out->cap < n) {
+    IndexBlockDecoded_Grow(out, Index_StoreNumeric, n);
+  }
+  PFor_Decode(br, out->deltas, n);
+  prefixSum_g(out->docIds, out->deltas, n, blk->firstId);
+  if (Buffer_ReadU8(br) == COLUMNAR_VALUES_INTEGERS) {
+    // the doc id deltas were consumed, the value offsets are unpacked in their place
+    double min, max;
+    IndexBlock_ZoneMap(blk, &min, &max);
+    PFor_Decode(br, out->deltas, n);
+    for (uint32_t i = 0; i < n; ++i) {
+      out->values[i] = min + out->deltas[i];
+    }
+  } else {
+    Buffer_Read(br, out->values, n * sizeof(double));
+  }
+  out->len = n;
+  return n;
+}
+
+/* Decode a staged numeric block, positioned after its format byte (if any). The deltas of numeric
+ * records may not fit in 32 bits, so the ids are summed up as the records are read */
+static uint32_t IndexBlock_DecodeNumericStaged(const IndexBlock *blk, BufferReader *br,
+                                               IndexBlockDecoded *out) {
+  static const IndexDecoderCtx empty = {0};
+  RSIndexResult rec = {.type = RSResultType_Numeric};
+  t_docId lastId = blk->firstId;
+  uint32_t n = 0;
+  while (!BufferReader_AtEnd(br)) {
+    if (n == out->cap) {
+      IndexBlockDecoded_Grow(out, Index_StoreNumeric, out->cap * 2 + 16);
+    }
+    readNumeric(br, &empty, &rec);
+    lastId += rec.docId;
+    out->docIds[n] = lastId;
+    out->values[n] = rec.num.value;
+    ++n;
+  }
+  out->len = n;
+  return n;
+}
+
+uint32_t IndexBlock_Decode(const IndexBlock *blk, IndexFlags flags, IndexBlockDecoded *out) {
+  int hasFormat = flags & Index_BlockPacked;
+  flags &= INDEX_STORAGE_MASK;
+  out->len = 0;
+  if (out->cap < blk->numEntries) {
+    IndexBlockDecoded_Grow(out, flags, blk->numEntries);
+  }
+  pthread_once(&selectDocIdsKernelsOnce_g, selectDocIdsKernels);
+
+  BufferReader br = NewBufferReader((Buffer *)&blk->buf);
+  if (hasFormat && !BufferReader_AtEnd(&br)) {
+    switch (Buffer_ReadU8(&br)) {
+      case INDEX_BLOCK_PACKED:
+        return IndexBlock_DecodePacked(blk, flags, &br, out);
+      case INDEX_BLOCK_BITMAP:
+        return IndexBlock_DecodeBitmap(blk, &br, out);
+      case INDEX_BLOCK_COLUMNAR:
+        return IndexBlock_DecodeColumnar(blk, &br, out);
+    }
+  }
+  if (flags & Index_StoreNumeric) {
+    return IndexBlock_DecodeNumericStaged(blk, &br, out);
+  }
+  uint32_t n = 0;
+  uint32_t fm32;
+  int raw = 0;
+
+  switch ((uint32_t)flags) {
+    // (freqs, fields, offset)
+    case Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets:
+      DECODE_RECORDS({
+        qint_decode4(&br, &out->deltas[n], &out->freqs[n], &fm32, &out->offsetsSz[n]);
+        out->fieldMasks[n] = fm32;
+        DECODE_OFFSETS();
+      });
+
+    case Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets | Index_WideSchema:
+      DECODE_RECORDS({
+        qint_decode3(&br, &out->deltas[n], &out->freqs[n], &out->offsetsSz[n]);
+        out->fieldMasks[n] = ReadVarintFieldMask(&br);
+        DECODE_OFFSETS();
+      });
+
+    // (freqs)
+    case Index_StoreFreqs:
+      DECODE_RECORDS(qint_decode2(&br, &out->deltas[n], &out->freqs[n]));
+
+    // (offsets)
+    case Index_StoreTermOffsets:
+      DECODE_RECORDS({
+        qint_decode2(&br, &out->deltas[n], &out->offsetsSz[n]);
+        DECODE_OFFSETS();
+      });
+
+    // (fields)
+    case Index_StoreFieldFlags:
+      DECODE_RECORDS({
+        qint_decode2(&br, &out->deltas[n], &fm32);
+        out->fieldMasks[n] = fm32;
+      });
+
+    case Index_StoreFieldFlags | Index_WideSchema:
+      DECODE_RECORDS({
+        out->deltas[n] = ReadVarint(&br);
+        out->fieldMasks[n] = ReadVarintFieldMask(&br);
+      });
+
+    // ()
+    case Index_DocIdsOnly:
+      if (RSGlobalConfig.invertedIndexRawDocidEncoding) {
+        raw = 1;
+        DECODE_RECORDS(Buffer_Read(&br, &out->deltas[n], 4));
+      } else {
+        DECODE_RECORDS(out->deltas[n] = ReadVarint(&br));
+      }
+
+    // (freqs, offsets)
+    case Index_StoreFreqs | Index_StoreTermOffsets:
+      DECODE_RECORDS({
+        qint_decode3(&br, &out->deltas[n], &out->freqs[n], &out->offsetsSz[n]);
+        DECODE_OFFSETS();
+      });
+
+    // (freqs, fields)
+    case Index_StoreFreqs | Index_StoreFieldFlags:
+      DECODE_RECORDS({
+        qint_decode3(&br, &out->deltas[n], &out->freqs[n], &fm32);
+        out->fieldMasks[n] = fm32;
+      });
+
+    case Index_StoreFreqs | Index_StoreFieldFlags | Index_WideSchema:
+      DECODE_RECORDS({
+        qint_decode2(&br, &out->deltas[n], &out->freqs[n]);
+        out->fieldMasks[n] = ReadVarintFieldMask(&br);
+      });
+
+    // (fields, offsets)
+    case Index_StoreFieldFlags | Index_StoreTermOffsets:
+      DECODE_RECORDS({
+        qint_decode3(&br, &out->deltas[n], &fm32, &out->offsetsSz[n]);
+        out->fieldMasks[n] = fm32;
+        DECODE_OFFSETS();
+      });
+
+    case Index_StoreFieldFlags | Index_StoreTermOffsets | Index_WideSchema:
+      DECODE_RECORDS({
+        qint_decode2(&br, &out->deltas[n], &out->offsetsSz[n]);
+        out->fieldMasks[n] = ReadVarintFieldMask(&br);
+        DECODE_OFFSETS();
+      });
+
+    default:
+      return 0;
+  }
+
+  if (raw) {
+    addBase_g(out->docIds, out->deltas, n, blk->firstId);
+  } else {
+    prefixSum_g(out->docIds, out->deltas, n, blk->firstId);
+  }
+  out->len = n;
+  return n;
+}
+
+/* Decode the records of a numeric block which match a numeric or geo filter. The values of the
+ * records matching a geo filter are replaced with their distances from its center. The zone map of
+ * a columnar block lets us skip the block without decoding it if none of its values can match, and
+ * accept all of its records without checking them if all of its values match a numeric filter */
+static uint32_t IndexBlock_DecodeNumeric(const IndexBlock *blk, IndexFlags flags,
+                                         const NumericFilter *f, IndexBlockDecoded *out) {
+  int columnar = (flags & Index_BlockPacked) && IndexBlock_Format(blk) == INDEX_BLOCK_COLUMNAR;
+  if (f && !NumericFilter_IsNumeric(f)) {
+    // the zone map of a geo block encloses its points in a geohash cell
+    if (columnar) {
+      double min, max;
+      IndexBlock_ZoneMap(blk, &min, &max);
+      if (!GeoFilter_MayMatchRange(f->geoFilter, min, max)) {
+        out->len = 0;
+        return 0;
+      }
+    }
+    uint32_t n = IndexBlock_Decode(blk, flags, out);
+    return out->len = GeoFilter_FilterPoints(f->geoFilter, out->docIds, out->values, n);
+  }
+  if (f && columnar) {
+    double min, max;
+    IndexBlock_ZoneMap(blk, &min, &max);
+    if (!(f->inclusiveMin ? max >= f->min : max > f->min) ||
+        !(f->inclusiveMax ? min <= f->max : min < f->max)) {
+      out->len = 0;
+      return 0;
+    }
+    if (NumericFilter_Match(f, min) && NumericFilter_Match(f, max)) {
+      f = NULL;
+    }
+  }
+  uint32_t n = IndexBlock_Decode(blk, flags, out);
+  if (f) {
+    n = out->len = filterValues_g(out->docIds, out->values, n, f);
+  }
+  return n;
+}
+
+/* Write the decoded records as a packed block. `src` is the buffer the offset vectors point into.
+ * The deltas array is used as scratch space */
+static size_t IndexBlock_WritePacked(BufferWriter *bw, IndexFlags flags, IndexBlockDecoded *dec,
+                                     const char *src, t_docId firstId) {
+  uint32_t n = dec->len;
+  size_t sz = Buffer_WriteU8(bw, INDEX_BLOCK_PACKED);
+  sz += WriteVarint(n, bw);
+
+  t_docId prev = firstId;
+  for (uint32_t i = 0; i < n; ++i) {
+    dec->deltas[i] = dec->docIds[i] - prev;
+    prev = dec->docIds[i];
+  }
+  sz += PFor_Encode(bw, dec->deltas, n);
+
+  if (flags & Index_StoreFreqs) {
+    sz += PFor_Encode(bw, dec->freqs, n);
+  }
+  if (flags & Index_StoreFieldFlags) {
+    if (flags & Index_WideSchema) {
+      for (uint32_t i = 0; i < n; ++i) {
+        sz += WriteVarintFieldMask(dec->fieldMasks[i], bw);
+      }
+    } else {
+      for (uint32_t i = 0; i < n; ++i) {
+        dec->deltas[i] = (uint32_t)dec->fieldMasks[i];
+      }
+      sz += PFor_Encode(bw, dec->deltas, n);
+    }
+  }
+  if (flags & Index_StoreTermOffsets) {
+    sz += PFor_Encode(bw, dec->offsetsSz, n);
+    for (uint32_t i = 0; i < n; ++i) {
+      sz += Buffer_Write(bw, src + dec->offsetsPos[i], dec->offsetsSz[i]);
+    }
+  }
+  return sz;
+}
+
+/* Whether the decoded records of a doc-ids-only block are dense enough to be written as a bitmap */
+static int IndexBlock_BitmapFits(IndexFlags flags, const IndexBlockDecoded *dec, t_docId firstId) {
+  if ((flags & INDEX_STORAGE_MASK) != Index_DocIdsOnly || !dec->len) {
+    return 0;
+  }
+  t_docId span = dec->docIds[dec->len - 1] - firstId + 1;
+  return span <= (t_docId)dec->len * INDEX_BLOCK_BITMAP_MAX_SPARSITY;
+}
+
+/* Write the decoded records of a doc-ids-only block as a bitmap block */
+static size_t IndexBlock_WriteBitmap(BufferWriter *bw, const IndexBlockDecoded *dec,
+                                     t_docId firstId) {
+  size_t sz = Buffer_WriteU8(bw, INDEX_BLOCK_BITMAP);
+  size_t nbytes = (dec->docIds[dec->len - 1] - firstId) / 8 + 1;
+  uint8_t *bits = rm_calloc(nbytes, 1);
+  for (uint32_t i = 0; i < dec->len; ++i) {
+    t_docId bit = dec->docIds[i] - firstId;
+    bits[bit / 8] |= 1 << (bit % 8);
+  }
+  sz += Buffer_Write(bw, bits, nbytes);
+  rm_free(bits);
+  return sz;
+}
+
+/* Check if the values of a columnar block can be stored as bit-packed offsets from their minimal
+ * value: they must be integers which are exactly represented by doubles, at most UINT32_MAX apart.
+ * A negative zero is stored as a double, so it is read back as is */
+static int IndexBlock_ValuesAreIntegers(const double *values, uint32_t n, double min, double max) {
+  if (!(fabs(min) <= COLUMNAR_MAX_EXACT_INTEGER && fabs(max) <= COLUMNAR_MAX_EXACT_INTEGER &&
+        max - min <= UINT32_MAX)) {
+    return 0;
+  }
+  for (uint32_t i = 0; i < n; ++i) {
+    if (values[i] != floor(values[i]) || (values[i] == 0 && signbit(values[i]))) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Write the decoded records of a numeric block as a columnar block. The ids must all be within
+ * UINT32_MAX of the first id. The deltas array is used as scratch space */
+static size_t IndexBlock_WriteColumnar(BufferWriter *bw, IndexBlockDecoded *dec, t_docId firstId) {
+  uint32_t n = dec->len;
+  double min = dec->values[0], max = dec->values[0];
+  t_docId prev = firstId;
+  for (uint32_t i = 0; i < n; ++i) {
+    min = MIN(min, dec->values[i]);
+    max = MAX(max, dec->values[i]);
+    dec->deltas[i] = dec->docIds[i] - prev;
+    prev = dec->docIds[i];
+  }
+  size_t sz = Buffer_WriteU8(bw, INDEX_BLOCK_COLUMNAR);
+  sz += Buffer_Write(bw, &min, sizeof(min));
+  sz += Buffer_Write(bw, &max, sizeof(max));
+  sz += WriteVarint(n, bw);
+  sz += PFor_Encode(bw, dec->deltas, n);
+  if (IndexBlock_ValuesAreIntegers(dec->values, n, min, max)) {
+    for (uint32_t i = 0; i < n; ++i) {
+      dec->deltas[i] = (uint32_t)(dec->values[i] - min);
+    }
+    sz += Buffer_WriteU8(bw, COLUMNAR_VALUES_INTEGERS);
+    sz += PFor_Encode(bw, dec->deltas, n);
+  } else {
+    sz += Buffer_WriteU8(bw, COLUMNAR_VALUES_DOUBLES);
+    sz += Buffer_Write(bw, dec->values, n * sizeof(*dec->values));
+  }
+  return sz;
+}
+
+/* Write the decoded records as a sealed block - columns for numeric blocks, a bitmap if they are
+ * dense enough, and bit-packed frames otherwise */
+static size_t IndexBlock_WriteSealed(BufferWriter *bw, IndexFlags flags, IndexBlockDecoded *dec,
+                                     const char *src, t_docId firstId) {
+  if (flags & Index_StoreNumeric) {
+    return IndexBlock_WriteColumnar(bw, dec, firstId);
+  }
+  if (IndexBlock_BitmapFits(flags, dec, firstId)) {
+    return IndexBlock_WriteBitmap(bw, dec, firstId);
+  }
+  return IndexBlock_WritePacked(bw, flags, dec, src, firstId);
+}
+
+/* Encode the decoded records one after the other with the regular record encoder, as they are
+ * stored in staged blocks and in the blocks of indexes without block formats */
+static size_t IndexBlock_EncodeRecords(BufferWriter *bw, IndexEncoder encoder,
+                                       const IndexBlockDecoded *dec, const char *src,
+                                       t_docId firstId) {
+  size_t sz = 0;
+  RSIndexResult rec = {.type = dec->values ? RSResultType_Numeric : RSResultType_Term, .freq = 1};
+  t_docId prev = firstId;
+  for (uint32_t i = 0; i < dec->len; ++i) {
+    rec.docId = dec->docIds[i];
+    if (dec->values) {
+      rec.num.value = dec->values[i];
+    }
+    if (dec->freqs) {
+      rec.freq = dec->freqs[i];
+    }
+    if (dec->fieldMasks) {
+      rec.fieldMask = dec->fieldMasks[i];
+    }
+    if (dec->offsetsSz) {
+      rec.offsetsSz = dec->offsetsSz[i];
+      rec.term.offsets = (RSOffsetVector){.data = (char *)src + dec->offsetsPos[i],
+                                          .len = dec->offsetsSz[i]};
+    }
+    uint32_t delta = rec.docId - (encoder == encodeRawDocIdsOnly ? firstId : prev);
+    sz += encoder(bw, delta, &rec);
+    prev = rec.docId;
+  }
+  return sz;
+}
+
+/* Write the decoded records as a staged block, using the regular record encoder */
+static size_t IndexBlock_WriteStaged(BufferWriter *bw, IndexEncoder encoder,
+                                     const IndexBlockDecoded *dec, const char *src,
+                                     t_docId firstId) {
+  size_t sz = Buffer_WriteU8(bw, INDEX_BLOCK_STAGED);
+  return sz + IndexBlock_EncodeRecords(bw, encoder, dec, src, firstId);
+}
+
+/* Seal a full staged block by re-encoding it as bit-packed frames, as a bitmap or as columns. The
+ * block is left as is if sealing would not make it smaller, or if the ids of a numeric block are too
+ * far apart for 32 bit deltas. Returns the number of bytes the block grew by, which is negative if
+ * it shrank */
+static ssize_t IndexBlock_Pack(IndexBlock *blk, IndexFlags flags) {
+  if (IndexBlock_IsSealed(blk) ||
+      ((flags & Index_StoreNumeric) && blk->lastId - blk->firstId > UINT32_MAX)) {
+    return 0;
+  }
+  ssize_t delta = 0;
+  IndexBlockDecoded dec = {0};
+  IndexBlock_Decode(blk, flags, &dec);
+
+  Buffer packed = {0};
+  BufferWriter bw = NewBufferWriter(&packed);
+  IndexBlock_WriteSealed(&bw, flags, &dec, blk->buf.data, blk->firstId);
+  if (packed.offset < blk->buf.offset) {
+    delta = (ssize_t)packed.offset - (ssize_t)blk->buf.offset;
+    Buffer_Free(&blk->buf);
+    blk->buf = packed;
+    Buffer_ShrinkToSize(&blk->buf);
+  } else {
+    Buffer_Free(&packed);
+  }
+  IndexBlockDecoded_Free(&dec);
+  return delta;
+}
+
+/* Turn a packed block back into a staged one, so more records can be appended to it. Returns the
+ * number of bytes the block grew by, which is negative if it shrank */
+static ssize_t IndexBlock_Unpack(IndexBlock *blk, IndexFlags flags, IndexEncoder encoder) {
+  IndexBlockDecoded dec = {0};
+  IndexBlock_Decode(blk, flags, &dec);
+
+  Buffer staged = {0};
+  BufferWriter bw = NewBufferWriter(&staged);
+  IndexBlock_WriteStaged(&bw, encoder, &dec, blk->buf.data, blk->firstId);
+  ssize_t delta = (ssize_t)staged.offset - (ssize_t)blk->buf.offset;
+  Buffer_Free(&blk->buf);
+  blk->buf = staged;
+  IndexBlockDecoded_Free(&dec);
+  return delta;
+}
+
 IndexReader *NewNumericReader(const IndexSpec *sp, InvertedIndex *idx, const NumericFilter *flt,
                               double rangeMin, double rangeMax, int skipMulti) {
   RSIndexResult *res = NewNumericResult();
@@ -961,7 +1771,13 @@ IndexReader *NewNumericReader(const IndexSpec *sp, InvertedIndex *idx, const Num
 
   IndexDecoderCtx ctx = {.ptr = (void *)flt, .rangeMin = rangeMin, .rangeMax = rangeMax};
   IndexDecoderProcs procs = {.decoder = readNumeric};
-  return NewIndexReaderGeneric(sp, idx, procs, ctx, skipMulti, res);
+  IndexReader *ret = NewIndexReaderGeneric(sp, idx, procs, ctx, skipMulti, res);
+  // sealed numeric blocks can only be read by the block decoder
+  if (idx->flags & Index_BlockPacked) {
+    ret->blockDecoding = 1;
+    IndexReader_DecodeBlock(ret);
+  }
+  return ret;
 }
 
 size_t IR_NumEstimated(void *ctx) {
@@ -969,12 +1785,65 @@ size_t IR_NumEstimated(void *ctx) {
   return ir->idx->numDocs;
 }
 
+/* Block decoding version of IR_Read, reading the next record from the decoded block arrays */
+static int IR_ReadDecoded(IndexReader *ir, RSIndexResult **e) {
+  const IndexBlockDecoded *dec = &ir->decoded;
+  RSIndexResult *record = ir->record;
+  do {
+    // if needed - skip to the next block (skipping empty blocks that may appear here due to GC)
+    while (ir->decodedPos >= dec->len) {
+      if (ir->currentBlock + 1 == ir->idx->size) {
+        return INDEXREAD_EOF;
+      }
+      IndexReader_AdvanceBlock(ir);
+    }
+
+    uint32_t i = ir->decodedPos++;
+    ir->lastId = record->docId = dec->docIds[i];
+    if (dec->values) {
+      // numeric and geo filters are applied when the block is decoded
+      record->num.value = dec->values[i];
+    }
+    if (dec->fieldMasks) {
+      record->fieldMask = dec->fieldMasks[i];
+      if (!(record->fieldMask & ir->decoderCtx.num)) {
+        continue;
+      }
+    }
+    if (dec->freqs) {
+      record->freq = dec->freqs[i];
+    }
+    if (dec->offsetsSz) {
+      record->offsetsSz = dec->offsetsSz[i];
+      record->term.offsets = (RSOffsetVector){
+          .data = IR_CURRENT_BLOCK(ir).buf.data + dec->offsetsPos[i], .len = dec->offsetsSz[i]};
+    }
+
+    if (ir->skipMulti) {
+      if (ir->sameId == ir->lastId) {
+        continue;
+      }
+      ir->sameId = ir->lastId;
+    }
+
+    ++ir->len;
+    *e = record;
+    return INDEXREAD_OK;
+  } while (1);
+}
+
 int IR_Read(void *ctx, RSIndexResult **e) {
 
   IndexReader *ir = ctx;
   if (IR_IS_AT_END(ir)) {
     goto eof;
   }
+  if (ir->blockDecoding) {
+    if (IR_ReadDecoded(ir, e) == INDEXREAD_OK) {
+      return INDEXREAD_OK;
+    }
+    goto eof;
+  }
   do {
 
     // if needed - skip to the next block (skipping empty blocks that may appear here due to GC)
@@ -1026,10 +1895,37 @@ eof:
   return INDEXREAD_EOF;
 }
 
+/* Find the first block, starting at block `from`, whose last docId is not smaller than `docId`, or
+ * `idx->size` if there is no such block. The search gallops (exponential search) from `from` and
+ * then binary searches the bracketed range, so its cost is logarithmic in the distance from `from`
+ * rather than in the number of blocks */
+static uint32_t InvertedIndex_GallopBlock(const InvertedIndex *idx, uint32_t from, t_docId docId) {
+  uint32_t size = idx->size;
+  if (from >= size || idx->blocks[from].lastId >= docId) {
+    return from;
+  }
+  // blocks[bottom - 1].lastId < docId holds throughout
+  uint32_t bottom = from + 1, step = 1;
+  uint32_t top = bottom;
+  while (top < size && idx->blocks[top].lastId < docId) {
+    bottom = top + 1;
+    top = (size - top > step) ? top + step : size;
+    step <<= 1;
+  }
+  while (bottom < top) {
+    uint32_t i = bottom + (top - bottom) / 2;
+    if (idx->blocks[i].lastId < docId) {
+      bottom = i + 1;
+    } else {
+      top = i;
+    }
+  }
+  return bottom;
+}
+
 #define BLOCK_MATCHES(blk, docId) ((blk).firstId <= docId && docId <= (blk).lastId)
 
 static int IndexReader_SkipToBlock(IndexReader *ir, t_docId docId) {
-  int rc = 0;
   InvertedIndex *idx = ir->idx;
 
   // the current block doesn't match and it's the last one - no point in searching
@@ -1037,33 +1933,42 @@ static int IndexReader_SkipToBlock(IndexReader *ir, t_docId docId) {
     return 0;
   }
 
-  uint32_t top = idx->size - 1;
-  uint32_t bottom = ir->currentBlock + 1;
-  uint32_t i = bottom;  //(bottom + top) / 2;
-  while (bottom <= top) {
-    const IndexBlock *blk = idx->blocks + i;
-    if (BLOCK_MATCHES(*blk, docId)) {
-      ir->currentBlock = i;
-      rc = 1;
-      goto new_block;
-    }
+  // Skips are usually short, so gallop from the current block instead of binary searching all the
+  // remaining ones. If docId precedes the current block we stay in it, and if it falls in a gap
+  // between blocks we land on the block after the gap
+  uint32_t i = InvertedIndex_GallopBlock(idx, ir->currentBlock, docId);
+  ir->currentBlock = MIN(i, idx->size - 1);
+  int rc = BLOCK_MATCHES(IR_CURRENT_BLOCK(ir), docId);
 
-    if (docId < blk->firstId) {
-      top = i - 1;
-    } else {
-      bottom = i + 1;
-    }
-    i = (bottom + top) / 2;
-  }
-
-  ir->currentBlock = i;
-
-new_block:
   ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
   ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
+  IndexReader_DecodeBlock(ir);
   return rc;
 }
 
+/* If the current block has skip points, move the reader to the last one that precedes docId,
+ * provided that it is ahead of the reader's position. All the records before that skip point have
+ * smaller ids than docId, so they don't need to be decoded */
+static inline void IndexReader_SeekSkipPoint(IndexReader *ir, t_docId docId) {
+  IndexBlockSkip *skips = IR_CURRENT_BLOCK(ir).skips;
+  if (!skips) {
+    return;
+  }
+  uint32_t lo = 0, hi = array_len(skips);
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (skips[mid].lastId < docId) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo && skips[lo - 1].offset > ir->br.pos) {
+    ir->br.pos = skips[lo - 1].offset;
+    ir->lastId = skips[lo - 1].lastId;
+  }
+}
+
 int IR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
   IndexReader *ir = ctx;
   if (!docId) {
@@ -1078,6 +1983,29 @@ int IR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
     goto eof;
   }
 
+  if (ir->blockDecoding) {
+    if (!BLOCK_MATCHES(IR_CURRENT_BLOCK(ir), docId)) {
+      IndexReader_SkipToBlock(ir, docId);
+    }
+    // binary search the decoded ids for the first one which is not smaller than docId. If all of
+    // them are, IR_ReadDecoded will continue from the next block
+    const t_docId *ids = ir->decoded.docIds;
+    uint32_t lo = ir->decodedPos, hi = ir->decoded.len;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (ids[mid] < docId) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    ir->decodedPos = lo;
+    if (IR_ReadDecoded(ir, hit) == INDEXREAD_EOF) {
+      goto eof;
+    }
+    return (ir->record->docId == docId) ? INDEXREAD_OK : INDEXREAD_NOTFOUND;
+  }
+
   if (!BLOCK_MATCHES(IR_CURRENT_BLOCK(ir), docId)) {
     IndexReader_SkipToBlock(ir, docId);
   } else if (BufferReader_AtEnd(&ir->br)) {
@@ -1088,6 +2016,7 @@ int IR_SkipTo(void *ctx, t_docId docId, RSIndexResult **hit) {
       return INDEXREAD_NOTFOUND;
     }
   }
+  IndexReader_SeekSkipPoint(ir, docId);
 
   /**
    * We need to replicate the effects of IR_Read() without actually calling it
@@ -1172,6 +2101,9 @@ static void IndexReader_Init(const IndexSpec *sp, IndexReader *ret, InvertedInde
   ret->decoderCtx = decoderCtx;
   ret->isValidP = NULL;
   ret->sp = sp;
+  ret->blockDecoding = 0;
+  ret->decoded = (IndexBlockDecoded){0};
+  ret->decodedPos = 0;
   IR_SetAtEnd(ret, 0);
 }
 
@@ -1203,12 +2135,19 @@ IndexReader *NewTermIndexReader(InvertedIndex *idx, IndexSpec *sp, t_fieldMask f
 
   IndexDecoderCtx dctx = {.num = fieldMask};
 
-  return NewIndexReaderGeneric(sp, idx, decoder, dctx, false, record);
+  IndexReader *ret = NewIndexReaderGeneric(sp, idx, decoder, dctx, false, record);
+  // blocks of packed indexes can only be read by the block decoder
+  if (RSGlobalConfig.invertedIndexBlockDecoding || (idx->flags & Index_BlockPacked)) {
+    ret->blockDecoding = 1;
+    IndexReader_DecodeBlock(ret);
+  }
+  return ret;
 }
 
 void IR_Free(IndexReader *ir) {
 
   IndexResult_Free(ir->record);
+  IndexBlockDecoded_Free(&ir->decoded);
   rm_free(ir);
 }
 
@@ -1239,6 +2178,7 @@ void IR_Rewind(void *ctx) {
   ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
   ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
   ir->sameId = 0;
+  IndexReader_DecodeBlock(ir);
 }
 
 IndexIterator *NewReadIterator(IndexReader *ir) {
@@ -1261,12 +2201,101 @@ IndexIterator *NewReadIterator(IndexReader *ir) {
   return ri;
 }
 
+/* Repair a block of an Index_BlockPacked index. The block is decoded at once, compacted, and written
+ * back in its original format */
+static int IndexBlock_RepairDecoded(IndexBlock *blk, DocTable *dt, IndexFlags flags,
+                                    IndexRepairParams *params) {
+  IndexEncoder encoder = InvertedIndex_GetEncoder(flags);
+  if (!encoder) {
+    fprintf(stderr, "Could not get encoder for index\n");
+    return -1;
+  }
+
+  IndexBlockDecoded dec = {0};
+  uint32_t n = IndexBlock_Decode(blk, flags, &dec);
+  RSIndexResult *res = (flags & Index_StoreNumeric) ? NewNumericResult() : NewTokenRecord(NULL, 1);
+  uint32_t kept = 0;
+  int frags = 0;
+  int docExists = 0;
+
+  params->bytesBeforFix = blk->buf.offset;
+
+  for (uint32_t i = 0; i < n; ++i) {
+    // Numeric indexes may hold several entries for the same document (multi values), which are
+    // counted as a single collected document
+    int newDoc = !i || dec.docIds[i] != res->docId;
+    res->docId = dec.docIds[i];
+    if (newDoc) {
+      docExists = DocTable_Exists(dt, res->docId);
+    }
+    if (!docExists) {
+      frags += newDoc;
+      ++params->entriesCollected;
+      continue;
+    }
+    if (dec.values) res->num.value = dec.values[i];
+    if (dec.freqs) res->freq = dec.freqs[i];
+    if (dec.fieldMasks) res->fieldMask = dec.fieldMasks[i];
+    if (dec.offsetsSz) {
+      res->offsetsSz = dec.offsetsSz[i];
+      res->term.offsets = (RSOffsetVector){.data = blk->buf.data + dec.offsetsPos[i],
+                                           .len = dec.offsetsSz[i]};
+    }
+    if (params->RepairCallback) {
+      params->RepairCallback(res, blk, params->arg);
+    }
+
+    dec.docIds[kept] = dec.docIds[i];
+    if (dec.values) dec.values[kept] = dec.values[i];
+    if (dec.freqs) dec.freqs[kept] = dec.freqs[i];
+    if (dec.fieldMasks) dec.fieldMasks[kept] = dec.fieldMasks[i];
+    if (dec.offsetsSz) {
+      dec.offsetsSz[kept] = dec.offsetsSz[i];
+      dec.offsetsPos[kept] = dec.offsetsPos[i];
+    }
+    ++kept;
+  }
+
+  if (frags) {
+    Buffer repair = {0};
+    dec.len = kept;
+    if (kept) {
+      BufferWriter bw = NewBufferWriter(&repair);
+      t_docId firstId = dec.docIds[0];
+      if (IndexBlock_IsSealed(blk)) {
+        IndexBlock_WriteSealed(&bw, flags, &dec, blk->buf.data, firstId);
+      } else {
+        IndexBlock_WriteStaged(&bw, encoder, &dec, blk->buf.data, firstId);
+      }
+      blk->firstId = firstId;
+      blk->lastId = dec.docIds[kept - 1];
+    } else {
+      blk->firstId = blk->lastId = 0;
+    }
+    blk->numEntries = kept;
+    Buffer_Free(&blk->buf);
+    blk->buf = repair;
+    Buffer_ShrinkToSize(&blk->buf);
+    params->bytesCollected += params->bytesBeforFix - blk->buf.offset;
+  }
+
+  params->bytesAfterFix = blk->buf.offset;
+
+  IndexResult_Free(res);
+  IndexBlockDecoded_Free(&dec);
+  return frags;
+}
+
 /* Repair an index block by removing garbage - records pointing at deleted documents,
  * and write valid entries in their place.
  * Returns the number of docs collected, and puts the number of bytes collected in the given
  * pointer. If an error occurred - returns -1
  */
 int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepairParams *params) {
+  if (flags & Index_BlockPacked) {
+    return IndexBlock_RepairDecoded(blk, dt, flags, params);
+  }
+
   t_docId firstReadId = blk->firstId;
   t_docId lastReadId = blk->firstId;
   bool isFirstRes = true;
@@ -1376,6 +2405,10 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
     Buffer_Free(&blk->buf);
     blk->buf = repair;
     Buffer_ShrinkToSize(&blk->buf);
+    // The skip points refer to the old buffer. The caller rebuilds them if needed (the fork GC
+    // child repairs blocks in its own address space, so only the parent can rebuild them)
+    array_free(blk->skips);
+    blk->skips = NULL;
   }
 
   params->bytesAfterFix = blk->buf.offset;
@@ -1384,6 +2417,47 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
   return frags;
 }
 
+void IndexBlock_BuildSkips(IndexBlock *blk, IndexFlags flags) {
+  array_free(blk->skips);
+  blk->skips = NULL;
+  if (!RSGlobalConfig.invertedIndexBlockSkips || (flags & Index_BlockPacked) ||
+      blk->numEntries <= INDEX_BLOCK_SKIP_INTERVAL) {
+    return;
+  }
+
+  uint32_t readFlags = flags & INDEX_STORAGE_MASK;
+  IndexDecoderProcs decoders = InvertedIndex_GetDecoder(readFlags);
+  if (!decoders.decoder) {
+    return;
+  }
+  // no field mask or numeric filtering - we only need to walk over the records
+  IndexDecoderCtx ctx = {.num = RS_FIELDMASK_ALL};
+  RSIndexResult *res = readFlags == Index_StoreNumeric ? NewNumericResult() : NewTokenRecord(NULL, 1);
+
+  blk->skips = array_new(IndexBlockSkip, blk->numEntries / INDEX_BLOCK_SKIP_INTERVAL);
+  BufferReader br = NewBufferReader(&blk->buf);
+  t_docId lastId = blk->firstId;
+  for (uint32_t n = 0; !BufferReader_AtEnd(&br); ++n) {
+    if (n && !(n % INDEX_BLOCK_SKIP_INTERVAL)) {
+      IndexBlockSkip skip = {.lastId = lastId, .offset = br.pos};
+      blk->skips = array_append(blk->skips, skip);
+    }
+    decoders.decoder(&br, &ctx, res);
+    // same as in IR_Read
+    uint32_t delta = *(uint32_t *)&res->docId;
+    lastId = (decoders.decoder != readRawDocIdsOnly ? lastId : blk->firstId) + delta;
+  }
+  IndexResult_Free(res);
+}
+
+uint32_t InvertedIndex_FindBlock(const InvertedIndex *idx, uint32_t from, t_docId docId) {
+  // the hint is invalid if the index has shrunk, or if it is already past the docId
+  if (from >= idx->size || (from && idx->blocks[from - 1].lastId >= docId)) {
+    from = 0;
+  }
+  return InvertedIndex_GallopBlock(idx, from, docId);
+}
+
 int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
                          IndexRepairParams *params) {
   size_t limit = params->limit ? params->limit : SIZE_MAX;
@@ -1400,6 +2474,7 @@ int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
     if (repaired == -1) {
       return 0;
     } else if (repaired > 0) {
+      IndexBlock_BuildSkips(blk, idx->flags);
       // Record the number of records removed for gc stats
       params->docsCollected += repaired;
       idx->numDocs -= repaired;
@@ -1411,3 +2486,88 @@ int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
 
   return startBlock < idx->size ? startBlock : 0;
 }
+
+/* Renumber the records of a block, dropping the records of documents without a new id. The block
+ * is written back in its original format. Returns the number of records kept */
+static uint32_t IndexBlock_Remap(IndexBlock *blk, IndexFlags flags, IndexEncoder encoder,
+                                 const DocIdRemap *remap, size_t *hint,
+                                 IndexRepairParams *params) {
+  IndexBlockDecoded dec = {0};
+  uint32_t n = IndexBlock_Decode(blk, flags, &dec);
+  uint32_t kept = 0;
+  t_docId newId = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    // multi value numeric records of the same document are next to each other
+    if (!i || dec.docIds[i] != dec.docIds[i - 1]) {
+      newId = DocIdRemap_Get(remap, dec.docIds[i], hint);
+      params->docsCollected += !newId;
+    }
+    if (!newId) {
+      ++params->entriesCollected;
+      continue;
+    }
+    dec.docIds[kept] = newId;
+    if (dec.values) dec.values[kept] = dec.values[i];
+    if (dec.freqs) dec.freqs[kept] = dec.freqs[i];
+    if (dec.fieldMasks) dec.fieldMasks[kept] = dec.fieldMasks[i];
+    if (dec.offsetsSz) {
+      dec.offsetsSz[kept] = dec.offsetsSz[i];
+      dec.offsetsPos[kept] = dec.offsetsPos[i];
+    }
+    ++kept;
+  }
+
+  Buffer remapped = {0};
+  dec.len = kept;
+  if (kept) {
+    BufferWriter bw = NewBufferWriter(&remapped);
+    t_docId firstId = dec.docIds[0];
+    if (!(flags & Index_BlockPacked)) {
+      IndexBlock_EncodeRecords(&bw, encoder, &dec, blk->buf.data, firstId);
+    } else if (IndexBlock_IsSealed(blk)) {
+      IndexBlock_WriteSealed(&bw, flags, &dec, blk->buf.data, firstId);
+    } else {
+      IndexBlock_WriteStaged(&bw, encoder, &dec, blk->buf.data, firstId);
+    }
+    blk->firstId = firstId;
+    blk->lastId = dec.docIds[kept - 1];
+  } else {
+    blk->firstId = blk->lastId = 0;
+  }
+  params->bytesBeforFix += blk->buf.offset;
+  params->bytesAfterFix += remapped.offset;
+  blk->numEntries = kept;
+  Buffer_Free(&blk->buf);
+  blk->buf = remapped;
+  Buffer_ShrinkToSize(&blk->buf);
+  IndexBlock_BuildSkips(blk, flags);
+
+  IndexBlockDecoded_Free(&dec);
+  return kept;
+}
+
+void InvertedIndex_Remap(InvertedIndex *idx, const DocIdRemap *remap, IndexRepairParams *params) {
+  IndexEncoder encoder = InvertedIndex_GetEncoder(idx->flags);
+  size_t docsBefore = params->docsCollected, entriesBefore = params->entriesCollected;
+  size_t hint = 0;
+  uint32_t size = 0;
+  for (uint32_t i = 0; i < idx->size; ++i) {
+    IndexBlock *blk = idx->blocks + i;
+    // empty blocks are dropped, but the index always keeps at least one block to write to
+    if (!IndexBlock_Remap(blk, idx->flags, encoder, remap, &hint, params) &&
+        (size || i + 1 < idx->size)) {
+      indexBlock_Free(blk);
+      continue;
+    }
+    idx->blocks[size++] = *blk;
+  }
+  TotalIIBlocks -= idx->size - size;
+  idx->size = size;
+  idx->lastId = INDEX_LAST_BLOCK(idx).lastId;
+  idx->numDocs -= params->docsCollected - docsBefore;
+  if (idx->flags & Index_StoreNumeric) {
+    idx->numEntries -= params->entriesCollected - entriesBefore;
+  }
+  // let readers which were paused on the index know it was rewritten
+  ++idx->gcMarker;
+}
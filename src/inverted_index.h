@@ -24,12 +24,30 @@ extern "C" {
 
 extern uint64_t TotalIIBlocks;
 
+// The number of records between two consecutive skip points of an index block
+#define INDEX_BLOCK_SKIP_INTERVAL 16
+
+/* A skip point inside an index block: the offset of a record in the block buffer, and the docId of
+ * the record preceding it, which is the base for decoding the record's delta */
+typedef struct {
+  t_docId lastId;
+  uint32_t offset;
+} IndexBlockSkip;
+
 /* A single block of data in the index. The index is basically a list of blocks we iterate */
 typedef struct {
   t_docId firstId;
   t_docId lastId;
   Buffer buf;
   uint16_t numEntries;  // Number of entries (i.e., docs)
+  // Upper bound of the term frequency of the block's records. 0 if unknown, and saturated at
+  // UINT16_MAX (which also means unknown)
+  uint16_t maxFreq;
+  // Lower bound of the length of the block's documents (see RSDocumentMetadata.len). 0 if unknown
+  uint32_t minDocLen;
+  // Optional array of skip points, one every INDEX_BLOCK_SKIP_INTERVAL records. NULL if the block
+  // was written without them
+  IndexBlockSkip *skips;
 } IndexBlock;
 
 typedef struct InvertedIndex {
@@ -90,9 +108,24 @@ void InvertedIndex_Free(void *idx);
 #define IndexBlock_DataBuf(b) (b)->buf.data
 #define IndexBlock_DataLen(b) (b)->buf.offset
 
+/* (Re)build the skip points of a block from its records, if skip points are enabled in the
+ * configuration. Called whenever a block buffer is replaced (GC repair, RDB load) */
+void IndexBlock_BuildSkips(IndexBlock *blk, IndexFlags flags);
+
+/* Find the first block of the index, starting at block `from`, whose last docId is not smaller
+ * than `docId`. Returns `idx->size` if there is no such block. The docId is in the returned block
+ * only if it is not smaller than the block's first docId */
+uint32_t InvertedIndex_FindBlock(const InvertedIndex *idx, uint32_t from, t_docId docId);
+
 int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
                          IndexRepairParams *params);
 
+/* Renumber the documents of the index after the doc table was compacted (see DocTable_Compact).
+ * The records of documents without a new id are dropped, and empty blocks are removed. The numbers
+ * of dropped documents and records are added to `params`, and so are the sizes of the blocks
+ * before and after the renumbering, in bytesBeforFix and bytesAfterFix */
+void InvertedIndex_Remap(InvertedIndex *idx, const DocIdRemap *remap, IndexRepairParams *params);
+
 /**
  * Decode a single record from the buffer reader. This function is responsible for:
  * (1) Decoding the record at the given position of br
@@ -125,6 +158,33 @@ typedef struct {
  * endoder/decoder when reading and writing */
 IndexDecoderProcs InvertedIndex_GetDecoder(uint32_t flags);
 
+/**
+ * A structure-of-arrays view of a fully decoded IndexBlock. In block decoding mode the reader
+ * decodes all the records of the current block at once, and then iterates (or binary searches)
+ * over these arrays instead of calling the decoder for every record.
+ *
+ * Arrays which are irrelevant for the index flags (e.g. `freqs` when frequencies are not stored)
+ * are left NULL.
+ */
+typedef struct {
+  t_docId *docIds;        // Absolute document ids
+  uint32_t *deltas;       // Raw deltas, as read from the block (scratch space for the decoder)
+  uint32_t *freqs;
+  t_fieldMask *fieldMasks;
+  uint32_t *offsetsSz;    // Length of the offsets vector of each record
+  uint32_t *offsetsPos;   // Position of the offsets vector of each record inside the block buffer
+  double *values;         // Values of numeric records
+  uint32_t len;           // Number of decoded records
+  uint32_t cap;           // Capacity of the arrays
+} IndexBlockDecoded;
+
+/* Decode all the records of a block into `out`, growing its arrays if needed. Returns the number
+ * of decoded records */
+uint32_t IndexBlock_Decode(const IndexBlock *blk, IndexFlags flags, IndexBlockDecoded *out);
+
+/* Free the arrays of a decoded block */
+void IndexBlockDecoded_Free(IndexBlockDecoded *decoded);
+
 /* An IndexReader wraps an inverted index record for reading and iteration */
 typedef struct IndexReader {
   const IndexSpec *sp;
@@ -163,6 +223,12 @@ typedef struct IndexReader {
    * thread was asleep, and reset the state in a deeper way
    */
   uint32_t gcMarker;
+
+  /* If set, the current block is decoded at once into `decoded`, and `decodedPos` is the position
+   * of the next record to return from it (see IndexBlockDecoded) */
+  int blockDecoding;
+  IndexBlockDecoded decoded;
+  uint32_t decodedPos;
 } IndexReader;
 
 // On Reopen callback for term index
@@ -175,17 +241,22 @@ void IndexReader_OnReopen(IndexReader *ir);
  * delta for encoding */
 typedef size_t (*IndexEncoder)(BufferWriter *bw, uint32_t delta, RSIndexResult *record);
 
-/* Write a ForwardIndexEntry into an indexWriter. Returns the number of bytes written to the index
- */
+/* Write a ForwardIndexEntry into an indexWriter. Returns the number of bytes written to the index.
+ * See InvertedIndex_WriteEntryGeneric for `resized` */
 size_t InvertedIndex_WriteForwardIndexEntry(InvertedIndex *idx, IndexEncoder encoder,
-                                            ForwardIndexEntry *ent);
+                                            ForwardIndexEntry *ent, ssize_t *resized);
 
 /* Write a numeric index entry to the index. it includes only a float value and docId. Returns the
- * number of bytes written */
-size_t InvertedIndex_WriteNumericEntry(InvertedIndex *idx, t_docId docId, double value);
-
+ * number of bytes written. See InvertedIndex_WriteEntryGeneric for `resized` */
+size_t InvertedIndex_WriteNumericEntry(InvertedIndex *idx, t_docId docId, double value,
+                                       ssize_t *resized);
+
+/* Write a record to the index. Returns the number of bytes written for the record, or 0 if it was
+ * not written. In block packed indexes the write can also seal or unseal blocks, which changes
+ * their size. If `resized` is not NULL, the number of bytes the blocks grew by, which is negative
+ * if they shrank, is added to it */
 size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder, t_docId docId,
-                                       RSIndexResult *entry);
+                                       RSIndexResult *entry, ssize_t *resized);
 /* Create a new index reader for numeric records, optionally using a given filter. If the filter
  * is
  * NULL we will return all the records in the index */
@@ -47,6 +47,11 @@ int GetJSONAPIs(RedisModuleCtx *ctx, int subscribeToModuleChange);
 int JSON_LoadDocumentField(JSONResultsIterator jsonIter, size_t len, FieldSpec *fs,
                            struct DocumentField *df, RedisModuleCtx *ctx, QueryError *status);
 
+/* Stores the array of a single-value vector field in `df->strval`, in the binary format of the
+ * vectors of the field */
+int JSON_StoreSingleVectorInDocField(FieldSpec *fs, RedisJSON arr, struct DocumentField *df,
+                                     QueryError *status);
+
 /* Checks if JSONType fits the FieldType */
 int FieldSpec_CheckJsonType(FieldType fieldType, JSONType type, QueryError *status);
 
@@ -14,10 +14,14 @@
 #include <math.h>
 #include "redismodule.h"
 #include "util/misc.h"
+#include "geo_index.h"
 //#include "tests/time_sample.h"
 #define NR_EXPONENT 4
 #define NR_MAXRANGE_CARD 2500
 #define NR_MAXRANGE_SIZE 10000
+// The window of docIds in which numeric filters over many ranges merge their readers. A window
+// takes a bit and a value per docId, about 130KB in all
+#define NR_MERGE_WINDOW (1 << 14)
 
 typedef struct {
   IndexIterator *it;
@@ -133,7 +137,7 @@ static inline void checkCardinality(NumericRange *n, double value) {
   ++n->card;
 }
 
-size_t NumericRange_Add(NumericRange *n, t_docId docId, double value, int checkCard) {
+ssize_t NumericRange_Add(NumericRange *n, t_docId docId, double value, int checkCard) {
   int add = 0;
   if (checkCard) {
     checkCardinality(n, value);
@@ -142,7 +146,10 @@ size_t NumericRange_Add(NumericRange *n, t_docId docId, double value, int checkC
   if (value < n->minVal) n->minVal = value;
   if (value > n->maxVal) n->maxVal = value;
 
-  size_t size = InvertedIndex_WriteNumericEntry(n->entries, docId, value);
+  // sealing or unsealing the last block of the range resizes it as well
+  ssize_t size = 0;
+  size_t recordSize = InvertedIndex_WriteNumericEntry(n->entries, docId, value, &size);
+  size += recordSize;
   n->invertedIndexSize += size;
   return size;
 }
@@ -179,6 +186,10 @@ NumericRangeNode *NewLeafNode(size_t cap, size_t splitCard) {
   n->maxDepth = 0;
   n->range = rm_malloc(sizeof(NumericRange));
 
+  IndexFlags flags = Index_StoreNumeric;
+  if (RSGlobalConfig.numericColumnarBlocks) {
+    flags |= Index_BlockPacked;
+  }
   *n->range = (NumericRange){
       .minVal = __DBL_MAX__,
       .maxVal = NF_NEGATIVE_INFINITY,
@@ -188,7 +199,7 @@ NumericRangeNode *NewLeafNode(size_t cap, size_t splitCard) {
       .splitCard = splitCard,
       .values = array_new(CardinalityValue, 1),
       //.values = rm_calloc(splitCard, sizeof(CardinalityValue)),
-      .entries = NewInvertedIndex(Index_StoreNumeric, 1),
+      .entries = NewInvertedIndex(flags, 1),
       .invertedIndexSize = 0,
   };
   return n;
@@ -240,7 +251,7 @@ NRN_AddRv NumericRangeNode_Add(NumericRangeNode *n, t_docId docId, double value)
   if (!NumericRangeNode_IsLeaf(n)) {
     // if this node has already split but retains a range, just add to the range without checking
     // anything
-    size_t s = 0;
+    ssize_t s = 0;
     size_t nRecords = 0;
     if (n->range) {
       s += NumericRange_Add(n->range, docId, value, 0);
@@ -270,7 +281,7 @@ NRN_AddRv NumericRangeNode_Add(NumericRangeNode *n, t_docId docId, double value)
   }
 
   // if this node is a leaf - we add AND check the cardinality. We only split leaf nodes
-  rv.sz = (uint32_t)NumericRange_Add(n->range, docId, value, 1);
+  rv.sz = NumericRange_Add(n->range, docId, value, 1);
   ++rv.numRecords;
   int card = n->range->card;
 
@@ -297,6 +308,11 @@ void __recursiveAddRange(Vector *v, NumericRangeNode *n, const NumericFilter *nf
   double min = nf->min;
   double max = nf->max;
   if (n->range) {
+    // the points of a geo range lie in the geohash cell enclosing its values - skip the whole
+    // subtree if that cell is outside of the search area
+    if (nf->geoFilter && !GeoFilter_MayMatchRange(nf->geoFilter, n->range->minVal, n->range->maxVal)) {
+      return;
+    }
     // if the range is completely contained in the search, we can just add it and not inspect any
     // downwards
     if (NumericRange_Contained(n->range, min, max)) {
@@ -524,6 +540,216 @@ void NumericRangeTree_Free(NumericRangeTree *t) {
   rm_free(t);
 }
 
+/**********************************************************
+ * Bulk build.
+ *
+ * Adding entries one at a time splits every leaf several times on its way down the tree, re-reading
+ * its entries and sampling its cardinality again each time. When all the entries are known up
+ * front, they are sorted by value once instead, and cut into leaves of about half the size at which
+ * a leaf splits. The tree over the leaves is perfectly balanced, and the leaves have room to grow.
+ *
+ * The cardinality of a range is estimated from every NR_CARD_CHECK-th entry added to it. Ranges built
+ * in bulk take these samples in the order of the values, which makes them cheap to count.
+ **********************************************************/
+
+// A leaf built in bulk ends after this many entries, or this many sampled distinct values
+#define NR_BULK_LEAF_SIZE (NR_MAXRANGE_SIZE / 2)
+#define NR_BULK_LEAF_CARD (NR_MAXRANGE_CARD / NR_CARD_CHECK / 2)
+
+// The radix sort by value uses 16-bit digits
+#define NR_BULK_RADIX_BITS 16
+#define NR_BULK_RADIX_PASSES (64 / NR_BULK_RADIX_BITS)
+
+/* The bits of a value, mapped so that they are ordered as the values */
+static inline uint64_t entryValueKey(const NumericRangeEntry *e) {
+  uint64_t u;
+  memcpy(&u, &e->value, sizeof(u));
+  return (u & (1ULL << 63)) ? ~u : u | (1ULL << 63);
+}
+
+/* Sort the entries by value, with an LSD radix sort. `tmp` has room for the entries */
+static void sortEntriesByValue(NumericRangeEntry *entries, size_t num, NumericRangeEntry *tmp) {
+  if (num < 2) {
+    return;
+  }
+  const size_t radix = 1 << NR_BULK_RADIX_BITS;
+  const uint64_t mask = radix - 1;
+  size_t *counts = rm_calloc(NR_BULK_RADIX_PASSES * radix, sizeof(*counts));
+  for (size_t i = 0; i < num; ++i) {
+    uint64_t key = entryValueKey(entries + i);
+    for (int d = 0; d < NR_BULK_RADIX_PASSES; ++d) {
+      counts[d * radix + ((key >> (d * NR_BULK_RADIX_BITS)) & mask)]++;
+    }
+  }
+
+  NumericRangeEntry *src = entries, *dst = tmp;
+  for (int d = 0; d < NR_BULK_RADIX_PASSES; ++d) {
+    size_t *c = counts + d * radix;
+    int shift = d * NR_BULK_RADIX_BITS;
+    // skip the digits which are the same for all the entries
+    if (c[(entryValueKey(src) >> shift) & mask] == num) {
+      continue;
+    }
+    size_t sum = 0;
+    for (size_t j = 0; j < radix; ++j) {
+      size_t count = c[j];
+      c[j] = sum;
+      sum += count;
+    }
+    for (size_t i = 0; i < num; ++i) {
+      dst[c[(entryValueKey(src + i) >> shift) & mask]++] = src[i];
+    }
+    NumericRangeEntry *swap = src;
+    src = dst;
+    dst = swap;
+  }
+  if (src != entries) {
+    memcpy(entries, src, num * sizeof(*entries));
+  }
+  rm_free(counts);
+}
+
+static int cmpEntryDocId(const void *p1, const void *p2) {
+  const NumericRangeEntry *e1 = p1, *e2 = p2;
+  return e1->docId < e2->docId ? -1 : e1->docId > e2->docId;
+}
+
+/* Build the subtree over leaves [lo, hi). The entries are sorted by value, and those of leaf i
+ * start at bounds[i]. Ranges are written in docId order through `scratch` */
+static NumericRangeNode *bulkBuildNode(const NumericRangeEntry *entries, const size_t *bounds,
+                                       size_t lo, size_t hi, NumericRangeEntry *scratch,
+                                       NRN_AddRv *rv) {
+  NumericRangeNode *n = NewLeafNode(bounds[hi] - bounds[lo], NR_MAXRANGE_CARD);
+  if (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    n->left = bulkBuildNode(entries, bounds, lo, mid, scratch, rv);
+    n->right = bulkBuildNode(entries, bounds, mid, hi, scratch, rv);
+    // leaves never share a value, so the right subtree starts above all the values on the left
+    n->value = entries[bounds[mid]].value;
+    n->maxDepth = MAX(n->left->maxDepth, n->right->maxDepth) + 1;
+    // as when splitting, only nodes close enough to the leaves retain their range
+    if (n->maxDepth > RSGlobalConfig.numericTreeMaxDepthRange) {
+      NRN_AddRv unused = {0};
+      removeRange(n, &unused);
+      return n;
+    }
+  }
+
+  NumericRange *r = n->range;
+  size_t len = bounds[hi] - bounds[lo];
+  const NumericRangeEntry *slice = entries + bounds[lo];
+  for (size_t i = NR_CARD_CHECK - 1; i < len; i += NR_CARD_CHECK) {
+    size_t last = array_len(r->values);
+    if (last && r->values[last - 1].value == slice[i].value) {
+      r->values[last - 1].appearances++;
+    } else {
+      CardinalityValue val = {.value = slice[i].value, .appearances = 1};
+      r->values = array_append(r->values, val);
+      r->unique_sum += val.value;
+      ++r->card;
+    }
+  }
+  r->cardCheck = NR_CARD_CHECK - len % NR_CARD_CHECK;
+
+  memcpy(scratch, slice, len * sizeof(*scratch));
+  qsort(scratch, len, sizeof(*scratch), cmpEntryDocId);
+  for (size_t i = 0; i < len; ++i) {
+    rv->sz += NumericRange_Add(r, scratch[i].docId, scratch[i].value, 0);
+  }
+  rv->numRecords += len;
+  rv->numRanges++;
+  return n;
+}
+
+/* Replace the nodes of the tree with a balanced tree over the entries. Returns the size, records and
+ * ranges of the new tree */
+static NRN_AddRv bulkBuild(NumericRangeTree *t, NumericRangeEntry *entries, size_t num) {
+  NumericRangeEntry *scratch = rm_malloc(num * sizeof(*scratch));
+  sortEntriesByValue(entries, num, scratch);
+
+  // a leaf only ends between two distinct values
+  size_t *bounds = array_new(size_t, num / NR_BULK_LEAF_SIZE + 2);
+  bounds = array_append(bounds, 0);
+  size_t start = 0, card = 0;
+  double lastSample = 0;
+  t_docId lastDocId = 0;
+  for (size_t i = 0; i < num; ++i) {
+    if (i > start && entries[i].value != entries[i - 1].value &&
+        (i - start >= NR_BULK_LEAF_SIZE || card >= NR_BULK_LEAF_CARD)) {
+      bounds = array_append(bounds, i);
+      start = i;
+      card = 0;
+    }
+    if ((i - start) % NR_CARD_CHECK == NR_CARD_CHECK - 1 && (!card || entries[i].value != lastSample)) {
+      lastSample = entries[i].value;
+      ++card;
+    }
+    lastDocId = MAX(lastDocId, entries[i].docId);
+  }
+  bounds = array_append(bounds, num);
+
+  NRN_AddRv rv = {0};
+  NumericRangeNode *root = bulkBuildNode(entries, bounds, 0, array_len(bounds) - 1, scratch, &rv);
+  rm_free(scratch);
+  array_free(bounds);
+
+  NumericRangeNode_Free(t->root);
+  t->root = root;
+  t->numRanges = rv.numRanges;
+  t->numEntries = num;
+  t->lastDocId = MAX(t->lastDocId, lastDocId);
+  t->emptyLeaves = 0;
+  return rv;
+}
+
+NumericRangeTree *NewNumericRangeTreeFromEntries(NumericRangeEntry *entries, size_t num) {
+  NumericRangeTree *t = NewNumericRangeTree();
+  if (num) {
+    bulkBuild(t, entries, num);
+  }
+  return t;
+}
+
+NRN_AddRv NumericRangeTree_Rebuild(NumericRangeTree *t) {
+  // the leaves hold every entry of the tree exactly once
+  NumericRangeEntry *entries = array_new(NumericRangeEntry, t->numEntries);
+  NRN_AddRv old = {.numRanges = t->numRanges};
+  NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(t);
+  NumericRangeNode *n;
+  while ((n = NumericRangeTreeIterator_Next(iter))) {
+    if (!n->range) {
+      continue;
+    }
+    // the retained ranges of inner nodes are accounted as well
+    old.sz += n->range->invertedIndexSize;
+    old.numRecords += n->range->entries->numEntries;
+    if (!NumericRangeNode_IsLeaf(n)) {
+      continue;
+    }
+    RSIndexResult *res = NULL;
+    IndexReader *ir = NewNumericReader(NULL, n->range->entries, NULL, 0, 0, false);
+    while (INDEXREAD_OK == IR_Read(ir, &res)) {
+      NumericRangeEntry e = {.docId = res->docId, .value = res->num.value};
+      entries = array_append(entries, e);
+    }
+    IR_Free(ir);
+  }
+  NumericRangeTreeIterator_Free(iter);
+
+  NRN_AddRv rv = bulkBuild(t, entries, array_len(entries));
+  array_free(entries);
+
+  // running iterators and forked GC runs hold pointers to the old nodes
+  t->revisionId++;
+  t->uniqueId = numericTreesUniqueId++;
+
+  rv.sz -= old.sz;
+  rv.numRecords -= old.numRecords;
+  rv.numRanges -= old.numRanges;
+  rv.changed = 1;
+  return rv;
+}
+
 IndexIterator *NewNumericRangeIterator(const IndexSpec *sp, NumericRange *nr,
                                        const NumericFilter *f, int skipMulti) {
 
@@ -580,6 +806,11 @@ IndexIterator *createNumericIterator(const IndexSpec *sp, NumericRangeTree *t,
 
   QueryNodeType type = (!f || NumericFilter_IsNumeric(f)) ? QN_NUMERIC : QN_GEO;
   IndexIterator *it = NewUnionIterator(its, n, NULL, 1, 1, type, NULL, config);
+  // Wide filters select many ranges, most of them contained in the filter and read unfiltered.
+  // Their docIds are merged through a bitmap rather than re-sorted by the union's heap
+  if (config->numericMergeMinRanges && n >= config->numericMergeMinRanges) {
+    UI_EnableNumericMerge(it, NR_MERGE_WINDOW);
+  }
 
   return it;
 }
@@ -608,25 +839,26 @@ static NumericRangeTree *openNumericKeysDict(IndexSpec* spec, RedisModuleString
   return kdv->p;
 }
 
-struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
-                                               ConcurrentSearchCtx *csx, FieldType forType, IteratorsConfig *config) {
+/* Open the tree of the filter's field for reading. Returns NULL if there is none */
+static NumericRangeTree *openNumericFilterTree(RedisSearchCtx *ctx, const NumericFilter *flt,
+                                               FieldType forType) {
   RedisModuleString *s = IndexSpec_GetFormattedKeyByName(ctx->spec, flt->fieldName, forType);
   if (!s) {
     return NULL;
   }
-  RedisModuleKey *key = NULL;
-  NumericRangeTree *t = NULL;
-  if (!ctx->spec->keysDict) {
-    key = RedisModule_OpenKey(ctx->redisCtx, s, REDISMODULE_READ);
-    if (!key || RedisModule_ModuleTypeGetType(key) != NumericIndexType) {
-      return NULL;
-    }
-
-    t = RedisModule_ModuleTypeGetValue(key);
-  } else {
-    t = openNumericKeysDict(ctx->spec, s, 0);
+  if (ctx->spec->keysDict) {
+    return openNumericKeysDict(ctx->spec, s, 0);
   }
+  RedisModuleKey *key = RedisModule_OpenKey(ctx->redisCtx, s, REDISMODULE_READ);
+  if (!key || RedisModule_ModuleTypeGetType(key) != NumericIndexType) {
+    return NULL;
+  }
+  return RedisModule_ModuleTypeGetValue(key);
+}
 
+struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
+                                               ConcurrentSearchCtx *csx, FieldType forType, IteratorsConfig *config) {
+  NumericRangeTree *t = openNumericFilterTree(ctx, flt, forType);
   if (!t) {
     return NULL;
   }
@@ -647,6 +879,11 @@ struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const Numeri
   return it;
 }
 
+Vector *NumericFilter_FindRanges(RedisSearchCtx *ctx, const NumericFilter *flt, FieldType forType) {
+  NumericRangeTree *t = openNumericFilterTree(ctx, flt, forType);
+  return t ? NumericRangeTree_Find(t, flt) : NULL;
+}
+
 NumericRangeTree *OpenNumericIndex(RedisSearchCtx *ctx, RedisModuleString *keyName,
                                    RedisModuleKey **idxKey) {
 
@@ -718,20 +955,6 @@ int NumericIndexType_Register(RedisModuleCtx *ctx) {
   return REDISMODULE_OK;
 }
 
-/* A single entry in a numeric index's single range. Since entries are binned together, each needs
- * to have the exact value */
-typedef struct {
-  t_docId docId;
-  double value;
-} NumericRangeEntry;
-
-static int cmpdocId(const void *p1, const void *p2) {
-  NumericRangeEntry *e1 = (NumericRangeEntry *)p1;
-  NumericRangeEntry *e2 = (NumericRangeEntry *)p2;
-
-  return (int)e1->docId - (int)e2->docId;
-}
-
 /** Version 0 stores the number of entries beforehand, and then loads them */
 static size_t loadV0(RedisModuleIO *rdb, NumericRangeEntry **entriespp) {
   uint64_t num = RedisModule_LoadUnsigned(rdb);
@@ -780,14 +1003,7 @@ void *NumericIndexType_RdbLoad(RedisModuleIO *rdb, int encver) {
     return NULL;  // Unknown version
   }
 
-  // sort the entries by doc id, as they were not saved in this order
-  qsort(entries, numEntries, sizeof(NumericRangeEntry), cmpdocId);
-  NumericRangeTree *t = NewNumericRangeTree();
-
-  // now push them in order into the tree
-  for (size_t i = 0; i < numEntries; i++) {
-    NumericRangeTree_Add(t, entries[i].docId, entries[i].value, true);
-  }
+  NumericRangeTree *t = NewNumericRangeTreeFromEntries(entries, numEntries);
   array_free(entries);
   return t;
 }
@@ -72,6 +72,13 @@ typedef struct {
   NumericRangeNode **nodesStack;
 } NumericRangeTreeIterator;
 
+/* A single entry in a numeric index's single range. Since entries are binned together, each needs
+ * to have the exact value */
+typedef struct {
+  t_docId docId;
+  double value;
+} NumericRangeEntry;
+
 /* The root tree and its metadata */
 typedef struct {
   NumericRangeNode *root;
@@ -95,10 +102,15 @@ struct indexIterator *NewNumericRangeIterator(const IndexSpec *sp, NumericRange
 struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
                                                ConcurrentSearchCtx *csx, FieldType forType, IteratorsConfig *config);
 
-/* Add an entry to a numeric range node. Returns the cardinality of the range after the
- * inserstion.
+/* Find the ranges of the filter's field which overlap the filter, in the order of the filter's
+ * `asc`. The ranges are valid for as long as the lock is held. Returns NULL if the field has no
+ * tree */
+Vector *NumericFilter_FindRanges(RedisSearchCtx *ctx, const NumericFilter *flt, FieldType forType);
+
+/* Add an entry to a numeric range node. Returns the number of bytes the range grew by, which is
+ * negative if sealing its last block shrank it.
  * No deduplication is done */
-size_t NumericRange_Add(NumericRange *r, t_docId docId, double value, int checkCard);
+ssize_t NumericRange_Add(NumericRange *r, t_docId docId, double value, int checkCard);
 
 /* Split n into two ranges, lp for left, and rp for right. We split by the median score */
 double NumericRange_Split(NumericRange *n, NumericRangeNode **lp, NumericRangeNode **rp,
@@ -127,6 +139,16 @@ NumericRangeTree *NewNumericRangeTree();
 /* Add a value to a tree. Returns 0 if no nodes were split, 1 if we splitted nodes */
 NRN_AddRv NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value, int isMulti);
 
+/* Create a balanced tree from entries in any order, with leaves that have room to grow. This is
+ * much faster than adding the entries one by one. The entries are sorted in place */
+NumericRangeTree *NewNumericRangeTreeFromEntries(NumericRangeEntry *entries, size_t num);
+
+/* Rebuild the tree in bulk from its entries, dropping empty leaves and restoring its balance after
+ * heavy churn. Running iterators on the tree are aborted the next time they get execution context.
+ * Returns the change in the size, records and ranges of the tree, to apply to the index stats
+ */
+NRN_AddRv NumericRangeTree_Rebuild(NumericRangeTree *t);
+
 /* Remove a node containing a range with value.
    Returns 1 if node was found, 0 otherwise */
 int NumericRangeTree_DeleteNode(NumericRangeTree *t, double value);
@@ -112,6 +112,42 @@ void OptimizerIterator_Free(struct indexIterator *self) {
   rm_free(it);
 }
 
+/* Offer the numeric result of a document that matches the query to the heap of results */
+static void OPT_Offer(OptimizerIterator *it, const RSIndexResult *numericRes) {
+  it->lastDocId = numericRes->docId;
+
+  // copy the numeric result for the sorting heap
+  if (numericRes->type == RSResultType_Numeric) {
+    *it->pooledResult = *numericRes;
+  } else {
+    RSIndexResult *child = numericRes->agg.children[0];
+    RS_LOG_ASSERT(child->type == RSResultType_Numeric, "???");
+    *it->pooledResult = *(child);
+  }
+
+  // handle expired results
+  const RSDocumentMetadata *dmd = DocTable_Borrow(&it->optim->sctx->spec->docs, numericRes->docId);
+  if (!dmd) {
+    return;
+  }
+  it->pooledResult->dmd = dmd;
+
+  // heap is not full. insert
+  if (heap_count(it->heap) < heap_size(it->heap)) {
+    heap_offer(&it->heap, it->pooledResult);
+    it->pooledResult++;
+
+  // heap is full. try to replace
+  } else {
+    RSIndexResult *tempRes = heap_peek(it->heap);
+    if (it->cmp(tempRes, it->pooledResult, NULL) > 0) {
+      heap_replace(it->heap, it->pooledResult);
+      it->pooledResult = tempRes;
+    }
+    DMD_Return(it->pooledResult->dmd);
+  }
+}
+
 int OPT_ReadYield(void *ctx, RSIndexResult **e) {
   OptimizerIterator *it = ctx;
   if (heap_count(it->heap) > 0) {
@@ -124,7 +160,6 @@ int OPT_ReadYield(void *ctx, RSIndexResult **e) {
 int OPT_Read(void *ctx, RSIndexResult **e) {
   int rc1, rc2;
   OptimizerIterator *it = ctx;
-  QOptimizer *opt = it->optim;
 
   IndexIterator *child = it->child;
   IndexIterator *numeric = it->numericIter;
@@ -155,38 +190,7 @@ int OPT_Read(void *ctx, RSIndexResult **e) {
 
       it->hitCounter++;
       if (childRes->docId == numericRes->docId) {
-        it->lastDocId = childRes->docId;
-
-        // copy the numeric result for the sorting heap
-        if (numericRes->type == RSResultType_Numeric) {
-          *it->pooledResult = *numericRes;
-        } else {
-          RSIndexResult *child = numericRes->agg.children[0];
-          RS_LOG_ASSERT(child->type == RSResultType_Numeric, "???");
-          *it->pooledResult = *(child);
-        }
-
-        // handle expired results
-        const RSDocumentMetadata *dmd = DocTable_Borrow(&opt->sctx->spec->docs, childRes->docId);
-        if (!dmd) {
-          continue;
-        }
-        it->pooledResult->dmd = dmd;
-
-        // heap is not full. insert
-        if (heap_count(it->heap) < heap_size(it->heap)) {
-          heap_offer(&it->heap, it->pooledResult);
-          it->pooledResult++;
-
-        // heap is full. try to replace
-        } else {
-          RSIndexResult *tempRes = heap_peek(it->heap);
-          if (it->cmp(tempRes, it->pooledResult, NULL) > 0) {
-            heap_replace(it->heap, it->pooledResult);
-            it->pooledResult = tempRes;
-          }
-          DMD_Return(it->pooledResult->dmd);
-        }
+        OPT_Offer(it, numericRes);
       }
     }
 
@@ -208,6 +212,76 @@ int OPT_Read(void *ctx, RSIndexResult **e) {
   }
 }
 
+static int cmpDocIds(const void *p1, const void *p2) {
+  t_docId id1 = *(const t_docId *)p1, id2 = *(const t_docId *)p2;
+  return id1 < id2 ? -1 : id1 > id2;
+}
+
+/* Ordered scan: walk the ranges of the sortby field in the order of the sort, one at a time, and
+ * intersect each with the query. The ranges hold disjoint intervals of values, so once the heap is
+ * full at the end of a range, no later range can improve on it. The rest of the ranges are never
+ * read, whatever the selectivity of the query */
+static int OPT_ReadOrdered(void *ctx, RSIndexResult **e) {
+  OptimizerIterator *it = ctx;
+  QOptimizer *qOpt = it->optim;
+  IndexIterator *child = it->child;
+
+  NumericFilter nf = *qOpt->nf;
+  nf.limit = 0;
+  nf.offset = 0;
+  Vector *ranges = NumericFilter_FindRanges(qOpt->sctx, &nf, INDEXFLD_T_NUMERIC);
+  size_t nranges = ranges ? Vector_Size(ranges) : 0;
+  // the documents in the heap, to skip the other values of multi-value documents
+  t_docId *seen = NULL;
+
+  it->hitCounter = 0;
+  for (size_t i = 0; i < nranges && heap_count(it->heap) < heap_size(it->heap); ++i) {
+    NumericRange *rng;
+    Vector_Get(ranges, i, &rng);
+    if (!rng) {
+      continue;
+    }
+    size_t nseen = heap_count(it->heap);
+    if (nseen) {
+      seen = rm_realloc(seen, nseen * sizeof(*seen));
+      for (size_t j = 0; j < nseen; ++j) {
+        seen[j] = it->resArr[j].docId;
+      }
+      qsort(seen, nseen, sizeof(*seen), cmpDocIds);
+    }
+
+    IndexIterator *numeric = NewNumericRangeIterator(qOpt->sctx->spec, rng, &nf, true);
+    RSIndexResult *childRes = NULL, *numericRes = NULL;
+    child->Rewind(child->ctx);
+    int rc = numeric->Read(numeric->ctx, &numericRes);
+    while (rc != INDEXREAD_EOF) {
+      if (!childRes || childRes->docId < numericRes->docId) {
+        if (child->SkipTo(child->ctx, numericRes->docId, &childRes) == INDEXREAD_EOF) {
+          break;
+        }
+      }
+      it->hitCounter++;
+      if (childRes->docId == numericRes->docId) {
+        if (!nseen || !bsearch(&numericRes->docId, seen, nseen, sizeof(*seen), cmpDocIds)) {
+          OPT_Offer(it, numericRes);
+        }
+        rc = numeric->Read(numeric->ctx, &numericRes);
+      } else {
+        rc = numeric->SkipTo(numeric->ctx, childRes->docId, &numericRes);
+      }
+    }
+    numeric->Free(numeric);
+    it->numIterations++;
+  }
+  rm_free(seen);
+  if (ranges) {
+    Vector_Free(ranges);
+  }
+
+  it->base.Read = OPT_ReadYield;
+  return OPT_ReadYield(ctx, e);
+}
+
 IndexIterator *NewOptimizerIterator(QOptimizer *qOpt, IndexIterator *root, IteratorsConfig *config) {
   OptimizerIterator *oi = rm_calloc(1, sizeof(*oi));
   oi->child = root;
@@ -254,7 +328,7 @@ IndexIterator *NewOptimizerIterator(QOptimizer *qOpt, IndexIterator *root, Itera
   ri->Rewind = OPT_Rewind;
   ri->HasNext = OPT_HasNext;
   ri->SkipTo = NULL;            // The iterator is always on top and and Read() is called
-  ri->Read = OPT_Read;
+  ri->Read = config->numericOrderedScan ? OPT_ReadOrdered : OPT_Read;
   ri->current = NewNumericResult();
 
   return &oi->base;
@@ -0,0 +1,131 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "pfor.h"
+#include "varint.h"
+#include <string.h>
+
+#define PFOR_MAX_BITS 32
+
+static inline uint8_t bitWidth(uint32_t v) {
+  return v ? 32 - __builtin_clz(v) : 0;
+}
+
+// Size in bytes of the high bits of an exception, written as a varint
+static inline size_t excHighSize(uint8_t width, uint8_t b) {
+  return (width - b + 6) / 7;
+}
+
+// Choose the bit width which minimizes the size of the frame
+static uint8_t chooseBitWidth(const uint32_t *arr, uint32_t n) {
+  uint32_t hist[PFOR_MAX_BITS + 1] = {0};
+  for (uint32_t i = 0; i < n; ++i) {
+    ++hist[bitWidth(arr[i])];
+  }
+
+  uint8_t best = PFOR_MAX_BITS;
+  size_t bestSize = SIZE_MAX;
+  for (uint8_t b = 0; b <= PFOR_MAX_BITS; ++b) {
+    size_t sz = ((size_t)n * b + 7) / 8;
+    for (uint8_t w = b + 1; w <= PFOR_MAX_BITS; ++w) {
+      // position delta (usually a single byte) and high bits
+      sz += hist[w] * (1 + excHighSize(w, b));
+    }
+    if (sz < bestSize) {
+      bestSize = sz;
+      best = b;
+    }
+  }
+  return best;
+}
+
+size_t PFor_Encode(BufferWriter *bw, const uint32_t *arr, uint32_t n) {
+  size_t sz = 0;
+  uint8_t b = chooseBitWidth(arr, n);
+  uint64_t mask = (1ULL << b) - 1;
+
+  uint32_t nexc = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    nexc += (arr[i] > mask);
+  }
+  sz += Buffer_WriteU8(bw, b);
+  sz += WriteVarint(nexc, bw);
+
+  // pack the low bits of all the integers
+  uint64_t acc = 0;
+  uint8_t nbits = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    acc |= (arr[i] & mask) << nbits;
+    nbits += b;
+    while (nbits >= 8) {
+      sz += Buffer_WriteU8(bw, acc & 0xff);
+      acc >>= 8;
+      nbits -= 8;
+    }
+  }
+  if (nbits) {
+    sz += Buffer_WriteU8(bw, acc & 0xff);
+  }
+
+  // patch list
+  uint32_t last = 0;
+  for (uint32_t i = 0; nexc && i < n; ++i) {
+    if (arr[i] > mask) {
+      sz += WriteVarint(i - last, bw);
+      sz += WriteVarint(arr[i] >> b, bw);
+      last = i;
+    }
+  }
+  return sz;
+}
+
+size_t PFor_Decode(BufferReader *br, uint32_t *arr, uint32_t n) {
+  size_t start = br->pos;
+  uint8_t b = Buffer_ReadU8(br);
+  uint32_t nexc = ReadVarint(br);
+
+  if (b == 0) {
+    memset(arr, 0, n * sizeof(*arr));
+  } else {
+    const uint8_t *in = (const uint8_t *)BufferReader_Current(br);
+    const size_t len = ((size_t)n * b + 7) / 8;
+    const uint64_t mask = (1ULL << b) - 1;
+    uint32_t i = 0;
+    // Every integer is within the 8 bytes starting at the byte its first bit is in, as b <= 32.
+    // Read them with unaligned 64 bit loads as long as these do not cross the end of the frame
+    for (size_t bit = 0; i < n && bit / 8 + 8 <= len; ++i, bit += b) {
+      uint64_t word;
+      memcpy(&word, in + bit / 8, sizeof(word));
+      arr[i] = (word >> (bit % 8)) & mask;
+    }
+    // and the tail byte by byte
+    size_t bit = (size_t)i * b;
+    const uint8_t *p = in + bit / 8;
+    uint64_t acc = 0;
+    uint8_t nbits = 0;
+    if (bit % 8 && i < n) {
+      acc = *p++ >> (bit % 8);
+      nbits = 8 - bit % 8;
+    }
+    for (; i < n; ++i) {
+      while (nbits < b) {
+        acc |= (uint64_t)*p++ << nbits;
+        nbits += 8;
+      }
+      arr[i] = acc & mask;
+      acc >>= b;
+      nbits -= b;
+    }
+    Buffer_Skip(br, len);
+  }
+
+  uint32_t pos = 0;
+  for (uint32_t i = 0; i < nexc; ++i) {
+    pos += ReadVarint(br);
+    arr[pos] |= ReadVarint(br) << b;
+  }
+  return br->pos - start;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#ifndef __PFOR_H__
+#define __PFOR_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* PFor - "patched frame of reference" encoding of arrays of unsigned 32 bit integers.
+ *
+ * A frame stores all the integers with the same bit width `b`, chosen so the frame is as small as
+ * possible. Integers that do not fit in `b` bits are "exceptions": their low `b` bits are stored in
+ * the frame, and their high bits are stored after it, along with their position. Decoding a frame
+ * is a tight unpacking loop with no per-integer branching, followed by patching the exceptions.
+ *
+ * Frame layout:
+ *   [u8 bit width] [varint number of exceptions] [n * b bits, LSB first]
+ *   [varint position delta, varint high bits] * number of exceptions
+ *
+ * The number of integers is not part of the frame, and must be known by the reader */
+
+/* Encode `n` integers as a frame. Returns the number of bytes written */
+size_t PFor_Encode(BufferWriter *bw, const uint32_t *arr, uint32_t n);
+
+/* Decode a frame of `n` integers into `arr`. Returns the number of bytes read */
+size_t PFor_Decode(BufferReader *br, uint32_t *arr, uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -11,7 +11,7 @@ void printReadIt(RedisModule_Reply *reply, IndexIterator *root, size_t counter,
 
   RedisModule_Reply_Map(reply);
 
-  if (ir->idx->flags == Index_DocIdsOnly) {
+  if ((ir->idx->flags & ~Index_BlockPacked) == Index_DocIdsOnly) {
     printProfileType("TAG");
     RedisModule_ReplyKV_SimpleString(reply, "Term", ir->record->term.term->str);
 
@@ -60,6 +60,7 @@ static double _recursiveProfilePrint(RedisModule_Reply *reply, ResultProcessor *
     switch (rp->type) {
       case RP_INDEX:
       case RP_METRICS:
+      case RP_RERANKER:
       case RP_LOADER:
       case RP_SAFE_LOADER:
       case RP_SCORER:
@@ -17,6 +17,14 @@
 #define printProfileCounter(vcounter) RedisModule_ReplyKV_LongLong(reply, "Counter", (vcounter))
 #define printProfileNumBatches(hybrid_reader) \
   RedisModule_ReplyKV_LongLong(reply, "Batches number", (hybrid_reader)->numIterations)
+#define printProfileFilterBitmapSize(hybrid_reader) \
+  RedisModule_ReplyKV_LongLong(reply, "Filter bitmap size", (hybrid_reader)->numFiltered)
+#define printProfileNumRings(geo_knn_reader) \
+  RedisModule_ReplyKV_LongLong(reply, "Rings number", (geo_knn_reader)->numRings)
+#define printProfileNumRangeBatches(vector_range_reader) \
+  RedisModule_ReplyKV_LongLong(reply, "Batches number", (vector_range_reader)->numIterations)
+#define printProfileNumReranked(quantized_knn_reader) \
+  RedisModule_ReplyKV_LongLong(reply, "Reranked candidates", (quantized_knn_reader)->numReranked)
 #define printProfileOptimizationType(oi) \
   RedisModule_ReplyKV_SimpleString(reply, "Optimizer mode", QOptimizer_PrintType((oi)->optim))
 
@@ -0,0 +1,286 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "quantized_reader.h"
+#include "document.h"
+#include "json.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+#include <sys/param.h>
+
+// The distance is the value of a metric result, which is the first child of a hybrid result
+#define QKR_METRIC(r) ((r)->type == RSResultType_Metric ? (r) : (r)->agg.children[0])
+#define QKR_DISTANCE(r) (QKR_METRIC(r)->num.value)
+
+static int cmpByDistance(const void *p1, const void *p2) {
+  const RSIndexResult *r1 = *(const RSIndexResult **)p1, *r2 = *(const RSIndexResult **)p2;
+  double d1 = QKR_DISTANCE(r1), d2 = QKR_DISTANCE(r2);
+  if (d1 != d2) {
+    return d1 < d2 ? -1 : 1;
+  }
+  return r1->docId < r2->docId ? -1 : r1->docId > r2->docId;
+}
+
+static int cmpCandidatesById(const void *p1, const void *p2) {
+  const QuantizedCandidate *c1 = p1, *c2 = p2;
+  return c1->id < c2->id ? -1 : c1->id > c2->id;
+}
+
+static bool hashExactDistance(QuantizedKnnIterator *it, RedisModuleString *keyName,
+                              double *distance) {
+  RedisModuleCtx *ctx = it->sctx->redisCtx;
+  RedisModuleKey *key = RedisModule_OpenKey(ctx, keyName, REDISMODULE_READ | REDISMODULE_OPEN_KEY_NOEFFECTS);
+  if (!key) {
+    return false;
+  }
+  bool found = false;
+  RedisModuleString *val = NULL;
+  if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_HASH &&
+      RedisModule_HashGet(key, REDISMODULE_HASH_CFIELDS, it->fs->path, &val, NULL) == REDISMODULE_OK &&
+      val) {
+    size_t len;
+    const char *blob = RedisModule_StringPtrLen(val, &len);
+    if (len == it->fs->vectorOpts.expBlobSize) {
+      *distance = QuantizedQuery_ExactDistance(it->query, blob);
+      found = true;
+    }
+    RedisModule_FreeString(ctx, val);
+  }
+  RedisModule_CloseKey(key);
+  return found;
+}
+
+static bool jsonExactDistance(QuantizedKnnIterator *it, RedisModuleString *keyName,
+                              double *distance) {
+  RedisModuleCtx *ctx = it->sctx->redisCtx;
+  RedisJSON root = japi_ver >= 5 ? japi->openKeyWithFlags(ctx, keyName, REDISMODULE_OPEN_KEY_NOEFFECTS)
+                                 : japi->openKey(ctx, keyName);
+  if (!root) {
+    return false;
+  }
+  JSONResultsIterator jsonIter = japi->get(root, it->fs->path);
+  if (!jsonIter) {
+    return false;
+  }
+  bool found = false;
+  RedisJSON arr = japi->next(jsonIter);
+  if (arr && japi->getType(arr) == JSONType_Array) {
+    DocumentField df = {0};
+    QueryError status = {0};
+    if (JSON_StoreSingleVectorInDocField((FieldSpec *)it->fs, arr, &df, &status) == REDISMODULE_OK) {
+      *distance = QuantizedQuery_ExactDistance(it->query, df.strval);
+      found = true;
+      rm_free(df.strval);
+    }
+    QueryError_ClearError(&status);
+  }
+  japi->freeIter(jsonIter);
+  return found;
+}
+
+bool QuantizedKnnIterator_Rerank(QuantizedKnnIterator *it, RSIndexResult *r,
+                                 const RSDocumentMetadata *dmd) {
+  RedisModuleString *keyName = DMD_CreateKeyString(dmd, it->sctx->redisCtx);
+  double distance;
+  bool found = dmd->type == DocumentType_Json ? jsonExactDistance(it, keyName, &distance)
+                                              : hashExactDistance(it, keyName, &distance);
+  RedisModule_FreeString(it->sctx->redisCtx, keyName);
+  if (!found) {
+    return false;
+  }
+  ++it->numReranked;
+  QKR_METRIC(r)->num.value = distance;
+  // the yielded distance as well
+  for (size_t i = 0; i < array_len(r->metrics); ++i) {
+    if (r->metrics[i].key == it->base.ownKey) {
+      RSValue_Decref(r->metrics[i].value);
+      r->metrics[i].value = RS_NumVal(distance);
+    }
+  }
+  return true;
+}
+
+double QuantizedKnnIterator_Distance(const RSIndexResult *r) {
+  return QKR_DISTANCE(r);
+}
+
+static void QKR_AddResult(QuantizedKnnIterator *it, const QuantizedCandidate *c,
+                          RSIndexResult *childRes) {
+  RSIndexResult *metric = NewMetricResult();
+  metric->docId = c->id;
+  metric->num.value = c->distance;
+
+  RSIndexResult *hit = metric;
+  if (childRes && !it->ignoreScores) {
+    // The first child is the distance, and the second is the result of the rest of the query
+    RSIndexResult *res = it->base.current;
+    AggregateResult_AddChild(res, metric);
+    AggregateResult_AddChild(res, childRes);
+    hit = IndexResult_DeepCopy(res);
+    AggregateResult_Reset(res);
+    IndexResult_Free(metric);
+  } else if (childRes) {
+    ResultMetrics_Concat(hit, childRes);  // Pass child metrics, if there are any
+  }
+  ResultMetrics_Add(hit, it->base.ownKey, RS_NumVal(c->distance));
+  it->results = array_append(it->results, hit);
+}
+
+static size_t QKR_NumResults(const QuantizedKnnIterator *it) {
+  return it->rerank ? MAX(it->rerank, it->k) : it->k;
+}
+
+static int QKR_PrepareResults(QuantizedKnnIterator *it) {
+  QuantizedTopK candidates;
+  QuantizedTopK_Init(&candidates, QKR_NumResults(it));
+  if (it->child) {
+    RSIndexResult *childRes;
+    double distance;
+    while (it->child->Read(it->child->ctx, &childRes) != INDEXREAD_EOF) {
+      if (TimedOut_WithCtx(&it->timeoutCtx)) {
+        QuantizedTopK_Free(&candidates);
+        return INDEXREAD_TIMEOUT;
+      }
+      if (QuantizedQuery_Distance(it->query, childRes->docId, &distance)) {
+        QuantizedTopK_Push(&candidates, childRes->docId, distance);
+      }
+    }
+  } else {
+    QuantizedQuery_TopK(it->query, &candidates);
+  }
+  QuantizedTopK_Sort(&candidates);
+  // the candidates to re-rank are all returned, and cut to k by the re-ranking result processor
+  size_t n = MIN(candidates.len, QKR_NumResults(it));
+
+  if (it->child) {
+    // Attach the results of the child to the nearest documents, skipping to them in increasing ids
+    qsort(candidates.items, n, sizeof(*candidates.items), cmpCandidatesById);
+    it->child->Rewind(it->child->ctx);
+    for (size_t i = 0; i < n; ++i) {
+      RSIndexResult *childRes;  // This will use the memory of it->child->current.
+      if (it->child->SkipTo(it->child->ctx, candidates.items[i].id, &childRes) == INDEXREAD_OK) {
+        QKR_AddResult(it, &candidates.items[i], childRes);
+      }
+    }
+    qsort(it->results, array_len(it->results), sizeof(*it->results), cmpByDistance);
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      QKR_AddResult(it, &candidates.items[i], NULL);
+    }
+  }
+  QuantizedTopK_Free(&candidates);
+  return INDEXREAD_OK;
+}
+
+static int QKR_HasNext(void *ctx) {
+  QuantizedKnnIterator *it = ctx;
+  return it->base.isValid;
+}
+
+static int QKR_Read(void *ctx, RSIndexResult **hit) {
+  QuantizedKnnIterator *it = ctx;
+  if (!it->resultsPrepared) {
+    it->resultsPrepared = true;
+    if (QKR_PrepareResults(it) == INDEXREAD_TIMEOUT) {
+      return INDEXREAD_TIMEOUT;
+    }
+  }
+  if (!it->base.isValid || it->pos == array_len(it->results)) {
+    it->base.isValid = 0;
+    return INDEXREAD_EOF;
+  }
+  *hit = it->results[it->pos++];
+  it->lastDocId = (*hit)->docId;
+  return INDEXREAD_OK;
+}
+
+static size_t QKR_NumEstimated(void *ctx) {
+  QuantizedKnnIterator *it = ctx;
+  if (it->child == NULL) return QKR_NumResults(it);
+  return MIN(QKR_NumResults(it), it->child->NumEstimated(it->child->ctx));
+}
+
+static size_t QKR_Len(void *ctx) {
+  return QKR_NumEstimated(ctx);
+}
+
+static void QKR_Abort(void *ctx) {
+  QuantizedKnnIterator *it = ctx;
+  it->base.isValid = 0;
+}
+
+static t_docId QKR_LastDocId(void *ctx) {
+  QuantizedKnnIterator *it = ctx;
+  return it->lastDocId;
+}
+
+static void QKR_Rewind(void *ctx) {
+  QuantizedKnnIterator *it = ctx;
+  for (size_t i = 0; i < array_len(it->results); ++i) {
+    IndexResult_Free(it->results[i]);
+  }
+  array_clear(it->results);
+  if (it->child) {
+    it->child->Rewind(it->child->ctx);
+  }
+  it->resultsPrepared = false;
+  it->numReranked = 0;
+  it->pos = 0;
+  it->lastDocId = 0;
+  it->base.isValid = 1;
+}
+
+static void QuantizedKnnIterator_Free(struct indexIterator *self) {
+  QuantizedKnnIterator *it = self->ctx;
+  if (it == NULL) {
+    return;
+  }
+  array_free_ex(it->results, IndexResult_Free(*(RSIndexResult **)ptr));
+  IndexResult_Free(it->base.current);
+  QuantizedQuery_Free(it->query);
+  if (it->child) {
+    it->child->Free(it->child);
+  }
+  rm_free(it);
+}
+
+IndexIterator *NewQuantizedKnnIterator(RedisSearchCtx *sctx, const FieldSpec *fs,
+                                       const QuantizedIndex *qi, const KNNVectorQuery *query,
+                                       IndexIterator *child, bool ignoreScores) {
+  QuantizedKnnIterator *it = rm_new(QuantizedKnnIterator);
+  it->sctx = sctx;
+  it->fs = fs;
+  it->query = NewQuantizedQuery(qi, query->vector);
+  it->k = query->k;
+  it->rerank = fs->vectorOpts.quantParams.rerank;
+  it->child = child;
+  it->ignoreScores = ignoreScores;
+  it->timeoutCtx = (TimeoutCtx){ .timeout = sctx->timeout, .counter = 0 };
+  it->resultsPrepared = false;
+  it->results = array_new(RSIndexResult *, MIN(query->k, 1024));
+  it->pos = 0;
+  it->numReranked = 0;
+  it->lastDocId = 0;
+
+  IndexIterator *ri = &it->base;
+  ri->ctx = it;
+  // This will be changed later to a valid RLookupKey if the distance is yielded,
+  // by the creation of the metrics loader results processor.
+  ri->ownKey = NULL;
+  ri->isValid = 1;
+  ri->type = QUANTIZED_KNN_ITERATOR;
+  ri->NumEstimated = QKR_NumEstimated;
+  ri->LastDocId = QKR_LastDocId;
+  ri->Free = QuantizedKnnIterator_Free;
+  ri->Len = QKR_Len;
+  ri->Abort = QKR_Abort;
+  ri->Rewind = QKR_Rewind;
+  ri->HasNext = QKR_HasNext;
+  ri->Read = QKR_Read;
+  ri->SkipTo = NULL;  // The results are returned by distance, unsorted by id
+  ri->current = child && !ignoreScores ? NewHybridResult() : NewMetricResult();
+  return ri;
+}
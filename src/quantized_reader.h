@@ -0,0 +1,65 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "index_iterator.h"
+#include "redisearch.h"
+#include "search_ctx.h"
+#include "vector_index.h"
+#include "vector_quant.h"
+#include "util/timeout.h"
+
+/* Returns the k documents whose vectors are nearest to the query vector in a quantized vector
+ * index, in increasing distance.
+ *
+ * The candidates are the nearest vectors by the distances of the quantized vectors, out of those
+ * matching the child iterator (the rest of the query) if there is one. If the field re-ranks its
+ * results, the `rerank` nearest candidates are returned instead, and the re-ranking result
+ * processor computes their exact distances from the full vectors of their documents and keeps the
+ * k nearest. The keyspace is only accessed there, after the spec is unlocked */
+typedef struct QuantizedKnnIterator {
+  IndexIterator base;
+  RedisSearchCtx *sctx;
+  const FieldSpec *fs;
+  QuantizedQuery *query;
+  size_t k;
+  size_t rerank;              // The number of candidates to re-rank, or 0
+  IndexIterator *child;       // The rest of the query, or NULL
+  bool ignoreScores;          // Ignore the document scores, only the distance matters.
+  TimeoutCtx timeoutCtx;
+
+  bool resultsPrepared;
+  RSIndexResult **results;    // The nearest documents (or candidates), in increasing distance
+  size_t pos;                 // The position of the next result to return
+  size_t numReranked;         // The number of candidates whose exact distance was computed
+  t_docId lastDocId;
+} QuantizedKnnIterator;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Create an iterator over the `query->k` documents nearest to `query->vector` in the quantized
+ * index of the vector field `fs`, which match `child` (which may be NULL). The iterator takes
+ * ownership of the child */
+IndexIterator *NewQuantizedKnnIterator(RedisSearchCtx *sctx, const FieldSpec *fs,
+                                       const QuantizedIndex *qi, const KNNVectorQuery *query,
+                                       IndexIterator *child, bool ignoreScores);
+
+/* Set the distance of a result of the iterator to the exact distance of the query from the full
+ * vector of its document. Returns false if the vector could not be loaded, e.g. since the document
+ * was deleted, and keeps the quantized distance then. Accesses the keyspace, so Redis must be
+ * locked */
+bool QuantizedKnnIterator_Rerank(QuantizedKnnIterator *it, RSIndexResult *r,
+                                 const RSDocumentMetadata *dmd);
+
+/* The distance of a result of the iterator */
+double QuantizedKnnIterator_Distance(const RSIndexResult *r);
+
+#ifdef __cplusplus
+}
+#endif
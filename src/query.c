@@ -34,6 +34,8 @@
 #include "suffix.h"
 #include "wildcard/wildcard.h"
 #include "geometry/geometry_api.h"
+#include "filter_cache.h"
+#include "geo_knn_reader.h"
 
 #define EFFECTIVE_FIELDMASK(q_, qn_) ((qn_)->opts.fieldMask & (q)->opts->fieldmask)
 
@@ -312,6 +314,8 @@ QueryNode *NewGeofilterNode(QueryParam *p) {
   // Move data and params pointers
   ret->gn.gf = p->gf;
   ret->params = p->params;
+  // the distance of the documents can be yielded in KNN queries
+  ret->opts.flags |= QueryNode_YieldsDistance;
   p->gf = NULL;
   p->params = NULL;
   rm_free(p);
@@ -393,15 +397,16 @@ static void setFilterNode(QueryAST *q, QueryNode *n) {
     // we usually want the numeric range as the "leader" iterator.
     q->root->children = array_ensure_prepend(q->root->children, &n, 1, QueryNode *);
     q->numTokens++;
-  // vector node of type KNN should always be in the root, so we have a special case here.
-  } else if (q->root->type == QN_VECTOR && q->root->vn.vq->type == VECSIM_QT_KNN) {
-    // for non-hybrid - add the filter node as the child of the vector node.
+  // vector and geo nodes of type KNN should always be in the root, so we have a special case here.
+  } else if ((q->root->type == QN_VECTOR && q->root->vn.vq->type == VECSIM_QT_KNN) ||
+             QueryNode_IsGeoKnn(q->root)) {
+    // for non-hybrid - add the filter node as the child of the KNN node.
     if (QueryNode_NumChildren(q->root) == 0) {
       QueryNode_AddChild(q->root, n);
-    // otherwise, add a new phrase node as the parent of the current child of the hybrid vector node,
+    // otherwise, add a new phrase node as the parent of the current child of the hybrid KNN node,
     // and set its children to be the previous child and the new filter node.
     } else {
-      RS_LOG_ASSERT(QueryNode_NumChildren(q->root) == 1, "Vector query node can have at most one child");
+      RS_LOG_ASSERT(QueryNode_NumChildren(q->root) == 1, "KNN query node can have at most one child");
       QueryNode *nr = NewPhraseNode(0);
       QueryNode_AddChild(nr, n);
       QueryNode_AddChild(nr, q->root->children[0]);
@@ -892,7 +897,35 @@ static IndexIterator *Query_EvalGeofilterNode(QueryEvalCtx *q, QueryNode *node,
   if (!fs || !FIELD_IS(fs, INDEXFLD_T_GEO)) {
     return NULL;
   }
-  return NewGeoRangeIterator(q->sctx, node->gn.gf, q->conc, q->config);
+  if (!node->gn.gf->knn) {
+    if (node->opts.distField) {
+      QueryError_SetErrorFmt(q->status, QUERY_EBADATTR,
+                             "Distance can only be yielded by GEO KNN queries: %s",
+                             node->opts.distField);
+      return NULL;
+    }
+    return NewGeoRangeIterator(q->sctx, node->gn.gf, q->conc, q->config);
+  }
+
+  size_t idx = -1;
+  if (node->opts.distField) {
+    idx = addMetricRequest(q, node->opts.distField, NULL);
+  }
+  IndexIterator *child_it = NULL;
+  if (QueryNode_NumChildren(node) > 0) {
+    RedisModule_Assert(QueryNode_NumChildren(node) == 1);
+    child_it = Query_EvalNode(q, node->children[0]);
+    // If the child iterator is invalid or empty, the KNN iterator is empty as well.
+    if (child_it == NULL) {
+      return NULL;
+    }
+  }
+  IndexIterator *it = NewGeoKnnIterator(q->sctx, node->gn.gf, child_it,
+                                        q->opts->flags & Search_IgnoreScores, q->config);
+  if (node->opts.distField) {
+    array_ensure_at(q->metricRequestsP, idx, MetricRequest)->key_ptr = &it->ownKey;
+  }
+  return it;
 }
 
 static IndexIterator *Query_EvalGeometryNode(QueryEvalCtx *q, QueryNode *node) {
@@ -919,6 +952,69 @@ static IndexIterator *Query_EvalGeometryNode(QueryEvalCtx *q, QueryNode *node) {
 }
 
 
+/* Append the shape of a hybrid query filter to `s`: the types of its nodes and the fields they
+ * filter, without their values, e.g. `INTERSECT(TAG(@t),NUMERIC(@n))`. Queries of the same shape
+ * share their learned pass rate (see hybrid_stats.h) */
+static sds hybridFilterShape(sds s, const QueryNode *qn) {
+  const char *field = NULL;
+  bool values = false;  // the children of the node are the values of the filter
+  switch (qn->type) {
+    case QN_PHRASE:
+      s = sdscat(s, qn->pn.exact ? "EXACT" : "INTERSECT");
+      break;
+    case QN_UNION:
+      s = sdscat(s, "UNION");
+      break;
+    case QN_NOT:
+      s = sdscat(s, "NOT");
+      break;
+    case QN_OPTIONAL:
+      s = sdscat(s, "OPTIONAL");
+      break;
+    case QN_NUMERIC:
+      s = sdscat(s, "NUMERIC");
+      field = qn->nn.nf->fieldName;
+      break;
+    case QN_GEO:
+      s = sdscat(s, "GEO");
+      field = qn->gn.gf->property;
+      break;
+    case QN_GEOMETRY:
+      s = sdscat(s, "GEOSHAPE");
+      field = qn->gmn.geomq->attr;
+      break;
+    case QN_TAG:
+      s = sdscat(s, "TAG");
+      field = qn->tag.fieldName;
+      values = true;
+      break;
+    case QN_IDS:
+      s = sdscat(s, "IDS");
+      break;
+    case QN_WILDCARD:
+      s = sdscat(s, "WILDCARD");
+      break;
+    default:
+      // text terms, whose fields are given by the field mask
+      s = sdscat(s, "TEXT");
+      if (qn->opts.fieldMask != RS_FIELDMASK_ALL) {
+        s = sdscatprintf(s, "[%" PRIx64 "]", (uint64_t)qn->opts.fieldMask);
+      }
+      return s;
+  }
+  if (field) {
+    s = sdscatprintf(s, "(@%s)", field);
+  }
+  if (values || !QueryNode_NumChildren(qn)) {
+    return s;
+  }
+  s = sdscat(s, "(");
+  for (size_t i = 0; i < QueryNode_NumChildren(qn); ++i) {
+    s = hybridFilterShape(i ? sdscat(s, ",") : s, qn->children[i]);
+  }
+  return sdscat(s, ")");
+}
+
 static IndexIterator *Query_EvalVectorNode(QueryEvalCtx *q, QueryNode *qn) {
   if (qn->type != QN_VECTOR) {
     return NULL;
@@ -955,6 +1051,7 @@ static IndexIterator *Query_EvalVectorNode(QueryEvalCtx *q, QueryNode *qn) {
     idx = addMetricRequest(q, qn->vn.vq->scoreField, NULL);
   }
   IndexIterator *child_it = NULL;
+  sds filterShape = NULL;
   if (QueryNode_NumChildren(qn) > 0) {
     RedisModule_Assert(QueryNode_NumChildren(qn) == 1);
     child_it = Query_EvalNode(q, qn->children[0]);
@@ -962,8 +1059,12 @@ static IndexIterator *Query_EvalVectorNode(QueryEvalCtx *q, QueryNode *qn) {
     if (child_it == NULL) {
       return NULL;
     }
+    if (RSGlobalConfig.hybridAdaptivePolicy) {
+      filterShape = hybridFilterShape(sdsempty(), qn->children[0]);
+    }
   }
-  IndexIterator *it = NewVectorIterator(q, qn->vn.vq, child_it);
+  IndexIterator *it = NewVectorIterator(q, qn->vn.vq, child_it, filterShape);
+  sdsfree(filterShape);
   // If iterator was created successfully, and we have a metric to yield, update the
   // relevant position in the metricRequests ptr array to the iterator's RLookup key ptr.
   if (it && qn->vn.vq->scoreField) {
@@ -1360,6 +1461,113 @@ done:
   return ret;
 }
 
+static int cmpSds(const void *p1, const void *p2) {
+  return strcmp(*(const sds *)p1, *(const sds *)p2);
+}
+
+/* Build the filter cache key of a tag or numeric node. The key of a tag node does not depend on the
+ * order of its tags, or on their case in case insensitive fields. Returns NULL if the node can not
+ * be cached */
+static sds filterCacheKey(QueryEvalCtx *q, QueryNode *qn) {
+  IndexSpec *spec = q->sctx->spec;
+  if (qn->type == QN_NUMERIC) {
+    const NumericFilter *nf = qn->nn.nf;
+    // filters which the query optimizer iterates partially can not be cached
+    if (nf->geoFilter || nf->limit) {
+      return NULL;
+    }
+    const FieldSpec *fs = IndexSpec_GetField(spec, nf->fieldName, strlen(nf->fieldName));
+    if (!fs || !FIELD_IS(fs, INDEXFLD_T_NUMERIC)) {
+      return NULL;
+    }
+    return sdscatprintf(sdsempty(), "num:%s:%c%.17g,%.17g%c", fs->name,
+                        nf->inclusiveMin ? '[' : '(', nf->min, nf->max,
+                        nf->inclusiveMax ? ']' : ')');
+  }
+
+  const FieldSpec *fs = IndexSpec_GetField(spec, qn->tag.fieldName, strlen(qn->tag.fieldName));
+  size_t n = QueryNode_NumChildren(qn);
+  if (!fs || !FIELD_IS(fs, INDEXFLD_T_TAG) || !n) {
+    return NULL;
+  }
+  // only plain tags are cached
+  for (size_t i = 0; i < n; ++i) {
+    if (qn->children[i]->type != QN_TOKEN || !qn->children[i]->tn.str) {
+      return NULL;
+    }
+  }
+  sds *tags = rm_malloc(n * sizeof(*tags));
+  for (size_t i = 0; i < n; ++i) {
+    tags[i] = sdsnewlen(qn->children[i]->tn.str, qn->children[i]->tn.len);
+    if (!(fs->tagOpts.tagFlags & TagField_CaseSensitive)) {
+      sdstolower(tags[i]);
+    }
+  }
+  qsort(tags, n, sizeof(*tags), cmpSds);
+  sds key = sdscatprintf(sdsempty(), "tag:%s", fs->name);
+  for (size_t i = 0; i < n; ++i) {
+    key = sdscatprintf(key, ":%zu:", sdslen(tags[i]));
+    key = sdscatsds(key, tags[i]);
+    sdsfree(tags[i]);
+  }
+  rm_free(tags);
+  return key;
+}
+
+/* Evaluate a tag or numeric filter node with `eval`, through the filter cache of the index. On a
+ * cache miss the filter is evaluated, and the ids it matches are read into the cache */
+static IndexIterator *Query_EvalCachedFilterNode(QueryEvalCtx *q, QueryNode *qn,
+                                                 IndexIterator *(*eval)(QueryEvalCtx *,
+                                                                        QueryNode *)) {
+  IndexSpec *spec = q->sctx->spec;
+  sds key = NULL;
+  if (RSGlobalConfig.filterCacheSize && spec->filterCache) {
+    key = filterCacheKey(q, qn);
+  }
+  if (!key) {
+    return eval(q, qn);
+  }
+
+  double weight = qn->opts.weight;
+  IndexIterator *ret =
+      FilterCache_Open(spec->filterCache, key, sdslen(key), spec->revision, weight);
+  if (ret) {
+    goto done;
+  }
+
+  // the iterator is read to its end right away, so it does not have to be registered with the
+  // concurrent search context
+  ConcurrentSearchCtx *conc = q->conc;
+  q->conc = NULL;
+  IndexIterator *it = eval(q, qn);
+  q->conc = conc;
+  if (!it) {
+    goto done;
+  }
+
+  size_t n = 0, cap = 64;
+  t_docId *ids = rm_malloc(cap * sizeof(*ids));
+  RSIndexResult *r;
+  int rc;
+  while ((rc = it->Read(it->ctx, &r)) != INDEXREAD_EOF) {
+    if (rc != INDEXREAD_OK || (n && ids[n - 1] == r->docId)) {
+      continue;
+    }
+    if (n == cap) {
+      cap *= 2;
+      ids = rm_realloc(ids, cap * sizeof(*ids));
+    }
+    ids[n++] = r->docId;
+  }
+  it->Free(it);
+  ret = FilterCache_Put(spec->filterCache, key, sdslen(key), spec->revision, ids, n,
+                        RSGlobalConfig.filterCacheSize, weight);
+
+done:
+  sdsfree(key);
+  return ret;
+}
+
 IndexIterator *Query_EvalNode(QueryEvalCtx *q, QueryNode *n) {
   switch (n->type) {
     case QN_TOKEN:
@@ -1369,7 +1577,7 @@ IndexIterator *Query_EvalNode(QueryEvalCtx *q, QueryNode *n) {
     case QN_UNION:
       return Query_EvalUnionNode(q, n);
     case QN_TAG:
-      return Query_EvalTagNode(q, n);
+      return Query_EvalCachedFilterNode(q, n, Query_EvalTagNode);
     case QN_NOT:
       return Query_EvalNotNode(q, n);
     case QN_PREFIX:
@@ -1379,7 +1587,7 @@ IndexIterator *Query_EvalNode(QueryEvalCtx *q, QueryNode *n) {
     case QN_FUZZY:
       return Query_EvalFuzzyNode(q, n);
     case QN_NUMERIC:
-      return Query_EvalNumericNode(q, n);
+      return Query_EvalCachedFilterNode(q, n, Query_EvalNumericNode);
     case QN_OPTIONAL:
       return Query_EvalOptionalNode(q, n);
     case QN_GEO:
@@ -1401,6 +1609,51 @@ IndexIterator *Query_EvalNode(QueryEvalCtx *q, QueryNode *n) {
   return NULL;
 }
 
+static size_t QueryNode_CountGeoKnn(const QueryNode *qn) {
+  size_t count = QueryNode_IsGeoKnn(qn) ? 1 : 0;
+  for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+    count += QueryNode_CountGeoKnn(qn->children[ii]);
+  }
+  return count;
+}
+
+/* A geo KNN node returns the nearest documents among those matching the rest of the query, so like
+ * a vector KNN node it must be the root of the query. If it is a clause of the top level
+ * intersection, move it to the root and make the other clauses its child */
+static int QAST_PlaceGeoKnnNode(QueryAST *q, QueryError *status) {
+  QueryNode *root = q->root;
+  size_t count = QueryNode_CountGeoKnn(root);
+  if (count == 0 || (count == 1 && QueryNode_IsGeoKnn(root))) {
+    return REDISMODULE_OK;
+  }
+  if (count == 1 && root->type == QN_PHRASE && !root->pn.exact) {
+    for (size_t ii = 0; ii < QueryNode_NumChildren(root); ++ii) {
+      QueryNode *knn = root->children[ii];
+      if (!QueryNode_IsGeoKnn(knn)) {
+        continue;
+      }
+      array_del(root->children, ii);
+      // an intersection of a single clause is the clause itself
+      if (QueryNode_NumChildren(root) <= 1) {
+        QueryNode *rest = QueryNode_GetChild(root, 0);
+        if (rest) {
+          rest->opts.fieldMask &= root->opts.fieldMask;
+          QueryNode_AddChild(knn, rest);
+        }
+        array_clear(root->children);
+        QueryNode_Free(root);
+      } else {
+        QueryNode_AddChild(knn, root);
+      }
+      q->root = knn;
+      return REDISMODULE_OK;
+    }
+  }
+  QueryError_SetError(status, QUERY_ESYNTAX,
+                      "GEO KNN must be used at most once, as a top level clause of the query");
+  return REDISMODULE_ERR;
+}
+
 int QAST_Parse(QueryAST *dst, const RedisSearchCtx *sctx, const RSSearchOptions *sopts,
                const char *qstr, size_t len, unsigned int dialectVersion, QueryError *status) {
   if (!dst->query) {
@@ -1443,6 +1696,11 @@ int QAST_Parse(QueryAST *dst, const RedisSearchCtx *sctx, const RSSearchOptions
     }
     return REDISMODULE_ERR;
   }
+  if (QAST_PlaceGeoKnnNode(dst, status) != REDISMODULE_OK) {
+    QueryNode_Free(dst->root);
+    dst->root = NULL;
+    return REDISMODULE_ERR;
+  }
   dst->numTokens = qpCtx.numTokens;
   dst->numParams = qpCtx.numParams;
   return REDISMODULE_OK;
@@ -1458,6 +1716,7 @@ IndexIterator *QAST_Iterate(QueryAST *qast, const RSSearchOptions *opts, RedisSe
       .sctx = sctx,
       .status = status,
       .metricRequestsP = &qast->metricRequests,
+      .rerankIterP = &qast->rerankIter,
       .reqFlags = reqflags,
       .config = &qast->config,
   };
@@ -1474,6 +1733,7 @@ void QAST_Destroy(QueryAST *q) {
   q->root = NULL;
   array_free(q->metricRequests);
   q->metricRequests = NULL;
+  q->rerankIter = NULL;
   q->numTokens = 0;
   q->numParams = 0;
   rm_free(q->query);
@@ -1760,6 +2020,22 @@ static sds QueryNode_DumpSds(sds s, const IndexSpec *spec, const QueryNode *qs,
       break;
     case QN_GEO:
 
+      if (qs->gn.gf->knn) {
+        s = sdscat(s, "GEO {");
+        if (QueryNode_NumChildren(qs) > 0) {
+          s = sdscat(s, "\n");
+          s = QueryNode_DumpChildren(s, spec, qs, depth + 1);
+          s = doPad(s, depth);
+          s = sdscat(s, "} => {");
+        }
+        s = sdscatprintf(s, "K=%zu nearest to {%f,%f} within %f %s in geo field @%s",
+                         qs->gn.gf->knn, qs->gn.gf->lon, qs->gn.gf->lat, qs->gn.gf->radius,
+                         GeoDistance_ToString(qs->gn.gf->unitType), qs->gn.gf->property);
+        if (qs->opts.distField) {
+          s = sdscatprintf(s, ", yields distance as `%s`", qs->opts.distField);
+        }
+        break;
+      }
       s = sdscatprintf(s, "GEO %s:{%f,%f --> %f %s", qs->gn.gf->property, qs->gn.gf->lon,
                        qs->gn.gf->lat, qs->gn.gf->radius,
                        GeoDistance_ToString(qs->gn.gf->unitType));
@@ -1989,6 +2265,16 @@ static int QueryNode_ApplyAttribute(QueryNode *qn, QueryAttribute *attr, QueryEr
     attr->value = NULL;
     res = 1;
 
+  } else if (qn->type == QN_GEO && STR_EQCASE(attr->name, attr->namelen, GEO_KNN_ATTR)) {
+    // Apply knn: [1 ... INF]
+    long long n;
+    if (!ParseInteger(attr->value, &n) || n < 1) {
+      MK_INVALID_VALUE();
+      return res;
+    }
+    ((GeoFilter *)qn->gn.gf)->knn = n;
+    res = 1;
+
   } else if (qn->type == QN_VECTOR) {
     res = QueryVectorNode_ApplyAttribute(qn->vn.vq, attr);
   }
@@ -51,6 +51,10 @@ typedef struct QueryAST {
   // array of additional metrics names in the AST.
   MetricRequest *metricRequests;
 
+  // The iterator whose results are re-ranked by the pipeline, or NULL. It is owned by the iterators
+  // tree, and set when the tree is built
+  IndexIterator *rerankIter;
+
   // Copied query and length, because it seems we modify the string
   // in the parser (FIXME). Thus, if the original query is const
   // then it explodes
@@ -10,6 +10,7 @@
 #include "util/timeout.h"
 
 struct MetricRequest;
+struct indexIterator;
 
 typedef struct QueryEvalCtx {
   ConcurrentSearchCtx *conc;
@@ -17,6 +18,7 @@ typedef struct QueryEvalCtx {
   const RSSearchOptions *opts;
   QueryError *status;
   struct MetricRequest **metricRequestsP;
+  struct indexIterator **rerankIterP;
   size_t numTokens;
   uint32_t tokenId;
   DocTable *docTable;
@@ -162,6 +162,7 @@ typedef struct {
 #define INORDER_ATTR "inorder"
 #define WEIGHT_ATTR "weight"
 #define PHONETIC_ATTR "phonetic"
+#define GEO_KNN_ATTR "knn"
 
 
 /* Various modifiers and options that can apply to the entire query or any sub-query of it */
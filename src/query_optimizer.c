@@ -2,6 +2,7 @@
 #include "optimizer_reader.h"
 #include "numeric_index.h"
 #include "ext/default.h"
+#include "geo_index.h"
 
 QOptimizer *QOptimizer_New() {
   return rm_calloc(1, sizeof(QOptimizer));
@@ -60,6 +61,10 @@ void QOptimizer_Parse(AREQ *req) {
     } else if (!strcmp(scorer, HAMMINGDISTANCE_SCORER)) {
       opt->scorerType = SCORER_TYPE_DOC;
     }
+    // results are ordered by score only if there is no sortby at all
+    if (IsSearch(req) && opt->type != Q_OPT_NONE) {
+      opt->scoreBound = DefaultScorer_GetTermBound(scorer);
+    }
   }
 }
 
@@ -127,6 +132,29 @@ static QueryNode *checkQueryTypes(QueryNode *node, const char *name, QueryNode *
   return ret;
 }
 
+/* check whether a union node is made of full-text terms only */
+static bool isTermsUnion(QueryNode *node) {
+  for (int i = 0; i < QueryNode_NumChildren(node); ++i) {
+    QueryNode *child = node->children[i];
+    switch (child->type) {
+      case QN_TOKEN:
+      case QN_FUZZY:
+      case QN_PREFIX:
+      case QN_WILDCARD_QUERY:
+      case QN_LEXRANGE:
+        break;
+      case QN_UNION:
+        if (!isTermsUnion(child)) {
+          return false;
+        }
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
 size_t QOptimizer_EstimateLimit(size_t numDocs, size_t estimate, size_t limit) {
   if (numDocs == 0 || estimate == 0) {
     return 0;
@@ -174,8 +202,14 @@ void QOptimizer_QueryNodes(QueryNode *root, QOptimizer *opt) {
   }
 
   // there is no sorting field and scorer is required - we must check all results
-  if ((!isSortby && opt->scorerReq) || (root->type == QN_VECTOR && root->vn.vq->type == VECSIM_QT_KNN)) {
+  if ((!isSortby && opt->scorerReq) || (root->type == QN_VECTOR && root->vn.vq->type == VECSIM_QT_KNN) ||
+      QueryNode_IsGeoKnn(root)) {
     opt->type = Q_OPT_NONE;
+    // documents of a union which cannot reach the top scores can be skipped
+    if (!isSortby && opt->scorerReq && opt->scoreBound && root->type == QN_UNION &&
+        isTermsUnion(root)) {
+      opt->type = Q_OPT_SCORE_PRUNE;
+    }
     return;
   }
 
@@ -224,6 +258,16 @@ void QOptimizer_Iterators(AREQ *req, QOptimizer *opt) {
     case Q_OPT_FILTER:
       return;
 
+    // the document scores are bounded by the doc table
+    case Q_OPT_SCORE_PRUNE: {
+      RSIndexStats stats;
+      IndexSpec_GetStats(spec, &stats);
+      if (!UI_EnableScorePruning(root, &req->qiter.minScore, opt->scoreBound, &stats, &spec->docs)) {
+        opt->type = Q_OPT_NONE;
+      }
+      return;
+    }
+
     // limit range to number of required LIMIT
     case Q_OPT_PARTIAL_RANGE: {
       if (root->type == WILDCARD_ITERATOR) {
@@ -279,6 +323,8 @@ const char *QOptimizer_PrintType(QOptimizer *opt) {
       return "Undecided";
     case Q_OPT_FILTER:
       return "Filter";
+    case Q_OPT_SCORE_PRUNE:
+      return "Score pruning";
   }
   return NULL;
 }
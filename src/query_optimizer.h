@@ -13,11 +13,12 @@ struct AREQ;
 ***********************************************************
 *  Y  *   N   *  Q_OPT_PARTIAL_RANGE  *  Q_OPT_NO_SORTER  *
 ***********************************************************
-*  N  *   Y   *    Q_OPT_HYBRID       *     Q_OPT_NONE    *
+*  N  *   Y   *    Q_OPT_HYBRID       * Q_OPT_NONE (note2)*
 ***********************************************************
 *  N  *   N   *  Q_OPT_PARTIAL_RANGE  *  Q_OPT_NO_SORTER  *
 **********************************************************/
 // note1: potential for filter or no sorter
+// note2: Q_OPT_SCORE_PRUNE for a union of terms, with a scorer that has term score bounds
 
 typedef enum {
   // No optimization
@@ -40,6 +41,9 @@ typedef enum {
   // Use `FILTER` result processor instead of numeric range
   Q_OPT_FILTER = 4,
 
+  // No sortby, scores of a union of terms. Skip documents that cannot reach the top results
+  Q_OPT_SCORE_PRUNE = 5,
+
   // sortby other field. currently no optimization
   // Q_OPT_SORTBY_OTHER
 } Q_Optimize_Type;
@@ -57,6 +61,7 @@ typedef struct QOptimizer {
 
     bool scorerReq;             // does the query require a scorer (WITHSCORES does not count)
     ScorerType scorerType;      // 
+    RSTermScoreBound scoreBound;  // term score bound of the scorer, if it has one
 
     const char *fieldName;      // name of sortby field
     const FieldSpec *field;     // spec of sortby field
@@ -12,6 +12,7 @@
 #include "rmutil/util.h"
 #include "util/logging.h"
 #include "util/misc.h"
+#include "util/arr.h"
 #include "tag_index.h"
 #include "rmalloc.h"
 #include <stdio.h>
@@ -56,6 +57,7 @@ void *InvertedIndex_RdbLoad(RedisModuleIO *rdb, int encver) {
       RedisModule_Free(blk->buf.data);
       blk->buf.data = buf;
     }
+    IndexBlock_BuildSkips(blk, idx->flags);
   }
   idx->size = actualSize;
   if (idx->size == 0) {
@@ -105,6 +107,7 @@ unsigned long InvertedIndex_MemUsage(const void *value) {
   for (size_t i = 0; i < idx->size; i++) {
     ret += sizeof(IndexBlock);
     ret += IndexBlock_DataLen(&idx->blocks[i]);
+    ret += array_len(idx->blocks[i].skips) * sizeof(IndexBlockSkip);
   }
   return ret;
 }
@@ -397,6 +397,13 @@ typedef struct {
 typedef double (*RSScoringFunction)(const ScoringFunctionArgs *ctx, const RSIndexResult *res,
                                     const RSDocumentMetadata *dmd, double minScore);
 
+/* RSTermScoreBound returns an upper bound of the contribution of a single term record to the score
+ * of a document with a document score of at most 1. `maxFreq` is an upper bound of the term's
+ * frequency (0 if unknown), and `minDocLen` is a lower bound of the document's length (0 if
+ * unknown) */
+typedef double (*RSTermScoreBound)(const RSIndexStats *stats, const RSIndexResult *term,
+                                   uint32_t maxFreq, uint32_t minDocLen);
+
 /* The extension registeration context, containing the callbacks avaliable to the extension for
  * registering query expanders and scorers. */
 typedef struct RSExtensionCtx {
@@ -258,6 +258,7 @@ int RediSearch_DeleteDocument(RefManager* rm, const void* docKey, size_t len) {
     if (DocTable_Delete(&sp->docs, docKey, len)) {
       // Delete returns true/false, not RM_{OK,ERR}
       sp->stats.numDocuments--;
+      sp->revision++;
       if (sp->gc) {
         GCContext_OnDelete(sp->gc);
       }
@@ -399,7 +400,7 @@ QueryNode* RediSearch_CreateGeoNode(RefManager* rm, const char* field, double la
   QueryNode* ret = NewQueryNode(QN_GEO);
   ret->opts.fieldMask = IndexSpec_GetFieldBit(__RefManager_Get_Object(rm), field, strlen(field));
 
-  GeoFilter *flt = rm_malloc(sizeof(*flt));
+  GeoFilter *flt = rm_calloc(1, sizeof(*flt));
   flt->lat = lat;
   flt->lon = lon;
   flt->radius = radius;
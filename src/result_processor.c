@@ -13,6 +13,7 @@
 #include "rmutil/rm_assert.h"
 #include "util/timeout.h"
 #include "util/arr.h"
+#include "quantized_reader.h"
 
 /*******************************************************************************************************************
  *  General Result Processor Helper functions
@@ -82,6 +83,7 @@ typedef struct {
   ResultProcessor base;
   IndexIterator *iiter;
   size_t timeoutLimiter;    // counter to limit number of calls to TimedOut_WithCounter()
+  uint32_t docIdsEpoch;     // the docIdsEpoch of the spec when the iterators were built
 } RPIndexIterator;
 
 /* Next implementation */
@@ -98,6 +100,11 @@ static int rpidxNext(ResultProcessor *base, SearchResult *res) {
     // and reopen the keys in the concurrent search context (iterators' validation)
     RedisSearchCtx_LockSpecRead(RP_SCTX(base));
     ConcurrentSearchCtx_ReopenKeys(base->parent->conc);
+    // The documents were renumbered while the query was paused, so the ids read so far no longer
+    // identify the documents, and the iterators can not be resumed
+    if (RP_SPEC(base)->docIdsEpoch != self->docIdsEpoch) {
+      return UnlockSpec_and_ReturnRPResult(base, RS_RESULT_EOF);
+    }
   }
 
   RSIndexResult *r;
@@ -160,9 +167,10 @@ static void rpidxFree(ResultProcessor *iter) {
   rm_free(iter);
 }
 
-ResultProcessor *RPIndexIterator_New(IndexIterator *root) {
+ResultProcessor *RPIndexIterator_New(IndexIterator *root, uint32_t docIdsEpoch) {
   RPIndexIterator *ret = rm_calloc(1, sizeof(*ret));
   ret->iiter = root;
+  ret->docIdsEpoch = docIdsEpoch;
   ret->base.Next = rpidxNext;
   ret->base.Free = rpidxFree;
   ret->base.type = RP_INDEX;
@@ -925,10 +933,118 @@ ResultProcessor *RPLoader_New(AREQ *r, RLookup *lk, const RLookupKey **keys, siz
   }
 }
 
+/*******************************************************************************************************************
+ *  Re-ranking Results Processor
+ *
+ * The RP has three phases, as the safe loader:
+ * 1. Buffering phase - the RP buffers all the candidates of the upstream.
+ * 2. Re-ranking phase - the exact distances of the candidates are set from the keyspace, which a background query
+ *    locks once the spec is unlocked. The candidates are sorted by them, and only the k nearest are kept.
+ * 3. Yielding phase - the RP yields the buffered results.
+ *******************************************************************************************************************/
+
+typedef struct {
+  ResultProcessor base;
+  QuantizedKnnIterator *knn;
+  bool lockRedis;
+  SearchResult *results;    // The buffered candidates
+  size_t pos;               // The position of the next result to yield
+  int lastRc;               // The code to return once all the buffered results were yielded
+} RPReranker;
+
+static int cmpByRerankedDistance(const void *p1, const void *p2) {
+  const SearchResult *r1 = p1, *r2 = p2;
+  double d1 = QuantizedKnnIterator_Distance(r1->indexResult);
+  double d2 = QuantizedKnnIterator_Distance(r2->indexResult);
+  if (d1 != d2) {
+    return d1 < d2 ? -1 : 1;
+  }
+  return r1->docId < r2->docId ? -1 : r1->docId > r2->docId;
+}
+
+static int rpRerankerNext_Yield(ResultProcessor *rp, SearchResult *res) {
+  RPReranker *self = (RPReranker *)rp;
+  if (self->pos == array_len(self->results)) {
+    return self->lastRc;
+  }
+  SetResult(&self->results[self->pos++], res);
+  return RS_RESULT_OK;
+}
+
+static void rpReranker_Rerank(RPReranker *self) {
+  RedisSearchCtx *sctx = RP_SCTX(&self->base);
+  size_t n = array_len(self->results);
+  if (self->lockRedis) {
+    // First, we verify that we unlocked the spec before we lock Redis.
+    RedisSearchCtx_UnlockSpec(sctx);
+    RedisModule_ThreadSafeContextLock(sctx->redisCtx);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    QuantizedKnnIterator_Rerank(self->knn, self->results[i].indexResult, self->results[i].dmd);
+  }
+  if (self->lockRedis) {
+    RedisModule_ThreadSafeContextUnlock(sctx->redisCtx);
+  }
+
+  qsort(self->results, n, sizeof(*self->results), cmpByRerankedDistance);
+  size_t k = MIN(n, self->knn->k);
+  for (size_t i = k; i < n; ++i) {
+    SearchResult_Destroy(&self->results[i]);
+  }
+  self->results = array_trimm_len(self->results, n - k);
+  // The dropped candidates were counted by the index processor
+  self->base.parent->totalResults -= n - k;
+}
+
+static int rpRerankerNext_Accumulate(ResultProcessor *rp, SearchResult *res) {
+  RPReranker *self = (RPReranker *)rp;
+  SearchResult resToBuffer = {0};
+  int result_status;
+  while ((result_status = rp->upstream->Next(rp->upstream, &resToBuffer)) == RS_RESULT_OK) {
+    self->results = array_append(self->results, resToBuffer);
+    memset(&resToBuffer, 0, sizeof(SearchResult));
+  }
+  if (result_status != RS_RESULT_EOF &&
+      !(result_status == RS_RESULT_TIMEDOUT && rp->parent->timeoutPolicy == TimeoutPolicy_Return)) {
+    return result_status;
+  }
+  self->lastRc = result_status;
+  if (array_len(self->results)) {
+    rpReranker_Rerank(self);
+  }
+
+  // Move to the yielding phase
+  rp->Next = rpRerankerNext_Yield;
+  return rp->Next(rp, res);
+}
+
+static void rpRerankerFree(ResultProcessor *rp) {
+  RPReranker *self = (RPReranker *)rp;
+  for (size_t i = self->pos; i < array_len(self->results); ++i) {
+    SearchResult_Destroy(&self->results[i]);
+  }
+  array_free(self->results);
+  rm_free(self);
+}
+
+ResultProcessor *RPReranker_New(IndexIterator *knn, bool lockRedis) {
+  RPReranker *ret = rm_calloc(1, sizeof(*ret));
+  ret->knn = knn->ctx;
+  ret->lockRedis = lockRedis;
+  ret->results = array_new(SearchResult, ret->knn->k);
+  ret->lastRc = RS_RESULT_EOF;
+  ret->base.Next = rpRerankerNext_Accumulate;
+  ret->base.Free = rpRerankerFree;
+  ret->base.type = RP_RERANKER;
+  return &ret->base;
+}
+
+/*********************************************************************************/
+
 static char *RPTypeLookup[RP_MAX] = {"Index",   "Loader",    "Threadsafe-Loader", "Scorer",
                                      "Sorter",  "Counter",   "Pager/Limiter",     "Highlighter",
                                      "Grouper", "Projector", "Filter",            "Profile",
-                                     "Network", "Metrics Applier"};
+                                     "Network", "Metrics Applier", "Reranker"};
 
 const char *RPTypeToString(ResultProcessorType type) {
   RS_LOG_ASSERT(type >= 0 && type < RP_MAX, "enum is out of range");
@@ -56,6 +56,7 @@ typedef enum {
   RP_PROFILE,
   RP_NETWORK,
   RP_METRICS,
+  RP_RERANKER,
   RP_MAX,
 } ResultProcessorType;
 
@@ -188,7 +189,7 @@ void SearchResult_Clear(SearchResult *r);
  */
 void SearchResult_Destroy(SearchResult *r);
 
-ResultProcessor *RPIndexIterator_New(IndexIterator *itr);
+ResultProcessor *RPIndexIterator_New(IndexIterator *itr, uint32_t docIdsEpoch);
 
 ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
                               const ScoringFunctionArgs *fnargs);
@@ -232,6 +233,18 @@ ResultProcessor *RPPager_New(size_t offset, size_t limit);
 struct AREQ;
 ResultProcessor *RPLoader_New(struct AREQ *r, RLookup *lk, const RLookupKey **keys, size_t nkeys);
 
+/*******************************************************************************************************************
+ *  Re-ranking Processor
+ *
+ * The quantized KNN iterator of a field which re-ranks its results returns the nearest candidates by the distances
+ * of the quantized vectors. This processor buffers all of them, sets their exact distances from the full vectors of
+ * their documents, and yields the k nearest by the exact distances, in increasing distance.
+ *
+ * Like the safe loader, in thread safe mode it loads the vectors once all the candidates were read and the spec
+ * was unlocked, with Redis locked.
+ *******************************************************************************************************************/
+ResultProcessor *RPReranker_New(IndexIterator *knn, bool lockRedis);
+
 /** Creates a new Highlight processor */
 ResultProcessor *RPHighlighter_New(const RSSearchOptions *searchopts, const FieldList *fields,
                                    const RLookup *lookup);
@@ -31,6 +31,8 @@
 #include "rdb.h"
 #include "commands.h"
 #include "util/workers.h"
+#include "filter_cache.h"
+#include "hybrid_stats.h"
 
 #define INITIAL_DOC_TABLE_SIZE 1000
 
@@ -309,7 +311,9 @@ void Indexes_SetTempSpecsTimers(TimerOp op) {
 double IndexesScanner_IndexedPercent(IndexesScanner *scanner, IndexSpec *sp) {
   if (scanner || sp->scan_in_progress) {
     if (scanner) {
-      return scanner->totalKeys > 0 ? (double)scanner->scannedKeys / scanner->totalKeys : 0;
+      // the keys of the batch in progress are counted once they are indexed
+      size_t indexedKeys = scanner->scannedKeys - scanner->pendingKeys;
+      return scanner->totalKeys > 0 ? (double)indexedKeys / scanner->totalKeys : 0;
     } else {
       return 0;
     }
@@ -475,6 +479,21 @@ static int parseVectorField_GetMetric(ArgsCursor *ac, VecSimMetric *metric) {
   return AC_OK;
 }
 
+// Tries to get the quantization of a FLAT index from ac.
+static int parseVectorField_GetQuantization(ArgsCursor *ac, VecSimQuantType *type) {
+  const char *quantStr;
+  size_t len;
+  int rc;
+  if ((rc = AC_GetString(ac, &quantStr, &len, 0)) != AC_OK) {
+    return rc;
+  }
+  if (!strncasecmp(VECSIM_QUANT_SQ8, quantStr, len))
+    *type = VecSimQuant_SQ8;
+  else
+    return AC_ERR_ENOENT;
+  return AC_OK;
+}
+
 // memoryLimit / 10 - default is 10% of global memory limit
 #define BLOCK_MEMORY_LIMIT ((RSGlobalConfig.vssMaxResize) ? RSGlobalConfig.vssMaxResize : memoryLimit / 10)
 
@@ -684,6 +703,16 @@ static int parseVectorField_flat(FieldSpec *fs, VecSimParams *params, ArgsCursor
         QERR_MKBADARGS_AC(status, "vector similarity FLAT index blocksize", rc);
         return 0;
       }
+    } else if (AC_AdvanceIfMatch(ac, VECSIM_QUANTIZATION)) {
+      if ((rc = parseVectorField_GetQuantization(ac, &fs->vectorOpts.quantParams.type)) != AC_OK) {
+        QERR_MKBADARGS_AC(status, "vector similarity FLAT index quantization", rc);
+        return 0;
+      }
+    } else if (AC_AdvanceIfMatch(ac, VECSIM_RERANK)) {
+      if ((rc = AC_GetSize(ac, &fs->vectorOpts.quantParams.rerank, 0)) != AC_OK) {
+        QERR_MKBADARGS_AC(status, "vector similarity FLAT index rerank", rc);
+        return 0;
+      }
     } else {
       QERR_MKBADARGS_FMT(status, "Bad arguments for algorithm %s: %s", VECSIM_ALGORITHM_BF, AC_GetStringNC(ac, NULL));
       return 0;
@@ -706,6 +735,14 @@ static int parseVectorField_flat(FieldSpec *fs, VecSimParams *params, ArgsCursor
     VECSIM_ERR_MANDATORY(status, VECSIM_ALGORITHM_BF, VECSIM_DISTANCE_METRIC);
     return 0;
   }
+  if (fs->vectorOpts.quantParams.type == VecSimQuant_NONE && fs->vectorOpts.quantParams.rerank) {
+    QERR_MKBADARGS_FMT(status, "%s requires %s", VECSIM_RERANK, VECSIM_QUANTIZATION);
+    return 0;
+  }
+  if (fs->vectorOpts.quantParams.type != VecSimQuant_NONE && params->algoParams.bfParams.multi) {
+    QERR_MKBADARGS_FMT(status, "%s is not supported for multi-value vector fields", VECSIM_QUANTIZATION);
+    return 0;
+  }
   // Calculating expected blob size of a vector in bytes.
   fs->vectorOpts.expBlobSize = params->algoParams.bfParams.dim * VecSimType_sizeof(params->algoParams.bfParams.type);
 
@@ -717,6 +754,7 @@ static int parseVectorField(IndexSpec *sp, StrongRef sp_ref, FieldSpec *fs, Args
   // init default type, size, distance metric and algorithm
 
   memset(&fs->vectorOpts.vecSimParams, 0, sizeof(VecSimParams));
+  fs->vectorOpts.quantParams = (VecSimQuantParams){0};
 
   // If the index is on JSON and the given path is dynamic, create a multi-value index.
   bool multi = false;
@@ -869,6 +907,10 @@ size_t IndexSpec_VectorIndexSize(IndexSpec *sp) {
     const FieldSpec *fs = sp->fields + i;
     if (FIELD_IS(fs, INDEXFLD_T_VECTOR)) {
       RedisModuleString *vecsim_name = IndexSpec_GetFormattedKey(sp, fs, INDEXFLD_T_VECTOR);
+      if (FieldSpec_IsQuantized(fs)) {
+        total_memory += QuantizedIndex_MemoryUsage(OpenQuantizedVectorIndex(sp, vecsim_name));
+        continue;
+      }
       VecSimIndex *vecsim = OpenVectorIndex(sp, vecsim_name);
       total_memory += VecSimIndex_Info(vecsim).commonInfo.memory;
     }
@@ -1088,6 +1130,7 @@ StrongRef IndexSpec_Parse(const char *name, const char **argv, int argc, QueryEr
       {AC_MKUNFLAG(SPEC_NOHL_STR, &spec->flags, Index_StoreByteOffsets)},
       {AC_MKUNFLAG(SPEC_NOFIELDS_STR, &spec->flags, Index_StoreFieldFlags)},
       {AC_MKUNFLAG(SPEC_NOFREQS_STR, &spec->flags, Index_StoreFreqs)},
+      {AC_MKBITFLAG(SPEC_PACKED_STR, &spec->flags, Index_BlockPacked)},
       {AC_MKBITFLAG(SPEC_SCHEMA_EXPANDABLE_STR, &spec->flags, Index_WideSchema)},
       {AC_MKBITFLAG(SPEC_ASYNC_STR, &spec->flags, Index_Async)},
       {AC_MKBITFLAG(SPEC_SKIPINITIALSCAN_STR, &spec->flags, Index_SkipInitialScan)},
@@ -1275,6 +1318,9 @@ static void IndexSpec_FreeUnlinkedData(IndexSpec *spec) {
 
   // Free all documents metadata
   DocTable_Free(&spec->docs);
+  // Free cached filter results
+  FilterCache_Free(spec->filterCache);
+  HybridStats_Free(spec->hybridStats);
   // Free TEXT field trie and inverted indexes
   if (spec->terms) {
     TrieType_Free(spec->terms);
@@ -1577,6 +1623,8 @@ IndexSpec *NewIndexSpec(const char *name) {
   sp->name = rm_strdup(name);
   sp->nameLen = strlen(name);
   sp->docs = DocTable_New(INITIAL_DOC_TABLE_SIZE);
+  sp->filterCache = NewFilterCache();
+  sp->hybridStats = NewHybridStats();
   sp->stopwords = DefaultStopWordList();
   sp->terms = NewTrie(NULL, Trie_Sort_Lex);
   sp->suffix = NULL;
@@ -1739,6 +1787,8 @@ static void FieldSpec_RdbSave(RedisModuleIO *rdb, FieldSpec *f) {
   if (FIELD_IS(f, INDEXFLD_T_VECTOR)) {
     RedisModule_SaveUnsigned(rdb, f->vectorOpts.expBlobSize);
     VecSim_RdbSave(rdb, &f->vectorOpts.vecSimParams);
+    RedisModule_SaveUnsigned(rdb, f->vectorOpts.quantParams.type);
+    RedisModule_SaveUnsigned(rdb, f->vectorOpts.quantParams.rerank);
   }
   if (FIELD_IS(f, INDEXFLD_T_GEOMETRY) || (f->options & FieldSpec_Dynamic)) {
     RedisModule_SaveUnsigned(rdb, f->geometryOpts.geometryCoords);
@@ -1839,6 +1889,11 @@ static int FieldSpec_RdbLoad(RedisModuleIO *rdb, FieldSpec *f, StrongRef sp_ref,
         break;
       }
     }
+    f->vectorOpts.quantParams = (VecSimQuantParams){0};
+    if (encver >= INDEX_VECSIM_QUANT_VERSION) {
+      f->vectorOpts.quantParams.type = LoadUnsigned_IOError(rdb, goto fail);
+      f->vectorOpts.quantParams.rerank = LoadUnsigned_IOError(rdb, goto fail);
+    }
   }
 
   // Load geometry specific options
@@ -1928,6 +1983,21 @@ static IndexesScanner *IndexesScanner_New(StrongRef global_ref) {
   return scanner;
 }
 
+static void IndexesScanner_DropBatch(IndexesScanner *scanner) {
+  for (size_t i = 0; i < array_len(scanner->batch); ++i) {
+    Document_Free(scanner->batch + i);
+  }
+  array_clear(scanner->batch);
+  scanner->pendingKeys = 0;
+}
+
+// Called with the GIL held before a key is (re)indexed or deleted by anything but the scanner
+static void IndexesScanner_OnKeyChange(IndexesScanner *scanner, RedisModuleString *key) {
+  if (scanner && scanner->batchInFlight) {
+    dictAdd(scanner->superseded, key, NULL);
+  }
+}
+
 void IndexesScanner_Free(IndexesScanner *scanner) {
   if (global_spec_scanner == scanner) {
     global_spec_scanner = NULL;
@@ -1944,6 +2014,13 @@ void IndexesScanner_Free(IndexesScanner *scanner) {
     WeakRef_Release(scanner->spec_ref);
   }
   if (scanner->spec_name) rm_free(scanner->spec_name);
+  if (scanner->batch) {
+    IndexesScanner_DropBatch(scanner);
+    array_free(scanner->batch);
+  }
+  if (scanner->superseded) {
+    dictRelease(scanner->superseded);
+  }
   rm_free(scanner);
 }
 
@@ -1960,6 +2037,53 @@ static void IndexSpec_DoneIndexingCallabck(struct RSAddDocumentCtx *docCtx, Redi
 //---------------------------------------------------------------------------------------------
 
 int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type);
+static int IndexSpec_LoadDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key,
+                             DocumentType type, Document *doc);
+static void IndexSpec_UpdateDocsBatch(IndexSpec *spec, RedisModuleCtx *ctx, Document *docs, size_t n);
+static void IndexSpec_UpdateDocsBatchUnlocked(IndexSpec *spec, RedisModuleCtx *ctx,
+                                              IndexesScanner *scanner);
+
+// The documents are loaded while the key is at hand, and owns their strings as the key name only
+// lives for the duration of the scan callback
+static void IndexesScanner_AddToBatch(IndexesScanner *scanner, IndexSpec *sp, RedisModuleCtx *ctx,
+                                      RedisModuleString *keyname, DocumentType type) {
+  Document doc = {0};
+  if (IndexSpec_LoadDoc(sp, ctx, keyname, type, &doc) != REDISMODULE_OK) {
+    return;
+  }
+  Document_MakeStringsOwner(&doc);
+  if (!scanner->batch) {
+    scanner->batch = array_new(Document, RSGlobalConfig.bgIndexingBatchSize);
+  }
+  scanner->batch = array_append(scanner->batch, doc);
+  scanner->pendingKeys++;
+}
+
+// Index the documents of the batch. Must be called before the GIL is released, as the keys of the
+// documents may be changed (and reindexed) as soon as it is. In parallel mode the GIL is released
+// while the batch is preprocessed, and the keys changed meanwhile are skipped
+static void IndexesScanner_IndexBatch(IndexesScanner *scanner, RedisModuleCtx *ctx) {
+  if (!scanner->batch || !array_len(scanner->batch)) {
+    return;
+  }
+  StrongRef curr_run_ref = WeakRef_Promote(scanner->spec_ref);
+  IndexSpec *sp = StrongRef_Get(curr_run_ref);
+  if (sp) {
+    if (RSGlobalConfig.bgIndexingParallel) {
+      IndexSpec_UpdateDocsBatchUnlocked(sp, ctx, scanner);
+    } else {
+      IndexSpec_UpdateDocsBatch(sp, ctx, scanner->batch, array_len(scanner->batch));
+    }
+    array_clear(scanner->batch);
+    scanner->pendingKeys = 0;
+    StrongRef_Release(curr_run_ref);
+  } else {
+    // spec was deleted, cancel scan
+    IndexesScanner_DropBatch(scanner);
+    scanner->cancelled = true;
+  }
+}
+
 static void Indexes_ScanProc(RedisModuleCtx *ctx, RedisModuleString *keyname, RedisModuleKey *key,
                              IndexesScanner *scanner) {
   if (scanner->cancelled) {
@@ -1991,7 +2115,11 @@ static void Indexes_ScanProc(RedisModuleCtx *ctx, RedisModuleString *keyname, Re
       // This check is performed without locking the spec, but it's ok since we locked the GIL
       // So the main thread is not running and the GC is not touching the relevant data
       if (SchemaRule_ShouldIndex(sp, keyname, type)) {
-        IndexSpec_UpdateDoc(sp, ctx, keyname, type);
+        if (RSGlobalConfig.bgIndexingBatchSize) {
+          IndexesScanner_AddToBatch(scanner, sp, ctx, keyname, type);
+        } else {
+          IndexSpec_UpdateDoc(sp, ctx, keyname, type);
+        }
       }
       StrongRef_Release(curr_run_ref);
     } else {
@@ -2022,6 +2150,12 @@ static void Indexes_ScanAndReindexTask(IndexesScanner *scanner) {
 
   size_t counter = 0;
   while (RedisModule_Scan(ctx, cursor, (RedisModuleScanCB)Indexes_ScanProc, scanner)) {
+    if (scanner->batch && array_len(scanner->batch) &&
+        array_len(scanner->batch) < RSGlobalConfig.bgIndexingBatchSize) {
+      // keep the GIL until the batch is full
+      continue;
+    }
+    IndexesScanner_IndexBatch(scanner, ctx);
     RedisModule_ThreadSafeContextUnlock(ctx);
     counter++;
     if (counter % RSGlobalConfig.numBGIndexingIterationsBeforeSleep == 0) {
@@ -2043,6 +2177,7 @@ static void Indexes_ScanAndReindexTask(IndexesScanner *scanner) {
     }
   }
 
+  IndexesScanner_IndexBatch(scanner, ctx);
   if (scanner->global) {
     RedisModule_Log(ctx, "notice", "Scanning indexes in background: done (scanned=%ld)",
                     scanner->scannedKeys);
@@ -2095,7 +2230,7 @@ void IndexSpec_AddToInfo(RedisModuleInfoCtx *ctx, IndexSpec *sp) {
   RedisModule_InfoAddSection(ctx, name);
 
   // Index flags
-  if (sp->flags & ~(Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets | Index_StoreByteOffsets) || sp->flags & Index_WideSchema) {
+  if (sp->flags & ~(Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets | Index_StoreByteOffsets) || sp->flags & (Index_WideSchema | Index_BlockPacked)) {
     RedisModule_InfoBeginDictField(ctx, "index_options");
     if (!(sp->flags & (Index_StoreFreqs)))
       RedisModule_InfoAddFieldCString(ctx, SPEC_NOFREQS_STR, "ON");
@@ -2107,6 +2242,8 @@ void IndexSpec_AddToInfo(RedisModuleInfoCtx *ctx, IndexSpec *sp) {
       RedisModule_InfoAddFieldCString(ctx, SPEC_NOHL_STR, "ON");
     if (sp->flags & Index_WideSchema)
       RedisModule_InfoAddFieldCString(ctx, SPEC_SCHEMA_EXPANDABLE_STR, "ON");
+    if (sp->flags & Index_BlockPacked)
+      RedisModule_InfoAddFieldCString(ctx, SPEC_PACKED_STR, "ON");
     RedisModule_InfoEndDictField(ctx);
   }
 
@@ -2317,6 +2454,8 @@ int IndexSpec_CreateFromRdb(RedisModuleCtx *ctx, RedisModuleIO *rdb, int encver,
 
   sp->sortables = NewSortingTable();
   sp->docs = DocTable_New(INITIAL_DOC_TABLE_SIZE);
+  sp->filterCache = NewFilterCache();
+  sp->hybridStats = NewHybridStats();
   sp->name = LoadStringBuffer_IOError(rdb, NULL, goto cleanup);
   sp->nameLen = strlen(sp->name);
   char *tmpName = rm_strdup(sp->name);
@@ -2453,6 +2592,8 @@ void *IndexSpec_LegacyRdbLoad(RedisModuleIO *rdb, int encver) {
   sp->sortables = NewSortingTable();
   sp->terms = NULL;
   sp->docs = DocTable_New(INITIAL_DOC_TABLE_SIZE);
+  sp->filterCache = NewFilterCache();
+  sp->hybridStats = NewHybridStats();
   sp->name = rm_strdup(name);
   sp->nameLen = strlen(sp->name);
   RedisModule_Free(name);
@@ -2733,28 +2874,22 @@ int IndexSpec_RegisterType(RedisModuleCtx *ctx) {
   return REDISMODULE_OK;
 }
 
-int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type) {
+// Load the indexed fields of a document. On failure the error is added to the stats of the spec,
+// and the document is deleted from the index
+static int IndexSpec_LoadDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key,
+                             DocumentType type, Document *doc) {
   RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
-
-  if (!spec->rule) {
-    RedisModule_Log(ctx, "warning", "Index spec %s: no rule found", spec->name);
-    return REDISMODULE_ERR;
-  }
-
-  clock_t startDocTime = clock();
-
   QueryError status = {0};
-  Document doc = {0};
-  Document_Init(&doc, key, DEFAULT_SCORE, DEFAULT_LANGUAGE, type);
+  Document_Init(doc, key, DEFAULT_SCORE, DEFAULT_LANGUAGE, type);
   // if a key does not exit, is not a hash or has no fields in index schema
 
   int rv = REDISMODULE_ERR;
   switch (type) {
   case DocumentType_Hash:
-    rv = Document_LoadSchemaFieldHash(&doc, &sctx, &status);
+    rv = Document_LoadSchemaFieldHash(doc, &sctx, &status);
     break;
   case DocumentType_Json:
-    rv = Document_LoadSchemaFieldJson(&doc, &sctx, &status);
+    rv = Document_LoadSchemaFieldJson(doc, &sctx, &status);
     break;
   case DocumentType_Unsupported:
     RS_LOG_ASSERT(0, "Should receieve valid type");
@@ -2762,13 +2897,32 @@ int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString
 
   if (rv != REDISMODULE_OK) {
     // we already unlocked the spec but we can increase this value atomically
-    IndexError_AddError(&spec->stats.indexError, status.detail, doc.docKey);
+    IndexError_AddError(&spec->stats.indexError, status.detail, doc->docKey);
 
     // if a document did not load properly, it is deleted
     // to prevent mismatch of index and hash
     IndexSpec_DeleteDoc(spec, ctx, key);
     QueryError_ClearError(&status);
-    Document_Free(&doc);
+    Document_Free(doc);
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type) {
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+  IndexesScanner_OnKeyChange(spec->scanner, key);
+
+  if (!spec->rule) {
+    RedisModule_Log(ctx, "warning", "Index spec %s: no rule found", spec->name);
+    return REDISMODULE_ERR;
+  }
+
+  clock_t startDocTime = clock();
+
+  QueryError status = {0};
+  Document doc = {0};
+  if (IndexSpec_LoadDoc(spec, ctx, key, type, &doc) != REDISMODULE_OK) {
     return REDISMODULE_ERR;
   }
 
@@ -2785,10 +2939,106 @@ int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString
   return REDISMODULE_OK;
 }
 
+// Index a batch of loaded documents, see AddDocumentCtx_SubmitBatch. The documents are freed
+static void IndexSpec_UpdateDocsBatch(IndexSpec *spec, RedisModuleCtx *ctx, Document *docs, size_t n) {
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+  clock_t startTime = clock();
+
+  RSAddDocumentCtx **aCtxs = rm_malloc(n * sizeof(*aCtxs));
+  size_t numCtxs = 0;
+  RedisSearchCtx_LockSpecRead(&sctx);
+  for (size_t i = 0; i < n; ++i) {
+    QueryError status = {0};
+    RSAddDocumentCtx *aCtx = NewAddDocumentCtx(spec, docs + i, &status);
+    if (!aCtx) {
+      QueryError_ClearError(&status);
+      continue;
+    }
+    aCtx->stateFlags |= ACTX_F_NOFREEDOC;
+    aCtxs[numCtxs++] = aCtx;
+  }
+  AddDocumentCtx_SubmitBatch(aCtxs, numCtxs, &sctx, DOCUMENT_ADD_REPLACE);
+
+  spec->stats.totalIndexTime += clock() - startTime;
+  RedisSearchCtx_UnlockSpec(&sctx);
+
+  for (size_t i = 0; i < n; ++i) {
+    Document_Free(docs + i);
+  }
+  rm_free(aCtxs);
+}
+
+// Index the batch of the scanner, preprocessing it with the GIL released. The scanned version of
+// the keys written meanwhile is stale, and was replaced by their notifications, so they are
+// dropped from the batch. Called and returns with the GIL held
+static void IndexSpec_UpdateDocsBatchUnlocked(IndexSpec *spec, RedisModuleCtx *ctx,
+                                              IndexesScanner *scanner) {
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+  Document *docs = scanner->batch;
+  size_t n = array_len(docs);
+  clock_t startTime = clock();
+
+  RSAddDocumentCtx **aCtxs = rm_malloc(n * sizeof(*aCtxs));
+  const FieldSpec **failed = rm_malloc(n * sizeof(*failed));
+  size_t numCtxs = 0;
+  RedisSearchCtx_LockSpecRead(&sctx);
+  for (size_t i = 0; i < n; ++i) {
+    QueryError status = {0};
+    RSAddDocumentCtx *aCtx = NewAddDocumentCtx(spec, docs + i, &status);
+    if (!aCtx) {
+      QueryError_ClearError(&status);
+      continue;
+    }
+    aCtx->stateFlags |= ACTX_F_NOFREEDOC;
+    aCtxs[numCtxs++] = aCtx;
+  }
+  RedisSearchCtx_UnlockSpec(&sctx);
+
+  if (!scanner->superseded) {
+    scanner->superseded = dictCreate(&dictTypeHeapRedisStrings, NULL);
+  }
+  scanner->batchInFlight = true;
+  RedisModule_ThreadSafeContextUnlock(ctx);
+  AddDocumentCtx_PreprocessBatch(aCtxs, numCtxs, &sctx, DOCUMENT_ADD_REPLACE, failed);
+  RedisModule_ThreadSafeContextLock(ctx);
+  scanner->batchInFlight = false;
+
+  // the index may have been dropped or altered while the GIL was released
+  StrongRef spec_ref = WeakRef_Promote(scanner->spec_ref);
+  if (StrongRef_Get(spec_ref)) {
+    StrongRef_Release(spec_ref);
+  } else {
+    scanner->cancelled = true;
+  }
+
+  size_t numIndexed = 0;
+  for (size_t i = 0; i < numCtxs; ++i) {
+    if (scanner->cancelled || dictFind(scanner->superseded, aCtxs[i]->doc->docKey)) {
+      AddDocumentCtx_Free(aCtxs[i]);
+      continue;
+    }
+    aCtxs[numIndexed] = aCtxs[i];
+    failed[numIndexed++] = failed[i];
+  }
+  dictEmpty(scanner->superseded, NULL);
+
+  RedisSearchCtx_LockSpecWrite(&sctx);
+  AddDocumentCtx_IndexBatch(aCtxs, numIndexed, failed);
+  spec->stats.totalIndexTime += clock() - startTime;
+  RedisSearchCtx_UnlockSpec(&sctx);
+
+  for (size_t i = 0; i < n; ++i) {
+    Document_Free(docs + i);
+  }
+  rm_free(aCtxs);
+  rm_free(failed);
+}
+
 void IndexSpec_DeleteDoc_Unsafe(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key, t_docId id) {
 
   if (DocTable_DeleteR(&spec->docs, key)) {
     spec->stats.numDocuments--;
+    spec->revision++;
 
     // Increment the index's garbage collector's scanning frequency after document deletions
     if (spec->gc) {
@@ -2807,6 +3057,10 @@ void IndexSpec_DeleteDoc_Unsafe(IndexSpec *spec, RedisModuleCtx *ctx, RedisModul
         if (!kdv) {
           continue;
         }
+        if (FieldSpec_IsQuantized(&spec->fields[i])) {
+          QuantizedIndex_Delete(kdv->p, id);
+          continue;
+        }
         VecSimIndex *vecsim = kdv->p;
         VecSimIndex_DeleteVector(vecsim, id);
       }
@@ -2820,6 +3074,7 @@ void IndexSpec_DeleteDoc_Unsafe(IndexSpec *spec, RedisModuleCtx *ctx, RedisModul
 
 int IndexSpec_DeleteDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key) {
   RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+  IndexesScanner_OnKeyChange(spec->scanner, key);
 
   // TODO: is this necessary?
   RedisSearchCtx_LockSpecRead(&sctx);
@@ -3037,9 +3292,15 @@ void Indexes_ReplaceMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStri
     dictEntry *entry = dictFind(to_specs->specs, spec->name);
     if (entry) {
       RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+      IndexesScanner_OnKeyChange(spec->scanner, from_key);
       RedisSearchCtx_LockSpecWrite(&sctx);
-      DocTable_Replace(&spec->docs, from_str, from_len, to_str, to_len);
+      int rc = DocTable_Replace(&spec->docs, from_str, from_len, to_str, to_len);
       RedisSearchCtx_UnlockSpec(&sctx);
+      if (rc != REDISMODULE_OK && spec->scanner && spec->scanner->batchInFlight) {
+        // the key may be in the batch the scanner is indexing, which drops it now that it was
+        // renamed. Index it under its new name instead
+        IndexSpec_UpdateDoc(spec, ctx, to_key, type);
+      }
       size_t index = entry->v.u64;
       dictDelete(to_specs->specs, spec->name);
       array_del_fast(to_specs->specsOps, index);
@@ -46,6 +46,7 @@ struct DocumentIndexer;
 #define SPEC_NOOFFSETS_STR "NOOFFSETS"
 #define SPEC_NOFIELDS_STR "NOFIELDS"
 #define SPEC_NOFREQS_STR "NOFREQS"
+#define SPEC_PACKED_STR "PACKED"
 #define SPEC_NOHL_STR "NOHL"
 #define SPEC_SCHEMA_STR "SCHEMA"
 #define SPEC_SCHEMA_EXPANDABLE_STR "MAXTEXTFIELDS"
@@ -158,6 +159,11 @@ typedef enum {
 
   Index_HasGeometry = 0x40000,
 
+  // Full blocks of the term inverted indexes are stored as bit-packed frames (see pfor.h), or as
+  // bitmaps when they hold dense document ids only. Also set on tag indexes (see tagBitmapBlocks),
+  // and on numeric indexes, whose full blocks are stored in columns (see numericColumnarBlocks)
+  Index_BlockPacked = 0x80000,
+
 } IndexFlags;
 
 // redis version (its here because most file include it with no problem,
@@ -190,7 +196,8 @@ typedef uint16_t FieldSpecDedupeArray[SPEC_MAX_FIELDS];
   (Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets | Index_StoreNumeric | \
    Index_WideSchema)
 
-#define INDEX_CURRENT_VERSION 23
+#define INDEX_CURRENT_VERSION 24
+#define INDEX_VECSIM_QUANT_VERSION 24
 #define INDEX_GEOMETRY_VERSION 23
 #define INDEX_VECSIM_TIERED_VERSION 22
 #define INDEX_VECSIM_MULTI_VERSION 21
@@ -305,6 +312,16 @@ typedef struct IndexSpec {
   // Count the number of times the index was used
   long long counter;
 
+  // Bumped whenever documents are added to the index or deleted from it
+  uint64_t revision;
+  // Bumped whenever the documents of the index are renumbered (see docid_compact.h), which
+  // invalidates the document ids held by paused queries
+  uint32_t docIdsEpoch;
+  // Cached results of filter subtrees of queries, valid at the current revision (see filter_cache.h)
+  struct FilterCache *filterCache;
+  // Learned pass rates of the filters of hybrid vector queries (see hybrid_stats.h)
+  struct HybridStats *hybridStats;
+
   // read write lock
   pthread_rwlock_t rwlock;
 
@@ -562,6 +579,13 @@ typedef struct IndexesScanner {
   WeakRef spec_ref;
   char *spec_name;
   size_t scannedKeys, totalKeys;
+  // Documents loaded by the scan and not indexed yet, see RSConfig.bgIndexingBatchSize
+  arrayof(struct Document) batch;
+  size_t pendingKeys;
+  // Set while a batch is preprocessed with the GIL released. The keys written meanwhile are
+  // collected in `superseded`, and are not indexed from the batch
+  bool batchInFlight;
+  dict *superseded;
 } IndexesScanner;
 
 double IndexesScanner_IndexedPercent(IndexesScanner *scanner, IndexSpec *sp);
@@ -15,6 +15,7 @@
 #include "util/arr.h"
 #include "rmutil/rm_assert.h"
 #include "resp3.h"
+#include "config.h"
 
 extern RedisModuleCtx *RSDummyContext;
 
@@ -132,7 +133,11 @@ struct InvertedIndex *TagIndex_OpenIndex(TagIndex *idx, const char *value, size_
   InvertedIndex *iv = TrieMap_Find(idx->values, (char *)value, len);
   if (iv == TRIEMAP_NOTFOUND) {
     if (create) {
-      iv = NewInvertedIndex(Index_DocIdsOnly, 1);
+      IndexFlags flags = Index_DocIdsOnly;
+      if (RSGlobalConfig.tagBitmapBlocks) {
+        flags |= Index_BlockPacked;
+      }
+      iv = NewInvertedIndex(flags, 1);
       TrieMap_Add(idx->values, (char *)value, len, iv, NULL);
     }
   }
@@ -140,22 +145,24 @@ struct InvertedIndex *TagIndex_OpenIndex(TagIndex *idx, const char *value, size_
 }
 
 /* Encode a single docId into a specific tag value */
-static inline size_t tagIndex_Put(TagIndex *idx, const char *value, size_t len, t_docId docId) {
+static inline size_t tagIndex_Put(TagIndex *idx, const char *value, size_t len, t_docId docId,
+                                  ssize_t *resized) {
 
   IndexEncoder enc = InvertedIndex_GetEncoder(Index_DocIdsOnly);
   RSIndexResult rec = {.type = RSResultType_Virtual, .docId = docId, .offsetsSz = 0, .freq = 0};
   InvertedIndex *iv = TagIndex_OpenIndex(idx, value, len, 1);
-  return InvertedIndex_WriteEntryGeneric(iv, enc, docId, &rec);
+  return InvertedIndex_WriteEntryGeneric(iv, enc, docId, &rec, resized);
 }
 
 /* Index a vector of pre-processed tags for a docId */
-size_t TagIndex_Index(TagIndex *idx, const char **values, size_t n, t_docId docId) {
+size_t TagIndex_Index(TagIndex *idx, const char **values, size_t n, t_docId docId,
+                      ssize_t *resized) {
   if (!values) return 0;
   size_t ret = 0;
   for (size_t ii = 0; ii < n; ++ii) {
     const char *tok = values[ii];
     if (tok && *tok != '\0') {
-      ret += tagIndex_Put(idx, tok, strlen(tok), docId);
+      ret += tagIndex_Put(idx, tok, strlen(tok), docId, resized);
       if (idx->suffix) { // add to suffix triemap if exist
         addSuffixTrieMap(idx->suffix, tok, strlen(tok));
       }
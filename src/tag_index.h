@@ -127,8 +127,11 @@ static inline void TagIndex_FreePreprocessedData(char **s) {
   array_free(s);
 }
 
-/* Index a vector of pre-processed tags for a docId */
-size_t TagIndex_Index(TagIndex *idx, const char **values, size_t n, t_docId docId);
+/* Index a vector of pre-processed tags for a docId. Returns the number of bytes written. If `resized`
+ * is not NULL, the number of bytes the blocks sealed or unsealed by the writes grew by is added to
+ * it */
+size_t TagIndex_Index(TagIndex *idx, const char **values, size_t n, t_docId docId,
+                      ssize_t *resized);
 
 /* Open an index reader to iterate a tag index for a specific tag. Used at query evaluation time.
  * Returns NULL if there is no such tag in the index */
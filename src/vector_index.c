@@ -9,10 +9,15 @@
 #include "metric_iterator.h"
 #include "query_param.h"
 #include "rdb.h"
+#include "quantized_reader.h"
+#include "vector_range_reader.h"
+#include "aggregate/aggregate.h"
 #include "util/workers_pool.h"
 #include "util/threadpool_api.h"
+#include "util/strconv.h"
 
-static VecSimIndex *openVectorKeysDict(IndexSpec *spec, RedisModuleString *keyName, int write) {
+// Returns the VecSimIndex of the field, or its QuantizedIndex if the field is quantized.
+static void *openVectorKeysDict(IndexSpec *spec, RedisModuleString *keyName, int write) {
   KeysDictValue *kdv = dictFetchValue(spec->keysDict, keyName);
   if (kdv) {
     return kdv->p;
@@ -36,10 +41,15 @@ static VecSimIndex *openVectorKeysDict(IndexSpec *spec, RedisModuleString *keyNa
 
   // create new vector data structure
   kdv = rm_calloc(1, sizeof(*kdv));
-  kdv->p = VecSimIndex_New(&fieldSpec->vectorOpts.vecSimParams);
+  if (FieldSpec_IsQuantized(fieldSpec)) {
+    kdv->p = NewQuantizedIndex(&fieldSpec->vectorOpts.vecSimParams.algoParams.bfParams);
+    kdv->dtor = (void (*)(void *))QuantizedIndex_Free;
+  } else {
+    kdv->p = VecSimIndex_New(&fieldSpec->vectorOpts.vecSimParams);
+    kdv->dtor = (void (*)(void *))VecSimIndex_Free;
+  }
 
   dictAdd(spec->keysDict, keyName, kdv);
-  kdv->dtor = (void (*)(void *))VecSimIndex_Free;
   return kdv->p;
 }
 
@@ -47,6 +57,10 @@ VecSimIndex *OpenVectorIndex(IndexSpec *sp, RedisModuleString *keyName) {
   return openVectorKeysDict(sp, keyName, 1);
 }
 
+QuantizedIndex *OpenQuantizedVectorIndex(IndexSpec *sp, RedisModuleString *keyName) {
+  return openVectorKeysDict(sp, keyName, 1);
+}
+
 IndexIterator *createMetricIteratorFromVectorQueryResults(VecSimQueryReply *reply, bool yields_metric) {
   size_t res_num = VecSimQueryReply_Len(reply);
   if (res_num == 0) {
@@ -70,14 +84,104 @@ IndexIterator *createMetricIteratorFromVectorQueryResults(VecSimQueryReply *repl
   return NewMetricIterator(docIdsList, metricList, VECTOR_DISTANCE, yields_metric);
 }
 
-IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator *child_it) {
+// Copy the params of a range query to `out` except for BATCH_SIZE, whose value is parsed into
+// `batchSize`.
+static int VectorQuery_ExtractBatchSize(const VecSimRawParam *params, size_t nparams,
+                                        VecSimRawParam *out, size_t *nout, size_t *batchSize,
+                                        QueryError *status) {
+  *nout = 0;
+  for (size_t i = 0; i < nparams; i++) {
+    if (!STR_EQCASE(params[i].name, params[i].nameLen, VECSIM_BATCH_SIZE)) {
+      out[(*nout)++] = params[i];
+      continue;
+    }
+    long long n;
+    if (*batchSize) {
+      QueryError_SetErrorFmt(status, QUERY_EDUPPARAM, "Error parsing vector similarity parameters: %s",
+                             QueryError_Strerror(QUERY_EDUPPARAM));
+      return REDISMODULE_ERR;
+    }
+    if (!ParseInteger(params[i].value, &n) || n <= 0) {
+      QueryError_SetErrorFmt(status, QUERY_EBADVAL, "Error parsing vector similarity parameters: %s",
+                             QueryError_Strerror(QUERY_EBADVAL));
+      return REDISMODULE_ERR;
+    }
+    *batchSize = n;
+  }
+  return REDISMODULE_OK;
+}
+
+static IndexIterator *newQuantizedVectorIterator(QueryEvalCtx *q, VectorQuery *vq,
+                                                 const FieldSpec *fs, const QuantizedIndex *qi,
+                                                 IndexIterator *child_it) {
+  size_t vecLen = vq->type == VECSIM_QT_KNN ? vq->knn.vecLen : vq->range.vecLen;
+  if (vecLen != fs->vectorOpts.expBlobSize) {
+    QueryError_SetErrorFmt(q->status, QUERY_EINVAL,
+                           "Error parsing vector similarity query: query vector blob size"
+                           " (%zu) does not match index's expected size (%zu).",
+                           vecLen, fs->vectorOpts.expBlobSize);
+    return NULL;
+  }
+  if (array_len(vq->params.params)) {
+    QueryError_SetErrorFmt(q->status, QUERY_EINVAL,
+                           "Error parsing vector similarity parameters: %s is not supported by"
+                           " quantized vector indexes", vq->params.params[0].name);
+    return NULL;
+  }
+  switch (vq->type) {
+    case VECSIM_QT_KNN: {
+      IndexIterator *it = NewQuantizedKnnIterator(q->sctx, fs, qi, &vq->knn, child_it,
+                                                  q->opts->flags & Search_IgnoreScores);
+      // Re-ranking loads the documents from the keyspace, which is done by the pipeline
+      if (fs->vectorOpts.quantParams.rerank && q->rerankIterP) {
+        *q->rerankIterP = it;
+      }
+      return it;
+    }
+    case VECSIM_QT_RANGE: {
+      if (vq->range.radius < 0) {
+        QueryError_SetErrorFmt(q->status, QUERY_EINVAL,
+                               "Error parsing vector similarity query: negative radius (%g) "
+                               "given in a range query",
+                               vq->range.radius);
+        return NULL;
+      }
+      // The distances of the quantized vectors are returned, range queries are not re-ranked.
+      QuantizedQuery *qq = NewQuantizedQuery(qi, vq->range.vector);
+      QuantizedCandidate *results = QuantizedQuery_Range(qq, vq->range.radius);
+      QuantizedQuery_Free(qq);
+      size_t res_num = array_len(results);
+      if (res_num == 0) {
+        array_free(results);
+        return NULL;
+      }
+      t_docId *docIdsList = array_new(t_docId, res_num);
+      double *metricList = array_new(double, res_num);
+      for (size_t i = 0; i < res_num; ++i) {
+        docIdsList = array_append(docIdsList, results[i].id);
+        metricList = array_append(metricList, results[i].distance);
+      }
+      array_free(results);
+      return NewMetricIterator(docIdsList, metricList, VECTOR_DISTANCE, vq->scoreField != NULL);
+    }
+  }
+  return NULL;
+}
+
+IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator *child_it,
+                                 const char *filterShape) {
   RedisSearchCtx *ctx = q->sctx;
   RedisModuleString *key = RedisModule_CreateStringPrintf(ctx->redisCtx, "%s", vq->property);
-  VecSimIndex *vecsim = openVectorKeysDict(ctx->spec, key, 0);
+  void *index = openVectorKeysDict(ctx->spec, key, 0);
   RedisModule_FreeString(ctx->redisCtx, key);
-  if (!vecsim) {
+  if (!index) {
     return NULL;
   }
+  const FieldSpec *vecField = IndexSpec_GetField(ctx->spec, vq->property, strlen(vq->property));
+  if (vecField && FieldSpec_IsQuantized(vecField)) {
+    return newQuantizedVectorIterator(q, vq, vecField, index, child_it);
+  }
+  VecSimIndex *vecsim = index;
 
   VecSimIndexBasicInfo info = VecSimIndex_BasicInfo(vecsim);
   size_t dim = info.dim;
@@ -109,7 +213,13 @@ IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator
                                       .ignoreDocScore = q->opts->flags & Search_IgnoreScores,
                                       .childIt = child_it,
                                       .timeout = q->sctx->timeout,
+                                      .prefilter = RSGlobalConfig.hybridPrefilterBitmap,
       };
+      if (RSGlobalConfig.hybridAdaptivePolicy && child_it) {
+        hParams.stats = ctx->spec->hybridStats;
+        hParams.fieldName = vecField ? vecField->name : NULL;
+        hParams.filterShape = filterShape;
+      }
       return NewHybridVectorIterator(hParams, q->status);
     }
     case VECSIM_QT_RANGE: {
@@ -127,20 +237,36 @@ IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator
                                vq->range.radius);
         return NULL;
       }
-      if (VecSim_ResolveQueryParams(vecsim, vq->params.params, array_len(vq->params.params),
+      // BATCH_SIZE streams the results, and is not a range query param of VecSim.
+      size_t batchSize = 0;
+      size_t nparams = array_len(vq->params.params);
+      VecSimRawParam params[nparams + 1];
+      if (VectorQuery_ExtractBatchSize(vq->params.params, nparams, params, &nparams, &batchSize,
+                                       q->status) != REDISMODULE_OK) {
+        return NULL;
+      }
+      if (VecSim_ResolveQueryParams(vecsim, params, nparams,
                                     &qParams, QUERY_TYPE_RANGE, q->status) != VecSim_OK)  {
         return NULL;
       }
+      bool yields_metric = vq->scoreField != NULL;
+      // Results by distance are only read at the root of the query. Tiered indexes lock their graph
+      // while a batch iterator is alive, so it can not be kept while a cursor is paused.
+      if (batchSize && vq->range.order == BY_SCORE &&
+          (!vecField || vecField->vectorOpts.vecSimParams.algo != VecSimAlgo_TIERED)) {
+        return NewVectorRangeIterator(q->sctx, vecsim, &vq->range, qParams, batchSize,
+                                      yields_metric, q->conc);
+      }
       qParams.timeoutCtx = &(TimeoutCtx){ .timeout = q->sctx->timeout, .counter = 0 };
+      // The metric iterator returns the results by id.
       VecSimQueryReply *results =
           VecSimIndex_RangeQuery(vecsim, vq->range.vector, vq->range.radius,
-                                 &qParams, vq->range.order);
+                                 &qParams, BY_ID);
       if (VecSimQueryReply_GetCode(results) == VecSim_QueryReply_TimedOut) {
         VecSimQueryReply_Free(results);
         QueryError_SetError(q->status, QUERY_ETIMEDOUT, NULL);
         return NULL;
       }
-      bool yields_metric = vq->scoreField != NULL;
       return createMetricIteratorFromVectorQueryResults(results, yields_metric);
     }
   }
@@ -10,6 +10,7 @@
 #include "index_iterator.h"
 #include "query_node.h"
 #include "query_ctx.h"
+#include "vector_quant.h"
 
 #define VECSIM_TYPE_FLOAT32 "FLOAT32"
 #define VECSIM_TYPE_FLOAT64 "FLOAT64"
@@ -110,8 +111,13 @@ typedef struct VecSimLogCtx {
 // TODO: remove idxKey from all OpenFooIndex functions
 VecSimIndex *OpenVectorIndex(IndexSpec *sp,
   RedisModuleString *keyName/*, RedisModuleKey **idxKey*/);
+// The index of a quantized vector field (see FieldSpec_IsQuantized), which is not a VecSim index
+QuantizedIndex *OpenQuantizedVectorIndex(IndexSpec *sp, RedisModuleString *keyName);
 
-IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator *child_it);
+// `filterShape` describes the filter of a hybrid query (`child_it`) for learning its pass rate,
+// and may be NULL.
+IndexIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, IndexIterator *child_it,
+                                 const char *filterShape);
 
 int VectorQuery_EvalParams(dict *params, QueryNode *node, QueryError *status);
 int VectorQuery_ParamResolve(VectorQueryParams params, size_t index, dict *paramsDict, QueryError *status);
@@ -0,0 +1,325 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "vector_quant.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+#include "util/khash.h"
+#include <math.h>
+#include <string.h>
+#include <sys/param.h>
+
+// The bounds of a quantized vector: its smallest element, the step between two codes, and the
+// squared norm of the decoded vector
+#define QUANT_BOUNDS 3
+#define QUANT_MAX_CODE 255
+#define QUANT_MAX_QUERY_CODE 127
+// The number of elements whose products of codes fit a 32 bit accumulator
+#define QUANT_DOT_BLOCK 65536
+#define QUANT_INITIAL_CAP 64
+
+KHASH_MAP_INIT_INT64(quantslots, size_t)
+
+struct QuantizedIndex {
+  VecSimType type;
+  VecSimMetric metric;
+  size_t dim;
+  size_t size;
+  size_t cap;
+  t_docId *ids;                   // The document of every vector
+  uint8_t *codes;                 // `dim` codes per vector
+  float *bounds;                  // QUANT_BOUNDS values per vector
+  khash_t(quantslots) *slots;     // The position of the vector of every document
+};
+
+struct QuantizedQuery {
+  const QuantizedIndex *index;
+  double *vector;                 // Normalized for COSINE
+  int8_t *codes;                  // codes[i] * scale is about vector[i]
+  double scale;
+  double sum;
+  double sqnorm;
+};
+
+static inline double elementAt(VecSimType type, const void *vector, size_t i) {
+  return type == VecSimType_FLOAT64 ? ((const double *)vector)[i] : ((const float *)vector)[i];
+}
+
+// Copy a vector to doubles, normalized for COSINE as VecSim does.
+static void loadVector(const QuantizedIndex *qi, const void *vector, double *out) {
+  double sqnorm = 0;
+  for (size_t i = 0; i < qi->dim; ++i) {
+    out[i] = elementAt(qi->type, vector, i);
+    sqnorm += out[i] * out[i];
+  }
+  if (qi->metric == VecSimMetric_Cosine && sqnorm > 0) {
+    double norm = sqrt(sqnorm);
+    for (size_t i = 0; i < qi->dim; ++i) {
+      out[i] /= norm;
+    }
+  }
+}
+
+// A plain loop over integers, which the compiler vectorizes.
+static int64_t dotCodes(const int8_t *query, const uint8_t *codes, size_t dim) {
+  int64_t total = 0;
+  for (size_t start = 0; start < dim; start += QUANT_DOT_BLOCK) {
+    size_t end = MIN(dim, start + QUANT_DOT_BLOCK);
+    int32_t sum = 0;
+    for (size_t i = start; i < end; ++i) {
+      sum += (int32_t)query[i] * (int32_t)codes[i];
+    }
+    total += sum;
+  }
+  return total;
+}
+
+QuantizedIndex *NewQuantizedIndex(const BFParams *params) {
+  QuantizedIndex *qi = rm_calloc(1, sizeof(*qi));
+  qi->type = params->type;
+  qi->metric = params->metric;
+  qi->dim = params->dim;
+  qi->slots = kh_init(quantslots);
+  return qi;
+}
+
+void QuantizedIndex_Free(QuantizedIndex *qi) {
+  if (!qi) {
+    return;
+  }
+  kh_destroy(quantslots, qi->slots);
+  rm_free(qi->ids);
+  rm_free(qi->codes);
+  rm_free(qi->bounds);
+  rm_free(qi);
+}
+
+static void QuantizedIndex_Grow(QuantizedIndex *qi) {
+  qi->cap = qi->cap ? qi->cap + qi->cap / 2 : QUANT_INITIAL_CAP;
+  qi->ids = rm_realloc(qi->ids, qi->cap * sizeof(*qi->ids));
+  qi->codes = rm_realloc(qi->codes, qi->cap * qi->dim);
+  qi->bounds = rm_realloc(qi->bounds, qi->cap * QUANT_BOUNDS * sizeof(*qi->bounds));
+}
+
+void QuantizedIndex_Add(QuantizedIndex *qi, const void *vector, t_docId docId) {
+  int absent;
+  khiter_t it = kh_put(quantslots, qi->slots, docId, &absent);
+  if (absent) {
+    if (qi->size == qi->cap) {
+      QuantizedIndex_Grow(qi);
+    }
+    kh_val(qi->slots, it) = qi->size;
+    qi->ids[qi->size++] = docId;
+  }
+  size_t pos = kh_val(qi->slots, it);
+
+  double *x = rm_malloc(qi->dim * sizeof(*x));
+  loadVector(qi, vector, x);
+  double min = INFINITY, max = -INFINITY;
+  for (size_t i = 0; i < qi->dim; ++i) {
+    min = MIN(min, x[i]);
+    max = MAX(max, x[i]);
+  }
+  float lower = min, step = (max - min) / QUANT_MAX_CODE;
+  if (!(step > 0)) {
+    step = 0;
+  }
+
+  uint8_t *codes = qi->codes + pos * qi->dim;
+  double sqnorm = 0;
+  for (size_t i = 0; i < qi->dim; ++i) {
+    long code = step ? lrint((x[i] - lower) / step) : 0;
+    codes[i] = MAX(0, MIN(QUANT_MAX_CODE, code));
+    double decoded = lower + (double)step * codes[i];
+    sqnorm += decoded * decoded;
+  }
+  float *bounds = qi->bounds + pos * QUANT_BOUNDS;
+  bounds[0] = lower;
+  bounds[1] = step;
+  bounds[2] = sqnorm;
+  rm_free(x);
+}
+
+void QuantizedIndex_Delete(QuantizedIndex *qi, t_docId docId) {
+  khiter_t it = kh_get(quantslots, qi->slots, docId);
+  if (it == kh_end(qi->slots)) {
+    return;
+  }
+  size_t pos = kh_val(qi->slots, it);
+  kh_del(quantslots, qi->slots, it);
+
+  // Move the last vector to the freed position
+  size_t last = --qi->size;
+  if (pos != last) {
+    qi->ids[pos] = qi->ids[last];
+    memcpy(qi->codes + pos * qi->dim, qi->codes + last * qi->dim, qi->dim);
+    memcpy(qi->bounds + pos * QUANT_BOUNDS, qi->bounds + last * QUANT_BOUNDS,
+           QUANT_BOUNDS * sizeof(*qi->bounds));
+    kh_val(qi->slots, kh_get(quantslots, qi->slots, qi->ids[pos])) = pos;
+  }
+}
+
+size_t QuantizedIndex_Size(const QuantizedIndex *qi) {
+  return qi->size;
+}
+
+size_t QuantizedIndex_MemoryUsage(const QuantizedIndex *qi) {
+  size_t vectors = qi->cap * (sizeof(*qi->ids) + qi->dim + QUANT_BOUNDS * sizeof(*qi->bounds));
+  // The keys and values of the buckets, and 2 bits of flags per bucket
+  size_t slots = kh_n_buckets(qi->slots) * (sizeof(khint64_t) + sizeof(size_t)) +
+                 kh_n_buckets(qi->slots) / 4;
+  return sizeof(*qi) + sizeof(*qi->slots) + vectors + slots;
+}
+
+QuantizedQuery *NewQuantizedQuery(const QuantizedIndex *qi, const void *vector) {
+  QuantizedQuery *qq = rm_new(QuantizedQuery);
+  qq->index = qi;
+  qq->vector = rm_malloc(qi->dim * sizeof(*qq->vector));
+  qq->codes = rm_malloc(qi->dim * sizeof(*qq->codes));
+  loadVector(qi, vector, qq->vector);
+
+  double maxAbs = 0;
+  qq->sum = qq->sqnorm = 0;
+  for (size_t i = 0; i < qi->dim; ++i) {
+    maxAbs = MAX(maxAbs, fabs(qq->vector[i]));
+    qq->sum += qq->vector[i];
+    qq->sqnorm += qq->vector[i] * qq->vector[i];
+  }
+  qq->scale = maxAbs / QUANT_MAX_QUERY_CODE;
+  for (size_t i = 0; i < qi->dim; ++i) {
+    qq->codes[i] = qq->scale ? lrint(qq->vector[i] / qq->scale) : 0;
+  }
+  return qq;
+}
+
+void QuantizedQuery_Free(QuantizedQuery *qq) {
+  if (!qq) {
+    return;
+  }
+  rm_free(qq->vector);
+  rm_free(qq->codes);
+  rm_free(qq);
+}
+
+static double QuantizedQuery_DistanceAt(const QuantizedQuery *qq, size_t pos) {
+  const QuantizedIndex *qi = qq->index;
+  const float *bounds = qi->bounds + pos * QUANT_BOUNDS;
+  // The decoded element i is bounds[0] + bounds[1] * code[i]
+  double dot = bounds[0] * qq->sum +
+               bounds[1] * qq->scale * dotCodes(qq->codes, qi->codes + pos * qi->dim, qi->dim);
+  if (qi->metric == VecSimMetric_L2) {
+    return MAX(0, qq->sqnorm - 2 * dot + bounds[2]);
+  }
+  return 1 - dot;
+}
+
+bool QuantizedQuery_Distance(const QuantizedQuery *qq, t_docId docId, double *distance) {
+  khiter_t it = kh_get(quantslots, qq->index->slots, docId);
+  if (it == kh_end(qq->index->slots)) {
+    return false;
+  }
+  *distance = QuantizedQuery_DistanceAt(qq, kh_val(qq->index->slots, it));
+  return true;
+}
+
+double QuantizedQuery_ExactDistance(const QuantizedQuery *qq, const void *vector) {
+  const QuantizedIndex *qi = qq->index;
+  double dot = 0, sqnorm = 0, l2 = 0;
+  for (size_t i = 0; i < qi->dim; ++i) {
+    double x = elementAt(qi->type, vector, i);
+    dot += qq->vector[i] * x;
+    sqnorm += x * x;
+    l2 += (qq->vector[i] - x) * (qq->vector[i] - x);
+  }
+  switch (qi->metric) {
+    case VecSimMetric_L2:
+      return l2;
+    case VecSimMetric_Cosine:
+      return 1 - (sqnorm > 0 ? dot / sqrt(sqnorm) : 0);
+    default:
+      return 1 - dot;
+  }
+}
+
+void QuantizedQuery_TopK(const QuantizedQuery *qq, QuantizedTopK *topk) {
+  const QuantizedIndex *qi = qq->index;
+  for (size_t pos = 0; pos < qi->size; ++pos) {
+    QuantizedTopK_Push(topk, qi->ids[pos], QuantizedQuery_DistanceAt(qq, pos));
+  }
+}
+
+static int cmpCandidatesById(const void *p1, const void *p2) {
+  const QuantizedCandidate *c1 = p1, *c2 = p2;
+  return c1->id < c2->id ? -1 : c1->id > c2->id;
+}
+
+static int cmpCandidatesByDistance(const void *p1, const void *p2) {
+  const QuantizedCandidate *c1 = p1, *c2 = p2;
+  if (c1->distance != c2->distance) {
+    return c1->distance < c2->distance ? -1 : 1;
+  }
+  return cmpCandidatesById(p1, p2);
+}
+
+QuantizedCandidate *QuantizedQuery_Range(const QuantizedQuery *qq, double radius) {
+  const QuantizedIndex *qi = qq->index;
+  QuantizedCandidate *results = array_new(QuantizedCandidate, 16);
+  for (size_t pos = 0; pos < qi->size; ++pos) {
+    double distance = QuantizedQuery_DistanceAt(qq, pos);
+    if (distance <= radius) {
+      QuantizedCandidate c = {.id = qi->ids[pos], .distance = distance};
+      results = array_append(results, c);
+    }
+  }
+  qsort(results, array_len(results), sizeof(*results), cmpCandidatesById);
+  return results;
+}
+
+void QuantizedTopK_Init(QuantizedTopK *topk, size_t cap) {
+  topk->items = cap ? rm_malloc(cap * sizeof(*topk->items)) : NULL;
+  topk->len = 0;
+  topk->cap = cap;
+}
+
+void QuantizedTopK_Push(QuantizedTopK *topk, t_docId id, double distance) {
+  QuantizedCandidate *items = topk->items;
+  size_t i;
+  if (topk->len < topk->cap) {
+    // Sift the new candidate up from the end
+    i = topk->len++;
+    while (i > 0 && items[(i - 1) / 2].distance < distance) {
+      items[i] = items[(i - 1) / 2];
+      i = (i - 1) / 2;
+    }
+  } else if (topk->cap && distance < items[0].distance) {
+    // Replace the farthest candidate, and sift the new one down from the root
+    i = 0;
+    for (size_t child = 1; child < topk->len; child = 2 * i + 1) {
+      if (child + 1 < topk->len && items[child + 1].distance > items[child].distance) {
+        ++child;
+      }
+      if (items[child].distance <= distance) {
+        break;
+      }
+      items[i] = items[child];
+      i = child;
+    }
+  } else {
+    return;
+  }
+  items[i].id = id;
+  items[i].distance = distance;
+}
+
+void QuantizedTopK_Sort(QuantizedTopK *topk) {
+  qsort(topk->items, topk->len, sizeof(*topk->items), cmpCandidatesByDistance);
+}
+
+void QuantizedTopK_Free(QuantizedTopK *topk) {
+  rm_free(topk->items);
+  topk->items = NULL;
+  topk->len = topk->cap = 0;
+}
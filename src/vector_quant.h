@@ -0,0 +1,99 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "redisearch.h"
+#include "VecSim/vec_sim.h"
+#include <stdbool.h>
+
+#define VECSIM_QUANTIZATION "QUANTIZATION"
+#define VECSIM_QUANT_SQ8 "SQ8"
+#define VECSIM_RERANK "RERANK"
+
+typedef enum {
+  VecSimQuant_NONE = 0,
+  VecSimQuant_SQ8 = 1,  // Every element is stored as an 8 bit code between the vector's bounds
+} VecSimQuantType;
+
+typedef struct {
+  VecSimQuantType type;
+  // The number of nearest candidates of a KNN query whose exact distance is computed from the
+  // full vector of their document, 0 for returning the distances of the quantized vectors.
+  size_t rerank;
+} VecSimQuantParams;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A flat vector index storing its vectors quantized, in a quarter of the memory of FLOAT32
+ * vectors (an eighth of FLOAT64 vectors) and a few bytes of bounds per vector.
+ *
+ * Every element of a vector is stored as an 8 bit code of its position between the smallest and
+ * the largest elements of the vector. Queries are quantized to signed 8 bit codes as well, so the
+ * distances are computed by integer dot products which the compiler vectorizes. The distances are
+ * those of VecSim: squared L2, and 1 minus the inner product for IP and COSINE (whose vectors are
+ * normalized before they are quantized).
+ *
+ * Like the other indexes of a spec, it is guarded by the spec lock.
+ */
+typedef struct QuantizedIndex QuantizedIndex;
+
+/* A query vector, prepared for computing its distances from the vectors of an index */
+typedef struct QuantizedQuery QuantizedQuery;
+
+typedef struct {
+  t_docId id;
+  double distance;
+} QuantizedCandidate;
+
+/* The `cap` candidates nearest to a query out of those pushed into it */
+typedef struct {
+  QuantizedCandidate *items;  // A max-heap by distance
+  size_t len;
+  size_t cap;
+} QuantizedTopK;
+
+/* Create an empty index of the vectors described by the parameters of a FLAT index */
+QuantizedIndex *NewQuantizedIndex(const BFParams *params);
+void QuantizedIndex_Free(QuantizedIndex *qi);
+
+/* Add the vector of a document to the index, replacing its previous vector */
+void QuantizedIndex_Add(QuantizedIndex *qi, const void *vector, t_docId docId);
+void QuantizedIndex_Delete(QuantizedIndex *qi, t_docId docId);
+
+size_t QuantizedIndex_Size(const QuantizedIndex *qi);
+size_t QuantizedIndex_MemoryUsage(const QuantizedIndex *qi);
+
+/* Prepare a query vector, in the binary format of the vectors of the index */
+QuantizedQuery *NewQuantizedQuery(const QuantizedIndex *qi, const void *vector);
+void QuantizedQuery_Free(QuantizedQuery *qq);
+
+/* Set the distance of the query from the quantized vector of a document. Returns false if the
+ * document has no vector in the index */
+bool QuantizedQuery_Distance(const QuantizedQuery *qq, t_docId docId, double *distance);
+
+/* The exact distance of the query from a full vector, in the binary format of the vectors of the
+ * index */
+double QuantizedQuery_ExactDistance(const QuantizedQuery *qq, const void *vector);
+
+/* Push the `topk->cap` vectors of the index nearest to the query into `topk` */
+void QuantizedQuery_TopK(const QuantizedQuery *qq, QuantizedTopK *topk);
+
+/* The vectors of the index within `radius` from the query, sorted by their document ids */
+QuantizedCandidate *QuantizedQuery_Range(const QuantizedQuery *qq, double radius);
+
+void QuantizedTopK_Init(QuantizedTopK *topk, size_t cap);
+void QuantizedTopK_Push(QuantizedTopK *topk, t_docId id, double distance);
+/* Sort the candidates by increasing distance. The heap can not be pushed into afterwards */
+void QuantizedTopK_Sort(QuantizedTopK *topk);
+void QuantizedTopK_Free(QuantizedTopK *topk);
+
+#ifdef __cplusplus
+}
+#endif
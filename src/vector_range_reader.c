@@ -0,0 +1,168 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#include "vector_range_reader.h"
+#include "spec.h"
+#include "rmalloc.h"
+
+static void VRI_FreeBatch(VectorRangeIterator *it) {
+  if (it->replyIter) {
+    VecSimQueryReply_IteratorFree(it->replyIter);
+    it->replyIter = NULL;
+  }
+  if (it->reply) {
+    VecSimQueryReply_Free(it->reply);
+    it->reply = NULL;
+  }
+}
+
+static void VRI_FreeBatches(VectorRangeIterator *it) {
+  VRI_FreeBatch(it);
+  if (it->batchIter) {
+    VecSimBatchIterator_Free(it->batchIter);
+    it->batchIter = NULL;
+  }
+}
+
+// Replace the current batch with the next one.
+static int VRI_NextBatch(VectorRangeIterator *it) {
+  VRI_FreeBatch(it);
+  if (!it->batchIter) {
+    it->batchIter = VecSimBatchIterator_New(it->index, it->vector, &it->qParams);
+  }
+  if (!VecSimBatchIterator_HasNext(it->batchIter)) {
+    IITER_SET_EOF(&it->base);
+    return INDEXREAD_EOF;
+  }
+  // A cursor reads with a new timeout every time
+  it->timeoutCtx = (TimeoutCtx){ .timeout = it->sctx->timeout, .counter = 0 };
+  it->reply = VecSimBatchIterator_Next(it->batchIter, it->batchSize, BY_SCORE);
+  it->numIterations++;
+  if (VecSimQueryReply_GetCode(it->reply) == VecSim_QueryReply_TimedOut) {
+    VRI_FreeBatch(it);
+    return INDEXREAD_TIMEOUT;
+  }
+  it->replyIter = VecSimQueryReply_GetIterator(it->reply);
+  return INDEXREAD_OK;
+}
+
+static int VRI_Read(void *ctx, RSIndexResult **hit) {
+  VectorRangeIterator *it = ctx;
+  if (!it->base.isValid) {
+    return INDEXREAD_EOF;
+  }
+  while (!it->replyIter || !VecSimQueryReply_IteratorHasNext(it->replyIter)) {
+    int rc = VRI_NextBatch(it);
+    if (rc != INDEXREAD_OK) {
+      return rc;
+    }
+  }
+  VecSimQueryResult *res = VecSimQueryReply_IteratorNext(it->replyIter);
+  double score = VecSimQueryResult_GetScore(res);
+  if (score > it->radius) {
+    // The batches are in increasing distance, so the rest of the vectors are out of the radius too.
+    IITER_SET_EOF(&it->base);
+    return INDEXREAD_EOF;
+  }
+  *hit = it->base.current;
+  (*hit)->docId = it->lastDocId = VecSimQueryResult_GetId(res);
+  (*hit)->num.value = score;
+  if (it->yieldsMetric) {
+    ResultMetrics_Reset(*hit);
+    ResultMetrics_Add(*hit, it->base.ownKey, RS_NumVal(score));
+  }
+  return INDEXREAD_OK;
+}
+
+static int VRI_HasNext(void *ctx) {
+  VectorRangeIterator *it = ctx;
+  return it->base.isValid;
+}
+
+static size_t VRI_NumEstimated(void *ctx) {
+  VectorRangeIterator *it = ctx;
+  return VecSimIndex_IndexSize(it->index);
+}
+
+static void VRI_Abort(void *ctx) {
+  VectorRangeIterator *it = ctx;
+  IITER_SET_EOF(&it->base);
+}
+
+static t_docId VRI_LastDocId(void *ctx) {
+  VectorRangeIterator *it = ctx;
+  return it->lastDocId;
+}
+
+static void VRI_Rewind(void *ctx) {
+  VectorRangeIterator *it = ctx;
+  VRI_FreeBatches(it);
+  it->revision = it->sctx->spec->revision;
+  it->numIterations = 0;
+  it->lastDocId = 0;
+  IITER_CLEAR_EOF(&it->base);
+}
+
+static void VRI_Free(IndexIterator *self) {
+  VectorRangeIterator *it = self->ctx;
+  if (it == NULL) {
+    return;
+  }
+  VRI_FreeBatches(it);
+  IndexResult_Free(it->base.current);
+  rm_free(it);
+}
+
+/* A callback called after the query regains the spec lock. The batches can not be continued if
+ * documents were added or deleted meanwhile, so the cursor is invalidated, as numeric ranges are */
+static void VectorRangeIterator_OnReopen(void *privdata) {
+  VectorRangeIterator *it = privdata;
+  uint64_t revision = it->sctx->spec->revision;
+  if (revision == it->revision) {
+    return;
+  }
+  if (it->batchIter) {
+    it->base.Abort(it->base.ctx);
+  } else {
+    it->revision = revision;
+  }
+}
+
+IndexIterator *NewVectorRangeIterator(RedisSearchCtx *sctx, VecSimIndex *index,
+                                      const RangeVectorQuery *query, VecSimQueryParams qParams,
+                                      size_t batchSize, bool yieldsMetric, ConcurrentSearchCtx *conc) {
+  VectorRangeIterator *it = rm_calloc(1, sizeof(*it));
+  it->sctx = sctx;
+  it->index = index;
+  it->vector = query->vector;
+  it->radius = query->radius;
+  it->batchSize = batchSize;
+  it->yieldsMetric = yieldsMetric;
+  it->qParams = qParams;
+  it->qParams.timeoutCtx = &it->timeoutCtx;
+  it->revision = sctx->spec->revision;
+
+  IndexIterator *ri = &it->base;
+  ri->ctx = it;
+  ri->type = VECTOR_RANGE_ITERATOR;
+  ri->current = NewMetricResult();
+  // This will be changed later to a valid RLookupKey if the distance is yielded.
+  ri->ownKey = NULL;
+  ri->isValid = 1;
+  ri->Read = VRI_Read;
+  ri->SkipTo = NULL;  // The results are returned by distance, unsorted by id
+  ri->Rewind = VRI_Rewind;
+  ri->Free = VRI_Free;
+  ri->HasNext = VRI_HasNext;
+  ri->NumEstimated = ri->Len = VRI_NumEstimated;
+  ri->Abort = VRI_Abort;
+  ri->LastDocId = VRI_LastDocId;
+
+  if (conc) {
+    ConcurrentSearch_AddKey(conc, VectorRangeIterator_OnReopen, it, NULL);
+  }
+  return ri;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright Redis Ltd. 2016 - present
+ * Licensed under your choice of the Redis Source Available License 2.0 (RSALv2) or
+ * the Server Side Public License v1 (SSPLv1).
+ */
+
+#pragma once
+
+#include "index_iterator.h"
+#include "search_ctx.h"
+#include "vector_index.h"
+#include "concurrent_ctx.h"
+#include "util/timeout.h"
+
+/* Returns the vectors within a radius from the query vector in increasing distance, pulling them
+ * from the vector index in batches on demand, so only a single batch is held at a time.
+ *
+ * Reading stops at the first vector out of the radius. Since the results are not ordered by id,
+ * the iterator can not be skipped, and it is only used at the root of a query. If documents are
+ * added or deleted while the query is paused (by a cursor), the iterator is aborted, as the batches
+ * of the vector index are no longer valid */
+typedef struct {
+  IndexIterator base;
+  RedisSearchCtx *sctx;
+  VecSimIndex *index;
+  const void *vector;
+  double radius;
+  size_t batchSize;
+  bool yieldsMetric;
+  VecSimQueryParams qParams;
+  TimeoutCtx timeoutCtx;                 // The timeout of qParams, updated before every batch
+  uint64_t revision;                     // The revision of the spec when the batches started
+
+  VecSimBatchIterator *batchIter;        // Created on the first read
+  VecSimQueryReply *reply;               // The current batch
+  VecSimQueryReply_Iterator *replyIter;
+  size_t numIterations;                  // The number of batches
+  t_docId lastDocId;
+} VectorRangeIterator;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Create an iterator over the vectors of `index` within `query->radius` from `query->vector`, in
+ * batches of `batchSize` vectors. `conc` is used for aborting the iterator if the index changes
+ * while the query is paused, and may be NULL */
+IndexIterator *NewVectorRangeIterator(RedisSearchCtx *sctx, VecSimIndex *index,
+                                      const RangeVectorQuery *query, VecSimQueryParams qParams,
+                                      size_t batchSize, bool yieldsMetric, ConcurrentSearchCtx *conc);
+
+#ifdef __cplusplus
+}
+#endif
@@ -16,6 +16,7 @@ InvertedIndex *createIndex(int size, int idStep, int start_with) {
         h.docId = id;
         h.fieldMask = 1;
         h.freq = 1;
+        h.docLen = 0;
         h.term = "hello";
         h.len = 5;
 
@@ -24,7 +25,7 @@ InvertedIndex *createIndex(int size, int idStep, int start_with) {
             VVW_Write(h.vw, n);
         }
 
-        InvertedIndex_WriteForwardIndexEntry(idx, enc, &h);
+        InvertedIndex_WriteForwardIndexEntry(idx, enc, &h, NULL);
         VVW_Free(h.vw);
 
         id += idStep;
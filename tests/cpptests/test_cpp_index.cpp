@@ -4,10 +4,12 @@
 #include "src/index_result.h"
 #include "src/query_parser/tokenizer.h"
 #include "src/spec.h"
+#include "src/ext/default.h"
 #include "src/tokenize.h"
 #include "src/varint.h"
 #include "src/hybrid_reader.h"
 #include "src/metric_iterator.h"
+#include "src/filter_cache.h"
 #include "src/util/arr.h"
 #include "src/util/references.h"
 
@@ -24,6 +26,8 @@
 #include <time.h>
 #include <float.h>
 #include <vector>
+#include <string>
+#include <algorithm>
 #include <cstdint>
 #include <random>
 #include <chrono>
@@ -167,7 +171,7 @@ TEST_P(IndexFlagsTest, testRWFlags) {
     }
     VVW_Truncate(h.vw);
 
-    InvertedIndex_WriteForwardIndexEntry(idx, enc, &h);
+    InvertedIndex_WriteForwardIndexEntry(idx, enc, &h, NULL);
 
     // printf("doc %d, score %f offset %zd\n", h.docId, h.docScore, w->bw.buf->offset);
     VVW_Free(h.vw);
@@ -226,6 +230,325 @@ TEST_P(IndexFlagsTest, testRWFlags) {
 
 INSTANTIATE_TEST_SUITE_P(IndexFlagsP, IndexFlagsTest, ::testing::Range(1, 32));
 
+TEST_P(IndexFlagsTest, testBlockDecoding) {
+  IndexFlags indexFlags = (IndexFlags)GetParam();
+  InvertedIndex *idx = NewInvertedIndex(indexFlags, 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(indexFlags);
+
+  for (size_t i = 1; i <= 350; i += 1 + i % 3) {
+    ForwardIndexEntry h = {0};
+    h.docId = i;
+    h.fieldMask = 1 << (i % 3);
+    h.freq = 1 + i % 7;
+    h.vw = NewVarintVectorWriter(8);
+    for (int n = 0; n < i % 4; n++) {
+      VVW_Write(h.vw, n);
+    }
+    VVW_Truncate(h.vw);
+    InvertedIndex_WriteForwardIndexEntry(idx, enc, &h, NULL);
+    VVW_Free(h.vw);
+  }
+
+  int oldConfig = RSGlobalConfig.invertedIndexBlockDecoding;
+  for (t_fieldMask mask : {RS_FIELDMASK_ALL, (t_fieldMask)0x02}) {
+    // read the index with and without block decoding and compare the results
+    RSGlobalConfig.invertedIndexBlockDecoding = 0;
+    IndexReader *expected = NewTermIndexReader(idx, NULL, mask, NULL, 1);
+    RSGlobalConfig.invertedIndexBlockDecoding = 1;
+    IndexReader *ir = NewTermIndexReader(idx, NULL, mask, NULL, 1);
+    ASSERT_TRUE(ir->blockDecoding);
+
+    RSIndexResult *h1 = NULL, *h2 = NULL;
+    int rc;
+    while ((rc = IR_Read(expected, &h1)) != INDEXREAD_EOF) {
+      ASSERT_EQ(rc, IR_Read(ir, &h2));
+      ASSERT_EQ(h1->docId, h2->docId);
+      // the record decoders only set the low 32 bits of narrow field masks
+      ASSERT_EQ((uint32_t)h1->fieldMask, (uint32_t)h2->fieldMask);
+      ASSERT_EQ(h1->freq, h2->freq);
+      ASSERT_EQ(h1->term.offsets.len, h2->term.offsets.len);
+      ASSERT_EQ(0, memcmp(h1->term.offsets.data, h2->term.offsets.data, h1->term.offsets.len));
+    }
+    ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &h2));
+
+    IR_Rewind(expected);
+    IR_Rewind(ir);
+    for (t_docId id = 3; id < 360; id += 7) {
+      int rc1 = IR_SkipTo(expected, id, &h1);
+      ASSERT_EQ(rc1, IR_SkipTo(ir, id, &h2));
+      if (rc1 == INDEXREAD_EOF) break;
+      ASSERT_EQ(h1->docId, h2->docId);
+    }
+
+    IR_Free(expected);
+    IR_Free(ir);
+  }
+  RSGlobalConfig.invertedIndexBlockDecoding = oldConfig;
+  InvertedIndex_Free(idx);
+}
+
+// The parameterized test above does not cover doc-ids-only indexes, whose block decoder turns the
+// records into doc ids with a prefix sum, or with a base add if the doc ids are raw encoded
+TEST_F(IndexTest, testBlockDecodingDocIdsOnly) {
+  int oldDecoding = RSGlobalConfig.invertedIndexBlockDecoding;
+  int oldRaw = RSGlobalConfig.invertedIndexRawDocidEncoding;
+  for (int raw : {0, 1}) {
+    RSGlobalConfig.invertedIndexRawDocidEncoding = raw;
+    InvertedIndex *idx = NewInvertedIndex(Index_DocIdsOnly, 1);
+    IndexEncoder enc = InvertedIndex_GetEncoder(Index_DocIdsOnly);
+
+    // a few full blocks, with gaps of every size the kernels handle
+    t_docId id = 1;
+    for (size_t i = 0; i < 2500; i++) {
+      ForwardIndexEntry h = {0};
+      h.docId = id;
+      h.fieldMask = 1;
+      h.freq = 1;
+      InvertedIndex_WriteForwardIndexEntry(idx, enc, &h, NULL);
+      id += 1 + (i % 7 == 0 ? i * 13 : i % 3);
+    }
+    ASSERT_EQ(3, idx->size);
+
+    RSGlobalConfig.invertedIndexBlockDecoding = 0;
+    IndexReader *expected = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+    RSGlobalConfig.invertedIndexBlockDecoding = 1;
+    IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+    ASSERT_TRUE(ir->blockDecoding);
+
+    RSIndexResult *h1 = NULL, *h2 = NULL;
+    size_t n = 0;
+    while (IR_Read(expected, &h1) != INDEXREAD_EOF) {
+      ASSERT_EQ(INDEXREAD_OK, IR_Read(ir, &h2));
+      ASSERT_EQ(h1->docId, h2->docId);
+      ++n;
+    }
+    ASSERT_EQ(2500, n);
+    ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &h2));
+
+    IR_Rewind(expected);
+    IR_Rewind(ir);
+    for (t_docId target = 3; target < id + 10; target += 977) {
+      int rc = IR_SkipTo(expected, target, &h1);
+      ASSERT_EQ(rc, IR_SkipTo(ir, target, &h2));
+      if (rc == INDEXREAD_EOF) break;
+      ASSERT_EQ(h1->docId, h2->docId);
+    }
+
+    IR_Free(expected);
+    IR_Free(ir);
+    InvertedIndex_Free(idx);
+  }
+  RSGlobalConfig.invertedIndexBlockDecoding = oldDecoding;
+  RSGlobalConfig.invertedIndexRawDocidEncoding = oldRaw;
+}
+
+TEST_P(IndexFlagsTest, testPackedBlocks) {
+  IndexFlags indexFlags = (IndexFlags)GetParam();
+  InvertedIndex *idx = NewInvertedIndex(indexFlags, 1);
+  InvertedIndex *packed = NewInvertedIndex((IndexFlags)(indexFlags | Index_BlockPacked), 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(indexFlags);
+  size_t packedWritten = 0;
+  ssize_t resized = 0;
+
+  for (size_t i = 1; i <= 2500; i += 1 + i % 5) {
+    ForwardIndexEntry h = {0};
+    h.docId = i;
+    h.fieldMask = 1 << (i % 3);
+    h.freq = 1 + i % 7;
+    h.vw = NewVarintVectorWriter(8);
+    for (int n = 0; n < i % 4; n++) {
+      VVW_Write(h.vw, n);
+    }
+    VVW_Truncate(h.vw);
+    // sealing blocks is reported apart from the size of the record
+    size_t sz = InvertedIndex_WriteForwardIndexEntry(idx, enc, &h, NULL);
+    ASSERT_EQ(sz, InvertedIndex_WriteForwardIndexEntry(packed, enc, &h, &resized));
+    packedWritten += sz;
+    VVW_Free(h.vw);
+  }
+  ASSERT_EQ(idx->size, packed->size);
+  ASSERT_EQ(idx->lastId, packed->lastId);
+
+  for (t_fieldMask mask : {RS_FIELDMASK_ALL, (t_fieldMask)0x02}) {
+    IndexReader *expected = NewTermIndexReader(idx, NULL, mask, NULL, 1);
+    IndexReader *ir = NewTermIndexReader(packed, NULL, mask, NULL, 1);
+    // packed blocks can only be read by the block decoder
+    ASSERT_TRUE(ir->blockDecoding);
+
+    RSIndexResult *h1 = NULL, *h2 = NULL;
+    int rc;
+    while ((rc = IR_Read(expected, &h1)) != INDEXREAD_EOF) {
+      ASSERT_EQ(rc, IR_Read(ir, &h2));
+      ASSERT_EQ(h1->docId, h2->docId);
+      ASSERT_EQ((uint32_t)h1->fieldMask, (uint32_t)h2->fieldMask);
+      ASSERT_EQ(h1->freq, h2->freq);
+      ASSERT_EQ(h1->term.offsets.len, h2->term.offsets.len);
+      ASSERT_EQ(0, memcmp(h1->term.offsets.data, h2->term.offsets.data, h1->term.offsets.len));
+    }
+    ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &h2));
+
+    IR_Rewind(expected);
+    IR_Rewind(ir);
+    for (t_docId id = 3; id < 2600; id += 29) {
+      int rc1 = IR_SkipTo(expected, id, &h1);
+      ASSERT_EQ(rc1, IR_SkipTo(ir, id, &h2));
+      if (rc1 == INDEXREAD_EOF) break;
+      ASSERT_EQ(h1->docId, h2->docId);
+    }
+
+    IR_Free(expected);
+    IR_Free(ir);
+  }
+
+  // full blocks are only sealed in the packed format if it is smaller
+  size_t bytes = 0, packedBytes = 0;
+  for (uint32_t i = 0; i < idx->size; i++) {
+    bytes += IndexBlock_DataLen(&idx->blocks[i]);
+    packedBytes += IndexBlock_DataLen(&packed->blocks[i]);
+  }
+  ASSERT_LE(packedBytes, bytes + packed->size);
+  ASSERT_EQ(packedBytes, packedWritten + resized);
+
+  InvertedIndex_Free(idx);
+  InvertedIndex_Free(packed);
+}
+
+TEST_P(IndexFlagsTest, testBlockSkips) {
+  IndexFlags indexFlags = (IndexFlags)GetParam();
+  IndexEncoder enc = InvertedIndex_GetEncoder(indexFlags);
+  int oldConfig = RSGlobalConfig.invertedIndexBlockSkips;
+  InvertedIndex *idx[2];
+  for (int withSkips = 0; withSkips < 2; withSkips++) {
+    RSGlobalConfig.invertedIndexBlockSkips = withSkips;
+    idx[withSkips] = NewInvertedIndex(indexFlags, 1);
+    for (size_t i = 1; i <= 5000; i += 1 + i % 3) {
+      ForwardIndexEntry h = {0};
+      h.docId = i;
+      h.fieldMask = 1 << (i % 3);
+      h.freq = 1 + i % 7;
+      h.vw = NewVarintVectorWriter(8);
+      VVW_Write(h.vw, i % 5);
+      VVW_Truncate(h.vw);
+      InvertedIndex_WriteForwardIndexEntry(idx[withSkips], enc, &h, NULL);
+      VVW_Free(h.vw);
+    }
+  }
+  ASSERT_TRUE(idx[0]->blocks[0].skips == NULL);
+  ASSERT_EQ((idx[1]->blocks[0].numEntries - 1) / INDEX_BLOCK_SKIP_INTERVAL,
+            array_len(idx[1]->blocks[0].skips));
+
+  for (t_fieldMask mask : {RS_FIELDMASK_ALL, (t_fieldMask)0x02}) {
+    for (t_docId step : {3, 40, 250}) {
+      IndexReader *expected = NewTermIndexReader(idx[0], NULL, mask, NULL, 1);
+      IndexReader *ir = NewTermIndexReader(idx[1], NULL, mask, NULL, 1);
+      RSIndexResult *h1 = NULL, *h2 = NULL;
+      for (t_docId id = 2; id < 5100; id += step) {
+        int rc = IR_SkipTo(expected, id, &h1);
+        ASSERT_EQ(rc, IR_SkipTo(ir, id, &h2));
+        if (rc == INDEXREAD_EOF) break;
+        ASSERT_EQ(h1->docId, h2->docId);
+        ASSERT_EQ(h1->freq, h2->freq);
+        // reading after a skip continues from the right position
+        rc = IR_Read(expected, &h1);
+        ASSERT_EQ(rc, IR_Read(ir, &h2));
+        if (rc == INDEXREAD_EOF) break;
+        ASSERT_EQ(h1->docId, h2->docId);
+      }
+      IR_Free(expected);
+      IR_Free(ir);
+    }
+  }
+
+  // rebuilding the skip points from the block records gives the same ones the writer recorded
+  IndexBlockSkip *written = array_new(IndexBlockSkip, 8);
+  for (uint32_t i = 0; i < array_len(idx[1]->blocks[0].skips); i++) {
+    written = array_append(written, idx[1]->blocks[0].skips[i]);
+  }
+  IndexBlock_BuildSkips(&idx[1]->blocks[0], idx[1]->flags);
+  ASSERT_EQ(array_len(written), array_len(idx[1]->blocks[0].skips));
+  for (uint32_t i = 0; i < array_len(written); i++) {
+    ASSERT_EQ(written[i].lastId, idx[1]->blocks[0].skips[i].lastId);
+    ASSERT_EQ(written[i].offset, idx[1]->blocks[0].skips[i].offset);
+  }
+  array_free(written);
+
+  RSGlobalConfig.invertedIndexBlockSkips = oldConfig;
+  InvertedIndex_Free(idx[0]);
+  InvertedIndex_Free(idx[1]);
+}
+
+TEST_F(IndexTest, testBitmapBlocks) {
+  const t_docId N = 45000;
+  DocTable dt = NewDocTable(1000, N);
+  char buf[16];
+  for (t_docId i = 1; i <= N; i++) {
+    size_t nkey = sprintf(buf, "doc_%llu", (unsigned long long)i);
+    DMD_Return(DocTable_Put(&dt, buf, nkey, 1, Document_DefaultFlags, NULL, 0, DocumentType_Hash));
+  }
+
+  // a dense range of ids, which is sealed as bitmap blocks, followed by a sparse one
+  InvertedIndex *idx = NewInvertedIndex(Index_DocIdsOnly, 1);
+  InvertedIndex *bitmap = NewInvertedIndex((IndexFlags)(Index_DocIdsOnly | Index_BlockPacked), 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(Index_DocIdsOnly);
+  for (t_docId i = 1; i <= N; i += i < 3000 ? 1 : 37) {
+    if (i % 7 == 3) continue;
+    RSIndexResult rec = {.docId = i, .type = RSResultType_Virtual};
+    InvertedIndex_WriteEntryGeneric(idx, enc, i, &rec, NULL);
+    InvertedIndex_WriteEntryGeneric(bitmap, enc, i, &rec, NULL);
+  }
+  ASSERT_EQ(4, bitmap->size);
+  // the format byte of the blocks: bitmap, bit-packed and staged (see inverted_index.c)
+  ASSERT_EQ(2, IndexBlock_DataBuf(&bitmap->blocks[0])[0]);
+  ASSERT_EQ(2, IndexBlock_DataBuf(&bitmap->blocks[1])[0]);
+  ASSERT_EQ(1, IndexBlock_DataBuf(&bitmap->blocks[2])[0]);
+  ASSERT_EQ(0, IndexBlock_DataBuf(&bitmap->blocks[3])[0]);
+  ASSERT_LT(IndexBlock_DataLen(&bitmap->blocks[0]), IndexBlock_DataLen(&idx->blocks[0]));
+
+  auto compare = [&]() {
+    IndexReader *expected = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+    IndexReader *ir = NewTermIndexReader(bitmap, NULL, RS_FIELDMASK_ALL, NULL, 1);
+    RSIndexResult *h1 = NULL, *h2 = NULL;
+    int rc;
+    while ((rc = IR_Read(expected, &h1)) != INDEXREAD_EOF) {
+      ASSERT_EQ(rc, IR_Read(ir, &h2));
+      ASSERT_EQ(h1->docId, h2->docId);
+    }
+    ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &h2));
+
+    IR_Rewind(expected);
+    IR_Rewind(ir);
+    for (t_docId id = 2; id < N + 100; id += 13) {
+      rc = IR_SkipTo(expected, id, &h1);
+      ASSERT_EQ(rc, IR_SkipTo(ir, id, &h2));
+      if (rc == INDEXREAD_EOF) break;
+      ASSERT_EQ(h1->docId, h2->docId);
+    }
+    IR_Free(expected);
+    IR_Free(ir);
+  };
+  compare();
+
+  // collect the deleted documents, bitmap blocks remain bitmaps
+  for (t_docId i = 5; i <= N; i += 5) {
+    size_t nkey = sprintf(buf, "doc_%llu", (unsigned long long)i);
+    ASSERT_TRUE(DocTable_Delete(&dt, buf, nkey));
+  }
+  for (uint32_t i = 0; i < idx->size; i++) {
+    IndexRepairParams params = {0};
+    int n = IndexBlock_Repair(&idx->blocks[i], &dt, idx->flags, &params);
+    IndexRepairParams bitmapParams = {0};
+    ASSERT_EQ(n, IndexBlock_Repair(&bitmap->blocks[i], &dt, bitmap->flags, &bitmapParams));
+    ASSERT_EQ(idx->blocks[i].numEntries, bitmap->blocks[i].numEntries);
+    ASSERT_EQ(idx->blocks[i].firstId, bitmap->blocks[i].firstId);
+  }
+  ASSERT_EQ(2, IndexBlock_DataBuf(&bitmap->blocks[0])[0]);
+  compare();
+
+  InvertedIndex_Free(idx);
+  InvertedIndex_Free(bitmap);
+  DocTable_Free(&dt);
+}
+
 int printIntersect(void *ctx, RSIndexResult *hits, int argc) {
   printf("intersect: %llu\n", (unsigned long long)hits[0].docId);
   return 0;
@@ -316,6 +639,89 @@ TEST_F(IndexTest, testUnion) {
   RSGlobalConfig.iteratorsConfigParams.minUnionIterHeap = oldConfig;
 }
 
+TEST_F(IndexTest, testUnionBatched) {
+  // many children with different densities, spanning many windows
+  const int n = 40;
+  InvertedIndex *idxs[n];
+  for (int i = 0; i < n; i++) {
+    idxs[i] = createIndex(2000 / (i + 1), 7 * i + 3, i * 13 + 1);
+  }
+  IteratorsConfig config{};
+  iteratorsConfig_init(&config);
+  config.minUnionIterHeap = 20;
+  auto newUnion = [&](long long window, int quickExit) {
+    IndexIterator **irs = (IndexIterator **)calloc(n, sizeof(IndexIterator *));
+    for (int i = 0; i < n; i++) {
+      irs[i] = NewReadIterator(NewTermIndexReader(idxs[i], NULL, RS_FIELDMASK_ALL, NULL, 1));
+    }
+    config.unionBatchWindow = window;
+    return NewUnionIterator(irs, n, NULL, quickExit, 1, QN_UNION, NULL, &config);
+  };
+  // a summary of a result that does not depend on the order of its children
+  auto summary = [](RSIndexResult *h) {
+    std::vector<std::string> ret;
+    for (int i = 0; i < h->agg.numChildren; i++) {
+      RSIndexResult *c = h->agg.children[i];
+      ret.push_back(std::to_string(c->docId) + ":" + std::to_string(c->freq) + ":" +
+                    std::string(c->term.offsets.data, c->term.offsets.len));
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  };
+
+  IndexIterator *heap = newUnion(0, 0);
+  for (long long window : {1, 100, 1000, 65536}) {
+    IndexIterator *ui = newUnion(window, 0);
+    heap->Rewind(heap->ctx);
+    RSIndexResult *h1, *h2;
+    size_t count = 0;
+    while (heap->Read(heap->ctx, &h1) != INDEXREAD_EOF) {
+      ASSERT_EQ(INDEXREAD_OK, ui->Read(ui->ctx, &h2)) << window;
+      ASSERT_EQ(h1->docId, h2->docId) << window;
+      ASSERT_EQ(summary(h1), summary(h2));
+      count++;
+    }
+    ASSERT_EQ(INDEXREAD_EOF, ui->Read(ui->ctx, &h2));
+    ASSERT_EQ(count, ui->Len(ui->ctx));
+
+    // skips, mixed with reads
+    heap->Rewind(heap->ctx);
+    ui->Rewind(ui->ctx);
+    for (t_docId id = 5; ; id += 517) {
+      int rc1 = heap->SkipTo(heap->ctx, id, &h1);
+      int rc2 = ui->SkipTo(ui->ctx, id, &h2);
+      ASSERT_EQ(rc1, rc2) << id;
+      if (rc1 == INDEXREAD_EOF) break;
+      ASSERT_EQ(h1->docId, h2->docId) << id;
+      if (rc1 == INDEXREAD_OK) {
+        ASSERT_EQ(summary(h1), summary(h2));
+      }
+      rc1 = heap->Read(heap->ctx, &h1);
+      rc2 = ui->Read(ui->ctx, &h2);
+      ASSERT_EQ(rc1, rc2) << id;
+      if (rc1 == INDEXREAD_EOF) break;
+      ASSERT_EQ(h1->docId, h2->docId) << id;
+      ASSERT_EQ(summary(h1), summary(h2));
+    }
+    ui->Free(ui);
+
+    // quick exit unions return a single child
+    ui = newUnion(window, 1);
+    heap->Rewind(heap->ctx);
+    while (heap->Read(heap->ctx, &h1) != INDEXREAD_EOF) {
+      ASSERT_EQ(INDEXREAD_OK, ui->Read(ui->ctx, &h2));
+      ASSERT_EQ(h1->docId, h2->docId);
+      ASSERT_EQ(1, h2->agg.numChildren);
+    }
+    ASSERT_EQ(INDEXREAD_EOF, ui->Read(ui->ctx, &h2));
+    ui->Free(ui);
+  }
+  heap->Free(heap);
+  for (int i = 0; i < n; i++) {
+    InvertedIndex_Free(idxs[i]);
+  }
+}
+
 TEST_F(IndexTest, testWeight) {
   InvertedIndex *w = createIndex(10, 1);
   InvertedIndex *w2 = createIndex(10, 2);
@@ -354,6 +760,110 @@ TEST_F(IndexTest, testWeight) {
   InvertedIndex_Free(w2);
 }
 
+// Read the top 10 scores of a union, feeding the threshold the way the sorter does
+static std::vector<std::pair<double, t_docId>> unionTopScores(InvertedIndex **idx, RSQueryTerm **terms,
+                                                              int n, const std::vector<uint32_t> &lens,
+                                                              RSTermScoreBound bound, const RSIndexStats *stats) {
+  IndexIterator **irs = (IndexIterator **)calloc(n, sizeof(IndexIterator *));
+  for (int i = 0; i < n; i++) {
+    RSToken tok = {0};
+    RSQueryTerm *term = NewQueryTerm(&tok, i);
+    term->bm25_idf = terms[i]->bm25_idf;
+    irs[i] = NewReadIterator(NewTermIndexReader(idx[i], NULL, RS_FIELDMASK_ALL, term, 1));
+  }
+  IteratorsConfig config{};
+  iteratorsConfig_init(&config);
+  IndexIterator *ui = NewUnionIterator(irs, n, NULL, 0, 1, QN_UNION, NULL, &config);
+  double threshold = 0;
+  if (bound) {
+    EXPECT_TRUE(UI_EnableScorePruning(ui, &threshold, bound, stats, NULL));
+  }
+
+  std::vector<std::pair<double, t_docId>> top;
+  RSIndexResult *h = NULL;
+  while (ui->Read(ui->ctx, &h) == INDEXREAD_OK) {
+    // BM25STD, as computed by the scorer
+    const float b = 0.5f, k1 = 1.2f;
+    double score = 0;
+    for (int i = 0; i < h->agg.numChildren; i++) {
+      const RSIndexResult *c = h->agg.children[i];
+      double f = c->freq;
+      score += c->term.term->bm25_idf * f * (k1 + 1) /
+               (f + k1 * (1.0f - b + b * (float)lens[c->docId] / stats->avgDocLen));
+    }
+    top.push_back({-score, h->docId});
+    std::sort(top.begin(), top.end());
+    if (top.size() > 10) {
+      top.pop_back();
+    }
+    if (top.size() == 10) {
+      threshold = -top.back().first;
+    }
+  }
+  ui->Free(ui);
+  return top;
+}
+
+TEST_F(IndexTest, testUnionScorePruning) {
+  const int n = 3, numDocs = 20000;
+  const double density[n] = {0.5, 0.1, 0.01};
+  std::mt19937 gen(42);
+  std::vector<uint32_t> lens(numDocs + 1);
+  double totalLen = 0;
+  for (int d = 1; d <= numDocs; d++) {
+    lens[d] = 5 + gen() % 200;
+    totalLen += lens[d];
+  }
+  RSIndexStats stats = {numDocs, n, totalLen / numDocs};
+
+  InvertedIndex *idx[n];
+  RSQueryTerm *terms[n];
+  for (int i = 0; i < n; i++) {
+    idx[i] = NewInvertedIndex((IndexFlags)(INDEX_DEFAULT_FLAGS), 1);
+    IndexEncoder enc = InvertedIndex_GetEncoder(idx[i]->flags);
+    size_t df = 0;
+    for (int d = 1; d <= numDocs; d++) {
+      if (gen() % 1000 >= density[i] * 1000) continue;
+      ForwardIndexEntry h = {0};
+      h.docId = d;
+      h.fieldMask = 1;
+      h.freq = 1 + (gen() % 20 ? gen() % 3 : gen() % 30);
+      h.docLen = lens[d];
+      InvertedIndex_WriteForwardIndexEntry(idx[i], enc, &h, NULL);
+      df++;
+    }
+    RSToken tok = {0};
+    terms[i] = NewQueryTerm(&tok, i);
+    terms[i]->bm25_idf = CalculateIDF_BM25(numDocs, df);
+
+    // the block statistics bound the records of the block
+    IndexReader *ir = NewTermIndexReader(idx[i], NULL, RS_FIELDMASK_ALL, NULL, 1);
+    RSIndexResult *h = NULL;
+    while (IR_Read(ir, &h) == INDEXREAD_OK) {
+      const IndexBlock *blk = &idx[i]->blocks[InvertedIndex_FindBlock(idx[i], 0, h->docId)];
+      ASSERT_LE(blk->firstId, h->docId);
+      ASSERT_LE(h->freq, blk->maxFreq);
+      ASSERT_GE(lens[h->docId], blk->minDocLen);
+    }
+    IR_Free(ir);
+  }
+
+  RSTermScoreBound bound = DefaultScorer_GetTermBound(BM25_STD_SCORER_NAME);
+  ASSERT_TRUE(bound != NULL);
+  auto expected = unionTopScores(idx, terms, n, lens, NULL, &stats);
+  auto pruned = unionTopScores(idx, terms, n, lens, bound, &stats);
+  ASSERT_EQ(expected.size(), pruned.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(expected[i].second, pruned[i].second);
+    ASSERT_DOUBLE_EQ(expected[i].first, pruned[i].first);
+  }
+
+  for (int i = 0; i < n; i++) {
+    Term_Free(terms[i]);
+    InvertedIndex_Free(idx[i]);
+  }
+}
+
 TEST_F(IndexTest, testNot) {
   InvertedIndex *w = createIndex(16, 1);
   // not all numbers that divide by 3
@@ -437,12 +947,61 @@ TEST_F(IndexTest, DISABLED_testOptional) {
   InvertedIndex_Free(w2);
 }
 
+TEST_F(IndexTest, testFilterCache) {
+  FilterCache *cache = NewFilterCache();
+  auto put = [&](const char *key, uint64_t revision, t_docId first, size_t n, size_t maxEntries) {
+    t_docId *ids = (t_docId *)rm_malloc(n * sizeof(t_docId));
+    for (size_t i = 0; i < n; i++) {
+      ids[i] = first + i * 3;
+    }
+    return FilterCache_Put(cache, key, strlen(key), revision, ids, n, maxEntries, 1);
+  };
+  auto open = [&](const char *key, uint64_t revision) {
+    return FilterCache_Open(cache, key, strlen(key), revision, 1);
+  };
+
+  IndexIterator *it = put("a", 1, 10, 100, 2);
+  it->Free(it);
+  ASSERT_TRUE(open("b", 1) == NULL);
+  // entries are served only at the revision they were computed at
+  ASSERT_TRUE(open("a", 2) == NULL);
+  ASSERT_EQ(0, FilterCache_Size(cache));
+
+  IndexIterator *a = put("a", 2, 10, 100, 2);
+  IndexIterator *b = put("b", 2, 20, 50, 2);
+  a->Free(a);
+  a = open("a", 2);
+  ASSERT_TRUE(a != NULL);
+  // "b" is the least recently used entry
+  it = put("c", 2, 30, 10, 2);
+  it->Free(it);
+  ASSERT_EQ(2, FilterCache_Size(cache));
+  ASSERT_TRUE(open("b", 2) == NULL);
+  it = open("c", 2);
+  ASSERT_EQ(10, it->NumEstimated(it->ctx));
+  it->Free(it);
+
+  // open iterators remain valid after their entries are evicted, and after the cache is freed
+  FilterCache_Free(cache);
+  RSIndexResult *r;
+  ASSERT_EQ(INDEXREAD_NOTFOUND, b->SkipTo(b->ctx, 21, &r));
+  ASSERT_EQ(23, r->docId);
+  size_t n = 0;
+  while (a->Read(a->ctx, &r) == INDEXREAD_OK) {
+    ASSERT_EQ(10 + n * 3, r->docId);
+    n++;
+  }
+  ASSERT_EQ(100, n);
+  a->Free(a);
+  b->Free(b);
+}
+
 TEST_F(IndexTest, testNumericInverted) {
 
   InvertedIndex *idx = NewInvertedIndex(Index_StoreNumeric, 1);
 
   for (int i = 0; i < 75; i++) {
-    size_t sz = InvertedIndex_WriteNumericEntry(idx, i + 1, (double)(i + 1));
+    size_t sz = InvertedIndex_WriteNumericEntry(idx, i + 1, (double)(i + 1), NULL);
     // printf("written %zd bytes\n", sz);
 
     ASSERT_TRUE(sz > (i ? 1 : 0)); // first doc has zero delta (not written)
@@ -474,7 +1033,7 @@ TEST_F(IndexTest, testNumericVaried) {
   static const size_t numCount = sizeof(nums) / sizeof(double);
 
   for (size_t i = 0; i < numCount; i++) {
-    size_t sz = InvertedIndex_WriteNumericEntry(idx, i + 1, nums[i]);
+    size_t sz = InvertedIndex_WriteNumericEntry(idx, i + 1, nums[i], NULL);
     ASSERT_GT(sz, (i ? 1 : 0)); // first doc has zero delta (not written)
     // printf("[%lu]: Stored %lf\n", i, nums[i]);
   }
@@ -495,6 +1054,110 @@ TEST_F(IndexTest, testNumericVaried) {
   it->Free(it);
 }
 
+TEST_F(IndexTest, testNumericColumnarBlocks) {
+  const t_docId N = 1000;
+  DocTable dt = NewDocTable(1000, N);
+  char buf[16];
+  for (t_docId i = 1; i <= N; i++) {
+    size_t nkey = sprintf(buf, "doc_%llu", (unsigned long long)i);
+    DMD_Return(DocTable_Put(&dt, buf, nkey, 1, Document_DefaultFlags, NULL, 0, DocumentType_Hash));
+  }
+
+  // ascending integers for the first half of the ids, so whole blocks can be skipped or accepted,
+  // followed by scattered fractions, with a second value for every tenth document
+  InvertedIndex *idx = NewInvertedIndex(Index_StoreNumeric, 1);
+  InvertedIndex *col = NewInvertedIndex((IndexFlags)(Index_StoreNumeric | Index_BlockPacked), 1);
+  for (t_docId i = 1; i <= N; i++) {
+    double value = i <= N / 2 ? i : (double)((i * 37) % 700) - 200.5;
+    InvertedIndex_WriteNumericEntry(idx, i, value, NULL);
+    InvertedIndex_WriteNumericEntry(col, i, value, NULL);
+    if (i % 10 == 0) {
+      double second = i <= N / 2 ? value + 1 : value + 0.25;
+      InvertedIndex_WriteNumericEntry(idx, i, second, NULL);
+      InvertedIndex_WriteNumericEntry(col, i, second, NULL);
+    }
+  }
+  ASSERT_EQ(idx->size, col->size);
+  ASSERT_EQ(idx->numEntries, col->numEntries);
+  // the format byte of the blocks (see inverted_index.c): blocks of integers are columnar, with
+  // their values bit-packed. Blocks of fractions are only sealed as columns if it makes them
+  // smaller, which doubles do not, and the last block is staged
+  ASSERT_EQ(3, IndexBlock_DataBuf(&col->blocks[0])[0]);
+  ASSERT_LT(IndexBlock_DataLen(&col->blocks[0]), IndexBlock_DataLen(&idx->blocks[0]));
+  ASSERT_EQ(0, IndexBlock_DataBuf(&col->blocks[col->size - 2])[0]);
+  ASSERT_EQ(0, IndexBlock_DataBuf(&col->blocks[col->size - 1])[0]);
+  size_t bytes = 0, colBytes = 0;
+  for (uint32_t i = 0; i < idx->size; i++) {
+    bytes += IndexBlock_DataLen(&idx->blocks[i]);
+    colBytes += IndexBlock_DataLen(&col->blocks[i]);
+  }
+  ASSERT_LE(colBytes, bytes + col->size);
+
+  auto compare = [&](const NumericFilter *f, int skipMulti) {
+    IndexReader *expected = NewNumericReader(NULL, idx, f, 0, 0, skipMulti);
+    IndexReader *ir = NewNumericReader(NULL, col, f, 0, 0, skipMulti);
+    RSIndexResult *h1 = NULL, *h2 = NULL;
+    int rc;
+    while ((rc = IR_Read(expected, &h1)) != INDEXREAD_EOF) {
+      ASSERT_EQ(rc, IR_Read(ir, &h2));
+      ASSERT_EQ(h1->docId, h2->docId);
+      ASSERT_EQ(h1->num.value, h2->num.value);
+    }
+    ASSERT_EQ(INDEXREAD_EOF, IR_Read(ir, &h2));
+
+    IR_Rewind(expected);
+    IR_Rewind(ir);
+    for (t_docId id = 2; id < N + 10; id += 7) {
+      rc = IR_SkipTo(expected, id, &h1);
+      ASSERT_EQ(rc, IR_SkipTo(ir, id, &h2));
+      if (rc == INDEXREAD_EOF) break;
+      ASSERT_EQ(h1->docId, h2->docId);
+      ASSERT_EQ(h1->num.value, h2->num.value);
+    }
+    IR_Free(expected);
+    IR_Free(ir);
+  };
+  auto compareAll = [&]() {
+    static const double ranges[][2] = {{-INFINITY, INFINITY}, {100, 300},   {150, 151},
+                                       {-50.5, 40},           {600, 2000},  {-1e9, -1e8}};
+    for (int skipMulti = 0; skipMulti < 2; skipMulti++) {
+      compare(NULL, skipMulti);
+      for (auto &range : ranges) {
+        for (int inclusive = 0; inclusive < 4; inclusive++) {
+          NumericFilter f = {0};
+          f.min = range[0];
+          f.max = range[1];
+          f.inclusiveMin = inclusive & 1;
+          f.inclusiveMax = inclusive & 2;
+          compare(&f, skipMulti);
+        }
+      }
+    }
+  };
+  compareAll();
+
+  // collect the deleted documents, columnar blocks remain columnar
+  for (t_docId i = 5; i <= N; i += 5) {
+    size_t nkey = sprintf(buf, "doc_%llu", (unsigned long long)i);
+    ASSERT_TRUE(DocTable_Delete(&dt, buf, nkey));
+  }
+  for (uint32_t i = 0; i < idx->size; i++) {
+    IndexRepairParams params = {0};
+    int n = IndexBlock_Repair(&idx->blocks[i], &dt, idx->flags, &params);
+    IndexRepairParams colParams = {0};
+    ASSERT_EQ(n, IndexBlock_Repair(&col->blocks[i], &dt, col->flags, &colParams));
+    ASSERT_EQ(params.entriesCollected, colParams.entriesCollected);
+    ASSERT_EQ(idx->blocks[i].numEntries, col->blocks[i].numEntries);
+    ASSERT_EQ(idx->blocks[i].firstId, col->blocks[i].firstId);
+  }
+  ASSERT_EQ(3, IndexBlock_DataBuf(&col->blocks[0])[0]);
+  compareAll();
+
+  InvertedIndex_Free(idx);
+  InvertedIndex_Free(col);
+  DocTable_Free(&dt);
+}
+
 typedef struct {
   double value;
   size_t size;
@@ -536,10 +1199,10 @@ void testNumericEncodingHelper(bool isMulti) {
 
   for (size_t ii = 0; ii < numInfos; ii++) {
     // printf("\n[%lu]: Expecting Val=%lf, Sz=%lu\n", ii, infos[ii].value, infos[ii].size);
-    size_t sz = InvertedIndex_WriteNumericEntry(idx, ii + 1, infos[ii].value);
+    size_t sz = InvertedIndex_WriteNumericEntry(idx, ii + 1, infos[ii].value, NULL);
     ASSERT_EQ(infos[ii].size, sz);
     if (isMulti) {
-      size_t sz = InvertedIndex_WriteNumericEntry(idx, ii + 1, infos[ii].value);
+      size_t sz = InvertedIndex_WriteNumericEntry(idx, ii + 1, infos[ii].value, NULL);
       // in multi mode we do not write the zero delta
       // (first entry has zero delta also for single mode)
       ASSERT_EQ(infos[ii].size - (ii ? 1 : 0), sz);
@@ -624,6 +1287,15 @@ TEST_F(IndexTest, testIntersection) {
 
     ASSERT_TRUE(copy->docId == h->docId);
     ASSERT_TRUE(copy->type == RSResultType_Intersection);
+    ASSERT_EQ(copy->agg.numChildren, h->agg.numChildren);
+    for (int i = 0; i < h->agg.numChildren; i++) {
+      RSIndexResult *cc = copy->agg.children[i], *hc = h->agg.children[i];
+      ASSERT_TRUE(cc != hc);
+      ASSERT_EQ(cc->docId, hc->docId);
+      ASSERT_EQ(cc->term.offsets.len, hc->term.offsets.len);
+      ASSERT_TRUE(cc->term.offsets.data != hc->term.offsets.data);
+      ASSERT_EQ(0, memcmp(cc->term.offsets.data, hc->term.offsets.data, hc->term.offsets.len));
+    }
     ASSERT_EQ((count * 2 + 2) * 2, h->docId);
     ASSERT_EQ(count * 2 + 2, h->freq);
     IndexResult_Free(copy);
@@ -656,6 +1328,80 @@ TEST_F(IndexTest, testIntersection) {
   InvertedIndex_Free(w2);
 }
 
+static InvertedIndex *createIndexOf(const std::vector<t_docId> &ids) {
+  InvertedIndex *idx = NewInvertedIndex((IndexFlags)(INDEX_DEFAULT_FLAGS), 1);
+  IndexEncoder enc = InvertedIndex_GetEncoder(idx->flags);
+  for (t_docId id : ids) {
+    ForwardIndexEntry h = {0};
+    h.docId = id;
+    h.fieldMask = 1;
+    h.freq = 1;
+    h.term = "hello";
+    h.len = 5;
+    h.vw = NewVarintVectorWriter(8);
+    VVW_Write(h.vw, 1);
+    InvertedIndex_WriteForwardIndexEntry(idx, enc, &h, NULL);
+    VVW_Free(h.vw);
+  }
+  return idx;
+}
+
+TEST_F(IndexTest, testIntersectionAdaptiveOrder) {
+  // the selectivity of the children changes along the index: `c` is sparse in the first half and
+  // dense in the second one
+  const t_docId n = 50000;
+  std::vector<t_docId> a, b, c, expected;
+  for (t_docId id = 1; id <= n; id++) {
+    a.push_back(id);
+    if (id % 3 == 0) b.push_back(id);
+    bool inC = id > n / 2 || id % 11 == 0;
+    if (inC) c.push_back(id);
+    if (id % 3 == 0 && inC) expected.push_back(id);
+  }
+  InvertedIndex *idxs[] = {createIndexOf(a), createIndexOf(b), createIndexOf(c)};
+
+  int oldConfig = RSGlobalConfig.adaptiveIntersectOrder;
+  for (int adaptive = 0; adaptive < 2; adaptive++) {
+    RSGlobalConfig.adaptiveIntersectOrder = adaptive;
+    IndexIterator **irs = (IndexIterator **)calloc(3, sizeof(IndexIterator *));
+    for (int i = 0; i < 3; i++) {
+      irs[i] = NewReadIterator(NewTermIndexReader(idxs[i], NULL, RS_FIELDMASK_ALL, NULL, 1));
+    }
+    IndexIterator *ii = NewIntersecIterator(irs, 3, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
+
+    for (int pass = 0; pass < 2; pass++) {
+      RSIndexResult *h = NULL;
+      std::vector<t_docId> found;
+      while (ii->Read(ii->ctx, &h) != INDEXREAD_EOF) {
+        ASSERT_EQ(h->type, RSResultType_Intersection);
+        ASSERT_EQ(3, h->agg.numChildren);
+        found.push_back(h->docId);
+      }
+      ASSERT_EQ(expected, found) << "adaptive " << adaptive << " pass " << pass;
+      // the second pass starts with the order learned by the first one
+      ii->Rewind(ii->ctx);
+    }
+
+    // skips are not affected by the order either
+    RSIndexResult *h = NULL;
+    for (t_docId id = 7; id <= n; id += 997) {
+      auto it = std::lower_bound(expected.begin(), expected.end(), id);
+      int rc = ii->SkipTo(ii->ctx, id, &h);
+      if (it == expected.end()) {
+        ASSERT_EQ(INDEXREAD_EOF, rc);
+        break;
+      }
+      ASSERT_EQ(*it == id ? INDEXREAD_OK : INDEXREAD_NOTFOUND, rc) << id;
+      ASSERT_EQ(*it, h->docId) << id;
+    }
+    ii->Free(ii);
+  }
+  RSGlobalConfig.adaptiveIntersectOrder = oldConfig;
+  for (int i = 0; i < 3; i++) {
+    InvertedIndex_Free(idxs[i]);
+  }
+}
+
 TEST_F(IndexTest, testHybridVector) {
 
   size_t n = 100;
@@ -1289,7 +2035,7 @@ TEST_F(IndexTest, testIndexFlags) {
   InvertedIndex *w = NewInvertedIndex(IndexFlags(flags), 1);
   IndexEncoder enc = InvertedIndex_GetEncoder(w->flags);
   ASSERT_TRUE(w->flags == flags);
-  size_t sz = InvertedIndex_WriteForwardIndexEntry(w, enc, &h);
+  size_t sz = InvertedIndex_WriteForwardIndexEntry(w, enc, &h, NULL);
   // printf("written %zd bytes. Offset=%zd\n", sz, h.vw->buf.offset);
   ASSERT_EQ(15, sz);
   InvertedIndex_Free(w);
@@ -1298,7 +2044,7 @@ TEST_F(IndexTest, testIndexFlags) {
   w = NewInvertedIndex(IndexFlags(flags), 1);
   ASSERT_TRUE(!(w->flags & Index_StoreTermOffsets));
   enc = InvertedIndex_GetEncoder(w->flags);
-  size_t sz2 = InvertedIndex_WriteForwardIndexEntry(w, enc, &h);
+  size_t sz2 = InvertedIndex_WriteForwardIndexEntry(w, enc, &h, NULL);
   // printf("Wrote %zd bytes. Offset=%zd\n", sz2, h.vw->buf.offset);
   ASSERT_EQ(sz2, sz - Buffer_Offset(&h.vw->buf) - 1);
   InvertedIndex_Free(w);
@@ -1308,7 +2054,7 @@ TEST_F(IndexTest, testIndexFlags) {
   ASSERT_TRUE((w->flags & Index_WideSchema));
   enc = InvertedIndex_GetEncoder(w->flags);
   h.fieldMask = 0xffffffffffff;
-  ASSERT_EQ(21, InvertedIndex_WriteForwardIndexEntry(w, enc, &h));
+  ASSERT_EQ(21, InvertedIndex_WriteForwardIndexEntry(w, enc, &h, NULL));
   InvertedIndex_Free(w);
 
   flags |= Index_WideSchema;
@@ -1316,7 +2062,7 @@ TEST_F(IndexTest, testIndexFlags) {
   ASSERT_TRUE((w->flags & Index_WideSchema));
   enc = InvertedIndex_GetEncoder(w->flags);
   h.fieldMask = 0xffffffffffff;
-  sz = InvertedIndex_WriteForwardIndexEntry(w, enc, &h);
+  sz = InvertedIndex_WriteForwardIndexEntry(w, enc, &h, NULL);
   ASSERT_EQ(21, sz);
   InvertedIndex_Free(w);
 
@@ -1325,7 +2071,7 @@ TEST_F(IndexTest, testIndexFlags) {
   ASSERT_TRUE(!(w->flags & Index_StoreTermOffsets));
   ASSERT_TRUE(!(w->flags & Index_StoreFieldFlags));
   enc = InvertedIndex_GetEncoder(w->flags);
-  sz = InvertedIndex_WriteForwardIndexEntry(w, enc, &h);
+  sz = InvertedIndex_WriteForwardIndexEntry(w, enc, &h, NULL);
   ASSERT_EQ(3, sz);
   InvertedIndex_Free(w);
 
@@ -1335,7 +2081,7 @@ TEST_F(IndexTest, testIndexFlags) {
   ASSERT_TRUE((w->flags & Index_StoreFieldFlags));
   enc = InvertedIndex_GetEncoder(w->flags);
   h.fieldMask = 0xffffffffffff;
-  sz = InvertedIndex_WriteForwardIndexEntry(w, enc, &h);
+  sz = InvertedIndex_WriteForwardIndexEntry(w, enc, &h, NULL);
   ASSERT_EQ(10, sz);
   InvertedIndex_Free(w);
 
@@ -1414,6 +2160,51 @@ TEST_F(IndexTest, testDocTable) {
   DocTable_Free(&dt);
 }
 
+TEST_F(IndexTest, testDocTableColumns) {
+  char buf[16];
+  // the columns grow with the buckets, and hold the ids below the max size
+  DocTable dt = NewDocTable(4, 50);
+  int N = 100;
+  for (int i = 0; i < N; i++) {
+    size_t nkey = sprintf(buf, "doc_%d", i);
+    RSDocumentMetadata *dmd = DocTable_Put(&dt, buf, nkey, i / 10.0, Document_DefaultFlags, NULL, 0, DocumentType_Hash);
+    dmd->len = i * 2;
+    DocTable_UpdateColumns(&dt, dmd);
+    DMD_Return(dmd);
+  }
+  ASSERT_FLOAT_EQ((N - 1) / 10.0, dt.maxDocScore);
+
+  for (t_docId id = 1; id <= N; id++) {
+    ASSERT_TRUE(DocTable_Exists(&dt, id));
+    if (id >= 50) {
+      ASSERT_FALSE(DocTable_InColumns(&dt, id));
+      continue;
+    }
+    ASSERT_TRUE(DocTable_InColumns(&dt, id));
+    sprintf(buf, "doc_%d", (int)id - 1);
+    ASSERT_STREQ(buf, dt.cols.keys[id]);
+    ASSERT_FLOAT_EQ((id - 1) / 10.0, dt.cols.scores[id]);
+    ASSERT_EQ((id - 1) * 2, dt.cols.lens[id]);
+  }
+
+  // deleted and renamed documents
+  ASSERT_TRUE(DocTable_Delete(&dt, "doc_4", 5));
+  ASSERT_FALSE(DocTable_InColumns(&dt, 5));
+  ASSERT_FALSE(DocTable_Exists(&dt, 5));
+  ASSERT_TRUE(DocTable_Delete(&dt, "doc_79", 6));
+  ASSERT_FALSE(DocTable_Exists(&dt, 80));
+  ASSERT_EQ(REDISMODULE_OK, DocTable_Replace(&dt, "doc_5", 5, "renamed", 7));
+  ASSERT_STREQ("renamed", dt.cols.keys[6]);
+  sds key = DocTable_GetKey(&dt, 6, NULL);
+  ASSERT_STREQ("renamed", key);
+  sdsfree(key);
+
+  // the max score is not decreased
+  ASSERT_TRUE(DocTable_Delete(&dt, "doc_99", 6));
+  ASSERT_FLOAT_EQ((N - 1) / 10.0, dt.maxDocScore);
+  DocTable_Free(&dt);
+}
+
 TEST_F(IndexTest, testSortable) {
   RSSortingTable *tbl = NewSortingTable();
   RSSortingTable_Add(&tbl, "foo", RSValue_String);
@@ -1512,18 +2303,18 @@ TEST_F(IndexTest, testDeltaSplits) {
   ent.fieldMask = RS_FIELDMASK_ALL;
 
   IndexEncoder enc = InvertedIndex_GetEncoder(idx->flags);
-  InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent);
+  InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent, NULL);
   ASSERT_EQ(idx->size, 1);
 
   ent.docId = 200;
-  InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent);
+  InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent, NULL);
   ASSERT_EQ(idx->size, 1);
 
   ent.docId = 1LLU << 48;
-  InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent);
+  InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent, NULL);
   ASSERT_EQ(idx->size, 2);
   ent.docId++;
-  InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent);
+  InvertedIndex_WriteForwardIndexEntry(idx, enc, &ent, NULL);
   ASSERT_EQ(idx->size, 2);
 
   IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
@@ -6,6 +6,9 @@
 #include "rmutil/alloc.h"
 
 #include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <random>
 
 extern "C" {
 // declaration for an internal function implemented in numeric_index.c
@@ -213,6 +216,169 @@ TEST_F(RangeTest, testRangeIteratorMulti) {
   testRangeIteratorHelper(true);
 }
 
+// The documents of a numeric filter, with their values. Multi-value documents are returned with the
+// value of any of their ranges, so only their ids are compared
+static std::vector<std::pair<t_docId, double>> readNumericTree(NumericRangeTree *t, NumericFilter *flt,
+                                                               bool isMulti) {
+  std::vector<std::pair<t_docId, double>> ret;
+  IteratorsConfig config{};
+  iteratorsConfig_init(&config);
+  IndexIterator *it = createNumericIterator(NULL, t, flt, &config);
+  RSIndexResult *res;
+  while (it && it->Read(it->ctx, &res) != INDEXREAD_EOF) {
+    if (res->type == RSResultType_Union) {
+      res = res->agg.children[0];
+    }
+    ret.push_back({res->docId, isMulti ? 0 : res->num.value});
+  }
+  if (it) {
+    it->Free(it);
+  }
+  return ret;
+}
+
+static void checkNumericNode(NumericRangeNode *n, double min, double max, size_t *leaves) {
+  if (NumericRangeNode_IsLeaf(n)) {
+    ASSERT_TRUE(n->range);
+    ASSERT_EQ(0, n->maxDepth);
+    ASSERT_GE(n->range->minVal, min);
+    ASSERT_LT(n->range->maxVal, max);
+    ++*leaves;
+    return;
+  }
+  ASSERT_LE(abs(n->left->maxDepth - n->right->maxDepth), 1);
+  ASSERT_EQ(n->maxDepth, std::max(n->left->maxDepth, n->right->maxDepth) + 1);
+  checkNumericNode(n->left, min, n->value, leaves);
+  checkNumericNode(n->right, n->value, max, leaves);
+}
+
+TEST_F(RangeTest, testBulkBuild) {
+  for (bool isMulti : {false, true}) {
+    NumericRangeTree *t = NewNumericRangeTree();
+    std::vector<NumericRangeEntry> entries;
+    const size_t N = 100000;
+    for (size_t i = 0; i < N; i++) {
+      // many duplicates, and a value shared by a large part of the documents
+      double value = i % 5 == 0 ? 42 : (double)(prng() % 30000) / 4 - 1000;
+      NumericRangeTree_Add(t, i + 1, value, isMulti);
+      entries.push_back({i + 1, value});
+      if (isMulti && i % 4 == 0) {
+        NumericRangeTree_Add(t, i + 1, value + 1, isMulti);
+        entries.push_back({i + 1, value + 1});
+      }
+    }
+    std::shuffle(entries.begin(), entries.end(), std::mt19937(isMulti));
+    NumericRangeTree *bulk = NewNumericRangeTreeFromEntries(entries.data(), entries.size());
+    ASSERT_EQ(t->numEntries, bulk->numEntries);
+    ASSERT_EQ(t->lastDocId, bulk->lastDocId);
+    size_t leaves = 0;
+    checkNumericNode(bulk->root, -INFINITY, INFINITY, &leaves);
+    ASSERT_EQ(leaves, bulk->numRanges);
+
+    double ranges[][2] = {{-INFINITY, INFINITY}, {-500, 3000}, {42, 42}, {41.5, 43.25}, {6000, 6500}};
+    for (auto &range : ranges) {
+      NumericFilter *flt = NewNumericFilter(range[0], range[1], 1, 1, true);
+      auto expected = readNumericTree(t, flt, isMulti);
+      ASSERT_EQ(expected, readNumericTree(bulk, flt, isMulti));
+      NumericFilter_Free(flt);
+    }
+
+    // rebuilding gives the same tree, under a new identity
+    uint32_t revisionId = bulk->revisionId;
+    uint32_t uniqueId = bulk->uniqueId;
+    NumericRangeTree_Rebuild(t);
+    ASSERT_EQ(bulk->numRanges, t->numRanges);
+    ASSERT_EQ(bulk->numEntries, t->numEntries);
+    leaves = 0;
+    checkNumericNode(t->root, -INFINITY, INFINITY, &leaves);
+    NumericRangeTree_Rebuild(bulk);
+    ASSERT_NE(revisionId, bulk->revisionId);
+    ASSERT_NE(uniqueId, bulk->uniqueId);
+    for (auto &range : ranges) {
+      NumericFilter *flt = NewNumericFilter(range[0], range[1], 1, 1, true);
+      ASSERT_EQ(readNumericTree(t, flt, isMulti), readNumericTree(bulk, flt, isMulti));
+      NumericFilter_Free(flt);
+    }
+
+    // new entries split the leaves as usual
+    for (size_t i = N; i < 2 * N; i++) {
+      NumericRangeTree_Add(bulk, i + 1, (double)(prng() % 30000) / 4, isMulti);
+    }
+    ASSERT_EQ(bulk->numEntries, t->numEntries + N);
+    ASSERT_GT(bulk->numRanges, t->numRanges);
+    NumericRangeTree_Free(t);
+    NumericRangeTree_Free(bulk);
+  }
+
+  NumericRangeTree *empty = NewNumericRangeTreeFromEntries(NULL, 0);
+  ASSERT_EQ(1, empty->numRanges);
+  NumericRangeTree_Rebuild(empty);
+  ASSERT_EQ(1, empty->numRanges);
+  ASSERT_EQ(0, empty->numEntries);
+  NumericRangeTree_Free(empty);
+}
+
+TEST_F(RangeTest, testNumericMerge) {
+  for (bool isMulti : {false, true}) {
+    NumericRangeTree *t = NewNumericRangeTree();
+    const size_t N = 100000;
+    for (size_t i = 0; i < N; i++) {
+      NumericRangeTree_Add(t, i + 1, (double)(1 + prng() % (N / 5)), isMulti);
+      if (isMulti && i % 3 == 0) {
+        NumericRangeTree_Add(t, i + 1, (double)(1 + prng() % (N / 5)), isMulti);
+      }
+    }
+
+    IteratorsConfig config{};
+    iteratorsConfig_init(&config);
+    IteratorsConfig mergeConfig = config;
+    mergeConfig.numericMergeMinRanges = 2;
+    double ranges[][2] = {{-INFINITY, INFINITY}, {0, 3000}, {1000, 13000}, {19500, 20000}, {50, 51}};
+    for (auto &range : ranges) {
+      NumericFilter *flt = NewNumericFilter(range[0], range[1], 1, 0, true);
+      IndexIterator *heap = createNumericIterator(NULL, t, flt, &config);
+      IndexIterator *merge = createNumericIterator(NULL, t, flt, &mergeConfig);
+      ASSERT_EQ(heap->NumEstimated(heap->ctx), merge->NumEstimated(merge->ctx));
+
+      RSIndexResult *h1, *h2;
+      size_t count = 0;
+      while (heap->Read(heap->ctx, &h1) != INDEXREAD_EOF) {
+        ASSERT_EQ(INDEXREAD_OK, merge->Read(merge->ctx, &h2));
+        ASSERT_EQ(h1->docId, h2->docId);
+        RSIndexResult *child = h2->type == RSResultType_Union ? h2->agg.children[0] : h2;
+        ASSERT_EQ(RSResultType_Numeric, child->type);
+        ASSERT_EQ(h2->docId, child->docId);
+        ASSERT_TRUE(NumericFilter_Match(flt, child->num.value));
+        if (!isMulti) {
+          // a single value, so the ranges of the two iterators agree on it
+          RSIndexResult *expected = h1->type == RSResultType_Union ? h1->agg.children[0] : h1;
+          ASSERT_EQ(expected->num.value, child->num.value);
+        }
+        count++;
+      }
+      ASSERT_EQ(INDEXREAD_EOF, merge->Read(merge->ctx, &h2));
+      ASSERT_EQ(count, merge->Len(merge->ctx));
+
+      heap->Rewind(heap->ctx);
+      merge->Rewind(merge->ctx);
+      for (t_docId id = 3; ; id += 1021) {
+        int rc = heap->SkipTo(heap->ctx, id, &h1);
+        ASSERT_EQ(rc, merge->SkipTo(merge->ctx, id, &h2)) << id;
+        if (rc == INDEXREAD_EOF) break;
+        ASSERT_EQ(h1->docId, h2->docId);
+        rc = heap->Read(heap->ctx, &h1);
+        ASSERT_EQ(rc, merge->Read(merge->ctx, &h2)) << id;
+        if (rc == INDEXREAD_EOF) break;
+        ASSERT_EQ(h1->docId, h2->docId);
+      }
+      heap->Free(heap);
+      merge->Free(merge);
+      NumericFilter_Free(flt);
+    }
+    NumericRangeTree_Free(t);
+  }
+}
+
 // int benchmarkNumericRangeTree() {
 //   NumericRangeTree *t = NewNumericRangeTree();
 //   int count = 1;
@@ -17,11 +17,11 @@ TEST_F(TagIndexTest, testCreate) {
   // }
   size_t totalSZ = 0;
   for (t_docId d = 1; d <= N; d++) {
-    size_t sz = TagIndex_Index(idx, &v[0], v.size(), d);
+    size_t sz = TagIndex_Index(idx, &v[0], v.size(), d, NULL);
     ASSERT_GT(sz, 0);
     totalSZ += sz;
     // make sure repeating push of the same vector doesn't get indexed
-    sz = TagIndex_Index(idx, &v[0], v.size(), d);
+    sz = TagIndex_Index(idx, &v[0], v.size(), d, NULL);
     ASSERT_EQ(0, sz);
   }
 
@@ -722,6 +722,57 @@ def testPrefix(env):
         env.expect('ft.search', 'idx', 'const* -term*', 'nocontent').equal([0])
         env.expect('ft.search', 'idx', 'constant term9*', 'nocontent').equal([0])
 
+@skip(cluster=True)
+def testPrefixBatchedUnion(env):
+    # unions of many expansions read their children in windows of docIds when _UNION_BATCH_WINDOW
+    # is set. Results must not change
+    conn = getConnectionByEnv(env)
+    env.expect('ft.create', 'idx', 'ON', 'HASH', 'schema', 'foo', 'text', 'n', 'numeric').ok()
+    N = 3000
+    for i in range(N):
+        conn.execute_command('hset', 'doc%d' % i, 'foo', 'term%d term%d' % (i % 97, i % 13), 'n', i % 500)
+
+    queries = [['term*'], ['term1*'], ['term* term5*'], ['@n:[10 400]'], ['term3* @n:[100 200]'],
+               ['term*', 'SORTBY', 'n'], ['-term9*']]
+    for _ in env.reloadingIterator():
+        waitForIndex(env, 'idx')
+        env.expect('ft.config', 'set', '_UNION_BATCH_WINDOW', 0).ok()
+        expected = [env.cmd('ft.search', 'idx', *q, 'WITHSCORES', 'NOCONTENT', 'LIMIT', 0, N) for q in queries]
+        for window in [64, 1000, 65536]:
+            env.expect('ft.config', 'set', '_UNION_BATCH_WINDOW', window).ok()
+            for q, res in zip(queries, expected):
+                env.assertEqual(env.cmd('ft.search', 'idx', *q, 'WITHSCORES', 'NOCONTENT', 'LIMIT', 0, N), res,
+                                message='%s window %d' % (q, window))
+        env.expect('ft.config', 'set', '_UNION_BATCH_WINDOW', 0).ok()
+
+def testFilterCache(env):
+    # tag and numeric filters are served from the cache when _FILTER_CACHE_SIZE is set, until
+    # documents are added or deleted
+    conn = getConnectionByEnv(env)
+    env.expect('ft.create', 'idx', 'ON', 'HASH', 'schema', 'foo', 'text', 't', 'tag', 'n', 'numeric').ok()
+    N = 1000
+    for i in range(N):
+        conn.execute_command('hset', 'doc%d' % i, 'foo', 'hello world', 't', 'tenant%d' % (i % 7), 'n', i % 100)
+
+    queries = [['@t:{tenant1}'], ['@t:{TENANT1 | tenant2}'], ['@t:{tenant2|tenant1} @n:[10 50]'],
+               ['hello @n:[(10 50]'], ['-@t:{tenant3}'], ['@n:[90 +inf] | @t:{tenant4}']]
+    def search(q):
+        return env.cmd('ft.search', 'idx', *q, 'NOCONTENT', 'SORTBY', 'n', 'LIMIT', 0, N)
+
+    waitForIndex(env, 'idx')
+    expected = [search(q) for q in queries]
+    env.expect('ft.config', 'set', '_FILTER_CACHE_SIZE', 4).ok()
+    for _ in range(2):
+        for q, res in zip(queries, expected):
+            env.assertEqual(search(q), res, message=q)
+
+    # results are not served from stale entries
+    conn.execute_command('hset', 'new', 'foo', 'hello', 't', 'tenant1', 'n', 1000)
+    conn.execute_command('del', 'doc1', 'doc8')
+    env.expect('ft.search', 'idx', '@t:{tenant1} @n:[1000 1000]', 'NOCONTENT').equal([1, 'new'])
+    env.expect('ft.search', 'idx', '@t:{tenant1}', 'LIMIT', 0, 0).equal([143 + 1 - 2])
+    env.expect('ft.config', 'set', '_FILTER_CACHE_SIZE', 0).ok()
+
 def testPrefixNodeCaseSensitive(env):
 
     conn = getConnectionByEnv(env)
@@ -1363,6 +1414,90 @@ def testExpander(env):
     env.assertEqual(2, len(res))
     env.assertEqual(1, res[0])
 
+@skip(cluster=True)
+def testNumericColumnarBlocks(env):
+    # numeric ranges created with _NUMERIC_COLUMNAR_BLOCKS return the same results as regular ones
+    conn = getConnectionByEnv(env)
+    conn.execute_command('FT.CONFIG', 'SET', 'FORK_GC_CLEAN_THRESHOLD', '0')
+    N = 3000
+    def add(prefix):
+        for i in range(N):
+            conn.execute_command('HSET', '%s%d' % (prefix, i), 'n', i if i < N / 2 else (i * 37) % 1000 - 300.5,
+                                 'g', '%f,%f' % (-10 + (i % 100) * 0.2, 20 + (i % 37) * 0.1))
+    env.expect('FT.CREATE', 'plain', 'PREFIX', 1, 'a:', 'SCHEMA', 'n', 'NUMERIC', 'g', 'GEO').ok()
+    add('a:')
+    env.expect('FT.CONFIG', 'SET', '_NUMERIC_COLUMNAR_BLOCKS', 'true').ok()
+    env.expect('FT.CREATE', 'col', 'PREFIX', 1, 'b:', 'SCHEMA', 'n', 'NUMERIC', 'g', 'GEO').ok()
+    add('b:')
+
+    queries = ['@n:[100 200]', '@n:[(100 (200]', '@n:[-inf 0]', '@n:[2000 +inf]', '@n:[-300.5 -300.5]',
+               '@n:[500 700] @g:[-5 21 300 km]', '@g:[0 22 100 km]']
+    def check():
+        for q in queries:
+            plain = env.cmd('FT.SEARCH', 'plain', q, 'NOCONTENT', 'SORTBY', 'n', 'LIMIT', 0, N)
+            col = env.cmd('FT.SEARCH', 'col', q, 'NOCONTENT', 'SORTBY', 'n', 'LIMIT', 0, N)
+            env.assertEqual(col, [plain[0]] + [k.replace('a:', 'b:') for k in plain[1:]], message=q)
+    check()
+
+    for i in range(0, N, 3):
+        conn.execute_command('DEL', 'a:%d' % i, 'b:%d' % i)
+    forceInvokeGC(env, 'plain')
+    forceInvokeGC(env, 'col')
+    check()
+    env.expect('FT.CONFIG', 'SET', '_NUMERIC_COLUMNAR_BLOCKS', 'false').ok()
+
+@skip(cluster=True)
+def testNumericColumnarBlocksGC(env):
+    # sealing columnar blocks changes their size. The index sizes must stay consistent with it so
+    # the GC can trim the ranges it empties
+    conn = getConnectionByEnv(env)
+    conn.execute_command('FT.CONFIG', 'SET', 'FORK_GC_CLEAN_THRESHOLD', '0')
+    env.expect('FT.CONFIG', 'SET', '_NUMERIC_COLUMNAR_BLOCKS', 'true').ok()
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC').ok()
+    N = 10000
+    for i in range(N):
+        conn.execute_command('HSET', 'doc%d' % i, 'n', i)
+    before = numeric_tree_summary(env, 'idx', 'n')
+    size_before = get_redisearch_index_memory(env, 'idx')
+
+    for i in range(N // 2, N):
+        conn.execute_command('DEL', 'doc%d' % i)
+    forceInvokeGC(env, 'idx')
+    after = numeric_tree_summary(env, 'idx', 'n')
+    env.assertEqual(after['numEntries'], N // 2)
+    env.assertEqual(after['emptyLeaves'], 0)
+    env.assertLess(after['numRanges'], before['numRanges'])
+    env.assertLess(get_redisearch_index_memory(env, 'idx'), size_before)
+    env.expect('FT.SEARCH', 'idx', '@n:[-inf +inf]', 'LIMIT', 0, 0).equal([N // 2])
+
+    for i in range(N // 2):
+        conn.execute_command('DEL', 'doc%d' % i)
+    forceInvokeGC(env, 'idx')
+    env.assertLess(get_redisearch_index_memory(env, 'idx'), size_before)
+    env.assertEqual(numeric_tree_summary(env, 'idx', 'n')['numEntries'], 0)
+    env.expect('FT.CONFIG', 'SET', '_NUMERIC_COLUMNAR_BLOCKS', 'false').ok()
+
+@skip(cluster=True)
+def testNumericMerge(env):
+    # filters over many numeric ranges merge them through a bitmap when _NUMERIC_MERGE_MIN_RANGES is
+    # set. Results must not change
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE', 't', 'TAG').ok()
+    N = 20000
+    for i in range(N):
+        conn.execute_command('HSET', 'doc%d' % i, 'n', (i * 7919) % 5000, 't', 'even' if i % 2 == 0 else 'odd')
+
+    queries = ['@n:[-inf +inf]', '@n:[100 (4000]', '@n:[(2500 2600]', '@n:[1000 3000] @t:{odd}',
+               '@n:[0 10] | @n:[4000 4500]', '-@n:[200 4800]']
+    def run():
+        return [env.cmd('FT.SEARCH', 'idx', q, 'NOCONTENT', 'SORTBY', 'n', 'LIMIT', 0, N) for q in queries] + \
+               [env.cmd('FT.AGGREGATE', 'idx', '@n:[100 4900]', 'LOAD', 1, '@n', 'SORTBY', 2, '@n', 'ASC',
+                        'LIMIT', 0, 100)]
+    expected = run()
+    env.expect('FT.CONFIG', 'SET', '_NUMERIC_MERGE_MIN_RANGES', '2').ok()
+    env.assertEqual(run(), expected)
+    env.expect('FT.CONFIG', 'SET', '_NUMERIC_MERGE_MIN_RANGES', '0').ok()
+
 def testNumericRange(env):
     env.expect('ft.create', 'idx', 'ON', 'HASH', 'schema', 'title', 'text', 'score', 'numeric', 'price', 'numeric').ok()
 
@@ -1668,8 +1803,8 @@ def _test_create_options_real(env, *options):
 
 def testCreationOptions(env):
     from itertools import combinations
-    for x in range(1, 5):
-        for combo in combinations(('NOOFFSETS', 'NOFREQS', 'NOFIELDS', ''), x):
+    for x in range(1, 6):
+        for combo in combinations(('NOOFFSETS', 'NOFREQS', 'NOFIELDS', 'PACKED', ''), x):
             _test_create_options_real(env, *combo)
 
     env.expect('ft.create', 'idx').error()
@@ -56,6 +56,17 @@ def testGetConfigOptions(env):
     check_config('_FREE_RESOURCE_ON_THREAD')
     check_config('BG_INDEX_SLEEP_GAP')
     check_config('_PRIORITIZE_INTERSECT_UNION_CHILDREN')
+    check_config('_BLOCK_DECODING')
+    check_config('_BLOCK_SKIPS')
+    check_config('_ADAPTIVE_INTERSECT_ORDER')
+    check_config('_UNION_BATCH_WINDOW')
+    check_config('_TAG_BITMAP_BLOCKS')
+    check_config('_FILTER_CACHE_SIZE')
+    check_config('_NUMERIC_COLUMNAR_BLOCKS')
+    check_config('_NUMERIC_MERGE_MIN_RANGES')
+    check_config('_NUMERIC_ORDERED_SCAN')
+    check_config('_HYBRID_ADAPTIVE_POLICY')
+    check_config('_HYBRID_PREFILTER_BITMAP')
 
 '''
 
@@ -128,6 +139,17 @@ def testAllConfig(env):
     env.assertEqual(res_dict['FORK_GC_CLEAN_NUMERIC_EMPTY_NODES'][0], 'true')
     env.assertEqual(res_dict['_FORK_GC_CLEAN_NUMERIC_EMPTY_NODES'][0], 'true')
     env.assertEqual(res_dict['_PRIORITIZE_INTERSECT_UNION_CHILDREN'][0], 'false')
+    env.assertEqual(res_dict['_BLOCK_DECODING'][0], 'false')
+    env.assertEqual(res_dict['_BLOCK_SKIPS'][0], 'false')
+    env.assertEqual(res_dict['_ADAPTIVE_INTERSECT_ORDER'][0], 'false')
+    env.assertEqual(res_dict['_UNION_BATCH_WINDOW'][0], '0')
+    env.assertEqual(res_dict['_TAG_BITMAP_BLOCKS'][0], 'false')
+    env.assertEqual(res_dict['_FILTER_CACHE_SIZE'][0], '0')
+    env.assertEqual(res_dict['_NUMERIC_COLUMNAR_BLOCKS'][0], 'false')
+    env.assertEqual(res_dict['_NUMERIC_MERGE_MIN_RANGES'][0], '0')
+    env.assertEqual(res_dict['_NUMERIC_ORDERED_SCAN'][0], 'false')
+    env.assertEqual(res_dict['_HYBRID_ADAPTIVE_POLICY'][0], 'false')
+    env.assertEqual(res_dict['_HYBRID_PREFILTER_BITMAP'][0], 'false')
     env.assertEqual(res_dict['_FREE_RESOURCE_ON_THREAD'][0], 'true')
     env.assertEqual(res_dict['BG_INDEX_SLEEP_GAP'][0], '100')
 
@@ -205,6 +227,25 @@ def testInitConfig():
     test_arg_str('_FREE_RESOURCE_ON_THREAD', 'true', 'true')
     test_arg_str('_PRIORITIZE_INTERSECT_UNION_CHILDREN', 'true', 'true')
     test_arg_str('_PRIORITIZE_INTERSECT_UNION_CHILDREN', 'false', 'false')
+    test_arg_str('_BLOCK_DECODING', 'true', 'true')
+    test_arg_str('_BLOCK_DECODING', 'false', 'false')
+    test_arg_str('_BLOCK_SKIPS', 'true', 'true')
+    test_arg_str('_BLOCK_SKIPS', 'false', 'false')
+    test_arg_str('_ADAPTIVE_INTERSECT_ORDER', 'true', 'true')
+    test_arg_str('_ADAPTIVE_INTERSECT_ORDER', 'false', 'false')
+    test_arg_num('_UNION_BATCH_WINDOW', 65536)
+    test_arg_str('_TAG_BITMAP_BLOCKS', 'true', 'true')
+    test_arg_str('_TAG_BITMAP_BLOCKS', 'false', 'false')
+    test_arg_num('_FILTER_CACHE_SIZE', 64)
+    test_arg_str('_NUMERIC_COLUMNAR_BLOCKS', 'true', 'true')
+    test_arg_str('_NUMERIC_COLUMNAR_BLOCKS', 'false', 'false')
+    test_arg_num('_NUMERIC_MERGE_MIN_RANGES', 8)
+    test_arg_str('_NUMERIC_ORDERED_SCAN', 'true', 'true')
+    test_arg_str('_NUMERIC_ORDERED_SCAN', 'false', 'false')
+    test_arg_str('_HYBRID_ADAPTIVE_POLICY', 'true', 'true')
+    test_arg_str('_HYBRID_ADAPTIVE_POLICY', 'false', 'false')
+    test_arg_str('_HYBRID_PREFILTER_BITMAP', 'true', 'true')
+    test_arg_str('_HYBRID_PREFILTER_BITMAP', 'false', 'false')
 
 @skip(cluster=True)
 def testImmutable(env):
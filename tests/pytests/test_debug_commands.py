@@ -1,6 +1,6 @@
 from RLTest import Env
 from includes import *
-from common import waitForIndex, getWorkersThpoolStats, create_np_array_typed, TimeLimit
+from common import waitForIndex, getWorkersThpoolStats, create_np_array_typed, TimeLimit, to_dict, forceInvokeGC, index_info
 
 class TestDebugCommands(object):
 
@@ -29,7 +29,7 @@ class TestDebugCommands(object):
         help_list = ['DUMP_INVIDX', 'DUMP_NUMIDX', 'DUMP_NUMIDXTREE', 'DUMP_TAGIDX', 'INFO_TAGIDX', 'DUMP_GEOMIDX',
                      'DUMP_PREFIX_TRIE', 'IDTODOCID', 'DOCIDTOID', 'DOCINFO', 'DUMP_PHONETIC_HASH', 'DUMP_SUFFIX_TRIE',
                      'DUMP_TERMS', 'INVIDX_SUMMARY', 'NUMIDX_SUMMARY', 'GC_FORCEINVOKE', 'GC_FORCEBGINVOKE', 'GC_CLEAN_NUMERIC',
-                     'GC_STOP_SCHEDULE', 'GC_CONTINUE_SCHEDULE', 'GC_WAIT_FOR_JOBS', 'GIT_SHA', 'TTL', 'TTL_PAUSE',
+                     'NUMIDX_REBUILD', 'COMPACT_DOCIDS', 'GC_STOP_SCHEDULE', 'GC_CONTINUE_SCHEDULE', 'GC_WAIT_FOR_JOBS', 'GIT_SHA', 'TTL', 'TTL_PAUSE',
                      'TTL_EXPIRE', 'VECSIM_INFO', 'DELETE_LOCAL_CURSORS']
         if MT_BUILD:
             help_list.append('WORKER_THREADS')
@@ -187,6 +187,45 @@ class TestDebugCommands(object):
     def testNumericIndexSummaryWrongArity(self):
         self.env.expect('FT.DEBUG', 'numidx_summary', 'idx1').error()
 
+    def testNumericIndexRebuild(self):
+        env = self.env
+        env.expect('FT.CREATE', 'idx_rebuild', 'PREFIX', 1, 'rebuild:', 'SCHEMA', 'n', 'NUMERIC').ok()
+        waitForIndex(env, 'idx_rebuild')
+        for i in range(2000):
+            env.cmd('HSET', 'rebuild:%d' % i, 'n', i % 700)
+        for i in range(0, 2000, 3):
+            env.cmd('DEL', 'rebuild:%d' % i)
+        forceInvokeGC(env, 'idx_rebuild')
+
+        queries = ['@n:[-inf +inf]', '@n:[0 99]', '@n:[350 (351]', '@n:[650 +inf]']
+        expected = [env.cmd('FT.SEARCH', 'idx_rebuild', q, 'NOCONTENT', 'LIMIT', 0, 0)[0] for q in queries]
+        before = to_dict(env.cmd('FT.DEBUG', 'NUMIDX_SUMMARY', 'idx_rebuild', 'n'))
+
+        env.expect('FT.DEBUG', 'NUMIDX_REBUILD', 'idx_rebuild', 'n').ok()
+        after = to_dict(env.cmd('FT.DEBUG', 'NUMIDX_SUMMARY', 'idx_rebuild', 'n'))
+        env.assertEqual(after['numEntries'], before['numEntries'])
+        env.assertEqual(after['emptyLeaves'], 0)
+        env.assertGreater(after['revisionId'], before['revisionId'])
+        # the index stats follow the records of the rebuilt tree
+        info = index_info(env, 'idx_rebuild')
+        env.assertGreaterEqual(int(info['num_records']), after['numEntries'])
+        env.assertGreater(float(info['inverted_sz_mb']), 0)
+        for q, count in zip(queries, expected):
+            env.expect('FT.SEARCH', 'idx_rebuild', q, 'NOCONTENT', 'LIMIT', 0, 0).equal([count])
+
+        # the rebuilt tree keeps accepting updates
+        env.cmd('HSET', 'rebuild:0', 'n', 10000)
+        env.expect('FT.SEARCH', 'idx_rebuild', '@n:[10000 10000]', 'NOCONTENT').equal([1, 'rebuild:0'])
+
+        env.expect('FT.DEBUG', 'NUMIDX_REBUILD', 'idx_rebuild', 'no_field').error()
+        env.expect('FT.DEBUG', 'NUMIDX_REBUILD', 'no_idx', 'n').error()
+        env.cmd('FT.DROPINDEX', 'idx_rebuild', 'DD')
+
+    def testCompactDocIdsVectorIndex(self):
+        # vector indexes can not renumber their vectors
+        self.env.expect('FT.DEBUG', 'COMPACT_DOCIDS', 'idx').error().contains('vector fields')
+        self.env.expect('FT.DEBUG', 'DOCIDTOID', 'idx', 'doc1').equal(1)
+
     def testDumpSuffixWrongArity(self):
         self.env.expect('FT.DEBUG', 'DUMP_SUFFIX_TRIE', 'idx1', 'no_suffix').error()
 
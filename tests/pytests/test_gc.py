@@ -28,6 +28,55 @@ def testBasicGC(env):
     env.assertEqual(env.cmd('ft.debug', 'DUMP_NUMIDX', 'idx', 'id'), [[int(i) for i in range(2, 102)]])
     env.assertEqual(env.cmd('ft.debug', 'DUMP_TAGIDX', 'idx', 't'), [['tag1', [int(i) for i in range(2, 102)]]])
 
+@skip(cluster=True)
+def testPackedIndexGC(env):
+    env.expect('ft.config', 'set', 'FORK_GC_CLEAN_THRESHOLD', 0).equal('OK')
+    env.assertOk(env.cmd('ft.create', 'idx', 'ON', 'HASH', 'PACKED', 'schema', 'title', 'text'))
+    waitForIndex(env, 'idx')
+    # enough documents to seal (pack) a few full blocks
+    for i in range(350):
+        env.assertOk(env.cmd('ft.add', 'idx', 'doc%d' % i, 1.0, 'fields',
+                             'title', 'hello world'))
+
+    env.assertEqual(env.cmd('ft.debug', 'DUMP_INVIDX', 'idx', 'world'), [int(i) for i in range(1, 351)])
+
+    for i in range(0, 350, 3):
+        env.assertEqual(env.cmd('ft.del', 'idx', 'doc%d' % i), 1)
+
+    forceInvokeGC(env, 'idx')
+
+    expected = [int(i) for i in range(1, 351) if (i - 1) % 3]
+    env.assertEqual(env.cmd('ft.debug', 'DUMP_INVIDX', 'idx', 'world'), expected)
+    # term indexes are rebuilt by scanning the keyspace on reload, so only the results are kept
+    for _ in env.reloadingIterator():
+        waitForIndex(env, 'idx')
+        env.assertEqual(env.cmd('ft.search', 'idx', 'hello world', 'NOCONTENT', 'LIMIT', 0, 0)[0], len(expected))
+
+@skip(cluster=True)
+def testGCWithBlockSkips(env):
+    env.expect('ft.config', 'set', 'FORK_GC_CLEAN_THRESHOLD', 0).equal('OK')
+    env.expect('ft.config', 'set', '_BLOCK_SKIPS', 'true').equal('OK')
+    env.assertOk(env.cmd('ft.create', 'idx', 'ON', 'HASH', 'schema', 'title', 'text', 'id', 'numeric'))
+    waitForIndex(env, 'idx')
+    for i in range(300):
+        title = 'hello world' if i % 50 else 'hello rare'
+        env.assertOk(env.cmd('ft.add', 'idx', 'doc%d' % i, 1.0, 'fields', 'title', title, 'id', i))
+
+    for i in range(0, 300, 7):
+        env.assertEqual(env.cmd('ft.del', 'idx', 'doc%d' % i), 1)
+
+    forceInvokeGC(env, 'idx')
+
+    # intersecting a rare term with a common one skips inside the blocks of the common term
+    expected = ['doc%d' % i for i in range(300) if i % 50 == 0 and i % 7]
+    for _ in env.reloadingIterator():
+        waitForIndex(env, 'idx')
+        res = env.cmd('ft.search', 'idx', 'hello rare', 'NOCONTENT', 'SORTBY', 'id')
+        env.assertEqual(res[1:], expected)
+        res = env.cmd('ft.search', 'idx', 'hello rare @id:[100 300]', 'NOCONTENT', 'SORTBY', 'id')
+        env.assertEqual(res[1:], [d for d in expected if int(d[3:]) >= 100])
+    env.expect('ft.config', 'set', '_BLOCK_SKIPS', 'false').equal('OK')
+
 @skip(cluster=True)
 def testBasicGCWithEmptyInvIdx(env):
     if env.moduleArgs is not None and 'GC_POLICY LEGACY' in env.moduleArgs:
@@ -277,3 +326,80 @@ def testAutoMemory_MOD_3951():
     env.expect('FT.ALTER', 'idx', 'SCHEMA', 'ADD', '2nd', 'TEXT').equal('OK')
 
     # This test should catch some leaks on the sanitizer
+
+@skip(cluster=True)
+def testCompactDocIds(env):
+    env.expect('ft.config', 'set', 'FORK_GC_CLEAN_THRESHOLD', 0).equal('OK')
+    env.expect('ft.config', 'set', '_FORK_GC_COMPACT_DOCIDS_RATIO', 2).equal('OK')
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE',
+               'tag', 'TAG', 'g', 'GEOSHAPE', 'FLAT').ok()
+    waitForIndex(env, 'idx')
+
+    def add(i):
+        conn.execute_command('HSET', 'doc%d' % i, 't', 'hello world%d' % (i % 3), 'n', i,
+                             'tag', 'tag%d' % (i % 4), 'g', 'POINT(%d %d)' % (i, i))
+
+    for i in range(200):
+        add(i)
+    # a cursor paused over the old ids
+    _, cursor = env.cmd('FT.AGGREGATE', 'idx', 'hello', 'LOAD', 1, '@n', 'WITHCURSOR', 'COUNT', 10)
+    env.assertNotEqual(cursor, 0)
+
+    # updates and deletions leave most of the id space unused
+    for _ in range(3):
+        for i in range(200):
+            add(i)
+    for i in range(0, 200, 2):
+        conn.execute_command('DEL', 'doc%d' % i)
+
+    poly = 'POLYGON((0 0, 0 100, 100 100, 100 0, 0 0))'
+    queries = [['hello'], ['@t:world1'], ['@n:[50 150]'], ['@tag:{tag1}'], ['-@tag:{tag1}'],
+               ['hello @tag:{tag3} @n:[0 100]'],
+               ['@g:[within $poly]', 'PARAMS', 2, 'poly', poly, 'DIALECT', 3]]
+    def search(q):
+        return env.cmd('FT.SEARCH', 'idx', q[0], 'NOCONTENT', 'SORTBY', 'n', 'LIMIT', 0, 200, *q[1:])
+    expected = [search(q) for q in queries]
+
+    forceInvokeGC(env, 'idx')
+
+    # the remaining documents are renumbered from 1, in the order of their ids
+    env.assertEqual(env.cmd('ft.debug', 'DUMP_INVIDX', 'idx', 'hello'), [int(i) for i in range(1, 101)])
+    env.expect('ft.debug', 'DOCIDTOID', 'idx', 'doc1').equal(1)
+    env.expect('ft.debug', 'DOCIDTOID', 'idx', 'doc199').equal(100)
+    for q, res in zip(queries, expected):
+        env.assertEqual(search(q), res)
+
+    # the paused cursor can not be resumed over the new ids
+    _, cursor = env.cmd('FT.CURSOR', 'READ', 'idx', cursor)
+    env.assertEqual(cursor, 0)
+
+    # new documents get the ids following the compacted ones
+    add(1000)
+    env.expect('ft.debug', 'DOCIDTOID', 'idx', 'doc1000').equal(101)
+    env.expect('FT.SEARCH', 'idx', '@n:[1000 1000]', 'NOCONTENT').equal([1, 'doc1000'])
+    # already compact
+    env.expect('ft.debug', 'COMPACT_DOCIDS', 'idx').equal(0)
+
+@skip(cluster=True)
+def testCompactDocIdsAfterCollection(env):
+    # the forced compaction runs on the GC thread, after a collection which is already queued, so
+    # the collection never applies changes collected on the old ids to the renumbered index
+    env.expect('ft.config', 'set', 'FORK_GC_CLEAN_THRESHOLD', 0).equal('OK')
+    env.expect('ft.config', 'set', '_FORK_GC_COMPACT_DOCIDS_RATIO', 0).equal('OK')
+    conn = getConnectionByEnv(env)
+    env.expect('ft.create', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'tag', 'TAG').ok()
+    waitForIndex(env, 'idx')
+    for i in range(1000):
+        conn.execute_command('HSET', 'doc%d' % i, 't', 'hello', 'n', i, 'tag', 'tag%d' % (i % 2))
+    for i in range(0, 1000, 2):
+        conn.execute_command('DEL', 'doc%d' % i)
+
+    env.expect('ft.debug', 'GC_FORCEBGINVOKE', 'idx').ok()
+    env.expect('ft.debug', 'COMPACT_DOCIDS', 'idx').equal(500)
+
+    env.assertEqual(env.cmd('ft.debug', 'DUMP_INVIDX', 'idx', 'hello'), list(range(1, 501)))
+    env.expect('FT.SEARCH', 'idx', '@n:[0 1000]', 'LIMIT', 0, 0).equal([500])
+    env.expect('FT.SEARCH', 'idx', '@tag:{tag1}', 'LIMIT', 0, 0).equal([500])
+    env.expect('FT.SEARCH', 'idx', '@tag:{tag0}', 'LIMIT', 0, 0).equal([0])
+    env.expect('ft.debug', 'DOCIDTOID', 'idx', 'doc999').equal(500)
@@ -1,5 +1,6 @@
 from RLTest import Env
 from common import *
+import random
 
 def testGeoHset(env):
   conn = getConnectionByEnv(env)
@@ -110,6 +111,92 @@ def testGeoDistanceSimple(env):
              'GROUPBY', '1', '@distance',
              'SORTBY', 2, '@distance', 'ASC').equal(res)
 
+@skip(cluster=True)
+def testGeoRadiusMatchesGeoRadius(env):
+  # compare with the GEORADIUS command, including search areas around the antimeridian and near the
+  # limits of the geohash latitudes, with and without columnar blocks
+  conn = getConnectionByEnv(env)
+  rnd = random.Random(14)
+  points = []
+  for i in range(3000):
+    if i % 3 == 0:
+      points.append((rnd.uniform(-180, 180), rnd.uniform(-85, 85)))
+    elif i % 3 == 1:
+      points.append((rnd.choice([-1, 1]) * rnd.uniform(178, 180), rnd.uniform(-2, 2)))
+    else:
+      points.append((rnd.uniform(-180, 180), rnd.choice([-1, 1]) * rnd.uniform(83, 85)))
+
+  queries = [(179.9, 0.5, 100, 'km'), (-179.99, -0.2, 300, 'km'), (0, 84.5, 500, 'km'),
+             (20, -84, 1000, 'km'), (2.35, 48.85, 2000, 'mi'), (0, 0, 15000, 'km'),
+             (-45, 10, 7000, 'km'), (179.5, 1, 50000, 'm'), (100, 84.9, 3000000, 'ft')]
+  for columnar in ['false', 'true']:
+    env.expect('FT.CONFIG', 'SET', '_NUMERIC_COLUMNAR_BLOCKS', columnar).ok()
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'g', 'GEO').ok()
+    for i, (lon, lat) in enumerate(points):
+      conn.execute_command('HSET', i, 'g', '%f,%f' % (lon, lat))
+      conn.execute_command('GEOADD', 'points', '%f' % lon, '%f' % lat, i)
+    for lon, lat, radius, unit in queries:
+      expected = sorted(int(k) for k in conn.execute_command('GEORADIUS', 'points', lon, lat, radius, unit))
+      res = env.cmd('FT.SEARCH', 'idx', '@g:[%f %f %f %s]' % (lon, lat, radius, unit), 'NOCONTENT',
+                    'LIMIT', 0, len(points))
+      env.assertEqual(res[0], len(expected), message=(lon, lat, radius, unit))
+      env.assertEqual(sorted(int(k) for k in res[1:]), expected, message=(lon, lat, radius, unit))
+    env.expect('FT.DROPINDEX', 'idx', 'DD').ok()
+    conn.execute_command('DEL', 'points')
+  env.expect('FT.CONFIG', 'SET', '_NUMERIC_COLUMNAR_BLOCKS', 'false').ok()
+
+@skip(cluster=True)
+def testGeoKnn(env):
+  # compare the k nearest documents, alone and with a filter, with GEORADIUS sorted by distance
+  conn = getConnectionByEnv(env)
+  rnd = random.Random(15)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 'g', 'GEO', 't', 'TAG').ok()
+  for i in range(2000):
+    lon, lat = (2.35 + rnd.uniform(-3, 3), 48.85 + rnd.uniform(-2, 2)) if i % 2 else \
+               (rnd.uniform(-180, 180), rnd.uniform(-85, 85))
+    tag = 'even' if i % 2 == 0 else 'odd'
+    conn.execute_command('HSET', i, 'g', '%f,%f' % (lon, lat), 't', tag)
+    conn.execute_command('GEOADD', 'points', '%f' % lon, '%f' % lat, i)
+    conn.execute_command('GEOADD', tag, '%f' % lon, '%f' % lat, i)
+
+  def check(key, lon, lat, radius, k, prefix=''):
+    expected = conn.execute_command('GEORADIUS', key, lon, lat, radius, 'km', 'WITHDIST', 'ASC', 'COUNT', k)
+    q = '%s@g:[%f %f %f km]=>{$knn: %d; $yield_distance_as: dist}' % (prefix, lon, lat, radius, k)
+    res = env.cmd('FT.SEARCH', 'idx', q, 'RETURN', 1, 'dist', 'SORTBY', 'dist', 'LIMIT', 0, k, 'DIALECT', 2)
+    env.assertEqual(res[0], len(expected), message=q)
+    env.assertEqual(res[1::2], [doc for doc, _ in expected], message=q)
+    for fields, (_, dist) in zip(res[2::2], expected):
+      env.assertAlmostEqual(float(fields[1]), float(dist), 0.001, message=q)
+
+  for lon, lat, radius, k in [(2.35, 48.85, 100, 10), (3, 49, 500, 50), (0, 0, 20000, 5),
+                              (2.35, 48.85, 5, 1000), (-120, 40, 3000, 20)]:
+    check('points', lon, lat, radius, k)
+    check('odd', lon, lat, radius, k, '@t:{odd} ')
+
+  # the documents are returned in increasing distance without sorting
+  res = env.cmd('FT.AGGREGATE', 'idx', '@g:[2.35 48.85 100 km]=>{$knn: $k; $yield_distance_as: dist}',
+                'PARAMS', 2, 'k', 20, 'DIALECT', 2)
+  dists = [float(r[1]) for r in res[1:]]
+  env.assertEqual(len(dists), 20)
+  env.assertEqual(dists, sorted(dists))
+
+  env.expect('FT.SEARCH', 'idx', '@g:[2.35 48.85 100 km]=>{$knn: 0}', 'DIALECT', 2).error().contains('Invalid value')
+  env.expect('FT.SEARCH', 'idx', '@g:[2.35 48.85 100 km]=>{$yield_distance_as: dist}', 'DIALECT', 2).error() \
+    .contains('Distance can only be yielded by GEO KNN queries')
+  env.expect('FT.SEARCH', 'idx', '@t:{odd} | @g:[2.35 48.85 100 km]=>{$knn: 5}', 'DIALECT', 2).error() \
+    .contains('GEO KNN must be used at most once, as a top level clause of the query')
+  env.expect('FT.SEARCH', 'idx', '@g:[2.35 48.85 100 km]=>{$knn: 5} @g:[2 48 100 km]=>{$knn: 5}', 'DIALECT', 2).error() \
+    .contains('GEO KNN must be used at most once, as a top level clause of the query')
+
+@skip(cluster=False)
+def testGeoKnnCluster(env):
+  # the nearest documents of the shards are not merged by the coordinator
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 'g', 'GEO', 't', 'TAG').ok()
+  env.expect('FT.SEARCH', 'idx', '@g:[2.35 48.85 100 km]=>{$knn: 10}', 'DIALECT', 2).error() \
+    .contains('GEO KNN is not supported in cluster mode')
+  env.expect('FT.AGGREGATE', 'idx', '@t:{odd} @g:[2.35 48.85 100 km]=>{$knn: $k}', 'PARAMS', 2, 'k', 10,
+             'DIALECT', 2).error().contains('GEO KNN is not supported in cluster mode')
+
 from hotels import hotels
 def testGeoDistanceFile(env):
   env.expect('ft.create', 'idx', 'schema', 'name', 'text', 'location', 'geo').ok()
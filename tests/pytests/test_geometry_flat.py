@@ -330,3 +330,50 @@ def testFtInfo(env):
   else:
     # TODO: in cluster - be able to wait for cleaning of the index (would wait for freeing the geoshape index memory)
     env.assertLess(cur_usage, usage)
+
+
+def checkBulkLoad(env):
+  ''' Test queries over many shapes, indexed by a background scan and then one by one '''
+
+  conn = getConnectionByEnv(env)
+  n = 60  # a grid of n x n unit squares, at distance 2 from each other
+  square = lambda x, y: f'POLYGON(({2*x} {2*y}, {2*x} {2*y+1}, {2*x+1} {2*y+1}, {2*x+1} {2*y}, {2*x} {2*y}))'
+  for x in range(n):
+    for y in range(n):
+      conn.execute_command('HSET', f'{x}_{y}', 'geom', square(x, y))
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 'geom', 'GEOSHAPE', 'FLAT').ok()
+  waitForIndex(env, 'idx')
+
+  def expected_within(lo, hi, keys):
+    return sorted(k for k in keys if all(lo <= 2 * int(c) and 2 * int(c) + 1 <= hi for c in k.split('_')))
+
+  def search_within(lo, hi):
+    query = f'POLYGON(({lo} {lo}, {lo} {hi}, {hi} {hi}, {hi} {lo}, {lo} {lo}))'
+    res = env.cmd('FT.SEARCH', 'idx', '@geom:[within $poly]', 'PARAMS', 2, 'poly', query,
+                  'NOCONTENT', 'LIMIT', 0, 10000, 'DIALECT', 3)
+    return sorted(res[1:])
+
+  keys = {f'{x}_{y}' for x in range(n) for y in range(n)}
+  for lo, hi in [(0, 2 * n), (10, 51), (31, 32), (-1, 0)]:
+    env.assertEqual(search_within(lo, hi), expected_within(lo, hi, keys), message=f'{lo} {hi}')
+  assert_index_num_docs(env, 'idx', 'geom', n * n)
+
+  # delete some of the shapes, and add shapes one by one between queries
+  for x in range(0, n, 3):
+    conn.execute_command('DEL', f'{x}_{x}')
+    keys.discard(f'{x}_{x}')
+  for x in range(n, n + 5):
+    for y in range(n):
+      conn.execute_command('HSET', f'{x}_{y}', 'geom', square(x, y))
+      keys.add(f'{x}_{y}')
+    env.assertEqual(search_within(0, 2 * x + 1), expected_within(0, 2 * x + 1, keys), message=x)
+  assert_index_num_docs(env, 'idx', 'geom', len(keys))
+
+def testBulkLoad(env):
+  checkBulkLoad(env)
+
+@skip(cluster=True, noWorkers=True)
+def testBulkLoadWorkers():
+  # the exact predicate of queries with many candidates runs on the workers
+  env = Env(moduleArgs='WORKER_THREADS 2 MT_MODE MT_MODE_FULL')
+  checkBulkLoad(env)
@@ -363,3 +363,102 @@ def test_multiple_loaders():
     cmd += ['LIMIT', '0', limit]
 
     env.expect(*cmd).noError().apply(lambda x: x[1:]).equal([['n', '0'], ['n', '1'], ['n', '2'], ['n', '3'], ['n', '4']])
+
+@skip(cluster=True)
+def test_bg_index_batch():
+    env = initEnv(moduleArgs='WORKER_THREADS 2 MT_MODE MT_MODE_FULL')
+    conn = getConnectionByEnv(env)
+    n_docs = 1000
+    for n in range(n_docs):
+        conn.execute_command('HSET', f'doc{n}', 't', f'hello running world{n % 10}', 'n', n, 'tag', f'tag{n % 5}')
+    # a document which fails to be indexed is dropped on its own
+    conn.execute_command('HSET', 'bad', 't', 'hello', 'n', 'not a number')
+
+    env.expect('FT.CONFIG', 'SET', '_BG_INDEX_BATCH_SIZE', 64).ok()
+    env.expect('FT.CONFIG', 'GET', '_BG_INDEX_BATCH_SIZE').equal([['_BG_INDEX_BATCH_SIZE', '64']])
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE', 'tag', 'TAG').ok()
+    waitForIndex(env, 'idx')
+
+    info = index_info(env, 'idx')
+    env.assertEqual(int(info['num_docs']), n_docs)
+    env.assertEqual(int(info['hash_indexing_failures']), 1)
+    # stemmed terms are found
+    env.expect('FT.SEARCH', 'idx', 'run', 'LIMIT', 0, 0).equal([n_docs])
+    env.expect('FT.SEARCH', 'idx', 'world3', 'LIMIT', 0, 0).equal([n_docs // 10])
+    env.expect('FT.SEARCH', 'idx', '@tag:{tag2}', 'LIMIT', 0, 0).equal([n_docs // 5])
+    env.expect('FT.SEARCH', 'idx', '@n:[10 19]', 'SORTBY', 'n', 'LIMIT', 0, 1, 'RETURN', 1, 'n').equal([10, 'doc10', ['n', '10']])
+
+    # the entries of a term merged across the documents of a batch are written in ascending ids
+    ids = env.cmd(debug_cmd(), 'DUMP_INVIDX', 'idx', 'hello')
+    env.assertEqual(len(ids), n_docs)
+    env.assertEqual(ids, sorted(ids))
+    ids = env.cmd(debug_cmd(), 'DUMP_INVIDX', 'idx', 'world7')
+    env.assertEqual(len(ids), n_docs // 10)
+    env.assertEqual(ids, sorted(ids))
+
+@skip(cluster=True)
+def test_bg_index_parallel():
+    env = initEnv(moduleArgs='WORKER_THREADS 4 MT_MODE MT_MODE_FULL')
+    conn = getConnectionByEnv(env)
+    n_docs = 10000
+    for n in range(n_docs):
+        conn.execute_command('HSET', f'doc{n}', 't', f'hello world{n % 10}', 'n', n)
+
+    env.expect('FT.CONFIG', 'SET', '_BG_INDEX_BATCH_SIZE', 100).ok()
+    env.expect('FT.CONFIG', 'SET', '_BG_INDEX_PARALLEL', 'true').ok()
+    env.expect('FT.CONFIG', 'GET', '_BG_INDEX_PARALLEL').equal([['_BG_INDEX_PARALLEL', 'true']])
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+
+    # keys written while the index is being built are indexed with their latest value, whether they
+    # were already scanned, are in the batch being processed, or were not scanned yet
+    for n in range(0, n_docs, 100):
+        conn.execute_command('HSET', f'doc{n}', 't', 'updated', 'n', -1)
+    for n in range(50, n_docs, 100):
+        conn.execute_command('DEL', f'doc{n}')
+    for n in range(25, n_docs, 100):
+        conn.execute_command('RENAME', f'doc{n}', f'renamed{n}')
+    percent = float(index_info(env, 'idx')['percent_indexed'])
+    env.assertGreaterEqual(percent, 0)
+    env.assertLessEqual(percent, 1)
+    waitForIndex(env, 'idx')
+
+    info = index_info(env, 'idx')
+    env.assertEqual(float(info['percent_indexed']), 1)
+    env.assertEqual(int(info['num_docs']), n_docs - n_docs // 100)
+    env.expect('FT.SEARCH', 'idx', 'updated', 'LIMIT', 0, 0).equal([n_docs // 100])
+    env.expect('FT.SEARCH', 'idx', '@n:[-1 -1]', 'LIMIT', 0, 0).equal([n_docs // 100])
+    env.expect('FT.SEARCH', 'idx', 'hello', 'LIMIT', 0, 0).equal([n_docs - 2 * (n_docs // 100)])
+    for n in range(25, n_docs, 100):
+        env.expect('FT.SEARCH', 'idx', f'@n:[{n} {n}]', 'NOCONTENT').equal([1, f'renamed{n}'])
+
+def test_quantized_rerank():
+    # queries running in the background re-rank the candidates of quantized indexes with the exact
+    # distances, as queries running on the main thread do
+    env = initEnv(moduleArgs='WORKER_THREADS 2 MT_MODE MT_MODE_FULL DEFAULT_DIALECT 2')
+    env.skipOnCluster()
+    conn = getConnectionByEnv(env)
+    dim = 32
+    k = 10
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '6', 'TYPE', 'FLOAT32',
+               'DIM', dim, 'DISTANCE_METRIC', 'L2').ok()
+    env.expect('FT.CREATE', 'idx_sq8', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '10', 'TYPE', 'FLOAT32',
+               'DIM', dim, 'DISTANCE_METRIC', 'L2', 'QUANTIZATION', 'SQ8', 'RERANK', 50).ok()
+    load_vectors_to_redis(env, 2000, 0, dim)
+
+    np.random.seed(19)
+    for _ in range(5):
+        query_vec = create_np_array_typed(np.random.rand(dim))
+        query = f'*=>[KNN {k} @v $vec_param]'
+        expected = conn.execute_command('FT.SEARCH', 'idx', query, 'SORTBY', '__v_score',
+                                        'PARAMS', 2, 'vec_param', query_vec.tobytes(), 'RETURN', 1, '__v_score')
+        res = conn.execute_command('FT.SEARCH', 'idx_sq8', query, 'SORTBY', '__v_score',
+                                   'PARAMS', 2, 'vec_param', query_vec.tobytes(), 'RETURN', 1, '__v_score')
+        env.assertEqual(res[0], k)
+        env.assertEqual(res[1::2], expected[1::2])
+        for expected_doc, doc in zip(expected[2::2], res[2::2]):
+            env.assertAlmostEqual(float(expected_doc[1]), float(doc[1]), 1E-4)
+
+    res = env.cmd('FT.PROFILE', 'idx_sq8', 'SEARCH', 'QUERY', f'*=>[KNN {k} @v $vec_param]',
+                  'PARAMS', 2, 'vec_param', query_vec.tobytes(), 'NOCONTENT')
+    env.assertEqual(to_dict(res[1][4][1])['Reranked candidates'], 50)
+    env.assertContains('Reranker', [to_dict(rp)['Type'] for rp in res[1][5][1:]])
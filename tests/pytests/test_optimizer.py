@@ -467,6 +467,82 @@ def testSearch(env):
             compare_optimized_to_not(env, ['ft.search', 'idx', '*'], params, 'case 12')
         #input('stop')
 
+@skip(cluster=True)
+def testScorePruning(env):
+    # top-k text unions are scored with block-max pruning in optimized mode (case 8 above).
+    # results must not change
+    repeat = 3000
+    conn = getConnectionByEnv(env)
+    env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT')
+
+    words = ['hello', 'world', 'foo', 'bar', 'baz']
+    for i in range(repeat):
+        # vary term frequencies and document lengths
+        text = ' '.join([words[i % 5]] * (i % 7 + 1) + [words[(i * 3) % 5]] * (i % 3 + 1) + ['filler'] * (i % 11))
+        conn.execute_command('hset', i, 't', text)
+
+    queries = ['hello | world', 'hello | foo | bar', '(hello | world) | baz', '@t:(foo | bar)']
+    for _ in env.reloadingIterator():
+        for scorer in ['TFIDF', 'BM25', 'BM25STD']:
+            for query in queries:
+                for limit in [1, 10, 50]:
+                    params = ['WITHSCORES', 'NOCONTENT', 'SCORER', scorer, 'LIMIT', 0, limit]
+                    not_res = env.cmd('FT.SEARCH', 'idx', query, *params)
+                    opt_res = env.cmd('FT.SEARCH', 'idx', query, 'WITHOUTCOUNT', *params)
+                    msg = '%s %s limit %d' % (scorer, query, limit)
+                    env.assertEqual(not_res[1:], opt_res[1:], message=msg)
+
+@skip(cluster=True)
+def testScorePruningScoreField(env):
+    # with a score field, the bounds use the scores and lengths of the documents in the doc table.
+    # results must not change
+    repeat = 3000
+    conn = getConnectionByEnv(env)
+    env.cmd('FT.CREATE', 'idx', 'SCORE_FIELD', 's', 'SCHEMA', 't', 'TEXT')
+
+    words = ['hello', 'world', 'foo', 'bar', 'baz']
+    for i in range(repeat):
+        text = ' '.join([words[i % 5]] * (i % 7 + 1) + [words[(i * 3) % 5]] * (i % 3 + 1) + ['filler'] * (i % 11))
+        # scores above 1 are rare
+        score = 5 if i % 97 == 0 else (i % 13) / 13
+        conn.execute_command('hset', i, 't', text, 's', score)
+
+    queries = ['hello | world', 'hello | foo | bar', '(hello | world) | baz']
+    for _ in env.reloadingIterator():
+        for scorer in ['TFIDF', 'BM25', 'BM25STD']:
+            for query in queries:
+                for limit in [1, 10, 50]:
+                    params = ['WITHSCORES', 'NOCONTENT', 'SCORER', scorer, 'LIMIT', 0, limit]
+                    not_res = env.cmd('FT.SEARCH', 'idx', query, *params)
+                    opt_res = env.cmd('FT.SEARCH', 'idx', query, 'WITHOUTCOUNT', *params)
+                    msg = '%s %s limit %d' % (scorer, query, limit)
+                    env.assertEqual(not_res[1:], opt_res[1:], message=msg)
+
+@skip(cluster=True)
+def testNumericOrderedScan(env):
+    # with _NUMERIC_ORDERED_SCAN, sorted queries walk the ranges of the sortby field in order.
+    # results must not change
+    repeat = 10000
+    conn = getConnectionByEnv(env)
+    env.cmd('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 't', 'TEXT', 'tag', 'TAG')
+    words = ['hello', 'world', 'foo', 'bar', 'baz']
+    for i in range(repeat):
+        # 'baz' is rare, and only has large values
+        word = 'baz' if i % 500 == 0 else words[i % 4]
+        conn.execute_command('hset', i, 't', word, 'tag', word, 'n', (i * 7919) % 3000 + (5000 if word == 'baz' else 0))
+
+    env.expect('FT.CONFIG', 'SET', '_NUMERIC_ORDERED_SCAN', 'true').ok()
+    queries = [['foo @n:[100 2500]', 'SORTBY', 'n'], ['@tag:{bar} @n:[(500 +inf]', 'SORTBY', 'n', 'DESC'],
+               ['foo', 'SORTBY', 'n'], ['baz', 'SORTBY', 'n'], ['@tag:{baz}', 'SORTBY', 'n', 'DESC'],
+               ['*', 'SORTBY', 'n'], ['-hello', 'SORTBY', 'n', 'DESC']]
+    for limits in [[0, 1], [0, 10], [0, 100], [20, 30], [500, 10]]:
+        params = ['limit'] + limits
+        for query in queries:
+            compare_optimized_to_not(env, ['ft.search', 'idx'] + query, params, ' '.join(query))
+            compare_optimized_to_not(env, ['ft.aggregate', 'idx', query[0], 'SORTBY', 2, '@n',
+                                           'DESC' if 'DESC' in query else 'ASC'], params, ' '.join(query))
+    env.expect('FT.CONFIG', 'SET', '_NUMERIC_ORDERED_SCAN', 'false').ok()
+
 @skip(cluster=True)
 def testAggregate(env):
     repeat = 1000
@@ -274,6 +274,36 @@ def testTagGCClearEmpty(env):
     env.expect('FT.SEARCH', 'idx', '@t:{foo}')  \
         .equal([2, 'doc4', ['t', 'foo'], 'doc5', ['t', 'foo']])
 
+@skip(cluster=True)
+def testTagBitmapBlocks(env):
+    # with _TAG_BITMAP_BLOCKS, full blocks of dense tag values are stored as bitmaps
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'SET', '_TAG_BITMAP_BLOCKS', 'true').ok()
+    conn.execute_command('FT.CONFIG', 'SET', 'FORK_GC_CLEAN_THRESHOLD', '0')
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 't', 'TAG', 'n', 'NUMERIC')
+    N = 5000
+    for i in range(N):
+        conn.execute_command('HSET', 'doc%d' % i, 't', 'even' if i % 2 == 0 else 'odd,sparse' if i % 50 == 1 else 'odd',
+                             'n', i)
+
+    def check():
+        for tag, count in [('even', N // 2), ('odd', N // 2), ('sparse', N // 50)]:
+            env.expect('FT.SEARCH', 'idx', '@t:{%s}' % tag, 'LIMIT', 0, 0).equal([count])
+        env.expect('FT.SEARCH', 'idx', '@t:{even} @n:[1000 1999]', 'LIMIT', 0, 0).equal([500])
+        env.expect('FT.SEARCH', 'idx', '@t:{odd} -@t:{sparse}', 'LIMIT', 0, 0).equal([N // 2 - N // 50])
+        env.expect('FT.SEARCH', 'idx', '@t:{even|sparse}', 'LIMIT', 0, 0).equal([N // 2 + N // 50])
+
+    for _ in env.reloadingIterator():
+        waitForIndex(env, 'idx')
+        check()
+
+    for i in range(0, N, 4):
+        conn.execute_command('DEL', 'doc%d' % i)
+    forceInvokeGC(env, 'idx')
+    env.expect('FT.SEARCH', 'idx', '@t:{even}', 'LIMIT', 0, 0).equal([N // 4])
+    env.expect('FT.SEARCH', 'idx', '@t:{even}', 'SORTBY', 'n', 'LIMIT', 0, 2, 'NOCONTENT').equal([N // 4, 'doc2', 'doc6'])
+    env.expect('FT.CONFIG', 'SET', '_TAG_BITMAP_BLOCKS', 'false').ok()
+
 @skip(cluster=True)
 def testTagGCClearEmptyWithCursor(env):
 
@@ -1422,6 +1422,175 @@ def test_hybrid_query_change_policy():
         conn.execute_command('FT.DROPINDEX', 'idx', 'DD')
 
 
+@skip(cluster=True)
+def test_hybrid_query_adaptive_policy():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'SET', '_HYBRID_ADAPTIVE_POLICY', 'true').ok()
+    dim = 2
+    n = 6000
+    np.random.seed(10)
+
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '6', 'TYPE', 'FLOAT32',
+               'DIM', dim, 'DISTANCE_METRIC', 'COSINE', 'tag1', 'TAG', 'tag2', 'TAG').ok()
+    with conn.pipeline(transaction=False) as p:
+        for i in range(n):
+            v = create_np_array_typed(np.random.rand(dim))
+            half = int(i >= n / 2)
+            p.execute_command('HSET', i, 'v', v.tobytes(), 'tag1', str(10 * half + randrange(10)),
+                              'tag2', 'word' + str(1 + half))
+        p.execute()
+    query_vec = create_np_array_typed(np.random.rand(dim))
+
+    # None of the tags in @tag1 go along with 'word2' in @tag2, although the child is estimated to
+    # have index_size/2 results. The first query learns that no vector passes the filter while it
+    # runs in batches, so the next one goes to AD-HOC BF right away.
+    query_string = '(@tag1:{0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9} @tag2:{word2})=>[KNN 10 @v $vec_param]'
+    execute_hybrid_query(env, query_string, query_vec, 'tag2',
+                         hybrid_mode='HYBRID_BATCHES_TO_ADHOC_BF').equal([0])
+    execute_hybrid_query(env, query_string, query_vec, 'tag2', hybrid_mode='HYBRID_ADHOC_BF').equal([0])
+
+    stats = to_dict(env.cmd('FT.INFO', 'idx'))['hybrid_filter_stats']
+    env.assertEqual(len(stats), 1)
+    stats = to_dict(stats[0])
+    env.assertEqual(stats['attribute'], 'v')
+    env.assertEqual(stats['filter'], 'INTERSECT(TAG(@tag1),TAG(@tag2))')
+    env.assertEqual(float(stats['pass_rate']), 0)
+    env.assertEqual(stats['queries'], 2)
+    env.assertGreater(stats['batches'], 0)
+
+    # A query of the same shape whose filter passes half of the vectors returns the same results,
+    # whatever policy its learned pass rate leads to.
+    query_string = '(@tag1:{0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9} @tag2:{word1})=>[KNN 10 @v $vec_param]'
+    res = conn.execute_command('FT.SEARCH', 'idx', query_string, 'SORTBY', '__v_score',
+                               'PARAMS', 2, 'vec_param', query_vec.tobytes(), 'RETURN', 1, '__v_score')
+    env.assertEqual(res[0], 10)
+    query_string = '(@tag1:{0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9} @tag2:{word1})=>[KNN 10 @v $vec_param HYBRID_POLICY ADHOC_BF]'
+    adhoc_res = conn.execute_command('FT.SEARCH', 'idx', query_string, 'SORTBY', '__v_score',
+                                     'PARAMS', 2, 'vec_param', query_vec.tobytes(), 'RETURN', 1, '__v_score')
+    for i, res_fields in enumerate(res[2::2]):
+        env.assertEqual(res_fields, adhoc_res[2+2*i])
+
+    stats = to_dict(to_dict(env.cmd('FT.INFO', 'idx'))['hybrid_filter_stats'][0])
+    env.assertEqual(stats['queries'], 4)
+    env.assertGreater(float(stats['pass_rate']), 0)
+
+    env.expect('FT.CONFIG', 'SET', '_HYBRID_ADAPTIVE_POLICY', 'false').ok()
+
+
+@skip(cluster=True)
+def test_hybrid_query_prefilter_bitmap():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CONFIG', 'SET', '_HYBRID_PREFILTER_BITMAP', 'true').ok()
+    dim = 2
+    n = 6000
+    np.random.seed(10)
+
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'HNSW', '6', 'TYPE', 'FLOAT32',
+               'DIM', dim, 'DISTANCE_METRIC', 'L2', 'tag', 'TAG').ok()
+    with conn.pipeline(transaction=False) as p:
+        for i in range(n):
+            v = create_np_array_typed(np.random.rand(dim))
+            p.execute_command('HSET', i, 'v', v.tobytes(), 'tag', str(i % 10))
+        p.execute()
+    query_vec = create_np_array_typed(np.random.rand(dim))
+
+    # The batches are filtered by the bitmap of the documents tagged 1 or 2, and the results are the
+    # same as those of AD-HOC BF.
+    for k in [1, 10, 100]:
+        query_string = f'(@tag:{{1 | 2}})=>[KNN {k} @v $vec_param HYBRID_POLICY BATCHES]'
+        res = conn.execute_command('FT.SEARCH', 'idx', query_string, 'SORTBY', '__v_score', 'LIMIT', 0, k,
+                                   'PARAMS', 2, 'vec_param', query_vec.tobytes(), 'RETURN', 1, '__v_score')
+        env.assertEqual(res[0], k)
+        query_string = f'(@tag:{{1 | 2}})=>[KNN {k} @v $vec_param HYBRID_POLICY ADHOC_BF]'
+        adhoc_res = conn.execute_command('FT.SEARCH', 'idx', query_string, 'SORTBY', '__v_score', 'LIMIT', 0, k,
+                                         'PARAMS', 2, 'vec_param', query_vec.tobytes(), 'RETURN', 1, '__v_score')
+        env.assertEqual(res, adhoc_res)
+
+    # The bitmap holds every document which passes the filter, read once from the child.
+    query_string = '(@tag:{1 | 2})=>[KNN 10 @v $vec_param HYBRID_POLICY BATCHES]'
+    res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', query_string, 'PARAMS', 2, 'vec_param',
+                  query_vec.tobytes(), 'NOCONTENT')
+    vector_profile = to_dict(res[1][4][1])
+    env.assertEqual(vector_profile['Type'], 'VECTOR')
+    env.assertEqual(vector_profile['Filter bitmap size'], n // 5)
+    env.assertEqual(to_dict(env.cmd('FT.DEBUG', 'VECSIM_INFO', 'idx', 'v'))['LAST_SEARCH_MODE'], 'HYBRID_BATCHES')
+
+    env.expect('FT.CONFIG', 'SET', '_HYBRID_PREFILTER_BITMAP', 'false').ok()
+
+
+@skip(cluster=True)
+def test_quantized_flat_index():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    dim = 64
+    n = 3000
+    k = 10
+    np.random.seed(10)
+
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '6', 'TYPE', 'FLOAT32',
+               'DIM', dim, 'DISTANCE_METRIC', 'L2', 'tag', 'TAG').ok()
+    env.expect('FT.CREATE', 'idx_sq8', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '10', 'TYPE', 'FLOAT32',
+               'DIM', dim, 'DISTANCE_METRIC', 'L2', 'QUANTIZATION', 'SQ8', 'RERANK', 50, 'tag', 'TAG').ok()
+    with conn.pipeline(transaction=False) as p:
+        for i in range(n):
+            v = create_np_array_typed(np.random.rand(dim))
+            p.execute_command('HSET', i, 'v', v.tobytes(), 'tag', str(i % 10))
+        p.execute()
+    waitForIndex(env, 'idx_sq8')
+
+    info = to_dict(env.cmd('FT.DEBUG', 'VECSIM_INFO', 'idx_sq8', 'v'))
+    env.assertEqual(info['QUANTIZATION'], 'SQ8')
+    env.assertEqual(info['RERANK'], 50)
+    env.assertEqual(get_vecsim_index_size(env, 'idx_sq8', 'v'), n)
+    # The codes take a quarter of the memory of the FLOAT32 vectors.
+    env.assertLess(get_vecsim_memory(env, 'idx_sq8', 'v'), get_vecsim_memory(env, 'idx', 'v') / 2)
+
+    # The re-ranked results are those of the FLAT index, with the exact distances.
+    for i in range(5):
+        query_vec = create_np_array_typed(np.random.rand(dim))
+        for query in [f'*=>[KNN {k} @v $vec_param]', f'(@tag:{{1 | 2}})=>[KNN {k} @v $vec_param]']:
+            expected = conn.execute_command('FT.SEARCH', 'idx', query, 'SORTBY', '__v_score',
+                                            'PARAMS', 2, 'vec_param', query_vec.tobytes(), 'RETURN', 1, '__v_score')
+            res = conn.execute_command('FT.SEARCH', 'idx_sq8', query, 'SORTBY', '__v_score',
+                                       'PARAMS', 2, 'vec_param', query_vec.tobytes(), 'RETURN', 1, '__v_score')
+            env.assertEqual(res[1::2], expected[1::2], message=query)
+            for expected_doc, doc in zip(expected[2::2], res[2::2]):
+                env.assertAlmostEqual(float(expected_doc[1]), float(doc[1]), 1E-4)
+
+    # Range queries return the distances of the quantized vectors.
+    query_vec = create_np_array_typed(np.random.rand(dim))
+    expected = conn.execute_command('FT.SEARCH', 'idx', f'*=>[KNN 100 @v $vec_param]', 'SORTBY', '__v_score',
+                                    'PARAMS', 2, 'vec_param', query_vec.tobytes(), 'RETURN', 1, '__v_score', 'LIMIT', 0, 100)
+    radius = float(expected[-1][1])
+    res = conn.execute_command('FT.SEARCH', 'idx_sq8', '@v:[VECTOR_RANGE $r $vec_param]=>{$YIELD_DISTANCE_AS:dist}',
+                               'SORTBY', 'dist', 'PARAMS', 4, 'vec_param', query_vec.tobytes(), 'r', radius,
+                               'RETURN', 1, 'dist', 'LIMIT', 0, n)
+    env.assertGreater(res[0], 50)
+    for dist in res[2::2]:
+        env.assertGreaterEqual(radius, float(dist[1]))
+
+    res = env.cmd('FT.PROFILE', 'idx_sq8', 'SEARCH', 'QUERY', f'*=>[KNN {k} @v $vec_param]',
+                  'PARAMS', 2, 'vec_param', query_vec.tobytes(), 'NOCONTENT')
+    vector_profile = to_dict(res[1][4][1])
+    env.assertEqual(vector_profile['Type'], 'VECTOR QUANTIZED')
+    env.assertEqual(vector_profile['Reranked candidates'], 50)
+
+    # Deleted documents are removed from the quantized index.
+    conn.execute_command('DEL', 0, 1, 2)
+    env.assertEqual(get_vecsim_index_size(env, 'idx_sq8', 'v'), n - 3)
+
+    env.expect('FT.CREATE', 'bad', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '8', 'TYPE', 'FLOAT32', 'DIM', dim,
+               'DISTANCE_METRIC', 'L2', 'RERANK', 10).error().contains('RERANK requires QUANTIZATION')
+    env.expect('FT.CREATE', 'bad', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '8', 'TYPE', 'FLOAT32', 'DIM', dim,
+               'DISTANCE_METRIC', 'L2', 'QUANTIZATION', 'PQ').error().contains('vector similarity FLAT index quantization')
+    env.expect('FT.CREATE', 'bad', 'SCHEMA', 'v', 'VECTOR', 'HNSW', '8', 'TYPE', 'FLOAT32', 'DIM', dim,
+               'DISTANCE_METRIC', 'L2', 'QUANTIZATION', 'SQ8').error().contains('Bad arguments for algorithm HNSW')
+    env.expect('FT.SEARCH', 'idx_sq8', f'*=>[KNN {k} @v $vec_param EF_RUNTIME 10]', 'PARAMS', 2, 'vec_param',
+               query_vec.tobytes()).error().contains('not supported by quantized vector indexes')
+
+
 def test_system_memory_limits():
     env = Env(moduleArgs='DEFAULT_DIALECT 2')
     conn = getConnectionByEnv(env)
@@ -1975,6 +2144,63 @@ def test_range_query_basic_random_vectors():
     env.assertEqual(ids_found, len(res_default_epsilon[1::2]))
 
 
+@skip(cluster=True)
+def test_range_query_batches():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    dim = 4
+    n = 1000
+    np.random.seed(10)
+
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', '6', 'TYPE', 'FLOAT32',
+               'DIM', dim, 'DISTANCE_METRIC', 'L2', 't', 'TAG').ok()
+    with conn.pipeline(transaction=False) as p:
+        for i in range(n):
+            p.execute_command('HSET', i, 'v', create_np_array_typed(np.random.rand(dim)).tobytes(), 't', i % 2)
+        p.execute()
+    query_vec = create_np_array_typed(np.random.rand(dim)).tobytes()
+    radius = 0.3
+    expected = conn.execute_command('FT.SEARCH', 'idx', '@v:[VECTOR_RANGE $r $vec]=>{$YIELD_DISTANCE_AS: dist}',
+                                    'PARAMS', 4, 'vec', query_vec, 'r', radius, 'RETURN', 1, 'dist', 'LIMIT', 0, n)
+    expected = {doc: float(fields[1]) for doc, fields in zip(expected[1::2], expected[2::2])}
+    env.assertGreater(len(expected), 100)
+
+    # The results are streamed in batches by increasing distance, and read by the cursor on demand.
+    query = '@v:[VECTOR_RANGE $r $vec]=>{$YIELD_DISTANCE_AS: dist; $BATCH_SIZE: 50}'
+    res, cursor = conn.execute_command('FT.AGGREGATE', 'idx', query, 'LOAD', 1, '@__key', 'PARAMS', 4,
+                                       'vec', query_vec, 'r', radius, 'WITHCURSOR', 'COUNT', 30)
+    rows = res[1:]
+    while cursor:
+        res, cursor = conn.execute_command('FT.CURSOR', 'READ', 'idx', cursor)
+        rows += res[1:]
+    distances = [float(to_dict(row)['dist']) for row in rows]
+    env.assertEqual(distances, sorted(distances))
+    env.assertEqual({to_dict(row)['__key']: float(to_dict(row)['dist']) for row in rows}, expected)
+
+    # Filtered range queries return the same results by id.
+    res = conn.execute_command('FT.SEARCH', 'idx', f'@t:{{0}} {query}', 'PARAMS', 4, 'vec', query_vec,
+                               'r', radius, 'NOCONTENT', 'LIMIT', 0, n)
+    env.assertEqual(set(res[1:]), {doc for doc in expected if int(doc) % 2 == 0})
+
+    env.cmd('FT.CONFIG', 'SET', '_PRINT_PROFILE_CLOCK', 'false')
+    res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', query, 'PARAMS', 4, 'vec', query_vec, 'r', radius,
+                  'NOCONTENT', 'LIMIT', 0, n)
+    env.assertEqual(res[1][4], ['Iterators profile', ['Type', 'VECTOR RANGE', 'Counter', len(expected),
+                                                      'Batches number', len(expected) // 50 + 1]])
+
+    # Adding a document while the cursor is paused invalidates it.
+    res, cursor = conn.execute_command('FT.AGGREGATE', 'idx', query, 'PARAMS', 4, 'vec', query_vec, 'r', radius,
+                                       'WITHCURSOR', 'COUNT', 30)
+    env.assertEqual(len(res[1:]), 30)
+    conn.execute_command('HSET', n, 'v', query_vec)
+    res, cursor = conn.execute_command('FT.CURSOR', 'READ', 'idx', cursor)
+    env.assertEqual(res[1:], [])
+    env.assertEqual(cursor, 0)
+
+    env.expect('FT.SEARCH', 'idx', '@v:[VECTOR_RANGE 1 $vec]=>{$BATCH_SIZE: 0}', 'PARAMS', 2, 'vec',
+               query_vec).error().contains('Error parsing vector similarity parameters: Invalid value')
+
+
 def test_range_query_complex_queries():
     env = Env(moduleArgs='DEFAULT_DIALECT 2')
     conn = getConnectionByEnv(env)